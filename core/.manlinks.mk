@@ -51,16 +51,26 @@ MANLINKS+=AG_Event.3:AG_SetTextFn.3
 CATLINKS+=AG_Event.cat3:AG_SetTextFn.cat3
 MANLINKS+=AG_Event.3:AG_FindEventHandler.3
 CATLINKS+=AG_Event.cat3:AG_FindEventHandler.cat3
+MANLINKS+=AG_Event.3:AG_FindEventHandlerAtom.3
+CATLINKS+=AG_Event.cat3:AG_FindEventHandlerAtom.cat3
 MANLINKS+=AG_Event.3:AG_UnsetEvent.3
 CATLINKS+=AG_Event.cat3:AG_UnsetEvent.cat3
 MANLINKS+=AG_Event.3:AG_PostEvent.3
 CATLINKS+=AG_Event.cat3:AG_PostEvent.cat3
+MANLINKS+=AG_Event.3:AG_PostEventAtom.3
+CATLINKS+=AG_Event.cat3:AG_PostEventAtom.cat3
 MANLINKS+=AG_Event.3:AG_PostEventByPtr.3
 CATLINKS+=AG_Event.cat3:AG_PostEventByPtr.cat3
 MANLINKS+=AG_Event.3:AG_SchedEvent.3
 CATLINKS+=AG_Event.cat3:AG_SchedEvent.cat3
 MANLINKS+=AG_Event.3:AG_ForwardEvent.3
 CATLINKS+=AG_Event.cat3:AG_ForwardEvent.cat3
+MANLINKS+=AG_Event.3:AG_InternEventName.3
+CATLINKS+=AG_Event.cat3:AG_InternEventName.cat3
+MANLINKS+=AG_Event.3:AG_LookupEventAtom.3
+CATLINKS+=AG_Event.cat3:AG_LookupEventAtom.cat3
+MANLINKS+=AG_Event.3:AG_GetEventAtomName.3
+CATLINKS+=AG_Event.cat3:AG_GetEventAtomName.cat3
 MANLINKS+=AG_Event.3:AG_SELF.3
 CATLINKS+=AG_Event.cat3:AG_SELF.cat3
 MANLINKS+=AG_Event.3:AG_SENDER.3
@@ -97,6 +107,10 @@ MANLINKS+=AG_Event.3:AG_FreeEventQ.3
 CATLINKS+=AG_Event.cat3:AG_FreeEventQ.cat3
 MANLINKS+=AG_Event.3:AG_QueueEvent.3
 CATLINKS+=AG_Event.cat3:AG_QueueEvent.cat3
+MANLINKS+=AG_Event.3:AG_SetEventPoolSize.3
+CATLINKS+=AG_Event.cat3:AG_SetEventPoolSize.cat3
+MANLINKS+=AG_Event.3:AG_GetEventPoolStats.3
+CATLINKS+=AG_Event.cat3:AG_GetEventPoolStats.cat3
 MANLINKS+=AG_Object.3:AG_ObjectNew.3
 CATLINKS+=AG_Object.cat3:AG_ObjectNew.cat3
 MANLINKS+=AG_Object.3:AG_ObjectInit.3
@@ -177,6 +191,14 @@ MANLINKS+=AG_Object.3:AG_UnregisterModuleDirectory.3
 CATLINKS+=AG_Object.cat3:AG_UnregisterModuleDirectory.cat3
 MANLINKS+=AG_Object.3:AG_OfClass.3
 CATLINKS+=AG_Object.cat3:AG_OfClass.cat3
+MANLINKS+=AG_Object.3:AG_OfSubclass.3
+CATLINKS+=AG_Object.cat3:AG_OfSubclass.cat3
+MANLINKS+=AG_Object.3:AG_CompileClassPattern.3
+CATLINKS+=AG_Object.cat3:AG_CompileClassPattern.cat3
+MANLINKS+=AG_Object.3:AG_OfClassPattern.3
+CATLINKS+=AG_Object.cat3:AG_OfClassPattern.cat3
+MANLINKS+=AG_Object.3:AG_ClassIsSubclass.3
+CATLINKS+=AG_Object.cat3:AG_ClassIsSubclass.cat3
 MANLINKS+=AG_Object.3:AG_ObjectSuperclass.3
 CATLINKS+=AG_Object.cat3:AG_ObjectSuperclass.cat3
 MANLINKS+=AG_Object.3:AG_ObjectGetInheritHier.3
@@ -271,6 +293,8 @@ MANLINKS+=AG_Timer.3:AG_TimerIsRunning.3
 CATLINKS+=AG_Timer.cat3:AG_TimerIsRunning.cat3
 MANLINKS+=AG_Timer.3:AG_ProcessTimeouts.3
 CATLINKS+=AG_Timer.cat3:AG_ProcessTimeouts.cat3
+MANLINKS+=AG_Timer.3:AG_GetNextTimeout.3
+CATLINKS+=AG_Timer.cat3:AG_GetNextTimeout.cat3
 MANLINKS+=AG_Config.3:AG_ConfigObject.3
 CATLINKS+=AG_Config.cat3:AG_ConfigObject.cat3
 MANLINKS+=AG_Config.3:AG_ConfigLoad.3
@@ -291,6 +315,8 @@ MANLINKS+=AG_DataSource.3:AG_OpenFile.3
 CATLINKS+=AG_DataSource.cat3:AG_OpenFile.cat3
 MANLINKS+=AG_DataSource.3:AG_OpenFileHandle.3
 CATLINKS+=AG_DataSource.cat3:AG_OpenFileHandle.cat3
+MANLINKS+=AG_DataSource.3:AG_OpenFileMapped.3
+CATLINKS+=AG_DataSource.cat3:AG_OpenFileMapped.cat3
 MANLINKS+=AG_DataSource.3:AG_OpenCore.3
 CATLINKS+=AG_DataSource.cat3:AG_OpenCore.cat3
 MANLINKS+=AG_DataSource.3:AG_OpenConstCore.3
@@ -313,6 +339,8 @@ MANLINKS+=AG_DataSource.3:AG_ReadP.3
 CATLINKS+=AG_DataSource.cat3:AG_ReadP.cat3
 MANLINKS+=AG_DataSource.3:AG_ReadAtP.3
 CATLINKS+=AG_DataSource.cat3:AG_ReadAtP.cat3
+MANLINKS+=AG_DataSource.3:AG_ReadPtr.3
+CATLINKS+=AG_DataSource.cat3:AG_ReadPtr.cat3
 MANLINKS+=AG_DataSource.3:AG_WriteP.3
 CATLINKS+=AG_DataSource.cat3:AG_WriteP.cat3
 MANLINKS+=AG_DataSource.3:AG_WriteAtP.3
@@ -325,6 +353,8 @@ MANLINKS+=AG_DataSource.3:AG_LockDataSource.3
 CATLINKS+=AG_DataSource.cat3:AG_LockDataSource.cat3
 MANLINKS+=AG_DataSource.3:AG_UnlockDataSource.3
 CATLINKS+=AG_DataSource.cat3:AG_UnlockDataSource.cat3
+MANLINKS+=AG_DataSource.3:AG_DataSourceSetUnlocked.3
+CATLINKS+=AG_DataSource.cat3:AG_DataSourceSetUnlocked.cat3
 MANLINKS+=AG_DataSource.3:AG_SetByteOrder.3
 CATLINKS+=AG_DataSource.cat3:AG_SetByteOrder.cat3
 MANLINKS+=AG_DataSource.3:AG_SetSourceDebug.3
@@ -825,6 +855,8 @@ MANLINKS+=AG_List.3:AG_ListClear.3
 CATLINKS+=AG_List.cat3:AG_ListClear.cat3
 MANLINKS+=AG_Variable.3:AG_Defined.3
 CATLINKS+=AG_Variable.cat3:AG_Defined.cat3
+MANLINKS+=AG_Variable.3:AG_ObjectFindVariable.3
+CATLINKS+=AG_Variable.cat3:AG_ObjectFindVariable.cat3
 MANLINKS+=AG_Variable.3:AG_GetVariable.3
 CATLINKS+=AG_Variable.cat3:AG_GetVariable.cat3
 MANLINKS+=AG_Variable.3:AG_GetVariableLocked.3
@@ -1303,6 +1335,12 @@ MANLINKS+=AG_EventLoop.3:AG_Terminate.3
 CATLINKS+=AG_EventLoop.cat3:AG_Terminate.cat3
 MANLINKS+=AG_EventLoop.3:AG_TerminateEv.3
 CATLINKS+=AG_EventLoop.cat3:AG_TerminateEv.cat3
+MANLINKS+=AG_EventLoop.3:AG_WakeupEventLoop.3
+CATLINKS+=AG_EventLoop.cat3:AG_WakeupEventLoop.cat3
+MANLINKS+=AG_EventLoop.3:AG_SetWakeupCallback.3
+CATLINKS+=AG_EventLoop.cat3:AG_SetWakeupCallback.cat3
+MANLINKS+=AG_EventLoop.3:AG_GetEventSourceTimeout.3
+CATLINKS+=AG_EventLoop.cat3:AG_GetEventSourceTimeout.cat3
 MANLINKS+=AG_EventLoop.3:AG_AddEventSink.3
 CATLINKS+=AG_EventLoop.cat3:AG_AddEventSink.cat3
 MANLINKS+=AG_EventLoop.3:AG_DelEventSink.3
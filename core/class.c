@@ -43,6 +43,72 @@ char           **agModuleDirs = NULL;		/* Module search directories */
 int              agModuleDirCount = 0;
 AG_Mutex	 agClassLock;			/* Lock on class table */
 
+/*
+ * Class patterns passed to AG_OfClass() are compiled on first use and
+ * cached per thread, keyed by the address of the pattern string. The
+ * caches are flushed whenever a class is registered or unregistered.
+ */
+#define AG_CLASS_PATTERN_CACHE 64		/* Entries (power of 2) */
+
+typedef struct ag_class_pattern_cache {
+	Uint gen;				/* Class table generation */
+	const char *key[AG_CLASS_PATTERN_CACHE];
+	AG_ClassPattern ent[AG_CLASS_PATTERN_CACHE];
+} AG_ClassPatternCache;
+
+static Uint agClassCount = 0;			/* Last allocated class ID */
+static volatile Uint agClassGen = 0;		/* Class table generation */
+static const AG_ClassPattern agClassPatternNone = {
+	AG_CLASS_PATTERN_NONE, NULL, ""
+};
+#ifdef AG_THREADS
+static AG_ThreadKey agClassPatternKey;		/* Pattern cache (per thread) */
+#else
+static AG_ClassPatternCache *agClassPatternCache = NULL;
+#endif
+
+static void
+DestroyClassPatternCache(void *pc)
+{
+	Free(pc);
+}
+
+/*
+ * Set up the class ID, depth and ancestor list of a class whose
+ * superclass (if any) is already set up.
+ */
+static void
+InitClassAncestors(AG_ObjectClass *cl, AG_ObjectClass *clSuper)
+{
+	if (clSuper != NULL) {
+		cl->id = ++agClassCount;
+		cl->depth = clSuper->depth+1;
+	} else {
+		cl->id = 0;
+		cl->depth = 0;
+	}
+	cl->supers = Malloc((cl->depth+1)*sizeof(AG_ObjectClass *));
+	if (clSuper != NULL) {
+		memcpy(cl->supers, clSuper->supers,
+		    cl->depth*sizeof(AG_ObjectClass *));
+	}
+	cl->supers[cl->depth] = cl;
+	AG_AtomicIncUint(&agClassGen);
+}
+
+static void
+FreeClassAncestors(AG_ObjectClass *cl)
+{
+	AG_ObjectClass *clSub;
+
+	TAILQ_FOREACH(clSub, &cl->sub, subclasses) {
+		FreeClassAncestors(clSub);
+	}
+	Free(cl->supers);
+	cl->supers = NULL;
+	cl->depth = 0;
+}
+
 static void
 InitClass(AG_ObjectClass *cl, const char *hier, const char *libs)
 {
@@ -79,6 +145,8 @@ AG_InitClassTbl(void)
 	/* Initialize the class tree */
 	InitClass(&agObjectClass, "AG_Object", "");
 	agClassTree = &agObjectClass;
+	agClassCount = 0;
+	InitClassAncestors(&agObjectClass, NULL);
 
 	/* Initialize the class table. */
 	agClassTbl = AG_TblNew(256, 0);
@@ -87,6 +155,9 @@ AG_InitClassTbl(void)
 		AG_FatalError(NULL);
 
 	AG_MutexInitRecursive(&agClassLock);
+#ifdef AG_THREADS
+	AG_ThreadKeyCreate(&agClassPatternKey, DestroyClassPatternCache);
+#endif
 }
 
 /*
@@ -106,7 +177,17 @@ AG_DestroyClassTbl(void)
 	agModuleDirs = NULL;
 	agModuleDirCount = 0;
 
+	FreeClassAncestors(agClassTree);
 	agClassTree = NULL;
+	AG_AtomicIncUint(&agClassGen);
+#ifdef AG_THREADS
+	DestroyClassPatternCache(AG_ThreadKeyGet(agClassPatternKey));
+	AG_ThreadKeySet(agClassPatternKey, NULL);
+	AG_ThreadKeyDelete(agClassPatternKey);
+#else
+	DestroyClassPatternCache(agClassPatternCache);
+	agClassPatternCache = NULL;
+#endif
 	
 	AG_TblDestroy(agClassTbl);
 	free(agClassTbl); agClassTbl = NULL;
@@ -244,6 +325,7 @@ AG_RegisterClass(void *p)
 		cl->super = agClassTree;			/* Root */
 	}
 	TAILQ_INSERT_TAIL(&cl->super->sub, cl, subclasses);
+	InitClassAncestors(cl, cl->super);
 
 	/* Insert into the class table. */
 	AG_InitPointer(&V, cl);
@@ -269,6 +351,10 @@ AG_UnregisterClass(void *p)
 		/* Remove from the class tree. */
 		TAILQ_REMOVE(&clSuper->sub, cl, subclasses);
 		cl->super = NULL;
+		Free(cl->supers);
+		cl->supers = NULL;
+		cl->depth = 0;
+		AG_AtomicIncUint(&agClassGen);
 
 		/* Remove from the class table. */
 		AG_TblDeleteHash(agClassTbl, h, cl->hier);
@@ -523,6 +609,171 @@ AG_ClassIsNamedGeneral(const AG_ObjectClass *cl, const char *cn)
 	return (1);
 }
 
+/* Match a class against a pattern string (see AG_ClassIsNamed()). */
+int
+AG_ClassMatchPatternString(const AG_ObjectClass *cls, const AG_ClassPattern *cp)
+{
+	const char *pat = cp->pat, *c;
+	int nwild = 0;
+	size_t patSize;
+
+	for (c = &pat[0]; *c != '\0'; c++) {
+		if (*c == '*')
+			nwild++;
+	}
+	if (nwild == 0) {
+		return (strcmp(cls->hier, pat) == 0);
+	} else if (nwild == 1) {
+		if (pat[strlen(pat)-1] == '*') {
+			for (c = &pat[0]; *c != '\0'; c++) {
+				if (c[0] != ':' || c[1] != '*' || c[2] != '\0')
+					continue;
+			
+				patSize = c - &pat[0];
+				if (c == &pat[0]) {
+					return (1);
+				}
+				if (!strncmp(cls->hier, pat, patSize) &&
+				    (cls->hier[patSize] == ':' ||
+				     cls->hier[patSize] == '\0')) {
+					return (1);
+				}
+			}
+		} else if (pat[0] == '*') {
+			return (1);
+		} else {
+			return AG_ClassIsNamedGeneral(cls, pat);
+		}
+		return (0);
+	}
+	return AG_ClassIsNamedGeneral(cls, pat);	/* General case */
+}
+
+/*
+ * Return 1 if the hierarchy string of a class begins with that of the
+ * given superclass (see AG_ClassIsSubclass()).
+ */
+int
+AG_ClassIsSubclassString(const AG_ObjectClass *cls, const AG_ObjectClass *sup)
+{
+	size_t len;
+
+	if (sup == &agObjectClass) {
+		return (1);
+	}
+	len = strlen(sup->hier);
+	return (strncmp(cls->hier, sup->hier, len) == 0 &&
+	        (cls->hier[len] == ':' || cls->hier[len] == '\0'));
+}
+
+/*
+ * Compile a class pattern. Patterns of the form "AG_Foo:AG_Bar" and
+ * "AG_Foo:AG_Bar:*" naming a registered class are reduced to a class
+ * pointer; other patterns are matched as strings. Patterns longer than
+ * AG_OBJECT_HIER_MAX-1 characters match no class.
+ */
+void
+AG_CompileClassPattern(AG_ClassPattern *cp, const char *pat)
+{
+	char hier[AG_OBJECT_HIER_MAX];
+	AG_Variable *V;
+	const char *c;
+	size_t len;
+	int nwild = 0;
+
+	Strlcpy(cp->pat, pat, sizeof(cp->pat));
+	cp->cls = NULL;
+
+	for (c = &pat[0]; *c != '\0'; c++) {
+		if (*c == '*')
+			nwild++;
+	}
+	len = c - &pat[0];
+	if (len >= sizeof(cp->pat)) {
+		cp->type = AG_CLASS_PATTERN_NONE;	/* Too long */
+		return;
+	}
+	if (nwild == 0) {
+		cp->type = AG_CLASS_PATTERN_EXACT;
+		Strlcpy(hier, pat, sizeof(hier));
+	} else if (nwild == 1 && pat[len-1] == '*') {
+		if (len < 2 || pat[len-2] != ':') {
+			cp->type = AG_CLASS_PATTERN_NONE;
+			return;
+		}
+		if (len == 2) {
+			cp->type = AG_CLASS_PATTERN_ANY;	/* ":*" */
+			return;
+		}
+		cp->type = AG_CLASS_PATTERN_SUBCLASS;
+		Strlcpy(hier, pat, MIN(len-1, sizeof(hier)));
+	} else if (nwild == 1 && pat[0] == '*') {
+		cp->type = AG_CLASS_PATTERN_ANY;
+		return;
+	} else {
+		cp->type = AG_CLASS_PATTERN_STRING;
+		return;
+	}
+	if (agClassTbl == NULL) {
+		cp->type = AG_CLASS_PATTERN_STRING;
+		return;
+	}
+
+	AG_MutexLock(&agClassLock);
+	if ((V = AG_TblLookup(agClassTbl, hier)) != NULL) {
+		cp->cls = (AG_ObjectClass *)V->data.p;
+		if (cp->cls == agClassTree) {
+			/* Only AG_Object itself has an "AG_Object" prefix. */
+			cp->type = AG_CLASS_PATTERN_EXACT;
+		}
+	} else {
+		cp->type = AG_CLASS_PATTERN_STRING;
+	}
+	AG_MutexUnlock(&agClassLock);
+}
+
+/*
+ * Return the compiled form of a class pattern, compiling it on first use.
+ * The result remains valid until the next AG_LookupClassPattern() call
+ * from the same thread.
+ */
+const AG_ClassPattern *
+AG_LookupClassPattern(const char *pat)
+{
+	AG_ClassPatternCache *pc;
+	AG_ClassPattern *cp;
+	size_t v = (size_t)pat;
+	Uint i, gen = AG_AtomicGetUint(&agClassGen);
+
+#ifdef AG_THREADS
+	if ((pc = AG_ThreadKeyGet(agClassPatternKey)) == NULL) {
+		pc = Malloc(sizeof(AG_ClassPatternCache));
+		pc->gen = gen-1;
+		AG_ThreadKeySet(agClassPatternKey, pc);
+	}
+#else
+	if ((pc = agClassPatternCache) == NULL) {
+		pc = agClassPatternCache = Malloc(sizeof(AG_ClassPatternCache));
+		pc->gen = gen-1;
+	}
+#endif
+	if (pc->gen != gen) {
+		memset(pc->key, 0, sizeof(pc->key));
+		pc->gen = gen;
+	}
+	i = (Uint)((v >> 3) ^ (v >> 9)) & (AG_CLASS_PATTERN_CACHE-1);
+	cp = &pc->ent[i];
+	if (pc->key[i] == pat && strcmp(cp->pat, pat) == 0) {
+		return (cp);
+	}
+	if (strlen(pat) >= sizeof(cp->pat)) {
+		return (&agClassPatternNone);		/* Too long to cache */
+	}
+	AG_CompileClassPattern(cp, pat);
+	pc->key[i] = pat;
+	return (cp);
+}
+
 /*
  * Return an array of class structures describing the inheritance
  * hierarchy of an object.
@@ -40,8 +40,23 @@ typedef struct ag_object_class {
 	AG_TAILQ_HEAD_(ag_object_class) sub;		/* Direct subclasses */
 	AG_TAILQ_ENTRY(ag_object_class) subclasses;	/* Subclass entry */
 	struct ag_object_class *super;			/* Superclass */
+	Uint id;					/* Class ID (dense) */
+	Uint depth;					/* Depth in class tree */
+	struct ag_object_class **supers;		/* Ancestors (by depth) */
 } AG_ObjectClass;
 
+/* Compiled class pattern (see AG_CompileClassPattern()). */
+typedef struct ag_class_pattern {
+	int type;
+#define AG_CLASS_PATTERN_NONE	  0		/* Matches no class */
+#define AG_CLASS_PATTERN_ANY	  1		/* Matches any class */
+#define AG_CLASS_PATTERN_EXACT	  2		/* Matches cls only */
+#define AG_CLASS_PATTERN_SUBCLASS 3		/* Matches cls and subclasses */
+#define AG_CLASS_PATTERN_STRING	  4		/* Match hierarchy strings */
+	AG_ObjectClass *cls;			/* Resolved class */
+	char pat[AG_OBJECT_HIER_MAX];		/* Pattern string */
+} AG_ClassPattern;
+
 #ifdef AG_DEBUG
 # define AG_ASSERT_CLASS(obj,class) \
 	if (!AG_OfClass((obj),(class))) \
@@ -74,6 +89,10 @@ void AG_UnregisterClass(void *);
 int  AG_ParseClassSpec(struct ag_object_class_spec *, const char *);
 int  AG_OfClassGeneral(const struct ag_object *, const char *);
 int  AG_ClassIsNamedGeneral(const AG_ObjectClass *, const char *);
+void AG_CompileClassPattern(AG_ClassPattern *, const char *);
+const AG_ClassPattern *AG_LookupClassPattern(const char *);
+int  AG_ClassMatchPatternString(const AG_ObjectClass *, const AG_ClassPattern *);
+int  AG_ClassIsSubclassString(const AG_ObjectClass *, const AG_ObjectClass *);
 int  AG_ObjectGetInheritHier(void *, AG_ObjectClass ***, int *);
 
 /* Return description for the given namespace. */
@@ -90,45 +109,59 @@ AG_GetNamespace(const char *ns)
 	return (NULL);
 }
 
-/* Compare the inheritance hierarchy of a class against a given pattern. */
+/*
+ * Return 1 if a class is the given class or one of its subclasses.
+ * The ancestors of a registered class are indexed by depth; classes
+ * that were never registered are compared by hierarchy string.
+ */
 static __inline__ int
-AG_ClassIsNamed(void *pClass, const char *pat)
+AG_ClassIsSubclass(const void *pClass, const void *pSuper)
 {
-	AG_ObjectClass *cls = (AG_ObjectClass *)pClass;
-	const char *c;
-	int nwild = 0;
-	size_t patSize;
-
-	for (c = &pat[0]; *c != '\0'; c++) {
-		if (*c == '*')
-			nwild++;
+	const AG_ObjectClass *cls = (const AG_ObjectClass *)pClass;
+	const AG_ObjectClass *sup = (const AG_ObjectClass *)pSuper;
+
+	if (cls == sup) {
+		return (1);
+	}
+	if (cls->supers == NULL || sup->supers == NULL) {
+		return AG_ClassIsSubclassString(cls, sup);
 	}
-	if (nwild == 0) {
-		return (strcmp(cls->hier, pat) == 0);
-	} else if (nwild == 1) {
-		if (pat[strlen(pat)-1] == '*') {
-			for (c = &pat[0]; *c != '\0'; c++) {
-				if (c[0] != ':' || c[1] != '*' || c[2] != '\0')
-					continue;
-			
-				patSize = c - &pat[0];
-				if (c == &pat[0]) {
-					return (1);
-				}
-				if (!strncmp(cls->hier, pat, patSize) &&
-				    (cls->hier[patSize] == ':' ||
-				     cls->hier[patSize] == '\0')) {
-					return (1);
-				}
-			}
-		} else if (pat[0] == '*') {
-			return (1);
-		} else {
-			return AG_ClassIsNamedGeneral(cls, pat);
+	return (cls->depth > sup->depth && cls->supers[sup->depth] == sup);
+}
+
+/* Evaluate a compiled class pattern against a class. */
+static __inline__ int
+AG_ClassMatchPattern(const void *pClass, const AG_ClassPattern *cp)
+{
+	const AG_ObjectClass *cls = (const AG_ObjectClass *)pClass;
+
+	switch (cp->type) {
+	case AG_CLASS_PATTERN_ANY:
+		return (1);
+	case AG_CLASS_PATTERN_EXACT:
+		if (cls->supers == NULL) {
+			return AG_ClassMatchPatternString(cls, cp);
+		}
+		return (cls == cp->cls);
+	case AG_CLASS_PATTERN_SUBCLASS:
+		if (cls->supers == NULL) {
+			return AG_ClassMatchPatternString(cls, cp);
 		}
-		return (0);
+		return AG_ClassIsSubclass(cls, cp->cls);
+	case AG_CLASS_PATTERN_STRING:
+		return AG_ClassMatchPatternString(cls, cp);
 	}
-	return AG_ClassIsNamedGeneral(cls, pat);	/* General case */
+	return (0);
+}
+
+/*
+ * Compare the inheritance hierarchy of a class against a given pattern.
+ * The pattern is compiled on first use and cached.
+ */
+static __inline__ int
+AG_ClassIsNamed(void *pClass, const char *pat)
+{
+	return AG_ClassMatchPattern(pClass, AG_LookupClassPattern(pat));
 }
 __END_DECLS
 
@@ -63,6 +63,7 @@
 #ifdef AG_THREADS
 pthread_mutexattr_t agRecursiveMutexAttr;	/* Recursive mutex attributes */
 AG_Thread agEventThread;			/* Event-processing thread */
+AG_Mutex agAtomicLock = AG_MUTEX_INITIALIZER;	/* For AG_Atomic*() fallback */
 #endif
 
 AG_Config *agConfig;				/* Global Agar config data */
@@ -30,6 +30,7 @@
 #include <agar/config/have_altivec.h>
 #include <agar/config/_mk_have_signal.h>
 #include <agar/config/_mk_have_setjmp.h>
+#include <agar/config/_mk_have_unistd_h.h>
 
 #include <agar/core/core.h>
 
@@ -38,12 +39,18 @@
 # if defined(__ppc__) && !defined(MAC_OS_X_VERSION_10_4)
 #  include <sys/sysctl.h>
 # endif
+#elif defined(_WIN32)
+# include <agar/core/win32.h>
 #elif defined(__AMIGAOS4__)
 # include <exec/exec.h>
 # include <interfaces/exec.h>
 # include <proto/exec.h>
 #endif
 
+#if defined(_MK_HAVE_UNISTD_H) && !defined(_WIN32)
+# include <unistd.h>
+#endif
+
 #if !defined(__APPLE__) && !defined(__MACOSX__) && !defined(__ppc__) && \
      defined(HAVE_ALTIVEC) && defined(_MK_HAVE_SIGNAL) && defined(_MK_HAVE_SETJMP)
 # include <signal.h>
@@ -149,6 +156,25 @@ IllegalInsn(int sig)
 }
 #endif
 
+/* Return the number of online processors (or 1 if unknown). */
+static int
+GetNumCPUs(void)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+	SYSTEM_INFO si;
+
+	GetSystemInfo(&si);
+	return (si.dwNumberOfProcessors > 0) ? (int)si.dwNumberOfProcessors : 1;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	long n;
+
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (int)n : 1;
+#else
+	return (1);
+#endif
+}
+
 /* Initialize the CPUInfo structure. */
 void
 AG_GetCPUInfo(AG_CPUInfo *cpu)
@@ -159,6 +185,7 @@ AG_GetCPUInfo(AG_CPUInfo *cpu)
 #endif
 
 	cpu->vendorID[0] = '\0';
+	cpu->nCPUs = GetNumCPUs();
 	cpu->ext = 0;
 
 #if defined(__alpha__)
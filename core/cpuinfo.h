@@ -7,6 +7,7 @@
 typedef struct ag_cpuinfo {
 	const char *arch;		/* Architecture name */
 	char vendorID[13];		/* CPU Vendor ID string */
+	int nCPUs;			/* Number of online processors */
 	Uint32 ext;			/* Architecture extensions
 					   (relevant to user-mode) */
 #define AG_EXT_CPUID		0x00000001 /* CPUID Instruction */
@@ -33,6 +33,18 @@
 #include <string.h>
 #include <stdarg.h>
 
+#include <agar/config/have_mmap.h>
+#ifdef HAVE_MMAP
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <errno.h>
+#endif
+
+#define CORE_AUTO_MINALLOC 256	/* Initial allocation of auto core sources */
+
 static AG_Object errorMgr;
 
 void
@@ -84,6 +96,16 @@ AG_DataSourceSetDebug(AG_DataSource *ds, int flag)
 	ds->debug = flag;
 }
 
+/*
+ * Disable locking of a data source which is only ever accessed by a single
+ * thread (such as a file opened to load an object).
+ */
+void
+AG_DataSourceSetUnlocked(AG_DataSource *ds, int flag)
+{
+	AG_SETFLAGS(ds->flags, AG_DATA_SOURCE_UNLOCKED, flag);
+}
+
 /* Write type identifier for type safety checks. */
 void
 AG_WriteTypeCode(AG_DataSource *ds, Uint32 type)
@@ -274,11 +296,11 @@ AG_CloseFile(AG_DataSource *ds)
 static __inline__ int
 CoreLimitBounds(AG_CoreSource *cs, off_t pos, size_t sizeReq, size_t *size)
 {
-	if (pos+sizeReq > cs->size) {
-		*size = cs->size - cs->offs;
-	} else {
-		*size = sizeReq;
+	if (pos < 0 || (size_t)pos > cs->size) {
+		AG_SetError("Bad offset %ld", (long)pos);
+		return (-1);
 	}
+	*size = MIN(sizeReq, cs->size - (size_t)pos);
 	return (0);
 }
 static int
@@ -308,6 +330,21 @@ CoreReadAt(AG_DataSource *ds, void *buf, size_t sizeReq, off_t pos, size_t *rv)
 	*rv = size;
 	return (0);
 }
+static const void *
+CoreReadPtr(AG_DataSource *ds, size_t sizeReq, size_t *rv)
+{
+	AG_CoreSource *cs = AG_CORE_SOURCE(ds);
+	const Uint8 *p;
+	size_t size;
+
+	if (CoreLimitBounds(cs, cs->offs, sizeReq, &size) == -1) {
+		return (NULL);
+	}
+	p = &cs->data[cs->offs];
+	*rv = size;
+	cs->offs += size;
+	return (p);
+}
 static int
 CoreWrite(AG_DataSource *ds, const void *buf, size_t sizeReq, size_t *rv)
 {
@@ -322,21 +359,40 @@ CoreWrite(AG_DataSource *ds, const void *buf, size_t sizeReq, size_t *rv)
 	cs->offs += size;
 	return (0);
 }
+/* Grow an auto core buffer geometrically to at least sizeReq bytes. */
+static int
+CoreAutoGrow(AG_CoreSource *cs, size_t sizeReq)
+{
+	Uint8 *dataNew;
+	size_t allocNew;
+
+	if (sizeReq <= cs->alloc) {
+		return (0);
+	}
+	allocNew = MAX(cs->alloc*2, CORE_AUTO_MINALLOC);
+	if (allocNew < sizeReq) {
+		allocNew = sizeReq;
+	}
+	if ((dataNew = TryRealloc(cs->data, allocNew)) == NULL) {
+		return (-1);
+	}
+	cs->data = dataNew;
+	cs->alloc = allocNew;
+	return (0);
+}
 static int
 CoreAutoWrite(AG_DataSource *ds, const void *buf, size_t size, size_t *rv)
 {
 	AG_CoreSource *cs = AG_CORE_SOURCE(ds);
-	Uint8 *dataNew;
 
-	if (cs->offs+size > cs->size) {
-		if ((dataNew = TryRealloc(cs->data, (cs->offs+size))) == NULL) {
-			return (-1);
-		}
-		cs->data = dataNew;
+	if (CoreAutoGrow(cs, cs->offs+size) == -1) {
+		return (-1);
 	}
 	memcpy(&cs->data[cs->offs], buf, size);
-	cs->size += size;
 	cs->offs += size;
+	if ((size_t)cs->offs > cs->size) {
+		cs->size = cs->offs;
+	}
 	*rv = size;
 	return (0);
 }
@@ -359,20 +415,18 @@ CoreAutoWriteAt(AG_DataSource *ds, const void *buf, size_t size, off_t pos,
     size_t *rv)
 {
 	AG_CoreSource *cs = AG_CORE_SOURCE(ds);
-	Uint8 *dataNew;
 
 	if (pos < 0) {
 		AG_SetError("Bad offset");
 		return (-1);
 	}
+	if (CoreAutoGrow(cs, pos+size) == -1) {
+		return (-1);
+	}
+	memcpy(&cs->data[pos], buf, size);
 	if (pos+size > cs->size) {
-		if ((dataNew = TryRealloc(cs->data, (pos+size))) == NULL) {
-			return (-1);
-		}
-		cs->data = dataNew;
 		cs->size = pos+size;
 	}
-	memcpy(&cs->data[pos], buf, size);
 	*rv = size;
 	return (0);
 }
@@ -399,7 +453,7 @@ CoreSeek(AG_DataSource *ds, off_t offs, enum ag_seek_mode mode)
 		nOffs = cs->size - offs;
 		break;
 	}
-	if (nOffs < 0 || nOffs >= cs->size) {
+	if (nOffs < 0 || (size_t)nOffs > cs->size) {
 		AG_SetError("Bad offset %ld", (long)nOffs);
 		return (-1);
 	}
@@ -418,6 +472,67 @@ AG_CloseAutoCore(AG_DataSource *ds)
 	AG_DataSourceDestroy(ds);
 }
 
+/*
+ * Memory-mapped file operations. The layout of AG_FileMappedSource matches
+ * that of AG_CoreSource, so the read, tell and seek operations are shared.
+ */
+void
+AG_CloseFileMapped(AG_DataSource *ds)
+{
+	AG_FileMappedSource *fs = AG_FILE_MAPPED_SOURCE(ds);
+
+#ifdef HAVE_MMAP
+	if (fs->mapped) {
+		munmap((void *)fs->data, fs->size);
+	} else
+#endif
+	{
+		Free((void *)fs->data);
+	}
+	Free(fs->path);
+	AG_DataSourceDestroy(ds);
+}
+
+/* Read the whole file into memory (if mmap(2) is unavailable or fails). */
+static int
+FileMappedReadAll(AG_FileMappedSource *fs)
+{
+	FILE *f;
+	Uint8 *data = NULL, *dataNew;
+	size_t size = 0, alloc = 0, rv;
+
+	if ((f = fopen(fs->path, "rb")) == NULL) {
+		AG_SetError(_("Unable to open %s"), fs->path);
+		return (-1);
+	}
+	for (;;) {
+		if (size == alloc) {
+			alloc = MAX(alloc*2, 4096);
+			if ((dataNew = TryRealloc(data, alloc)) == NULL) {
+				goto fail;
+			}
+			data = dataNew;
+		}
+		if ((rv = fread(&data[size], 1, alloc-size, f)) == 0) {
+			if (ferror(f)) {
+				AG_SetError(_("Read error"));
+				goto fail;
+			}
+			break;
+		}
+		size += rv;
+	}
+	fclose(f);
+	fs->data = data;
+	fs->size = size;
+	fs->mapped = 0;
+	return (0);
+fail:
+	Free(data);
+	fclose(f);
+	return (-1);
+}
+
 #ifdef AG_NETWORK
 /*
  * Network socket operations
@@ -452,6 +567,7 @@ ErrorDefault(AG_Event *event)
 void
 AG_DataSourceInit(AG_DataSource *ds)
 {
+	ds->flags = 0;
 	ds->debug = 0;
 	ds->byte_order = AG_BYTEORDER_BE;
 	ds->rdLast = 0;
@@ -465,6 +581,7 @@ AG_DataSourceInit(AG_DataSource *ds)
 	ds->tell = NULL;
 	ds->seek = NULL;
 	ds->close = NULL;
+	ds->read_ptr = NULL;
 	AG_MutexInitRecursive(&ds->lock);
 	AG_DataSourceSetErrorFn(ds, ErrorDefault, "%p", ds);
 }
@@ -530,6 +647,7 @@ AG_OpenCore(void *data, size_t size)
 	cs->data = (Uint8 *)data;
 	cs->size = size;
 	cs->offs = 0;
+	cs->alloc = size;
 	cs->ds.read = CoreRead;
 	cs->ds.read_at = CoreReadAt;
 	cs->ds.write = CoreWrite;
@@ -537,6 +655,7 @@ AG_OpenCore(void *data, size_t size)
 	cs->ds.tell = CoreTell;
 	cs->ds.seek = CoreSeek;
 	cs->ds.close = AG_CloseCore;
+	cs->ds.read_ptr = CoreReadPtr;
 	return (&cs->ds);
 }
 
@@ -560,6 +679,7 @@ AG_OpenConstCore(const void *data, size_t size)
 	cs->ds.tell = CoreTell;
 	cs->ds.seek = CoreSeek;
 	cs->ds.close = AG_CloseCore;
+	cs->ds.read_ptr = CoreReadPtr;
 	return (&cs->ds);
 }
 
@@ -576,6 +696,7 @@ AG_OpenAutoCore(void)
 	cs->data = NULL;
 	cs->size = 0;
 	cs->offs = 0;
+	cs->alloc = 0;
 	cs->ds.read = CoreRead;
 	cs->ds.read_at = CoreReadAt;
 	cs->ds.write = CoreAutoWrite;
@@ -583,9 +704,84 @@ AG_OpenAutoCore(void)
 	cs->ds.tell = CoreTell;
 	cs->ds.seek = CoreSeek;
 	cs->ds.close = AG_CloseAutoCore;
+	cs->ds.read_ptr = CoreReadPtr;
 	return (&cs->ds);
 }
 
+/*
+ * Create a read-only data source from the contents of a file. Where
+ * mmap(2) is available, the file is mapped into memory and read without
+ * any intermediate copy (see AG_ReadPtr()); otherwise it is read whole.
+ *
+ * The mapping is not protected against the file being truncated while
+ * open: accessing pages past the new end raises SIGBUS. Only use this
+ * for files which are not modified while open (e.g., installed data).
+ */
+AG_DataSource *
+AG_OpenFileMapped(const char *path)
+{
+	AG_FileMappedSource *fs;
+#ifdef HAVE_MMAP
+	struct stat sb;
+	void *p;
+	int fd;
+#endif
+
+	if ((fs = TryMalloc(sizeof(AG_FileMappedSource))) == NULL) {
+		return (NULL);
+	}
+	if ((fs->path = TryStrdup(path)) == NULL) {
+		Free(fs);
+		return (NULL);
+	}
+	fs->data = NULL;
+	fs->size = 0;
+	fs->offs = 0;
+	fs->mapped = 0;
+#ifdef HAVE_MMAP
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		AG_SetError(_("Unable to open %s"), path);
+		goto fail;
+	}
+	if (fstat(fd, &sb) == -1) {
+		AG_SetError("%s: %s", path, strerror(errno));
+		close(fd);
+		goto fail;
+	}
+	if (S_ISREG(sb.st_mode) && sb.st_size > 0 &&
+	    (off_t)(size_t)sb.st_size == sb.st_size) {
+		p = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE,
+		    fd, 0);
+		if (p != MAP_FAILED) {
+# ifdef MADV_SEQUENTIAL
+			madvise(p, (size_t)sb.st_size, MADV_SEQUENTIAL);
+# endif
+			fs->data = (const Uint8 *)p;
+			fs->size = (size_t)sb.st_size;
+			fs->mapped = 1;
+		}
+	}
+	close(fd);
+#endif /* HAVE_MMAP */
+	if (!fs->mapped && FileMappedReadAll(fs) == -1)
+		goto fail;
+
+	AG_DataSourceInit(&fs->ds);
+	fs->ds.read = CoreRead;
+	fs->ds.read_at = CoreReadAt;
+	fs->ds.write = WriteNotSup;
+	fs->ds.write_at = WriteAtNotSup;
+	fs->ds.tell = CoreTell;
+	fs->ds.seek = CoreSeek;
+	fs->ds.close = AG_CloseFileMapped;
+	fs->ds.read_ptr = CoreReadPtr;
+	return (&fs->ds);
+fail:
+	Free(fs->path);
+	Free(fs);
+	return (NULL);
+}
+
 #ifdef AG_NETWORK
 /* Create a data source using a network socket. */
 AG_DataSource *
@@ -613,18 +809,18 @@ AG_OpenNetSocket(AG_NetSocket *ns)
 void
 AG_SetByteOrder(AG_DataSource *ds, enum ag_byte_order order)
 {
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	ds->byte_order = order;
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 }
 
 /* Toggle encoding/decoding of debugging data. */
 void
 AG_SetSourceDebug(AG_DataSource *ds, int enable)
 {
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	ds->debug = enable;
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 }
 
 /* Low-level read operation. */
@@ -632,14 +828,14 @@ int
 AG_Read(AG_DataSource *ds, void *ptr, size_t size)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->read(ds, ptr, size, &ds->rdLast);
 	ds->rdTotal += ds->rdLast;
 	if (ds->rdLast < size) {
 		AG_SetError("Short read");
 		rv = -1;
 	}
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
@@ -648,11 +844,11 @@ int
 AG_ReadP(AG_DataSource *ds, void *ptr, size_t size, size_t *nRead)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->read(ds, ptr, size, &ds->rdLast);
 	ds->rdTotal += ds->rdLast;
 	if (nRead != NULL) { *nRead = ds->rdLast; }
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
@@ -661,14 +857,14 @@ int
 AG_ReadAt(AG_DataSource *ds, void *ptr, size_t size, off_t pos)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->read_at(ds, ptr, size, pos, &ds->rdLast);
 	ds->rdTotal += ds->rdLast;
 	if (ds->rdLast < size) {
 		AG_SetError("Short read");
 		rv = -1;
 	}
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
@@ -677,27 +873,53 @@ int
 AG_ReadAtP(AG_DataSource *ds, void *ptr, size_t size, off_t pos, size_t *nRead)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->read_at(ds, ptr, size, pos, &ds->rdLast);
 	ds->rdTotal += ds->rdLast;
 	if (nRead != NULL) { *nRead = ds->rdLast; }
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
+/*
+ * Zero-copy read operation for memory-backed sources. Return a pointer to
+ * the next size bytes and advance the position, or NULL on failure. The
+ * data remains valid until the source is written to or closed.
+ */
+const void *
+AG_ReadPtr(AG_DataSource *ds, size_t size)
+{
+	const void *p;
+
+	if (ds->read_ptr == NULL) {
+		AG_SetError(_("Operation not supported"));
+		return (NULL);
+	}
+	AG_LockDataSource(ds);
+	if ((p = ds->read_ptr(ds, size, &ds->rdLast)) != NULL) {
+		ds->rdTotal += ds->rdLast;
+		if (ds->rdLast < size) {
+			AG_SetError("Short read");
+			p = NULL;
+		}
+	}
+	AG_UnlockDataSource(ds);
+	return (p);
+}
+
 /* Low-level write operation. */
 int
 AG_Write(AG_DataSource *ds, const void *ptr, size_t size)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->write(ds, ptr, size, &ds->wrLast);
 	ds->wrTotal += ds->wrLast;
 	if (ds->wrLast < size) {
 		AG_SetError("Short write");
 		rv = -1;
 	}
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
@@ -706,11 +928,11 @@ int
 AG_WriteP(AG_DataSource *ds, const void *ptr, size_t size, size_t *nWrote)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->write(ds, ptr, size, &ds->wrLast);
 	ds->wrTotal += ds->wrLast;
 	if (nWrote != NULL) { *nWrote = ds->wrLast; }
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
@@ -719,14 +941,14 @@ int
 AG_WriteAt(AG_DataSource *ds, const void *ptr, size_t size, off_t pos)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->write_at(ds, ptr, size, pos, &ds->wrLast);
 	ds->wrTotal += ds->wrLast;
 	if (ds->wrLast < size) {
 		AG_SetError("Short write");
 		rv = -1;
 	}
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
@@ -735,11 +957,11 @@ int
 AG_WriteAtP(AG_DataSource *ds, const void *ptr, size_t size, off_t pos, size_t *nWrote)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->write_at(ds, ptr, size, pos, &ds->wrLast);
 	ds->wrTotal += ds->wrLast;
 	if (nWrote != NULL) { *nWrote = ds->wrLast; }
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 
@@ -43,6 +43,8 @@ enum ag_data_source_type {
 /* Generic data source object */
 typedef struct ag_data_source {
 	AG_Mutex lock;				/* Lock on all operations */
+	Uint flags;
+#define AG_DATA_SOURCE_UNLOCKED	0x01		/* Single owner; skip locking */
 	int debug;
 	struct ag_event *errorFn;		/* Exception handler */
 	enum ag_byte_order byte_order;		/* Byte order of source */
@@ -58,6 +60,7 @@ typedef struct ag_data_source {
 	off_t (*tell)(struct ag_data_source *);
 	int   (*seek)(struct ag_data_source *, off_t, enum ag_seek_mode);
 	void  (*close)(struct ag_data_source *);
+	const void *(*read_ptr)(struct ag_data_source *, size_t, size_t *);
 } AG_DataSource;
 
 /* File */
@@ -73,6 +76,7 @@ typedef struct ag_core_source {
 	Uint8 *data;			/* Pointer to data */
 	size_t size;			/* Current size */
 	off_t  offs;			/* Current position */
+	size_t alloc;			/* Allocated size (auto core) */
 } AG_CoreSource;
 
 /* Memory region (const) */
@@ -83,6 +87,16 @@ typedef struct ag_const_core_source {
 	off_t  offs;			/* Current position */
 } AG_ConstCoreSource;
 
+/* Memory-mapped file (read-only) */
+typedef struct ag_file_mapped_source {
+	struct ag_data_source ds;
+	const Uint8 *data;		/* Mapped file contents */
+	size_t size;			/* File size */
+	off_t  offs;			/* Current position */
+	char *path;			/* Open file path */
+	int mapped;			/* Data is mmap(2)ed (not malloc'd) */
+} AG_FileMappedSource;
+
 /* Network socket */
 typedef struct ag_net_socket_source {
 	struct ag_data_source ds;
@@ -93,6 +107,7 @@ typedef struct ag_net_socket_source {
 #define AG_FILE_SOURCE(ds) ((AG_FileSource *)(ds))
 #define AG_CORE_SOURCE(ds) ((AG_CoreSource *)(ds))
 #define AG_CONST_CORE_SOURCE(ds) ((AG_ConstCoreSource *)(ds))
+#define AG_FILE_MAPPED_SOURCE(ds) ((AG_FileMappedSource *)(ds))
 #define AG_NET_SOCKET_SOURCE(ds) ((AG_NetSocketSource *)(ds))
 
 __BEGIN_DECLS
@@ -102,6 +117,7 @@ void AG_DataSourceDestroySubsystem(void);
 void AG_DataSourceInit(AG_DataSource *);
 void AG_DataSourceDestroy(AG_DataSource *);
 void AG_DataSourceSetDebug(AG_DataSource *, int);
+void AG_DataSourceSetUnlocked(AG_DataSource *, int);
 void AG_DataSourceSetErrorFn(AG_DataSource *, void (*)(struct ag_event *),
                              const char *, ...);
 void AG_DataSourceError(AG_DataSource *, const char *, ...);
@@ -111,6 +127,7 @@ void AG_CloseDataSource(AG_DataSource *);
 
 AG_DataSource *AG_OpenFile(const char *, const char *);
 AG_DataSource *AG_OpenFileHandle(FILE *);
+AG_DataSource *AG_OpenFileMapped(const char *);
 AG_DataSource *AG_OpenCore(void *, size_t)
                            BOUNDED_ATTRIBUTE(__buffer__,1,2);
 AG_DataSource *AG_OpenConstCore(const void *, size_t)
@@ -124,6 +141,7 @@ int     AG_ReadP(AG_DataSource *, void *, size_t, size_t *)
                  BOUNDED_ATTRIBUTE(__buffer__,2,3);
 int     AG_ReadAt(AG_DataSource *, void *, size_t, off_t);
 int     AG_ReadAtP(AG_DataSource *, void *, size_t, off_t, size_t *);
+const void *AG_ReadPtr(AG_DataSource *, size_t);
 
 int     AG_Write(AG_DataSource *, const void *, size_t)
                  BOUNDED_ATTRIBUTE(__buffer__,2,3);
@@ -134,6 +152,7 @@ int     AG_WriteAtP(AG_DataSource *, const void *, size_t, off_t, size_t *);
 
 void    AG_CloseFile(AG_DataSource *);
 #define AG_CloseFileHandle(ds) AG_CloseFile(ds)
+void    AG_CloseFileMapped(AG_DataSource *);
 void    AG_CloseCore(AG_DataSource *);
 #define AG_CloseConstCore(ds) AG_CloseCore(ds)
 void    AG_CloseAutoCore(AG_DataSource *);
@@ -144,8 +163,12 @@ void    AG_WriteTypeCodeAt(AG_DataSource *, Uint32, off_t);
 int     AG_WriteTypeCodeE(AG_DataSource *, Uint32);
 int     AG_CheckTypeCode(AG_DataSource *, Uint32);
 
-#define AG_LockDataSource(ds) AG_MutexLock(&(ds)->lock);
-#define AG_UnlockDataSource(ds) AG_MutexUnlock(&(ds)->lock);
+#define AG_LockDataSource(ds) do { \
+	if (!((ds)->flags & AG_DATA_SOURCE_UNLOCKED)) AG_MutexLock(&(ds)->lock); \
+} while (0)
+#define AG_UnlockDataSource(ds) do { \
+	if (!((ds)->flags & AG_DATA_SOURCE_UNLOCKED)) AG_MutexUnlock(&(ds)->lock); \
+} while (0)
 
 /* For AG_WriteFooAt() */
 #define AG_WRITEAT_DEBUGOFFS(ds,pos) ((ds)->debug ? (pos)+sizeof(Uint32) : (pos))
@@ -162,6 +185,7 @@ AG_DataSourceRealloc(void *obj, size_t size)
 	}
 	cs->data = dataNew;
 	cs->size = size;
+	cs->alloc = size;
 	return (0);
 }
 
@@ -170,9 +194,9 @@ static __inline__ off_t
 AG_Tell(AG_DataSource *ds)
 {
 	off_t pos;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	pos = (ds->tell != NULL) ? ds->tell(ds) : 0;
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (pos);
 }
 
@@ -181,9 +205,9 @@ static __inline__ int
 AG_Seek(AG_DataSource *ds, off_t pos, enum ag_seek_mode mode)
 {
 	int rv;
-	AG_MutexLock(&ds->lock);
+	AG_LockDataSource(ds);
 	rv = ds->seek(ds, pos, mode);
-	AG_MutexUnlock(&ds->lock);
+	AG_UnlockDataSource(ds);
 	return (rv);
 }
 __END_DECLS
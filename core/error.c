@@ -91,7 +91,13 @@ AG_DestroyErrorSubsystem(void)
 #if defined(_WIN32) && defined(USE_WIN32_CONSOLE)
 	FreeConsole();
 #endif
+#ifdef AG_THREADS
+	/* agErrorMsg may belong to another thread; free our own message. */
+	Free(AG_ThreadKeyGet(agErrorMsgKey));
+	AG_ThreadKeySet(agErrorMsgKey, NULL);
+#else
 	Free(agErrorMsg);
+#endif
 	agErrorMsg = NULL;
 	agErrorCode = AG_EUNDEFINED;
 #ifdef AG_THREADS
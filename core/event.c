@@ -32,9 +32,11 @@
 
 #include <string.h>
 #include <stdarg.h>
+#include <stddef.h>
 
 #include <agar/config/have_kqueue.h>
 #include <agar/config/have_timerfd.h>
+#include <agar/config/have_epoll.h>
 #include <agar/config/have_select.h>
 #include <agar/config/ag_debug_core.h>
 
@@ -49,8 +51,16 @@
 #endif
 #if defined(HAVE_TIMERFD)
 # include <sys/timerfd.h>
+# include <unistd.h>
 # include <errno.h>
 #endif
+#if defined(HAVE_EPOLL)
+# if defined(HAVE_TIMERFD)
+#  include <sys/epoll.h>
+# else
+#  undef HAVE_EPOLL		/* The timer heap needs a timerfd */
+# endif
+#endif
 #if defined(HAVE_SELECT)
 # include <sys/types.h>
 # include <sys/time.h>
@@ -63,6 +73,11 @@ AG_EventSource *agEventSource = NULL;	/* Event source (thread-local) */
 #ifdef AG_THREADS
 AG_ThreadKey    agEventSourceKey;
 #endif
+#ifdef AG_THREADS
+static AG_Mutex      agWakeupLock;		/* Lock on agWakeupFn */
+static void        (*agWakeupFn)(void) = NULL;	/* Event loop wakeup routine */
+static volatile Uint agWakeupSet = 0;		/* agWakeupFn is non-NULL */
+#endif
 
 #ifdef HAVE_KQUEUE
 #define EVBUFSIZE 2
@@ -76,6 +91,21 @@ typedef struct ag_event_source_kqueue {
 } AG_EventSourceKQUEUE;
 #endif /* HAVE_KQUEUE */
 
+#ifdef HAVE_EPOLL
+#define AG_EPOLL_MAXEVENTS	32		/* Events per epoll_wait() */
+#define AG_TIMER_HEAP_INIT	64		/* Initial timer heap size */
+typedef struct ag_event_source_epoll {
+	struct ag_event_source _inherit;
+	int fd;					/* epoll(7) fd */
+	struct epoll_event events[AG_EPOLL_MAXEVENTS]; /* Input buffer */
+} AG_EventSourceEPOLL;
+
+static AG_Timer **agTimerHeap = NULL;		/* Min-heap of timers */
+static Uint       agTimerHeapCount = 0;
+static Uint       agTimerHeapSize = 0;
+static int        agTimerHeapFd = -1;		/* timerfd for heap root */
+#endif /* HAVE_EPOLL */
+
 /* #define DEBUG_TIMERS */
 
 #ifdef __NetBSD__
@@ -84,17 +114,55 @@ typedef struct ag_event_source_kqueue {
 # define AG_EV_SET(kevp,a,b,c,d,e,f) EV_SET((kevp),(a),(b),(c),(d),(e),(f))
 #endif
 
+/*
+ * Event names are interned to integer atoms. Each object keeps its
+ * event handlers in a hash index keyed by atom, such that dispatching
+ * an event does not involve any string comparisons.
+ *
+ * Lookups are lock-free: a table is never modified once published, except
+ * for empty slots being filled (after the name itself has been stored).
+ * Growing the table publishes a new one; retired tables are kept on a list
+ * until AG_DestroyEventSubsystem() since readers may still be using them.
+ * Insertions are serialized by agEventAtomLock.
+ */
+typedef struct ag_event_atom_tbl {
+	Uint size;			/* Table size (power of 2) */
+	AG_EventAtom *atoms;		/* Atoms (by name hash) */
+	char **names;			/* Interned names (by atom) */
+	struct ag_event_atom_tbl *prev;	/* Retired table */
+} AG_EventAtomTbl;
+
+static AG_EventAtomTbl *volatile agEventAtoms = NULL; /* Current table */
+static Uint agEventAtomCount = 0;		/* Last allocated atom */
+#ifdef AG_THREADS
+static AG_Mutex agEventAtomLock;
+#endif
+
+#define AG_EVENT_ATOM_TBL_INIT	256		/* Initial atom table size */
+#define AG_EVENT_ATOM_NAME_MAX	AG_VARIABLE_NAME_MAX /* Longest event or
+						        argument name (+NUL) */
+#define AG_EVENT_INDEX_INIT	8		/* Initial object index size */
+
 /* Initialize a pointer argument. */
 static __inline__ void
-InitPointerArg(AG_Variable *V, void *p)
+InitPointerArg(AG_EventArg *V, void *p)
 {
-	V->name[0] = '\0';
 	V->type = AG_VARIABLE_POINTER;
-	V->fn.fnVoid = NULL;
-	V->mutex = NULL;
+	V->key = 0;
 	V->data.p = p;
 }
 
+/*
+ * Copy an event and its arguments, including the slot following the last
+ * argument (where the sender pointer goes). Unused slots are not copied.
+ */
+static __inline__ void
+CopyEvent(AG_Event *dst, const AG_Event *src)
+{
+	memcpy(dst, src,
+	    offsetof(AG_Event, argv) + (src->argc+1)*sizeof(AG_EventArg));
+}
+
 static __inline__ void
 InitEvent(AG_Event *ev, AG_Object *ob)
 {
@@ -102,9 +170,243 @@ InitEvent(AG_Event *ev, AG_Object *ob)
 	ev->argc = 1;
 	ev->argc0 = 1;
 	ev->fn.fnVoid = NULL;
+	ev->atom = 0;
+	ev->atomNext = NULL;
 	InitPointerArg(&ev->argv[0], ob);
 }
 
+/* Hash an event name (up to AG_EVENT_ATOM_NAME_MAX-1 characters). */
+static __inline__ Uint
+HashEventName(const char *name)
+{
+	const Uchar *c;
+	Uint h = 2166136261U;
+	int i;
+
+	for (c = (const Uchar *)name, i = 0;
+	     *c != '\0' && i < AG_EVENT_ATOM_NAME_MAX-1;
+	     c++, i++) {
+		h = (h ^ *c) * 16777619U;
+	}
+	return (h);
+}
+
+/* Return the current atom table (or NULL). Safe without locking. */
+static __inline__ AG_EventAtomTbl *
+GetAtomTbl(void)
+{
+	return (AG_EventAtomTbl *)AG_AtomicGetPtr((void *volatile *)&agEventAtoms);
+}
+
+/* Look up an interned event name. Safe without locking. */
+static AG_EventAtom
+LookupAtom(const char *name, Uint h)
+{
+	AG_EventAtomTbl *tbl;
+	Uint i, mask;
+	AG_EventAtom atom;
+
+	if ((tbl = GetAtomTbl()) == NULL) {
+		return (0);
+	}
+	mask = tbl->size - 1;
+	for (i = h & mask;
+	     (atom = AG_AtomicGetUint(&tbl->atoms[i])) != 0;
+	     i = (i+1) & mask) {
+		if (strncmp(tbl->names[atom], name,
+		    AG_EVENT_ATOM_NAME_MAX-1) == 0)
+			return (atom);
+	}
+	return (0);
+}
+
+/*
+ * Publish a new atom table of twice the size. The atom table must be
+ * locked. The old table is retired, not freed.
+ */
+static AG_EventAtomTbl *
+GrowAtomTbl(AG_EventAtomTbl *tblOld)
+{
+	AG_EventAtomTbl *tbl;
+	Uint size = (tblOld != NULL) ? tblOld->size*2 : AG_EVENT_ATOM_TBL_INIT;
+	Uint mask = size - 1, i;
+	AG_EventAtom atom;
+
+	tbl = Malloc(sizeof(AG_EventAtomTbl));
+	tbl->size = size;
+	tbl->atoms = Malloc(size*sizeof(AG_EventAtom));
+	memset(tbl->atoms, 0, size*sizeof(AG_EventAtom));
+	tbl->names = Malloc((size/2 + 1)*sizeof(char *));
+	memset(tbl->names, 0, (size/2 + 1)*sizeof(char *));
+	tbl->prev = tblOld;
+
+	for (atom = 1; atom <= agEventAtomCount; atom++) {
+		tbl->names[atom] = tblOld->names[atom];
+		for (i = HashEventName(tbl->names[atom]) & mask;
+		     tbl->atoms[i] != 0;
+		     i = (i+1) & mask)
+			;;
+		tbl->atoms[i] = atom;
+	}
+	AG_AtomicSetPtr((void *volatile *)&agEventAtoms, tbl);
+	return (tbl);
+}
+
+/*
+ * Return the atom associated with the given event name, allocating a
+ * new one if the name has not been interned yet.
+ */
+AG_EventAtom
+AG_InternEventName(const char *name)
+{
+	AG_EventAtomTbl *tbl;
+	Uint h = HashEventName(name), i, mask;
+	AG_EventAtom atom;
+	char *s;
+
+	if ((atom = LookupAtom(name, h)) != 0)
+		return (atom);
+
+	AG_MutexLock(&agEventAtomLock);
+	if ((atom = LookupAtom(name, h)) != 0) {	/* Lost a race */
+		goto out;
+	}
+	tbl = GetAtomTbl();
+	if (tbl == NULL || (agEventAtomCount+1)*2 > tbl->size) {
+		tbl = GrowAtomTbl(tbl);
+	}
+	atom = ++agEventAtomCount;
+	s = Strdup(name);
+	if (strlen(s) >= AG_EVENT_ATOM_NAME_MAX) {
+		s[AG_EVENT_ATOM_NAME_MAX-1] = '\0';
+	}
+	tbl->names[atom] = s;
+
+	mask = tbl->size - 1;
+	for (i = h & mask; tbl->atoms[i] != 0; i = (i+1) & mask)
+		;;
+	AG_AtomicSetUint(&tbl->atoms[i], atom);	/* Publish (after name) */
+out:
+	AG_MutexUnlock(&agEventAtomLock);
+	return (atom);
+}
+
+/*
+ * Return the atom associated with the given event name, or 0 if the name
+ * was never interned (in which case no object can have a handler for it).
+ */
+AG_EventAtom
+AG_LookupEventAtom(const char *name)
+{
+	return LookupAtom(name, HashEventName(name));
+}
+
+/* Return the event name associated with a previously returned atom. */
+const char *
+AG_GetEventAtomName(AG_EventAtom atom)
+{
+	AG_EventAtomTbl *tbl;
+
+	if ((tbl = GetAtomTbl()) == NULL || atom == 0 || atom > tbl->size/2) {
+		return (NULL);
+	}
+	return (tbl->names[atom]);
+}
+
+/*
+ * Rebuild an object's event handler index from its list of handlers,
+ * preserving the order of handlers sharing the same atom.
+ */
+static void
+RebuildEventIndex(AG_Object *ob, Uint size)
+{
+	AG_Event *ev, **pEv;
+
+	Free(ob->evIndex);
+	ob->evIndex = Malloc(size*sizeof(AG_Event *));
+	memset(ob->evIndex, 0, size*sizeof(AG_Event *));
+	ob->evIndexSize = size;
+
+	TAILQ_FOREACH(ev, &ob->events, events) {
+		for (pEv = &ob->evIndex[ev->atom & (size-1)];
+		     *pEv != NULL;
+		     pEv = &(*pEv)->atomNext)
+			;;
+		ev->atomNext = NULL;
+		*pEv = ev;
+	}
+}
+
+/*
+ * Add an event handler (already inserted into the list of handlers)
+ * to the object's index. The object must be locked.
+ */
+static void
+IndexEvent(AG_Object *ob, AG_Event *ev)
+{
+	AG_Event **pEv;
+
+	if (++ob->nEvents > ob->evIndexSize) {
+		RebuildEventIndex(ob, (ob->evIndexSize > 0) ?
+		    ob->evIndexSize*2 : AG_EVENT_INDEX_INIT);
+		return;
+	}
+	for (pEv = &ob->evIndex[ev->atom & (ob->evIndexSize-1)];
+	     *pEv != NULL;
+	     pEv = &(*pEv)->atomNext)
+		;;
+	ev->atomNext = NULL;
+	*pEv = ev;
+}
+
+/* Remove an event handler from the object's index. */
+static void
+UnindexEvent(AG_Object *ob, AG_Event *ev)
+{
+	AG_Event **pEv;
+
+	for (pEv = &ob->evIndex[ev->atom & (ob->evIndexSize-1)];
+	     *pEv != NULL;
+	     pEv = &(*pEv)->atomNext) {
+		if (*pEv == ev) {
+			*pEv = ev->atomNext;
+			break;
+		}
+	}
+	ob->nEvents--;
+}
+
+/* Return the first event handler for the given atom. */
+static __inline__ AG_Event *
+FirstEventHandler(AG_Object *ob, AG_EventAtom atom)
+{
+	AG_Event *ev;
+
+	if (ob->evIndexSize == 0) {
+		return (NULL);
+	}
+	for (ev = ob->evIndex[atom & (ob->evIndexSize-1)];
+	     ev != NULL;
+	     ev = ev->atomNext) {
+		if (ev->atom == atom)
+			break;
+	}
+	return (ev);
+}
+
+/* Return the next event handler sharing the same atom. */
+static __inline__ AG_Event *
+NextEventHandler(AG_Event *ev)
+{
+	AG_EventAtom atom = ev->atom;
+
+	for (ev = ev->atomNext; ev != NULL; ev = ev->atomNext) {
+		if (ev->atom == atom)
+			break;
+	}
+	return (ev);
+}
+
 /* Initialize an AG_Event structure. */
 void
 AG_EventInit(AG_Event *ev)
@@ -129,15 +431,16 @@ AG_Event *
 AG_SetEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 {
 	AG_Object *ob = p;
+	AG_EventAtom atom;
 	AG_Event *ev;
 
 	AG_ObjectLock(ob);
 
 	if (name != NULL) {
-		TAILQ_FOREACH(ev, &ob->events, events)
-			if (strcmp(ev->name, name) == 0)
-				break;
+		atom = AG_InternEventName(name);
+		ev = FirstEventHandler(ob, atom);
 	} else {
+		atom = AG_InternEventName("");
 		ev = NULL;
 	}
 	if (ev == NULL) {
@@ -149,7 +452,9 @@ AG_SetEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 		} else {
 			ev->name[0] = '\0';
 		}
+		ev->atom = atom;
 		TAILQ_INSERT_TAIL(&ob->events, ev, events);
+		IndexEvent(ob, ev);
 	} else {
 		ev->argc = 1;
 		ev->argc0 = 1;
@@ -181,15 +486,13 @@ AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 	InitEvent(ev, ob);
 
 	if (name != NULL) {
-		TAILQ_FOREACH(evOther, &ob->events, events) {
-			if (strcmp(evOther->name, name) == 0)
-				break;
-		}
-		if (evOther != NULL) {
+		ev->atom = AG_InternEventName(name);
+		if ((evOther = FirstEventHandler(ob, ev->atom)) != NULL) {
 			ev->flags = evOther->flags;
 		}
 		Strlcpy(ev->name, name, sizeof(ev->name));
 	} else {
+		ev->atom = AG_InternEventName("");
 		ev->name[0] = '\0';
 	}
 
@@ -198,6 +501,7 @@ AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 	ev->argc0 = ev->argc;
 
 	TAILQ_INSERT_TAIL(&ob->events, ev, events);
+	IndexEvent(ob, ev);
 	AG_ObjectUnlock(ob);
 	return (ev);
 }
@@ -214,12 +518,14 @@ AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 	memset(ev, 0, sizeof(AG_Event));	\
 	InitEvent(ev, ob);				\
 	ev->name[0] = '\0';				\
+	ev->atom = AG_InternEventName("");		\
 	ev->fn.memb = fn;				\
 	InitPointerArg(&ev->argv[0], ob);		\
 	AG_EVENT_GET_ARGS(ev, fmt);			\
 							\
 	AG_ObjectLock(ob);				\
 	TAILQ_INSERT_TAIL(&ob->events, ev, events);	\
+	IndexEvent(ob, ev);				\
 	ev->argc0 = ev->argc;				\
 	AG_ObjectUnlock(ob);				\
 	return (AG_Function *)ev
@@ -253,16 +559,17 @@ void
 AG_UnsetEvent(void *p, const char *name)
 {
 	AG_Object *ob = p;
+	AG_EventAtom atom;
 	AG_Event *ev;
 
-	AG_ObjectLock(ob);
-	TAILQ_FOREACH(ev, &ob->events, events) {
-		if (strcmp(name, ev->name) == 0)
-			break;
+	if ((atom = AG_LookupEventAtom(name)) == 0) {
+		return;
 	}
-	if (ev == NULL) {
+	AG_ObjectLock(ob);
+	if ((ev = FirstEventHandler(ob, atom)) == NULL) {
 		goto out;
 	}
+	UnindexEvent(ob, ev);
 	TAILQ_REMOVE(&ob->events, ev, events);
 	free(ev);
 out:
@@ -272,15 +579,24 @@ out:
 /* Look up an AG_Event by name. */
 AG_Event *
 AG_FindEventHandler(void *p, const char *name)
+{
+	AG_EventAtom atom;
+
+	if ((atom = AG_LookupEventAtom(name)) == 0) {
+		return (NULL);
+	}
+	return AG_FindEventHandlerAtom(p, atom);
+}
+
+/* Look up an AG_Event by atom. */
+AG_Event *
+AG_FindEventHandlerAtom(void *p, AG_EventAtom atom)
 {
 	AG_Object *ob = p;
 	AG_Event *ev;
 	
 	AG_ObjectLock(ob);
-	TAILQ_FOREACH(ev, &ob->events, events) {
-		if (strcmp(name, ev->name) == 0)
-			break;
-	}
+	ev = FirstEventHandler(ob, atom);
 	AG_ObjectUnlock(ob);
 	return (ev);
 }
@@ -303,18 +619,15 @@ EventTimeout(AG_Timer *to, AG_Event *event)
 {
 	AG_Object *ob = AG_SELF();
 	AG_Object *obSender = AG_PTR(1);
-	char *eventName = AG_STRING(2);
+	AG_EventAtom atom = (AG_EventAtom)AG_UINT(2);
 	AG_Event *ev;
 
 #ifdef AG_DEBUG_CORE
 	if (agDebugLvl >= 2)
-		Debug(ob, "Event <%s> timeout (%u ticks)\n", eventName, (Uint)to->ival);
+		Debug(ob, "Event <%s> timeout (%u ticks)\n",
+		    AG_GetEventAtomName(atom), (Uint)to->ival);
 #endif
-	TAILQ_FOREACH(ev, &ob->events, events) {
-		if (strcmp(eventName, ev->name) == 0)
-			break;
-	}
-	if (ev == NULL) {
+	if ((ev = FirstEventHandler(ob, atom)) == NULL) {
 		return (0);
 	}
 	InitPointerArg(&ev->argv[ev->argc], obSender);
@@ -342,11 +655,45 @@ EventTimeout(AG_Timer *to, AG_Event *event)
 
 
 #ifdef AG_THREADS
-/* Invoke an event handler routine asynchronously. */
-static void *
-EventThread(void *p)
+/*
+ * Pool of worker threads servicing AG_EVENT_ASYNC handlers. Events are
+ * copied into preallocated slots and queued in FIFO order. If a handler
+ * has AG_EVENT_ASYNC_SERIAL set, at most one of its events will execute
+ * at any time for a given receiver, in the order they were posted.
+ *
+ * The queues are protected by agEventPoolLock rather than being lock-free:
+ * the AG_Atomic*() routines only provide load, store and increment (no
+ * compare-and-swap), and fall back to the global agAtomicLock where the
+ * compiler has no atomic builtins. A lock-free MPMC queue or per-worker
+ * work-stealing deques would need CAS.
+ */
+typedef struct ag_event_job {
+	AG_Event ev;				/* Event (with arguments) */
+	Uint32 tQueued;				/* Submission time (ticks) */
+	int heap;				/* Allocated on overflow */
+	AG_TAILQ_ENTRY(ag_event_job) jobs;
+} AG_EventJob;
+
+#define AG_EVENT_POOL_SLOTS	256		/* Default number of slots */
+
+static AG_Mutex     agEventPoolLock;
+static AG_Cond      agEventPoolCond;		/* Work available */
+static AG_TAILQ_HEAD(ag_event_jobq, ag_event_job) agEventJobsFree,
+                                                    agEventJobsQueued;
+static AG_EventJob *agEventJobs = NULL;		/* Preallocated slots */
+static AG_Thread   *agEventWorkers = NULL;	/* Worker threads */
+static void       **agEventWorkersRcvr = NULL;	/* Receiver (SERIAL jobs) */
+static Uint         agEventPoolThreads = 0;	/* Workers (0 = per CPU) */
+static Uint         agEventPoolSlots = AG_EVENT_POOL_SLOTS;
+static int          agEventPoolUp = 0;		/* Workers running */
+static int          agEventPoolExit = 0;	/* Shutdown requested */
+static AG_EventPoolStats agEventPoolStats;
+static Ulong        agEventPoolLatency = 0;	/* Sum of latencies */
+
+/* Execute an asynchronous event handler in the calling thread. */
+static void
+ExecAsyncEvent(AG_Event *eev)
 {
-	AG_Event *eev = p;
 	AG_Object *rcvr = eev->argv[0].data.p;
 	AG_Object *chld;
 
@@ -363,20 +710,268 @@ EventThread(void *p)
 	}
 #ifdef AG_DEBUG_CORE
 	if (agDebugLvl >= 2)
-		Debug(rcvr, "BEGIN event thread for <%s>\n", eev->name);
+		Debug(rcvr, "BEGIN async handler for <%s>\n", eev->name);
 #endif
 	if (eev->fn.fnVoid != NULL) {
 		eev->fn.fnVoid(eev);
 	}
 #ifdef AG_DEBUG_CORE
 	if (agDebugLvl >= 2)
-		Debug(rcvr, "CLOSE event thread for <%s>\n", eev->name);
+		Debug(rcvr, "CLOSE async handler for <%s>\n", eev->name);
 #endif
+	AG_WakeupEventLoop();		/* Handler may have changed GUI state */
+}
+
+/* Invoke an event handler routine in a dedicated thread (no pool). */
+static void *
+EventThread(void *p)
+{
+	AG_Event *eev = p;
+
+	ExecAsyncEvent(eev);
 	free(eev);
 	return (NULL);
 }
+
+/*
+ * Return the first queued job which may execute now, skipping serialized
+ * jobs whose receiver is being serviced by another worker.
+ * The pool must be locked.
+ */
+static AG_EventJob *
+NextAsyncJob(void)
+{
+	AG_EventJob *job;
+	Uint i;
+
+	AG_TAILQ_FOREACH(job, &agEventJobsQueued, jobs) {
+		if (!(job->ev.flags & AG_EVENT_ASYNC_SERIAL)) {
+			return (job);
+		}
+		for (i = 0; i < agEventPoolStats.nThreads; i++) {
+			if (agEventWorkersRcvr[i] == job->ev.argv[0].data.p)
+				break;
+		}
+		if (i == agEventPoolStats.nThreads)
+			return (job);
+	}
+	return (NULL);
+}
+
+/* Main routine of pool worker threads. */
+static void *
+EventWorker(void *p)
+{
+	void **busyRcvr = p;		/* Receiver being serviced */
+	AG_EventJob *job;
+	Uint32 t;
+	int serial;
+
+	AG_MutexLock(&agEventPoolLock);
+	for (;;) {
+		if ((job = NextAsyncJob()) == NULL) {
+			if (agEventPoolExit &&
+			    AG_TAILQ_EMPTY(&agEventJobsQueued)) {
+				break;
+			}
+			AG_CondWait(&agEventPoolCond, &agEventPoolLock);
+			continue;
+		}
+		AG_TAILQ_REMOVE(&agEventJobsQueued, job, jobs);
+		agEventPoolStats.nQueued--;
+		agEventPoolStats.nRunning++;
+		if ((serial = (job->ev.flags & AG_EVENT_ASYNC_SERIAL))) {
+			*busyRcvr = job->ev.argv[0].data.p;
+		}
+		t = AG_GetTicks() - job->tQueued;
+		agEventPoolLatency += t;
+		if (t > agEventPoolStats.latencyMax) {
+			agEventPoolStats.latencyMax = t;
+		}
+		AG_MutexUnlock(&agEventPoolLock);
+
+		ExecAsyncEvent(&job->ev);
+
+		AG_MutexLock(&agEventPoolLock);
+		agEventPoolStats.nRunning--;
+		agEventPoolStats.nProcessed++;
+		if (job->heap) {
+			free(job);
+		} else {
+			AG_TAILQ_INSERT_HEAD(&agEventJobsFree, job, jobs);
+		}
+		if (serial) {
+			/* Jobs for this receiver may now be runnable. */
+			*busyRcvr = NULL;
+			AG_CondBroadcast(&agEventPoolCond);
+		}
+	}
+	AG_MutexUnlock(&agEventPoolLock);
+	return (NULL);
+}
+
+/* Allocate the event slots and start the worker threads. Pool is locked. */
+static void
+StartEventPool(void)
+{
+	Uint i, nThreads;
+
+	if ((nThreads = agEventPoolThreads) == 0) {
+		nThreads = (agCPU.nCPUs > 1) ? (Uint)agCPU.nCPUs : 2;
+	}
+	agEventJobs = Malloc(agEventPoolSlots*sizeof(AG_EventJob));
+	agEventWorkers = Malloc(nThreads*sizeof(AG_Thread));
+	agEventWorkersRcvr = Malloc(nThreads*sizeof(void *));
+	for (i = 0; i < agEventPoolSlots; i++) {
+		agEventJobs[i].heap = 0;
+		AG_TAILQ_INSERT_TAIL(&agEventJobsFree, &agEventJobs[i], jobs);
+	}
+	agEventPoolStats.nSlots = agEventPoolSlots;
+	agEventPoolStats.nThreads = 0;
+	agEventPoolExit = 0;
+	agEventPoolUp = 1;
+
+	for (i = 0; i < nThreads; i++) {
+		agEventWorkersRcvr[i] = NULL;
+		if (AG_ThreadTryCreate(&agEventWorkers[i], EventWorker,
+		    &agEventWorkersRcvr[i]) == -1) {
+			Verbose("Event worker %u: %s\n", i, AG_GetError());
+			break;
+		}
+		agEventPoolStats.nThreads++;
+	}
+}
+
+/*
+ * Stop the worker threads and release the event slots. Fail if invoked
+ * from a worker (i.e., from an asynchronous handler), which would then
+ * have to join itself.
+ */
+static int
+StopEventPool(void)
+{
+	Uint i, nThreads;
+
+	AG_MutexLock(&agEventPoolLock);
+	if (!agEventPoolUp) {
+		AG_MutexUnlock(&agEventPoolLock);
+		return (0);
+	}
+	for (i = 0; i < agEventPoolStats.nThreads; i++) {
+		if (AG_ThreadEqual(agEventWorkers[i], AG_ThreadSelf())) {
+			AG_MutexUnlock(&agEventPoolLock);
+			AG_SetError("Cannot stop event pool from a worker");
+			return (-1);
+		}
+	}
+	agEventPoolExit = 1;
+	nThreads = agEventPoolStats.nThreads;
+	AG_CondBroadcast(&agEventPoolCond);
+	AG_MutexUnlock(&agEventPoolLock);
+
+	for (i = 0; i < nThreads; i++) {
+		AG_ThreadJoin(agEventWorkers[i], NULL);
+	}
+
+	AG_MutexLock(&agEventPoolLock);
+	AG_TAILQ_INIT(&agEventJobsFree);
+	AG_TAILQ_INIT(&agEventJobsQueued);
+	Free(agEventJobs);
+	Free(agEventWorkers);
+	Free(agEventWorkersRcvr);
+	agEventJobs = NULL;
+	agEventWorkers = NULL;
+	agEventWorkersRcvr = NULL;
+	agEventPoolStats.nThreads = 0;
+	agEventPoolStats.nSlots = 0;
+	agEventPoolUp = 0;
+	agEventPoolExit = 0;
+	AG_MutexUnlock(&agEventPoolLock);
+	return (0);
+}
+
+/*
+ * Queue a fully-prepared event for asynchronous execution. The pool is
+ * started on first use. If all slots are taken, an extra job is allocated
+ * so that ordering is preserved. If no worker could be started, the event
+ * is executed by a dedicated thread instead.
+ */
+static void
+SubmitAsyncEvent(const AG_Event *ev)
+{
+	AG_EventJob *job;
+	AG_Event *evNew;
+	AG_Thread th;
+
+	AG_MutexLock(&agEventPoolLock);
+	if (!agEventPoolUp && !agEventPoolExit) {
+		StartEventPool();
+	}
+	if (agEventPoolStats.nThreads > 0 && !agEventPoolExit) {
+		if ((job = AG_TAILQ_FIRST(&agEventJobsFree)) != NULL) {
+			AG_TAILQ_REMOVE(&agEventJobsFree, job, jobs);
+		} else {
+			job = Malloc(sizeof(AG_EventJob));
+			job->heap = 1;
+			agEventPoolStats.nOverflow++;
+		}
+		CopyEvent(&job->ev, ev);
+		job->tQueued = AG_GetTicks();
+		AG_TAILQ_INSERT_TAIL(&agEventJobsQueued, job, jobs);
+		if (++agEventPoolStats.nQueued > agEventPoolStats.nQueuedMax) {
+			agEventPoolStats.nQueuedMax = agEventPoolStats.nQueued;
+		}
+		AG_CondSignal(&agEventPoolCond);
+		AG_MutexUnlock(&agEventPoolLock);
+		return;
+	}
+	AG_MutexUnlock(&agEventPoolLock);
+
+	evNew = Malloc(sizeof(AG_Event));
+	CopyEvent(evNew, ev);
+	AG_ThreadCreate(&th, EventThread, evNew);
+}
 #endif /* AG_THREADS */
 
+/*
+ * Configure the number of worker threads (0 = one per CPU) and event
+ * slots used to service AG_EVENT_ASYNC handlers. If the pool is already
+ * running, it is drained and restarted on the next asynchronous event.
+ */
+int
+AG_SetEventPoolSize(Uint nThreads, Uint nSlots)
+{
+#ifdef AG_THREADS
+	if (nSlots == 0) {
+		AG_SetError("Invalid slot count");
+		return (-1);
+	}
+	if (StopEventPool() == -1) {
+		return (-1);
+	}
+	AG_MutexLock(&agEventPoolLock);
+	agEventPoolThreads = nThreads;
+	agEventPoolSlots = nSlots;
+	AG_MutexUnlock(&agEventPoolLock);
+#endif
+	return (0);
+}
+
+/* Return statistics about the AG_EVENT_ASYNC worker pool. */
+void
+AG_GetEventPoolStats(AG_EventPoolStats *st)
+{
+#ifdef AG_THREADS
+	AG_MutexLock(&agEventPoolLock);
+	memcpy(st, &agEventPoolStats, sizeof(AG_EventPoolStats));
+	st->latencyAvg = (st->nProcessed > 0) ?
+	                 (Uint32)(agEventPoolLatency / st->nProcessed) : 0;
+	AG_MutexUnlock(&agEventPoolLock);
+#else
+	memset(st, 0, sizeof(AG_EventPoolStats));
+#endif
+}
+
 void
 AG_InitEventQ(AG_EventQ *eq)
 {
@@ -405,6 +1000,66 @@ AG_QueueEvent(AG_EventQ *eq, const char *evname, const char *fmt, ...)
 	ev->argc0 = ev->argc;
 }
 
+/* Append the posted arguments to an event handler's argument vector. */
+static __inline__ void
+AppendEventArgs(AG_Event *ev, const AG_Event *args)
+{
+#ifdef AG_DEBUG
+	if (ev->argc + args->argc >= AG_EVENT_ARGS_MAX-1)
+		AG_FatalError("Too many AG_Event(3) arguments");
+#endif
+	memcpy(&ev->argv[ev->argc], &args->argv[0],
+	    args->argc*sizeof(AG_EventArg));
+	ev->argc += args->argc;
+}
+
+/*
+ * Invoke an event handler routine with the posted arguments (and the
+ * sender) appended to its argument vector. The receiver must be locked.
+ */
+static void
+InvokeEvent(AG_Object *sndr, AG_Object *rcvr, AG_Event *ev,
+    const AG_Event *args, int *propagated)
+{
+	AG_Object *chld;
+
+#ifdef AG_THREADS
+	if (ev->flags & AG_EVENT_ASYNC) {
+		AG_Event evAsync;
+
+		CopyEvent(&evAsync, ev);
+		AppendEventArgs(&evAsync, args);
+		InitPointerArg(&evAsync.argv[evAsync.argc], sndr);
+		if (evAsync.flags & AG_EVENT_PROPAGATE) { *propagated = 1; }
+		if (*propagated) {
+			evAsync.flags &= ~(AG_EVENT_PROPAGATE);
+		}
+		SubmitAsyncEvent(&evAsync);
+	} else
+#endif /* AG_THREADS */
+	{
+		AG_Event tmpev;
+
+		CopyEvent(&tmpev, ev);
+		AppendEventArgs(&tmpev, args);
+		InitPointerArg(&tmpev.argv[tmpev.argc], sndr);
+		if ((tmpev.flags & AG_EVENT_PROPAGATE) && !(*propagated)) {
+#ifdef AG_DEBUG_CORE
+			if (agDebugLvl >= 2)
+				Debug(rcvr, "Propagate <%s>\n", ev->name);
+#endif
+			AG_LockVFS(rcvr);
+			OBJECT_FOREACH_CHILD(chld, rcvr, ag_object) {
+				PropagateEvent(rcvr, chld, &tmpev);
+			}
+			AG_UnlockVFS(rcvr);
+			*propagated = 1;
+		}
+		if (tmpev.fn.fnVoid != NULL)
+			tmpev.fn.fnVoid(&tmpev);
+	}
+}
+
 /*
  * Raise the specified event. Configured event handler routines may be
  * called immediately, but they may also get called from a separate
@@ -419,55 +1074,47 @@ AG_PostEvent(void *sp, void *rp, const char *evname, const char *fmt, ...)
 {
 	AG_Object *sndr = sp;
 	AG_Object *rcvr = rp;
-	AG_Event *ev;
-	AG_Object *chld;
+	AG_EventAtom atom;
+	AG_Event *ev, args;
 	int propagated = 0;
 
 #ifdef AG_DEBUG_CORE
 	if (agDebugLvl >= 2)
 		Debug(rcvr, "Event <%s> posted from %s\n", evname, sndr ? sndr->name : "NULL");
 #endif
+	if ((atom = AG_LookupEventAtom(evname)) == 0) {
+		return;
+	}
 	AG_ObjectLock(rcvr);
-	TAILQ_FOREACH(ev, &rcvr->events, events) {
-		if (strcmp(evname, ev->name) != 0)
-			continue;
-#ifdef AG_THREADS
-		if (ev->flags & AG_EVENT_ASYNC) {
-			AG_Thread th;
-			AG_Event *evNew;
-
-			evNew = Malloc(sizeof(AG_Event));
-			memcpy(evNew, ev, sizeof(AG_Event));
-			AG_EVENT_GET_ARGS(evNew, fmt);
-			InitPointerArg(&evNew->argv[evNew->argc], sndr);
-			if (evNew->flags & AG_EVENT_PROPAGATE) { propagated = 1; }
-			if (propagated) {
-				evNew->flags &= ~(AG_EVENT_PROPAGATE);
-			}
-			AG_ThreadCreate(&th, EventThread, evNew);
-		} else
-#endif /* AG_THREADS */
-		{
-			AG_Event tmpev;
+	if ((ev = FirstEventHandler(rcvr, atom)) != NULL) {
+		args.argc = 0;
+		AG_EVENT_GET_ARGS(&args, fmt);
+		do {
+			InvokeEvent(sndr, rcvr, ev, &args, &propagated);
+		} while ((ev = NextEventHandler(ev)) != NULL);
+	}
+	AG_ObjectUnlock(rcvr);
+}
 
-			memcpy(&tmpev, ev, sizeof(AG_Event));
-			AG_EVENT_GET_ARGS(&tmpev, fmt);
-			InitPointerArg(&tmpev.argv[tmpev.argc], sndr);
-			if ((tmpev.flags & AG_EVENT_PROPAGATE) && !propagated) {
-#ifdef AG_DEBUG_CORE
-				if (agDebugLvl >= 2)
-					Debug(rcvr, "Propagate <%s>\n", evname);
-#endif
-				AG_LockVFS(rcvr);
-				OBJECT_FOREACH_CHILD(chld, rcvr, ag_object) {
-					PropagateEvent(rcvr, chld, &tmpev);
-				}
-				AG_UnlockVFS(rcvr);
-				propagated = 1;
-			}
-			if (tmpev.fn.fnVoid != NULL)
-				tmpev.fn.fnVoid(&tmpev);
-		}
+/*
+ * Variant of AG_PostEvent() which accepts an atom previously returned by
+ * AG_InternEventName(), avoiding the event name lookup.
+ */
+void
+AG_PostEventAtom(void *sp, void *rp, AG_EventAtom atom, const char *fmt, ...)
+{
+	AG_Object *sndr = sp;
+	AG_Object *rcvr = rp;
+	AG_Event *ev, args;
+	int propagated = 0;
+
+	AG_ObjectLock(rcvr);
+	if ((ev = FirstEventHandler(rcvr, atom)) != NULL) {
+		args.argc = 0;
+		AG_EVENT_GET_ARGS(&args, fmt);
+		do {
+			InvokeEvent(sndr, rcvr, ev, &args, &propagated);
+		} while ((ev = NextEventHandler(ev)) != NULL);
 	}
 	AG_ObjectUnlock(rcvr);
 }
@@ -481,51 +1128,17 @@ AG_PostEventByPtr(void *sp, void *rp, AG_Event *ev, const char *fmt, ...)
 {
 	AG_Object *sndr = sp;
 	AG_Object *rcvr = rp;
-	AG_Object *chld;
+	AG_Event args;
 	int propagated = 0;
 
 #ifdef AG_DEBUG_CORE
 	if (agDebugLvl >= 2)
 		Debug(rcvr, "Event %p posted from %s\n", ev, sndr ? sndr->name : "NULL");
-#endif
-	AG_ObjectLock(rcvr);
-#ifdef AG_THREADS
-	if (ev->flags & AG_EVENT_ASYNC) {
-		AG_Thread th;
-		AG_Event *evNew;
-
-		evNew = Malloc(sizeof(AG_Event));
-		memcpy(evNew, ev, sizeof(AG_Event));
-		AG_EVENT_GET_ARGS(evNew, fmt);
-		InitPointerArg(&evNew->argv[evNew->argc], sndr);
-		if (evNew->flags & AG_EVENT_PROPAGATE) { propagated = 1; }
-		if (propagated) {
-			evNew->flags &= ~(AG_EVENT_PROPAGATE);
-		}
-		AG_ThreadCreate(&th, EventThread, evNew);
-	} else
-#endif /* AG_THREADS */
-	{
-		AG_Event evTmp;
-
-		memcpy(&evTmp, ev, sizeof(AG_Event));
-		AG_EVENT_GET_ARGS(&evTmp, fmt);
-		InitPointerArg(&evTmp.argv[evTmp.argc], sndr);
-		if ((evTmp.flags & AG_EVENT_PROPAGATE) && !propagated) {
-#ifdef AG_DEBUG_CORE
-			if (agDebugLvl >= 2)
-				Debug(rcvr, "Propagate event %p (post)\n", ev);
-#endif
-			AG_LockVFS(rcvr);
-			OBJECT_FOREACH_CHILD(chld, rcvr, ag_object) {
-				PropagateEvent(rcvr, chld, &evTmp);
-			}
-			AG_UnlockVFS(rcvr);
-			propagated = 1;
-		}
-		if (evTmp.fn.fnVoid != NULL)
-			evTmp.fn.fnVoid(&evTmp);
-	}
+#endif
+	AG_ObjectLock(rcvr);
+	args.argc = 0;
+	AG_EVENT_GET_ARGS(&args, fmt);
+	InvokeEvent(sndr, rcvr, ev, &args, &propagated);
 	AG_ObjectUnlock(rcvr);
 }
 
@@ -554,8 +1167,8 @@ AG_SchedEvent(void *pSndr, void *pRcvr, Uint32 ticks, const char *evname,
 	AG_LockTiming();
 	AG_ObjectLock(rcvr);
 	
-	if (AG_AddTimer(rcvr, to, ticks,
-	    EventTimeout, "%p,%s", sndr, evname) == -1) {
+	if (AG_AddTimer(rcvr, to, ticks, EventTimeout, "%p,%u", sndr,
+	    (Uint)AG_InternEventName(evname)) == -1) {
 		free(to);
 		goto fail;
 	}
@@ -584,32 +1197,35 @@ AG_ForwardEvent(void *pSndr, void *pRcvr, AG_Event *event)
 	AG_Object *sndr = pSndr;
 	AG_Object *rcvr = pRcvr;
 	AG_Object *chld;
+	AG_EventAtom atom;
 	AG_Event *ev;
 
 #ifdef AG_DEBUG_CORE
 	if (agDebugLvl >= 2)
 		Debug(rcvr, "Event <%s> forwarded from %s\n", event->name, sndr ? sndr->name : "NULL");
 #endif
+	if ((atom = event->atom) == 0 &&
+	    (atom = AG_LookupEventAtom(event->name)) == 0) {
+		return;
+	}
 	AG_ObjectLock(rcvr);
-	TAILQ_FOREACH(ev, &rcvr->events, events) {
-		if (strcmp(event->name, ev->name) != 0)
-			continue;
+	for (ev = FirstEventHandler(rcvr, atom);
+	     ev != NULL;
+	     ev = NextEventHandler(ev)) {
 #ifdef AG_THREADS
 		if (ev->flags & AG_EVENT_ASYNC) {
-			AG_Thread th;
-			AG_Event *evNew;
-
-			evNew = Malloc(sizeof(AG_Event));
-			memcpy(evNew, ev, sizeof(AG_Event));
-			InitPointerArg(&evNew->argv[0], rcvr);
-			InitPointerArg(&evNew->argv[evNew->argc], sndr);
-			AG_ThreadCreate(&th, EventThread, evNew);
+			AG_Event evAsync;
+
+			CopyEvent(&evAsync, ev);
+			InitPointerArg(&evAsync.argv[0], rcvr);
+			InitPointerArg(&evAsync.argv[evAsync.argc], sndr);
+			SubmitAsyncEvent(&evAsync);
 		} else
 #endif /* AG_THREADS */
 		{
 			AG_Event tmpev;
 
-			memcpy(&tmpev, event, sizeof(AG_Event));
+			CopyEvent(&tmpev, event);
 			InitPointerArg(&tmpev.argv[0], rcvr);
 			InitPointerArg(&tmpev.argv[tmpev.argc], sndr);
 
@@ -651,13 +1267,58 @@ GrowKqChangelist(AG_EventSourceKQUEUE *kq, Uint n)
 }
 #endif /* HAVE_KQUEUE */
 
+#ifdef HAVE_EPOLL
+/* Register an I/O sink's descriptor (or update its event mask). */
+static int
+UpdateEpollSink(AG_EventSourceEPOLL *ep, int fd)
+{
+	struct epoll_event ev;
+	AG_EventSink *es;
+	Uint32 events = 0;
+
+	TAILQ_FOREACH(es, &ep->_inherit.sinks, sinks) {
+		if (es->ident != fd) {
+			continue;
+		}
+		switch (es->type) {
+		case AG_SINK_READ:	events |= EPOLLIN;	break;
+		case AG_SINK_WRITE:	events |= EPOLLOUT;	break;
+		default:					break;
+		}
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.fd = fd;
+	if (events == 0) {
+		if (epoll_ctl(ep->fd, EPOLL_CTL_DEL, fd, &ev) == -1 &&
+		    errno != ENOENT && errno != EBADF) {
+			AG_SetError("epoll_ctl: %s", AG_Strerror(errno));
+			return (-1);
+		}
+		return (0);
+	}
+	if (epoll_ctl(ep->fd, EPOLL_CTL_MOD, fd, &ev) == -1) {
+		if (errno != ENOENT ||
+		    epoll_ctl(ep->fd, EPOLL_CTL_ADD, fd, &ev) == -1) {
+			AG_SetError("epoll_ctl: %s", AG_Strerror(errno));
+			return (-1);
+		}
+	}
+	return (0);
+}
+#endif /* HAVE_EPOLL */
+
 /* Create a new event source. */
 static AG_EventSource *
 CreateEventSource(void)
 {
-#ifdef HAVE_KQUEUE
+#if defined(HAVE_KQUEUE)
 	AG_EventSourceKQUEUE *kq = TryMalloc(sizeof(AG_EventSourceKQUEUE));
 	AG_EventSource *src = (AG_EventSource *)kq;
+#elif defined(HAVE_EPOLL)
+	AG_EventSourceEPOLL *ep = TryMalloc(sizeof(AG_EventSourceEPOLL));
+	AG_EventSource *src = (AG_EventSource *)ep;
+	struct epoll_event ev;
 #else
 	AG_EventSource *src = TryMalloc(sizeof(AG_EventSource));
 #endif
@@ -693,6 +1354,35 @@ CreateEventSource(void)
 	src->caps[AG_SINK_FSEVENT] = 1;
 	src->caps[AG_SINK_PROCEVENT] = 1;
 	GrowKqChangelist(kq, 64);		/* Preallocate */
+#elif defined(HAVE_EPOLL)
+	if ((ep->fd = epoll_create(AG_EPOLL_MAXEVENTS)) == -1) {
+		AG_SetError("epoll_create: %s", AG_Strerror(errno));
+		free(ep);
+		return (NULL);
+	}
+	if (agTimerHeapFd == -1 &&
+	    (agTimerHeapFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK))
+	    == -1) {
+		AG_SetError("timerfd_create: %s", AG_Strerror(errno));
+		close(ep->fd);
+		free(ep);
+		return (NULL);
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = agTimerHeapFd;
+	if (epoll_ctl(ep->fd, EPOLL_CTL_ADD, agTimerHeapFd, &ev) == -1) {
+		AG_SetError("epoll_ctl: %s", AG_Strerror(errno));
+		close(ep->fd);
+		free(ep);
+		return (NULL);
+	}
+	src->sinkFn = AG_EventSinkEPOLL;
+	src->addTimerFn = AG_AddTimerEPOLL;
+	src->delTimerFn = AG_DelTimerEPOLL;
+	src->caps[AG_SINK_TIMER] = 1;		/* Provides timers internally */
+	src->caps[AG_SINK_READ] = 1;
+	src->caps[AG_SINK_WRITE] = 1;
 #elif defined(HAVE_TIMERFD)
 	src->sinkFn = AG_EventSinkTIMERFD;
 	src->addTimerFn = AG_AddTimerTIMERFD;
@@ -737,6 +1427,13 @@ DestroyEventSource(void *pEventSource)
 		}
 		Free(kq->changes);
 	}
+#elif defined(HAVE_EPOLL)
+	{
+		AG_EventSourceEPOLL *ep = pEventSource;
+
+		if (ep->fd != -1)
+			close(ep->fd);
+	}
 #endif
 	for (es = TAILQ_FIRST(&src->prologues); es != TAILQ_END(&src->prologues); es = esNext) {
 		esNext = TAILQ_NEXT(es, sinks);
@@ -783,6 +1480,27 @@ AG_GetEventSource(void)
 int
 AG_InitEventSubsystem(Uint flags)
 {
+	/* Initialize the table of interned event names. */
+	AG_MutexInit(&agEventAtomLock);
+	agEventAtoms = NULL;
+	agEventAtomCount = 0;
+
+#ifdef AG_THREADS
+	/* Initialize the AG_EVENT_ASYNC worker pool (started on demand). */
+	AG_MutexInit(&agEventPoolLock);
+	AG_CondInit(&agEventPoolCond);
+	AG_TAILQ_INIT(&agEventJobsFree);
+	AG_TAILQ_INIT(&agEventJobsQueued);
+	memset(&agEventPoolStats, 0, sizeof(AG_EventPoolStats));
+	agEventPoolLatency = 0;
+	agEventPoolUp = 0;
+	agEventPoolExit = 0;
+
+	AG_MutexInit(&agWakeupLock);
+	agWakeupFn = NULL;
+	agWakeupSet = 0;
+#endif
+
 	/* Initialize the main thread's event source. */
 	agEventSource = NULL;
 #ifdef AG_THREADS
@@ -798,10 +1516,45 @@ AG_InitEventSubsystem(Uint flags)
 void
 AG_DestroyEventSubsystem(void)
 {
+	AG_EventAtomTbl *tbl, *tblPrev;
+	AG_EventAtom atom;
+
+#ifdef AG_THREADS
+	(void)StopEventPool();
+	AG_CondDestroy(&agEventPoolCond);
+	AG_MutexDestroy(&agEventPoolLock);
+
+	AG_AtomicSetUint(&agWakeupSet, 0);
+	agWakeupFn = NULL;
+	AG_MutexDestroy(&agWakeupLock);
+#endif
 	if (agEventSource != NULL) {
 		DestroyEventSource(agEventSource);
 		agEventSource = NULL;
 	}
+#ifdef HAVE_EPOLL
+	if (agTimerHeapFd != -1) {
+		close(agTimerHeapFd);
+		agTimerHeapFd = -1;
+	}
+	Free(agTimerHeap);
+	agTimerHeap = NULL;
+	agTimerHeapCount = 0;
+	agTimerHeapSize = 0;
+#endif
+	if ((tbl = agEventAtoms) != NULL) {
+		for (atom = 1; atom <= agEventAtomCount; atom++)
+			free(tbl->names[atom]);
+	}
+	for (; tbl != NULL; tbl = tblPrev) {
+		tblPrev = tbl->prev;
+		Free(tbl->atoms);
+		Free(tbl->names);
+		Free(tbl);
+	}
+	agEventAtoms = NULL;
+	agEventAtomCount = 0;
+	AG_MutexDestroy(&agEventAtomLock);
 }
 
 #ifdef HAVE_KQUEUE
@@ -1045,6 +1798,14 @@ AG_AddEventSink(enum ag_event_sink_type type, int ident, Uint flags,
 	AG_EVENT_GET_ARGS(&es->fnArgs, fnArgs);
 	es->fnArgs.argc0 = es->fnArgs.argc;
 	TAILQ_INSERT_TAIL(&src->sinks, es, sinks);
+#ifdef HAVE_EPOLL
+	if ((type == AG_SINK_READ || type == AG_SINK_WRITE) &&
+	    UpdateEpollSink((AG_EventSourceEPOLL *)src, ident) == -1) {
+		TAILQ_REMOVE(&src->sinks, es, sinks);
+		free(es);
+		return (NULL);
+	}
+#endif
 	return (es);
 }
 void
@@ -1082,6 +1843,12 @@ AG_DelEventSink(AG_EventSink *es)
 #endif /* HAVE_KQUEUE */
 
 	TAILQ_REMOVE(&src->sinks, es, sinks);
+#ifdef HAVE_EPOLL
+	if (es->type == AG_SINK_READ || es->type == AG_SINK_WRITE) {
+		if (UpdateEpollSink((AG_EventSourceEPOLL *)src, es->ident) == -1)
+			Verbose("DelEventSink: %s\n", AG_GetError());
+	}
+#endif
 	free(es);
 }
 void
@@ -1171,6 +1938,7 @@ restart:
 			AG_EV_SET(kev, to->id, EVFILT_TIMER,
 			    EV_ADD|EV_ENABLE|EV_ONESHOT, 0, (int)rvt, to);
 			to->ival = rvt;
+			to->tSched = AG_GetTicks() + rvt;
 		} else {				/* Expire */
 #ifdef DEBUG_TIMERS
 			Verbose("TIMER[%d] expired\n", to->id);
@@ -1267,6 +2035,7 @@ AG_AddTimerKQUEUE(AG_Timer *to, Uint32 ival, int newTimer)
 		AG_EV_SET(kev, to->id, EVFILT_TIMER,
 		    EV_ADD|EV_ENABLE|EV_ONESHOT, 0, (int)ival, to);
 		to->ival = ival;
+		to->tSched = AG_GetTicks() + ival;
 	}
 	return (0);
 }
@@ -1347,7 +2116,9 @@ restart:
 	     ob != TAILQ_END(&agTimerObjQ);
 	     ob = obNext) {
 		obNext = TAILQ_NEXT(ob, tobjs);
-		AG_ObjectLock(ob);
+		if (AG_MutexTryLock(&ob->lock) != 0) {
+			continue;		/* Busy; timerfds stay readable */
+		}
 		for (to = TAILQ_FIRST(&ob->timers);
 		     to != TAILQ_END(&ob->timers);
 		     to = toNext) {
@@ -1368,6 +2139,8 @@ restart:
 					Verbose("timerfd_settime: %s\n", AG_Strerror(errno));
 					FD_CLR(to->id, &rdFds);
 					AG_DelTimer(ob, to);
+				} else {
+					to->tSched = AG_GetTicks() + rvt;
 				}
 			} else {
 				FD_CLR(to->id, &rdFds);
@@ -1422,6 +2195,7 @@ AG_AddTimerTIMERFD(AG_Timer *to, Uint32 ival, int newTimer)
 		return (-1);
 	}
 	to->ival = ival;
+	to->tSched = AG_GetTicks() + ival;
 	return (0);
 }
 void
@@ -1434,6 +2208,310 @@ AG_DelTimerTIMERFD(AG_Timer *to)
 }
 #endif /* HAVE_TIMERFD */
 
+#ifdef HAVE_EPOLL
+/*
+ * Timers for the epoll(7) event sink are kept in a binary min-heap ordered
+ * by expiration time (shared by all event sources), and a single timerfd
+ * is armed for the earliest deadline. The heap index of a timer is stored
+ * in its id field, so that it can be rescheduled or removed in O(log n).
+ * The heap is protected by agTimerLock (see AG_LockTiming()).
+ */
+
+/* Compare two expiration times (with wraparound). */
+#define TIMER_BEFORE(a,b) ((int)((a)->tSched - (b)->tSched) < 0)
+
+static __inline__ void
+TimerHeapSet(Uint i, AG_Timer *to)
+{
+	agTimerHeap[i] = to;
+	to->id = (int)i;
+}
+
+static void
+TimerHeapUp(Uint i)
+{
+	AG_Timer *to = agTimerHeap[i];
+
+	while (i > 0) {
+		Uint parent = (i-1)/2;
+
+		if (!TIMER_BEFORE(to, agTimerHeap[parent])) {
+			break;
+		}
+		TimerHeapSet(i, agTimerHeap[parent]);
+		i = parent;
+	}
+	TimerHeapSet(i, to);
+}
+
+static void
+TimerHeapDown(Uint i)
+{
+	AG_Timer *to = agTimerHeap[i];
+
+	for (;;) {
+		Uint child = 2*i + 1;
+
+		if (child >= agTimerHeapCount) {
+			break;
+		}
+		if (child+1 < agTimerHeapCount &&
+		    TIMER_BEFORE(agTimerHeap[child+1], agTimerHeap[child])) {
+			child++;
+		}
+		if (!TIMER_BEFORE(agTimerHeap[child], to)) {
+			break;
+		}
+		TimerHeapSet(i, agTimerHeap[child]);
+		i = child;
+	}
+	TimerHeapSet(i, to);
+}
+
+/* Remove the timer at heap index i. */
+static void
+TimerHeapRemove(Uint i)
+{
+	AG_Timer *toLast = agTimerHeap[--agTimerHeapCount];
+
+	if (i == agTimerHeapCount) {
+		return;
+	}
+	TimerHeapSet(i, toLast);
+	if (i > 0 && TIMER_BEFORE(toLast, agTimerHeap[(i-1)/2])) {
+		TimerHeapUp(i);
+	} else {
+		TimerHeapDown(i);
+	}
+}
+
+/*
+ * Arm the timerfd for the earliest deadline in the heap (or disarm it if
+ * the heap is empty).
+ */
+static void
+ArmTimerHeap(void)
+{
+	struct itimerspec its;
+	int dt;
+
+	its.it_interval.tv_sec = 0;
+	its.it_interval.tv_nsec = 0L;
+	if (agTimerHeapCount == 0) {
+		its.it_value.tv_sec = 0;
+		its.it_value.tv_nsec = 0L;		/* Disarm */
+	} else {
+		dt = (int)(agTimerHeap[0]->tSched - AG_GetTicks());
+		if (dt > 0) {
+			its.it_value.tv_sec = dt/1000;
+			its.it_value.tv_nsec = (dt % 1000)*1000000L;
+		} else {
+			its.it_value.tv_sec = 0;
+			its.it_value.tv_nsec = 1L;	/* Already expired */
+		}
+	}
+	if (timerfd_settime(agTimerHeapFd, 0, &its, NULL) == -1)
+		Verbose("timerfd_settime: %s\n", AG_Strerror(errno));
+}
+
+/*
+ * Execute the callback routines of expired timers, and re-arm the timerfd
+ * for the next deadline. The caller must use AG_LockTiming().
+ *
+ * Objects are locked before agTimerLock elsewhere (see AG_LockTimers()),
+ * so a timer whose object is busy is left expired, and the timerfd fires
+ * again right away.
+ */
+static void
+ProcessTimerHeap(void)
+{
+	AG_Object *ob;
+	AG_Timer *to;
+	Uint32 t, rv;
+
+	t = AG_GetTicks();
+	while (agTimerHeapCount > 0 &&
+	       (int)(agTimerHeap[0]->tSched - t) <= 0) {
+		to = agTimerHeap[0];
+		ob = to->obj;
+		if (AG_MutexTryLock(&ob->lock) != 0)
+			break;
+		rv = to->fn(to, &to->fnEvent);
+		if (rv > 0) {				/* Restart */
+			if (AG_ResetTimer(ob, to, rv) == -1) {
+				Verbose("%s: %s\n", ob->name, AG_GetError());
+				AG_DelTimer(ob, to);
+			}
+		} else {				/* Cancel */
+			AG_DelTimer(ob, to);
+		}
+		AG_ObjectUnlock(ob);
+	}
+	ArmTimerHeap();
+}
+
+/*
+ * Standard event sink using epoll(7) with persistent registration of I/O
+ * sinks, and a single timerfd armed from the timer heap. Usually available
+ * on Linux.
+ */
+int
+AG_EventSinkEPOLL(void)
+{
+	AG_EventSourceEPOLL *ep = (AG_EventSourceEPOLL *)agEventSource;
+	AG_EventSink *es, *esNext;
+	struct epoll_event *ev;
+	Uint8 nExp[8];
+#ifndef AG_THREADS
+	Uint32 tSoonest;
+#endif
+	int i, nEvents, timeout;
+
+restart:
+	if (!TAILQ_EMPTY(&agEventSource->spinners)) {
+		timeout = 0;
+	} else if (agEventSource->caps[AG_SINK_TIMER]) {
+		timeout = -1;
+	} else {
+		/*
+		 * Soft timers. Other threads may add timers without waking
+		 * us up, so only sleep until the next expiration in
+		 * single-threaded builds.
+		 */
+#ifdef AG_THREADS
+		timeout = 1;
+#else
+		tSoonest = AG_GetNextTimeout(AG_GetTicks());
+		timeout = (tSoonest == 0xfffffffe) ? -1 : (int)tSoonest;
+#endif
+	}
+	nEvents = epoll_wait(ep->fd, ep->events, AG_EPOLL_MAXEVENTS, timeout);
+	if (nEvents == -1) {
+		if (errno == EINTR) {
+			goto restart;
+		}
+		AG_SetError("epoll_wait: %s", AG_Strerror(errno));
+		return (-1);
+	}
+
+	AG_LockTiming();
+
+	/* 1. Process timer expirations. */
+	for (i = 0; i < nEvents; i++) {
+		if (ep->events[i].data.fd == agTimerHeapFd) {
+			if (read(agTimerHeapFd, nExp, sizeof(nExp)) == -1 &&
+			    errno != EAGAIN) {
+				Verbose("timerfd: %s\n", AG_Strerror(errno));
+			}
+			break;
+		}
+	}
+	if (agEventSource->caps[AG_SINK_TIMER]) {
+		ProcessTimerHeap();
+	} else {
+		AG_ProcessTimeouts(AG_GetTicks());
+	}
+
+	/* 2. Process I/O events. */
+	for (i = 0; i < nEvents; i++) {
+		ev = &ep->events[i];
+		if (ev->data.fd == agTimerHeapFd) {
+			continue;
+		}
+		for (es = TAILQ_FIRST(&agEventSource->sinks);
+		     es != TAILQ_END(&agEventSource->sinks);
+		     es = esNext) {
+			esNext = TAILQ_NEXT(es, sinks);
+			if (es->ident != ev->data.fd) {
+				continue;
+			}
+			switch (es->type) {
+			case AG_SINK_READ:
+				if (ev->events & (EPOLLIN|EPOLLHUP|EPOLLERR)) {
+					es->fn(es, &es->fnArgs);
+				}
+				break;
+			case AG_SINK_WRITE:
+				if (ev->events & (EPOLLOUT|EPOLLERR)) {
+					es->fn(es, &es->fnArgs);
+				}
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	AG_UnlockTiming();
+	return (0);
+}
+
+/*
+ * Schedule (or reschedule) a timer in the timer heap.
+ * The caller must use AG_LockTimers().
+ */
+int
+AG_AddTimerEPOLL(AG_Timer *to, Uint32 ival, int newTimer)
+{
+	AG_Timer *toRoot = NULL;
+	Uint32 tRoot = 0;
+
+	if (agTimerHeapCount > 0) {
+		toRoot = agTimerHeap[0];
+		tRoot = toRoot->tSched;
+	}
+	to->tSched = AG_GetTicks() + ival;
+	to->ival = ival;
+	if (newTimer) {
+		if (agTimerHeapCount+1 > agTimerHeapSize) {
+			Uint sizeNew = (agTimerHeapSize > 0) ?
+			               agTimerHeapSize*2 : AG_TIMER_HEAP_INIT;
+			AG_Timer **heapNew;
+
+			if ((heapNew = TryRealloc(agTimerHeap,
+			    sizeNew*sizeof(AG_Timer *))) == NULL) {
+				return (-1);
+			}
+			agTimerHeap = heapNew;
+			agTimerHeapSize = sizeNew;
+		}
+		TimerHeapSet(agTimerHeapCount++, to);
+		TimerHeapUp((Uint)to->id);
+	} else {
+#ifdef AG_DEBUG
+		if (to->id < 0 || (Uint)to->id >= agTimerHeapCount ||
+		    agTimerHeap[to->id] != to)
+			AG_FatalError("Timer heap inconsistency");
+#endif
+		TimerHeapUp((Uint)to->id);
+		TimerHeapDown((Uint)to->id);
+	}
+	if (agTimerHeap[0] != toRoot || agTimerHeap[0]->tSched != tRoot) {
+		ArmTimerHeap();
+	}
+	return (0);
+}
+
+/*
+ * Remove a timer from the timer heap.
+ * The caller must use AG_LockTimers().
+ */
+void
+AG_DelTimerEPOLL(AG_Timer *to)
+{
+#ifdef AG_DEBUG
+	if (to->id < 0 || (Uint)to->id >= agTimerHeapCount ||
+	    agTimerHeap[to->id] != to)
+		AG_FatalError("Timer heap inconsistency");
+#endif
+	TimerHeapRemove((Uint)to->id);
+	if (to->id == 0)
+		ArmTimerHeap();
+}
+
+#undef TIMER_BEFORE
+#endif /* HAVE_EPOLL */
+
 #if defined(HAVE_SELECT) && !defined(AG_THREADS)
 /*
  * Standard event sink using select(2) with timers implemented using the
@@ -1445,12 +2523,10 @@ int
 AG_EventSinkTIMEDSELECT(void)
 {
 	fd_set rdFds, wrFds;
-	int i, nFds, rv;
+	int nFds, rv;
 	AG_EventSink *es;
-	AG_Object *ob, *obNext;
-	AG_Timer *to, *toNext;
-	struct timeval timeo, *pTimeo;
-	Uint32 t, tSoonest;
+	struct timeval timeo;
+	Uint32 tSoonest;
 
 restart:
 	nFds = 0;
@@ -1466,6 +2542,8 @@ restart:
 			FD_SET(es->ident, &wrFds);
 			if (es->ident > nFds) { nFds = es->ident; }
 			break;
+		default:
+			break;
 		}
 	}
 
@@ -1473,18 +2551,9 @@ restart:
 		timeo.tv_sec = 0;
 		timeo.tv_usec = 0;
 	} else {
-		AG_LockTiming();
-		t = AG_GetTicks();
-		tSoonest = 0xfffffffe;
-		TAILQ_FOREACH(ob, &agTimerObjQ, tobjs) {
-			TAILQ_FOREACH(to, &ob->timers, timers) {
-				if ((to->tSched - t) < tSoonest)
-					tSoonest = (to->tSched - t);
-			}
-		}
+		tSoonest = AG_GetNextTimeout(AG_GetTicks());
 		timeo.tv_sec = tSoonest/1000;
 		timeo.tv_usec = (tSoonest % 1000)*1000;
-		AG_UnlockTiming();
 	}
 	rv = select(nFds+1, &rdFds, &wrFds, NULL, &timeo);
 	if (rv == -1) {
@@ -1497,7 +2566,7 @@ restart:
 	
 	AG_LockTiming();
 	/* 1. Process timer expirations. */
-	AG_ProcessTimeouts(t);
+	AG_ProcessTimeouts(AG_GetTicks());
 	if (rv > 0) {
 		/* 2. Process I/O events */
 		TAILQ_FOREACH(es, &agEventSource->sinks, sinks) {
@@ -1512,6 +2581,8 @@ restart:
 					es->fn(es, &es->fnArgs);
 				}
 				break;
+			default:
+				break;
 			}
 		}
 	}
@@ -1641,6 +2712,93 @@ AG_EventLoop(void)
 	return (src->returnCode);
 }
 
+/*
+ * Return the number of ticks until the next timer of the current event
+ * source is due, or 0xfffffffe if there are no timers. This is used by
+ * spinners which block outside of the event source (such as in a graphics
+ * library's own wait routine). I/O sinks are not taken into account; they
+ * are polled by the event source whenever the spinner returns.
+ */
+Uint32
+AG_GetEventSourceTimeout(void)
+{
+	AG_EventSource *src = AG_GetEventSource();
+	Uint32 t = AG_GetTicks(), dt = 0xfffffffe;
+	AG_Object *ob;
+	AG_Timer *to;
+
+	if (!src->caps[AG_SINK_TIMER]) {		/* Soft timers */
+		return AG_GetNextTimeout(t);
+	}
+	AG_LockTiming();
+#ifdef HAVE_EPOLL
+	if (src->sinkFn == AG_EventSinkEPOLL) {		/* Timer heap */
+		if (agTimerHeapCount > 0) {
+			dt = ((int)(agTimerHeap[0]->tSched - t) > 0) ?
+			     (agTimerHeap[0]->tSched - t) : 0;
+		}
+		AG_UnlockTiming();
+		return (dt);
+	}
+#endif
+	/*
+	 * Kernel timers (kqueue, timerfd); scan their expiration times. The
+	 * timer lists only change under agTimerLock, and the objects must not
+	 * be locked here (see AG_LockTimers()).
+	 */
+	TAILQ_FOREACH(ob, &agTimerObjQ, tobjs) {
+		TAILQ_FOREACH(to, &ob->timers, timers) {
+			if ((int)(to->tSched - t) <= 0) {
+				dt = 0;
+			} else if (to->tSched - t < dt) {
+				dt = to->tSched - t;
+			}
+		}
+	}
+	AG_UnlockTiming();
+	return (dt);
+}
+
+/*
+ * Set the routine used to wake up the event-processing thread when it is
+ * blocked outside of the event source (e.g., in a graphics driver's event
+ * wait). The routine may be invoked from any thread.
+ */
+void
+AG_SetWakeupCallback(void (*fn)(void))
+{
+#ifdef AG_THREADS
+	AG_MutexLock(&agWakeupLock);
+	agWakeupFn = fn;
+	AG_AtomicSetUint(&agWakeupSet, (fn != NULL));
+	AG_MutexUnlock(&agWakeupLock);
+#endif
+}
+
+/*
+ * Wake up the event-processing thread, so that it takes into account a new
+ * timer, a redraw request or any other state change made from another
+ * thread. This is a no-op in the event-processing thread itself, and
+ * costs a single atomic load if no wakeup routine is set.
+ */
+void
+AG_WakeupEventLoop(void)
+{
+#ifdef AG_THREADS
+	void (*fn)(void);
+
+	if (!AG_AtomicGetUint(&agWakeupSet) ||
+	    AG_ThreadEqual(AG_ThreadSelf(), agEventThread)) {
+		return;
+	}
+	AG_MutexLock(&agWakeupLock);
+	fn = agWakeupFn;
+	AG_MutexUnlock(&agWakeupLock);
+	if (fn != NULL)
+		fn();
+#endif
+}
+
 /* Request that we break out of AG_EventLoop(). */
 void
 AG_Terminate(int retCode)
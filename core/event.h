@@ -43,16 +43,40 @@
 struct ag_timer;
 struct ag_event_sink;
 
+/* Interned event name (0 = not interned) */
+typedef Uint AG_EventAtom;
+
+/* Event handler argument (16 bytes) */
+typedef struct ag_event_arg {
+	union {
+		void *p;
+		const void *Cp;
+		char *s;
+		const char *Cs;
+		int i;
+		Uint u;
+		float flt;
+		double dbl;
+		Uint32 u32;
+		Sint32 s32;
+	} data;					/* Argument value */
+	AG_VariableType type;			/* Argument type */
+	AG_EventAtom key;			/* Interned name (or 0) */
+} AG_EventArg;
+
 /* Event handler / virtual function */
 typedef struct ag_event {
 	char name[AG_EVENT_NAME_MAX];		/* String identifier */
 	Uint flags;
 #define	AG_EVENT_ASYNC     0x01			/* Service in separate thread */
 #define AG_EVENT_PROPAGATE 0x02			/* Forward to child objs */
+#define AG_EVENT_ASYNC_SERIAL 0x08		/* Serialize ASYNC per receiver */
 	union ag_function fn;			/* Callback function */
 	int argc, argc0;			/* Argument count & offset */
-	AG_Variable argv[AG_EVENT_ARGS_MAX];	/* Argument values */
 	AG_TAILQ_ENTRY(ag_event) events;	/* Entry in Object */
+	AG_EventAtom atom;			/* Interned name */
+	struct ag_event *atomNext;		/* Next entry in Object index */
+	AG_EventArg argv[AG_EVENT_ARGS_MAX];	/* Argument values (keep last) */
 } AG_Event, AG_Function;
 
 /* Low-level event sink */
@@ -113,6 +137,19 @@ typedef struct ag_event_queue {
 	AG_Event *events;
 } AG_EventQ;
 
+/* Statistics of the AG_EVENT_ASYNC worker pool */
+typedef struct ag_event_pool_stats {
+	Uint   nThreads;		/* Running worker threads */
+	Uint   nSlots;			/* Preallocated event slots */
+	Uint   nQueued;			/* Events currently queued */
+	Uint   nQueuedMax;		/* Highest queue depth observed */
+	Uint   nRunning;		/* Events currently executing */
+	Ulong  nProcessed;		/* Events processed by workers */
+	Ulong  nOverflow;		/* Events queued beyond nSlots */
+	Uint32 latencyAvg;		/* Mean queueing latency (ticks) */
+	Uint32 latencyMax;		/* Highest queueing latency (ticks) */
+} AG_EventPoolStats;
+
 typedef void (*AG_EventFn)(AG_Event *);
 
 #ifdef AG_DEBUG
@@ -126,28 +163,20 @@ typedef void (*AG_EventFn)(AG_Event *);
 #define AG_EVENT_INS_VAL(eev,tname,aname,member,val) {			\
 	AG_EVENT_BOUNDARY_CHECK(eev)					\
 	(eev)->argv[(eev)->argc].type = (tname);			\
-	if ((aname) != NULL) {						\
-		AG_Strlcpy((eev)->argv[(eev)->argc].name, (aname),	\
-		        AG_VARIABLE_NAME_MAX);				\
-	} else {							\
-		(eev)->argv[(eev)->argc].name[0] = '\0';		\
-	}								\
-	(eev)->argv[(eev)->argc].mutex = NULL;				\
+	(eev)->argv[(eev)->argc].key = ((aname) != NULL) ?		\
+	    AG_InternEventName(aname) : 0;				\
 	(eev)->argv[(eev)->argc].data.member = (val);			\
-	(eev)->argv[(eev)->argc].fn.fnVoid = NULL;			\
 	(eev)->argc++;							\
 }
 #define AG_EVENT_INS_ARG(eev,ap,tname,member,t) { 			\
 	V = &(eev)->argv[(eev)->argc];					\
 	AG_EVENT_BOUNDARY_CHECK(eev)					\
 	V->type = (tname);						\
-	V->mutex = NULL;						\
 	V->data.member = va_arg(ap,t);					\
-	V->fn.fnVoid = NULL;						\
 	(eev)->argc++;							\
 }
 #define AG_EVENT_PUSH_ARG(ap,ev) {					\
-	AG_Variable *V;							\
+	AG_EventArg *V;							\
 									\
 	switch (*c) {							\
 	case 'p':							\
@@ -216,9 +245,9 @@ typedef void (*AG_EventFn)(AG_Event *);
 	}								\
 	c++;								\
 	if (*c == '(' && c[1] != '\0') {				\
-		char *cEnd;						\
-		AG_Strlcpy(V->name, &c[1], sizeof(V->name));		\
-		for (cEnd = V->name; *cEnd != '\0'; cEnd++) {		\
+		char key[AG_VARIABLE_NAME_MAX], *cEnd;		\
+		AG_Strlcpy(key, &c[1], sizeof(key));			\
+		for (cEnd = key; *cEnd != '\0'; cEnd++) {		\
 			if (*cEnd == ')') {				\
 				*cEnd = '\0';				\
 				c+=2;					\
@@ -226,8 +255,9 @@ typedef void (*AG_EventFn)(AG_Event *);
 			}						\
 			c++;						\
 		}							\
+		V->key = AG_InternEventName(key);			\
 	} else {							\
-		V->name[0] = '\0';					\
+		V->key = 0;						\
 	}								\
 }
 
@@ -277,8 +307,14 @@ AG_Function *AG_SetTextFn(void *, AG_TextFn, const char *, ...);
 
 void      AG_UnsetEvent(void *, const char *);
 void      AG_PostEvent(void *, void *, const char *, const char *, ...);
+void      AG_PostEventAtom(void *, void *, AG_EventAtom, const char *, ...);
 void      AG_PostEventByPtr(void *, void *, AG_Event *, const char *, ...);
 AG_Event *AG_FindEventHandler(void *, const char *);
+AG_Event *AG_FindEventHandlerAtom(void *, AG_EventAtom);
+
+AG_EventAtom AG_InternEventName(const char *);
+AG_EventAtom AG_LookupEventAtom(const char *);
+const char  *AG_GetEventAtomName(AG_EventAtom);
 
 void      AG_InitEventQ(AG_EventQ *);
 void      AG_FreeEventQ(AG_EventQ *);
@@ -288,6 +324,9 @@ int       AG_SchedEvent(void *, void *, Uint32, const char *,
                         const char *, ...);
 void      AG_ForwardEvent(void *, void *, AG_Event *);
 
+int       AG_SetEventPoolSize(Uint, Uint);
+void      AG_GetEventPoolStats(AG_EventPoolStats *);
+
 int             AG_EventLoop(void);
 AG_EventSource *AG_GetEventSource(void);
 AG_EventSink   *AG_AddEventPrologue(AG_EventSinkFn, const char *, ...);
@@ -303,12 +342,19 @@ void            AG_DelEventSinksByIdent(enum ag_event_sink_type, int, Uint);
 void            AG_Terminate(int);
 void            AG_TerminateEv(AG_Event *);
 
+Uint32          AG_GetEventSourceTimeout(void);
+void            AG_SetWakeupCallback(void (*)(void));
+void            AG_WakeupEventLoop(void);
+
 int             AG_AddTimerKQUEUE(struct ag_timer *, Uint32, int);
 void            AG_DelTimerKQUEUE(struct ag_timer *);
 int             AG_AddTimerTIMERFD(struct ag_timer *, Uint32, int);
 void            AG_DelTimerTIMERFD(struct ag_timer *);
+int             AG_AddTimerEPOLL(struct ag_timer *, Uint32, int);
+void            AG_DelTimerEPOLL(struct ag_timer *);
 int             AG_EventSinkKQUEUE(void);
 int             AG_EventSinkTIMERFD(void);
+int             AG_EventSinkEPOLL(void);
 int             AG_EventSinkTIMEDSELECT(void);
 int             AG_EventSinkSELECT(void);
 int             AG_EventSinkSPINNER(void);
@@ -327,14 +373,17 @@ static __inline__ void AG_EventPopArgument(AG_Event *ev) { ev->argc--; }
 /*
  * Accessor functions for AG_FOO_NAMED() macros.
  */
-static __inline__ AG_Variable *
+static __inline__ AG_EventArg *
 AG_GetNamedEventArg(AG_Event *ev, const char *key)
 {
+	AG_EventAtom atom;
 	int i;
 
-	for (i = 0; i < ev->argc; i++) {
-		if (strcmp(ev->argv[i].name, key) == 0)
-			return (&ev->argv[i]);
+	if ((atom = AG_LookupEventAtom(key)) != 0) {
+		for (i = 0; i < ev->argc; i++) {
+			if (ev->argv[i].key == atom)
+				return (&ev->argv[i]);
+		}
 	}
 	AG_FatalError("No such AG_Event argument: \"%s\"", key);
 	return (NULL);
@@ -342,49 +391,49 @@ AG_GetNamedEventArg(AG_Event *ev, const char *key)
 static __inline__ void *
 AG_GetNamedPtr(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return (V->data.p);
 }
 static __inline__ char *
 AG_GetNamedString(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return (V->data.s);
 }
 static __inline__ int
 AG_GetNamedInt(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return (V->data.i);
 }
 static __inline__ Uint
 AG_GetNamedUint(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return (V->data.u);
 }
 static __inline__ long
 AG_GetNamedLong(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return ((long)V->data.s32);
 }
 static __inline__ Ulong
 AG_GetNamedUlong(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return ((Ulong)V->data.u32);
 }
 static __inline__ float
 AG_GetNamedFlt(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return (V->data.flt);
 }
 static __inline__ double
 AG_GetNamedDbl(AG_Event *event, const char *key)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 	return (V->data.dbl);
 }
 
@@ -81,10 +81,16 @@ AG_ObjectInit(void *p, void *cl)
 	AG_MutexInitRecursive(&ob->lock);
 	
 	TAILQ_INIT(&ob->vars);
+	ob->varIndex = NULL;
+	ob->varIndexSize = 0;
+	ob->nVars = 0;
 	TAILQ_INIT(&ob->deps);
 	TAILQ_INIT(&ob->children);
 	TAILQ_INIT(&ob->events);
 	TAILQ_INIT(&ob->timers);
+	ob->evIndex = NULL;
+	ob->evIndexSize = 0;
+	ob->nEvents = 0;
 	
 	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) == 0) {
 		for (i = 0; i < nHier; i++) {
@@ -759,9 +765,130 @@ AG_ObjectFreeVariables(void *pObj)
 		free(V);
 	}
 	TAILQ_INIT(&ob->vars);
+	Free(ob->varIndex);
+	ob->varIndex = NULL;
+	ob->varIndexSize = 0;
+	ob->nVars = 0;
 	AG_ObjectUnlock(ob);
 }
 
+/* Hash a variable name (up to AG_VARIABLE_NAME_MAX-1 characters). */
+static __inline__ Uint
+HashVariableName(const char *name)
+{
+	const Uchar *c;
+	Uint h = 2166136261U;
+	int i;
+
+	for (c = (const Uchar *)name, i = 0;
+	     *c != '\0' && i < AG_VARIABLE_NAME_MAX-1;
+	     c++, i++) {
+		h = (h ^ *c) * 16777619U;
+	}
+	return (h);
+}
+
+/*
+ * Rebuild the variable index (open addressing with linear probing) from
+ * the list of variables. The list itself remains the authority on order.
+ */
+static void
+RebuildVariableIndex(AG_Object *ob, Uint size)
+{
+	AG_Variable *V;
+	Uint i, mask = size-1;
+
+	Free(ob->varIndex);
+	ob->varIndex = Malloc(size*sizeof(AG_Variable *));
+	memset(ob->varIndex, 0, size*sizeof(AG_Variable *));
+	ob->varIndexSize = size;
+
+	TAILQ_FOREACH(V, &ob->vars, vars) {
+		for (i = V->hash & mask;
+		     ob->varIndex[i] != NULL;
+		     i = (i+1) & mask)
+			;;
+		ob->varIndex[i] = V;
+	}
+}
+
+/*
+ * Append a new variable to the object's list of variables. Once the
+ * object has more than AG_OBJECT_VAR_INDEX_MIN variables, they are also
+ * entered into a hash index. The object must be locked.
+ */
+void
+AG_ObjectInsertVariable(AG_Object *ob, AG_Variable *V)
+{
+	Uint i, mask;
+
+	V->hash = HashVariableName(V->name);
+	TAILQ_INSERT_TAIL(&ob->vars, V, vars);
+
+	if (++ob->nVars*2 > ob->varIndexSize) {
+		if (ob->nVars > AG_OBJECT_VAR_INDEX_MIN) {
+			RebuildVariableIndex(ob, (ob->varIndexSize > 0) ?
+			    ob->varIndexSize*2 : AG_OBJECT_VAR_INDEX_MIN*4);
+		}
+		return;
+	}
+	mask = ob->varIndexSize-1;
+	for (i = V->hash & mask; ob->varIndex[i] != NULL; i = (i+1) & mask)
+		;;
+	ob->varIndex[i] = V;
+}
+
+/*
+ * Remove a variable from the object's list of variables (the caller is
+ * responsible for freeing it). The object must be locked.
+ */
+void
+AG_ObjectRemoveVariable(AG_Object *ob, AG_Variable *V)
+{
+	AG_Variable *Vi;
+	Uint i, j, k, mask;
+
+	TAILQ_REMOVE(&ob->vars, V, vars);
+	ob->nVars--;
+	if (ob->varIndex == NULL) {
+		return;
+	}
+	mask = ob->varIndexSize-1;
+	for (i = V->hash & mask; ob->varIndex[i] != V; i = (i+1) & mask)
+		;;
+
+	/* Shift back entries which would become unreachable. */
+	for (j = (i+1) & mask;
+	     (Vi = ob->varIndex[j]) != NULL;
+	     j = (j+1) & mask) {
+		k = Vi->hash & mask;
+		if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+			continue;
+		}
+		ob->varIndex[i] = Vi;
+		i = j;
+	}
+	ob->varIndex[i] = NULL;
+}
+
+/*
+ * Look up a variable through the object's hash index. This is used by
+ * AG_ObjectFindVariable() for objects with many variables.
+ */
+AG_Variable *
+AG_ObjectLookupVariable(AG_Object *ob, const char *name)
+{
+	AG_Variable *V;
+	Uint h = HashVariableName(name);
+	Uint i, mask = ob->varIndexSize-1;
+
+	for (i = h & mask; (V = ob->varIndex[i]) != NULL; i = (i+1) & mask) {
+		if (V->hash == h && strcmp(V->name, name) == 0)
+			return (V);
+	}
+	return (NULL);
+}
+
 /* Destroy the event handler structures. */
 void
 AG_ObjectFreeEvents(AG_Object *ob)
@@ -776,6 +903,10 @@ AG_ObjectFreeEvents(AG_Object *ob)
 		free(ev);
 	}
 	TAILQ_INIT(&ob->events);
+	Free(ob->evIndex);
+	ob->evIndex = NULL;
+	ob->evIndexSize = 0;
+	ob->nEvents = 0;
 	AG_ObjectUnlock(ob);
 }
 
@@ -1307,6 +1438,7 @@ AG_ObjectLoadGenericFromFile(void *p, const char *pPath)
 #endif
 	if ((ds = AG_OpenFile(path, "rb")) == NULL)
 		goto fail_unlock;
+	AG_DataSourceSetUnlocked(ds, 1);
 
 	/* Free any resident dataset in order to clear the dependencies. */
 	AG_ObjectFreeDataset(ob);
@@ -1430,6 +1562,7 @@ AG_ObjectLoadDataFromFile(void *p, int *dataFound, const char *pPath)
 		*dataFound = 0;
 		goto fail_unlock;
 	}
+	AG_DataSourceSetUnlocked(ds, 1);
 
 	/* Seek to the start of the dataset. */
 	if (AG_ObjectReadHeader(ds, &oh) == -1 ||
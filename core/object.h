@@ -9,6 +9,7 @@
 #define AG_OBJECT_PATH_MAX 1024
 #define AG_OBJECT_LIBS_MAX 128
 #define AG_OBJECT_DIGEST_MAX 170
+#define AG_OBJECT_VAR_INDEX_MIN 8	/* Hash variables of larger objects */
 
 #define AGOBJECT(ob) ((struct ag_object *)(ob))
 #define AGOBJECT_CLASS(obj) ((struct ag_object_class *)(AGOBJECT(obj)->cls))
@@ -74,8 +75,14 @@ typedef struct ag_object {
 				 AG_OBJECT_REMAIN_DATA)
 
 	AG_TAILQ_HEAD_(ag_event) events;	/* Event handlers / virtual fns */
+	AG_Event **evIndex;			/* Event handlers (by atom) */
+	Uint evIndexSize;			/* Index size (power of 2) */
+	Uint nEvents;				/* Event handler count */
 	AG_TAILQ_HEAD_(ag_timer) timers;	/* Running timers */
 	AG_TAILQ_HEAD_(ag_variable) vars;	/* Named variables / bindings */
+	AG_Variable **varIndex;			/* Variables (by name hash) */
+	Uint varIndexSize;			/* Index size (power of 2) */
+	Uint nVars;				/* Variable count */
 	AG_TAILQ_HEAD_(ag_object_dep) deps;	/* Object dependencies */
 	struct ag_objectq children;		/* Child objects */
 	AG_TAILQ_ENTRY(ag_object) cobjs;	/* Entry in parent */
@@ -202,6 +209,9 @@ void	 AG_ObjectUnlinkDatafiles(void *);
 void	 AG_ObjectSetSavePfx(void *, char *);
 
 void	 AG_ObjectFreeVariables(void *);
+void	 AG_ObjectInsertVariable(AG_Object *, AG_Variable *);
+void	 AG_ObjectRemoveVariable(AG_Object *, AG_Variable *);
+AG_Variable *AG_ObjectLookupVariable(AG_Object *, const char *);
 void	 AG_ObjectFreeChildren(void *);
 void 	 AG_ObjectFreeEvents(AG_Object *);
 void	 AG_ObjectFreeDeps(AG_Object *);
@@ -237,6 +247,8 @@ void          AG_ObjectGenName(void *, AG_ObjectClass *, char *, size_t);
 void          AG_ObjectGenNamePfx(void *, const char *, char *, size_t);
 
 #define AG_OfClass(obj,cspec) AG_ClassIsNamed(AGOBJECT(obj)->cls,(cspec))
+#define AG_OfClassPattern(obj,pat) AG_ClassMatchPattern(AGOBJECT(obj)->cls,(pat))
+#define AG_OfSubclass(obj,sup) AG_ClassIsSubclass(AGOBJECT(obj)->cls,(sup))
 
 #ifdef AG_THREADS
 # define AG_ObjectLock(ob) AG_MutexLock(&AGOBJECT(ob)->lock)
@@ -320,20 +332,34 @@ AG_ObjectGetInheritHierString(void *obj, char *buf, size_t buf_size)
 }
 
 /*
- * Evaluate whether the named object variable exists.
- * The object must be locked.
+ * Return the named object variable, or NULL if there is no such variable.
+ * Objects with more than AG_OBJECT_VAR_INDEX_MIN variables are looked up
+ * through their hash index. The object must be locked.
  */
-static __inline__ int
-AG_Defined(void *pObj, const char *name)
+static __inline__ AG_Variable *
+AG_ObjectFindVariable(void *pObj, const char *name)
 {
 	AG_Object *obj = AGOBJECT(pObj);
 	AG_Variable *V;
 
+	if (obj->varIndex != NULL) {
+		return AG_ObjectLookupVariable(obj, name);
+	}
 	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
 		if (strcmp(name, V->name) == 0)
-			return (1);
+			break;
 	}
-	return (0);
+	return (V);
+}
+
+/*
+ * Evaluate whether the named object variable exists.
+ * The object must be locked.
+ */
+static __inline__ int
+AG_Defined(void *pObj, const char *name)
+{
+	return (AG_ObjectFindVariable(pObj, name) != NULL);
 }
 
 /*
@@ -346,15 +372,11 @@ AG_FetchVariable(void *pObj, const char *name, enum ag_variable_type type)
 	AG_Object *obj = (AG_Object *)pObj;
 	AG_Variable *V;
 
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_ObjectFindVariable(obj, name)) == NULL) {
 		V = AG_Malloc(sizeof(AG_Variable));
 		AG_InitVariable(V, type);
 		AG_Strlcpy(V->name, name, sizeof(V->name));
-		AG_TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+		AG_ObjectInsertVariable(obj, V);
 	}
 	return (V);
 }
@@ -381,14 +403,9 @@ AG_FetchVariableOfType(void *pObj, const char *name, enum ag_variable_type type)
 static __inline__ AG_Variable *
 AG_GetVariableLocked(void *pObj, const char *name)
 {
-	AG_Object *obj = AGOBJECT(pObj);
 	AG_Variable *V, *Vtgt;
 
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(name, V->name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_ObjectFindVariable(pObj, name)) == NULL) {
 		return (NULL);
 	}
 	AG_LockVariable(V);
@@ -404,7 +421,7 @@ AG_GetVariableLocked(void *pObj, const char *name)
 static __inline__ void *
 AG_GetNamedObject(AG_Event *event, const char *key, const char *classSpec)
 {
-	AG_Variable *V = AG_GetNamedEventArg(event, key);
+	AG_EventArg *V = AG_GetNamedEventArg(event, key);
 
 	if (!AG_OfClass((struct ag_object *)V->data.p, classSpec)) {
 		AG_FatalError("Argument %s is not a %s", key, classSpec);
@@ -23,10 +23,8 @@ GetProp(void *pObj, const char *key, int t, void *p)
 	AG_Variable *V;
 
 	AG_ObjectLock(obj);
-	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if ((t >= 0 && t != V->type) || strcmp(key, V->name) != 0) {
-			continue;
-		}
+	if ((V = AG_ObjectFindVariable(obj, key)) != NULL &&
+	    (t < 0 || t == V->type)) {
 		switch (AG_VARIABLE_TYPE(V)) {
 		case AG_VARIABLE_INT:    PROP_GET(i, int);	break;
 		case AG_VARIABLE_UINT:   PROP_GET(u, unsigned);	break;
@@ -31,6 +31,7 @@ typedef pthread_key_t AG_ThreadKey;
 __BEGIN_DECLS
 extern pthread_mutexattr_t agRecursiveMutexAttr;
 extern AG_Thread           agEventThread;
+extern AG_Mutex            agAtomicLock;
 __END_DECLS
 #include <agar/core/close.h>
 
@@ -151,6 +152,76 @@ AG_MutexDestroy(AG_Mutex *m)
 		AG_FatalError("pthread_mutex_destroy");
 }
 
+/*
+ * Atomic access to unsigned int and pointer variables shared between threads.
+ * Falls back to a global mutex where the compiler lacks atomic builtins.
+ */
+#if defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7)))
+# define AG_HAVE_ATOMIC_BUILTINS
+#endif
+static __inline__ unsigned int
+AG_AtomicGetUint(volatile unsigned int *p)
+{
+#ifdef AG_HAVE_ATOMIC_BUILTINS
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+	unsigned int rv;
+	AG_MutexLock(&agAtomicLock);
+	rv = *p;
+	AG_MutexUnlock(&agAtomicLock);
+	return (rv);
+#endif
+}
+static __inline__ void
+AG_AtomicSetUint(volatile unsigned int *p, unsigned int v)
+{
+#ifdef AG_HAVE_ATOMIC_BUILTINS
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#else
+	AG_MutexLock(&agAtomicLock);
+	*p = v;
+	AG_MutexUnlock(&agAtomicLock);
+#endif
+}
+static __inline__ unsigned int
+AG_AtomicIncUint(volatile unsigned int *p)
+{
+#ifdef AG_HAVE_ATOMIC_BUILTINS
+	return __atomic_add_fetch(p, 1, __ATOMIC_ACQ_REL);
+#else
+	unsigned int rv;
+	AG_MutexLock(&agAtomicLock);
+	rv = ++(*p);
+	AG_MutexUnlock(&agAtomicLock);
+	return (rv);
+#endif
+}
+static __inline__ void *
+AG_AtomicGetPtr(void *volatile *p)
+{
+#ifdef AG_HAVE_ATOMIC_BUILTINS
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+	void *rv;
+	AG_MutexLock(&agAtomicLock);
+	rv = *p;
+	AG_MutexUnlock(&agAtomicLock);
+	return (rv);
+#endif
+}
+static __inline__ void
+AG_AtomicSetPtr(void *volatile *p, void *v)
+{
+#ifdef AG_HAVE_ATOMIC_BUILTINS
+	__atomic_store_n(p, v, __ATOMIC_RELEASE);
+#else
+	AG_MutexLock(&agAtomicLock);
+	*p = v;
+	AG_MutexUnlock(&agAtomicLock);
+#endif
+}
+
 /*
  * Condition variable interface
  */
@@ -264,6 +335,12 @@ typedef int   AG_ThreadKey;
 #define AG_CondWait(cd,m)
 #define AG_CondTimedWait(cd,m,t)
 
+#define AG_AtomicGetUint(p)		(*(p))
+#define AG_AtomicSetUint(p,v)		(*(p) = (v))
+#define AG_AtomicIncUint(p)		(++(*(p)))
+#define AG_AtomicGetPtr(p)		(*(p))
+#define AG_AtomicSetPtr(p,v)		(*(p) = (v))
+
 static __inline__ int AG_MutexTryInit(AG_Mutex *mu) { return (0); }
 static __inline__ int AG_MutexTryInitRecursive(AG_Mutex *mu) { return (0); }
 static __inline__ int AG_MutexTryLock(AG_Mutex *mu) { return (0); }
@@ -18,6 +18,7 @@ typedef struct ag_timer {
 	AG_Event fnEvent;
 	AG_TAILQ_ENTRY(ag_timer) timers;
 	AG_TAILQ_ENTRY(ag_timer) change;
+	AG_TAILQ_ENTRY(ag_timer) wheel;	/* Entry in soft timing wheel */
 #ifdef AG_LEGACY
 	Uint32 (*fnLegacy)(void *p, Uint32 ival, void *arg);
 	void   *argLegacy;
@@ -70,6 +71,7 @@ int	  AG_TimerIsRunning(void *, AG_Timer *);
 int       AG_TimerWait(void *, AG_Timer *, Uint32);
 
 void    AG_ProcessTimeouts(Uint32);
+Uint32  AG_GetNextTimeout(Uint32);
 
 /* Execute a timer's associated callback routine. */
 static __inline__ Uint32
@@ -34,11 +34,115 @@ Uint              agTimerCount = 0;
 AG_Object         agTimerMgr;
 AG_Mutex          agTimerLock;
 
+/*
+ * Hierarchical timing wheel used for soft timers (when the event source
+ * does not provide AG_SINK_TIMER). Level 0 has one slot per tick for the
+ * next 256 ticks; each of the 4 upper levels has 64 slots covering
+ * progressively coarser ranges, and is cascaded down as time advances.
+ * Insertion and cancellation are O(1), and processing is O(expired) per
+ * tick. The slot number of a scheduled timer is stored in its id field.
+ * The wheel is protected by agTimerLock.
+ */
+#define WHEEL_BITS0	8
+#define WHEEL_BITS	6
+#define WHEEL_SIZE0	(1 << WHEEL_BITS0)
+#define WHEEL_SIZE	(1 << WHEEL_BITS)
+#define WHEEL_MASK0	(WHEEL_SIZE0 - 1)
+#define WHEEL_MASK	(WHEEL_SIZE - 1)
+#define WHEEL_LEVELS	5
+#define WHEEL_SLOTS	(WHEEL_SIZE0 + (WHEEL_LEVELS-1)*WHEEL_SIZE)
+#define WHEEL_EXPIRED	WHEEL_SLOTS		/* Timers being processed */
+
+/* Slot number in level l (> 0) for expiration time t. */
+#define WHEEL_SLOT(l,t) \
+	(WHEEL_SIZE0 + ((l)-1)*WHEEL_SIZE + \
+	 (((t) >> (WHEEL_BITS0 + ((l)-1)*WHEEL_BITS)) & WHEEL_MASK))
+
+static AG_TAILQ_HEAD(ag_timer_slot, ag_timer) agTimerWheel[WHEEL_SLOTS+1];
+static Uint   agTimerWheelCount = 0;		/* Timers in the wheel */
+static Uint   agTimerWheelCount0 = 0;		/* Timers in level 0 */
+static Uint32 agTimerWheelTime = 0;		/* Next tick to process */
+
+/* Insert a timer in the slot matching its expiration time. */
+static void
+WheelInsert(AG_Timer *to)
+{
+	Uint32 tExp = to->tSched, dt;
+	int slot;
+
+	if (agTimerWheelCount == 0 && agTimerWheelCount0 == 0) {
+		agTimerWheelTime = AG_GetTicks();
+	}
+	if ((int)(tExp - agTimerWheelTime) < 0) {	/* Already expired */
+		tExp = agTimerWheelTime;
+	}
+	dt = tExp - agTimerWheelTime;
+
+	if (dt < (1U << WHEEL_BITS0)) {
+		slot = tExp & WHEEL_MASK0;
+		agTimerWheelCount0++;
+	} else if (dt < (1U << (WHEEL_BITS0 + WHEEL_BITS))) {
+		slot = WHEEL_SLOT(1, tExp);
+	} else if (dt < (1U << (WHEEL_BITS0 + 2*WHEEL_BITS))) {
+		slot = WHEEL_SLOT(2, tExp);
+	} else if (dt < (1U << (WHEEL_BITS0 + 3*WHEEL_BITS))) {
+		slot = WHEEL_SLOT(3, tExp);
+	} else {
+		slot = WHEEL_SLOT(4, tExp);
+	}
+	TAILQ_INSERT_TAIL(&agTimerWheel[slot], to, wheel);
+	to->id = slot;
+	agTimerWheelCount++;
+}
+
+/* Remove a timer from its slot. */
+static void
+WheelRemove(AG_Timer *to)
+{
+#ifdef AG_DEBUG
+	if (to->id < 0 || to->id > WHEEL_EXPIRED)
+		AG_FatalError("Timing wheel inconsistency");
+#endif
+	TAILQ_REMOVE(&agTimerWheel[to->id], to, wheel);
+	if (to->id < WHEEL_SIZE0) {
+		agTimerWheelCount0--;
+	}
+	agTimerWheelCount--;
+	to->id = -1;
+}
+
+/* Redistribute the timers of an upper-level slot into lower levels. */
+static int
+WheelCascade(int l)
+{
+	struct ag_timer_slot *slot;
+	AG_Timer *to;
+	int idx;
+
+	idx = (agTimerWheelTime >> (WHEEL_BITS0 + (l-1)*WHEEL_BITS)) &
+	      WHEEL_MASK;
+	slot = &agTimerWheel[WHEEL_SLOT(l, agTimerWheelTime)];
+	while ((to = TAILQ_FIRST(slot)) != NULL) {
+		WheelRemove(to);
+		WheelInsert(to);
+	}
+	return (idx);
+}
+
 void
 AG_InitTimers(void)
 {
+	int i;
+
 	AG_MutexInitRecursive(&agTimerLock);
 	AG_ObjectInitStatic(&agTimerMgr, NULL);
+
+	for (i = 0; i <= WHEEL_EXPIRED; i++) {
+		TAILQ_INIT(&agTimerWheel[i]);
+	}
+	agTimerWheelCount = 0;
+	agTimerWheelCount0 = 0;
+	agTimerWheelTime = 0;
 }
 
 void
@@ -62,7 +166,6 @@ AG_AddTimer(void *p, AG_Timer *to, Uint32 ival, AG_TimerFn fn,
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? p : &agTimerMgr;
-	AG_Timer *toOther;
 	int newTimer = 0;
 	AG_Event *ev;
 	
@@ -81,35 +184,23 @@ AG_AddTimer(void *p, AG_Timer *to, Uint32 ival, AG_TimerFn fn,
 			AG_FatalError("Timer is in a different object (%s != %s)",
 			    OBJECT(to->obj)->name, ob->name);
 		}
-	} else {				/* Ordered timing wheel */
+	} else {				/* Global timing wheel */
 		if (to->obj == NULL) {
+			if (TAILQ_EMPTY(&ob->timers)) {
+				TAILQ_INSERT_TAIL(&agTimerObjQ, ob, tobjs);
+			}
+			TAILQ_INSERT_TAIL(&ob->timers, to, timers);
 			newTimer = 1;
 			to->obj = ob;
 		} else if (to->obj != ob) {
 			AG_FatalError("Timer is in a different object (%s != %s)",
 			    OBJECT(to->obj)->name, ob->name);
-		}
-		if (TAILQ_EMPTY(&ob->timers)) {
-			TAILQ_INSERT_TAIL(&agTimerObjQ, ob, tobjs);
+		} else if (to->id != -1) {
+			WheelRemove(to);
 		}
 		to->tSched = AG_GetTicks()+ival;
-reinsert:
-		TAILQ_FOREACH(toOther, &ob->timers, timers) {
-			if (toOther == to) {
-				newTimer = 0;
-				TAILQ_REMOVE(&ob->timers, to, timers);
-				goto reinsert;
-			}
-			if (to->tSched < toOther->tSched) {
-				TAILQ_INSERT_BEFORE(toOther, to, timers);
-				break;
-			}
-		}
-		if (toOther == TAILQ_END(&ob->timers)) {
-			TAILQ_INSERT_TAIL(&ob->timers, to, timers);
-		}
 		to->ival = ival;
-		to->id = 0;				/* Not needed */
+		WheelInsert(to);
 	}
 
 	to->fn = fn;
@@ -124,8 +215,12 @@ reinsert:
 		goto fail;
 	}
 	AG_UnlockTimers(ob);
+	AG_WakeupEventLoop();		/* Deadline may be sooner */
 	return (0);
 fail:
+	if (!src->caps[AG_SINK_TIMER] && to->id != -1) {
+		WheelRemove(to);
+	}
 	to->obj = NULL;
 	TAILQ_REMOVE(&ob->timers, to, timers);
 	if (TAILQ_EMPTY(&ob->timers)) { TAILQ_REMOVE(&agTimerObjQ, ob, tobjs); }
@@ -192,7 +287,6 @@ AG_ResetTimer(void *p, AG_Timer *to, Uint32 ival)
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? p : &agTimerMgr;
-	AG_Timer *toOther;
 	int rv = 0;
 	
 	AG_LockTimers(ob);
@@ -201,21 +295,19 @@ AG_ResetTimer(void *p, AG_Timer *to, Uint32 ival)
 		rv = -1;
 		goto out;
 	}
-	if (!src->caps[AG_SINK_TIMER]) {	/* Ordered timing wheel */
-		to->tSched = AG_GetTicks()+ival;
-		TAILQ_REMOVE(&ob->timers, to, timers);
-		TAILQ_FOREACH(toOther, &ob->timers, timers) {
-			if (to->tSched < toOther->tSched) {
-				TAILQ_INSERT_BEFORE(toOther, to, timers);
-				break;
-			}
+	if (!src->caps[AG_SINK_TIMER]) {	/* Global timing wheel */
+		if (to->id != -1) {
+			WheelRemove(to);
 		}
-		if (toOther == TAILQ_END(&ob->timers))
-			TAILQ_INSERT_TAIL(&ob->timers, to, timers);
+		to->tSched = AG_GetTicks()+ival;
+		WheelInsert(to);
 	}
 	to->ival = ival;
 out:
 	AG_UnlockTimers(ob);
+	if (rv == 0) {
+		AG_WakeupEventLoop();
+	}
 	return (rv);
 }
 
@@ -225,20 +317,18 @@ AG_DelTimer(void *p, AG_Timer *to)
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? p : &agTimerMgr;
-	AG_Timer *toOther;
 
 	AG_LockTimers(ob);
 	
-	TAILQ_FOREACH(toOther, &ob->timers, timers) {
-		if (toOther == to)
-			break;
-	}
-	if (toOther == NULL) 		/* Timer is not active */
+	if (to->obj != ob) 		/* Timer is not active */
 		goto out;
 
 	if (src->delTimerFn != NULL) {
 		src->delTimerFn(to);
 	}
+	if (!src->caps[AG_SINK_TIMER] && to->id != -1) {
+		WheelRemove(to);
+	}
 	to->id = -1;
 	to->obj = NULL;
 
@@ -260,13 +350,8 @@ int
 AG_TimerIsRunning(void *p, AG_Timer *to)
 {
 	AG_Object *ob = (p != NULL) ? p : &agTimerMgr;
-	AG_Timer *toRunning;
 
-	TAILQ_FOREACH(toRunning, &ob->timers, timers) {
-		if (toRunning == to)
-			break;
-	}
-	return (toRunning != NULL);
+	return (to->obj == ob);
 }
 
 /*
@@ -293,6 +378,37 @@ AG_TimerWait(void *p, AG_Timer *to, Uint32 timeout)
 	return (0);
 }
 
+/*
+ * Run the callbacks of the timers on the expired list. Objects are locked
+ * before agTimerLock elsewhere (see AG_LockTimers()), so if the object of
+ * a timer is busy, leave the timer on the list for the next call and
+ * return -1. The caller must use AG_LockTiming().
+ */
+static int
+WheelRunExpired(void)
+{
+	struct ag_timer_slot *expired = &agTimerWheel[WHEEL_EXPIRED];
+	AG_Timer *to;
+	AG_Object *ob;
+	Uint32 rv;
+
+	while ((to = TAILQ_FIRST(expired)) != NULL) {
+		ob = to->obj;
+		if (AG_MutexTryLock(&ob->lock) != 0) {
+			return (-1);
+		}
+		WheelRemove(to);
+		rv = to->fn(to, &to->fnEvent);
+		if (rv > 0) {				/* Restart */
+			(void)AG_ResetTimer(ob, to, rv);
+		} else {				/* Cancel */
+			AG_DelTimer(ob, to);
+		}
+		AG_ObjectUnlock(ob);
+	}
+	return (0);
+}
+
 /*
  * Execute the callback routines of expired timers using AG_GetTicks()
  * as a time source. This is used on platforms where system timers are not
@@ -304,37 +420,83 @@ AG_TimerWait(void *p, AG_Timer *to, Uint32 timeout)
 void
 AG_ProcessTimeouts(Uint32 t)
 {
-	AG_Timer *to, *toNext;
-	AG_Object *ob, *obNext;
-	Uint32 rv;
+	struct ag_timer_slot *expired = &agTimerWheel[WHEEL_EXPIRED];
+	AG_Timer *to;
+	Uint32 tNext;
+	int idx;
 
 	AG_LockTiming();
 
-	for (ob = TAILQ_FIRST(&agTimerObjQ);
-	     ob != TAILQ_END(&agTimerObjQ);
-	     ob = obNext) {
-		obNext = TAILQ_NEXT(ob, tobjs);
-		AG_ObjectLock(ob);
-rescan:
-		for (to = TAILQ_FIRST(&ob->timers);
-		     to != TAILQ_END(&ob->timers);
-		     to = toNext) {
-			toNext = TAILQ_NEXT(to, timers);
-
-			if ((int)(to->tSched - t) > 0) {
-				continue;
-			}
-			rv = to->fn(to, &to->fnEvent);
-			if (rv > 0) {				/* Restart */
-				(void)AG_ResetTimer(ob, to, rv);
-				goto rescan;
-			} else {				/* Cancel */
-				AG_DelTimer(ob, to);
+	if (WheelRunExpired() == -1) {		/* Left from the last call */
+		goto out;
+	}
+	while ((int)(t - agTimerWheelTime) >= 0) {
+		if (agTimerWheelCount == 0) {
+			agTimerWheelTime = t+1;
+			break;
+		}
+		idx = agTimerWheelTime & WHEEL_MASK0;
+		if (idx == 0 &&
+		    WheelCascade(1) == 0 &&
+		    WheelCascade(2) == 0 &&
+		    WheelCascade(3) == 0) {
+			WheelCascade(4);
+		}
+		/*
+		 * Move the expired timers to a separate list so that callbacks
+		 * may safely add, reset or delete any timer.
+		 */
+		while ((to = TAILQ_FIRST(&agTimerWheel[idx])) != NULL) {
+			WheelRemove(to);
+			TAILQ_INSERT_TAIL(expired, to, wheel);
+			to->id = WHEEL_EXPIRED;
+			agTimerWheelCount++;
+		}
+		agTimerWheelTime++;
+
+		if (WheelRunExpired() == -1)
+			break;
+
+		/* Skip to the next cascade if level 0 is empty. */
+		if (agTimerWheelCount0 == 0 &&
+		    (agTimerWheelTime & WHEEL_MASK0) != 0) {
+			tNext = (agTimerWheelTime | WHEEL_MASK0) + 1;
+			agTimerWheelTime = ((int)(tNext - t) > 0) ? t+1 : tNext;
+		}
+	}
+out:
+	AG_UnlockTiming();
+}
+
+/*
+ * Return the number of ticks from t until the next soft timer may expire
+ * (possibly earlier than the actual expiration), or 0xfffffffe if there
+ * are no soft timers.
+ */
+Uint32
+AG_GetNextTimeout(Uint32 t)
+{
+	Uint32 tNext;
+	int i;
+
+	AG_LockTiming();
+	if (agTimerWheelCount == 0) {
+		AG_UnlockTiming();
+		return (0xfffffffe);
+	}
+	tNext = (agTimerWheelTime | WHEEL_MASK0) + 1;
+	if (!TAILQ_EMPTY(&agTimerWheel[WHEEL_EXPIRED])) {
+		tNext = agTimerWheelTime;
+	} else if (agTimerWheelCount0 > 0) {
+		for (i = (agTimerWheelTime & WHEEL_MASK0); i < WHEEL_SIZE0; i++) {
+			if (!TAILQ_EMPTY(&agTimerWheel[i])) {
+				tNext = (agTimerWheelTime & ~WHEEL_MASK0) + i;
+				break;
 			}
 		}
-		AG_ObjectUnlock(ob);
 	}
 	AG_UnlockTiming();
+	return ((int)(tNext - t) > 0) ? (tNext - t) : 0;
 }
 
 #ifdef AG_LEGACY
@@ -171,11 +171,7 @@ AG_EvalVariable(void *pObj, AG_Variable *V)
 
 	AG_Strlcpy(evName, "get-", sizeof(evName));
 	AG_Strlcat(evName, V->name, sizeof(evName));
-	TAILQ_FOREACH(ev, &obj->events, events) {
-		if (strcmp(evName, ev->name) == 0)
-			break;
-	}
-	if (ev == NULL) {
+	if ((ev = AG_FindEventHandler(obj, evName)) == NULL) {
 		AG_SetError("Missing get-%s event", V->name);
 		return (-1);
 	}
@@ -370,13 +366,10 @@ AG_Unset(void *pObj, const char *name)
 	AG_Object *obj = pObj;
 	AG_Variable *V;
 
-	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0) {
-			TAILQ_REMOVE(&obj->vars, V, vars);
-			AG_FreeVariable(V);
-			free(V);
-			break;
-		}
+	if ((V = AG_ObjectFindVariable(obj, name)) != NULL) {
+		AG_ObjectRemoveVariable(obj, V);
+		AG_FreeVariable(V);
+		free(V);
 	}
 }
 
@@ -471,11 +464,7 @@ AG_Unset(void *pObj, const char *name)
 	Strlcpy(evName, "get-", sizeof(evName));		\
 	Strlcat(evName, V->name, sizeof(evName));		\
 	AG_ObjectLock(obj);					\
-	TAILQ_FOREACH(ev, &OBJECT(obj)->events, events) {	\
-		if (strcmp(evName, ev->name) == 0)		\
-			break;					\
-	}							\
-	if (ev != NULL) {					\
+	if ((ev = AG_FindEventHandler(obj, evName)) != NULL) {	\
 		V->data._field = V->fn._fname(ev);		\
 	}							\
 	AG_ObjectUnlock(obj);					\
@@ -1160,10 +1149,7 @@ GetStringFn(void *obj, AG_Variable *V, char *dst, size_t dstSize)
 	Strlcat(evName, V->name, sizeof(evName));
 
 	AG_ObjectLock(obj);
-	TAILQ_FOREACH(ev, &OBJECT(obj)->events, events) {
-		if (strcmp(evName, ev->name) == 0)
-			break;
-	}
+	ev = AG_FindEventHandler(obj, evName);
 	rv = (V->fn.fnString != NULL) ?
 	      V->fn.fnString(ev, dst, dstSize) : 0;
 	AG_ObjectUnlock(obj);
@@ -1240,15 +1226,11 @@ AG_SetString(void *pObj, const char *name, const char *s)
 	AG_Variable *V;
 
 	AG_ObjectLock(obj);
-	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_ObjectFindVariable(obj, name)) == NULL) {
 		V = Malloc(sizeof(AG_Variable));
 		AG_InitVariable(V, AG_VARIABLE_STRING);
 		Strlcpy(V->name, name, sizeof(V->name));
-		TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+		AG_ObjectInsertVariable(obj, V);
 
 		V->info.size = 0;				/* Allocated */
 		V->data.s = Strdup(s);
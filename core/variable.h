@@ -148,6 +148,7 @@ typedef struct ag_variable {
 	} info;
 	union ag_function fn;		/* Eval function */
 	union ag_variable_data data;	/* Variable-stored data */
+	Uint hash;			/* Name hash (for object index) */
 	AG_TAILQ_ENTRY(ag_variable) vars;
 } AG_Variable;
 
@@ -129,15 +129,18 @@ PollEvents(AG_Event *event)
 		args[0] = '(';
 		args[1] = '\0';
 		for (i = 1; i < ev->argc; i++) {
-			AG_Variable *V = &ev->argv[i];
+			AG_EventArg *A = &ev->argv[i];
+			AG_Variable V;
 
-			AG_LockVariable(V);
-			if (V->name != NULL && V->name[0] != '\0') {
-				Strlcat(args, V->name, sizeof(args));
+			if (A->key != 0) {
+				Strlcat(args, AG_GetEventAtomName(A->key),
+				    sizeof(args));
 				Strlcat(args, "=", sizeof(args));
 			}
-			AG_PrintVariable(arg, sizeof(arg), &ev->argv[i]);
-			AG_UnlockVariable(V);
+			memset(&V, 0, sizeof(V));
+			V.type = A->type;
+			memcpy(&V.data, &A->data, sizeof(A->data));
+			AG_PrintVariable(arg, sizeof(arg), &V);
 
 			Strlcat(args, arg, sizeof(args));
 			if (i < ev->argc-1)
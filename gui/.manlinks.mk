@@ -55,12 +55,16 @@ MANLINKS+=AG_Widget.3:AG_WidgetUnmapSurface.3
 CATLINKS+=AG_Widget.cat3:AG_WidgetUnmapSurface.cat3
 MANLINKS+=AG_Widget.3:AG_WidgetUpdateSurface.3
 CATLINKS+=AG_Widget.cat3:AG_WidgetUpdateSurface.cat3
+MANLINKS+=AG_Widget.3:AG_WidgetUpdateSurfaceRect.3
+CATLINKS+=AG_Widget.cat3:AG_WidgetUpdateSurfaceRect.cat3
 MANLINKS+=AG_Widget.3:AG_WidgetBlitFrom.3
 CATLINKS+=AG_Widget.cat3:AG_WidgetBlitFrom.cat3
 MANLINKS+=AG_Widget.3:AG_WidgetBlitSurface.3
 CATLINKS+=AG_Widget.cat3:AG_WidgetBlitSurface.cat3
 MANLINKS+=AG_Widget.3:AG_Redraw.3
 CATLINKS+=AG_Widget.cat3:AG_Redraw.cat3
+MANLINKS+=AG_Widget.3:AG_WidgetRedrawRect.3
+CATLINKS+=AG_Widget.cat3:AG_WidgetRedrawRect.cat3
 MANLINKS+=AG_Widget.3:AG_RedrawOnChange.3
 CATLINKS+=AG_Widget.cat3:AG_RedrawOnChange.cat3
 MANLINKS+=AG_Widget.3:AG_RedrawOnTick.3
@@ -179,6 +183,12 @@ MANLINKS+=AG_FixedPlotter.3:AG_FixedPlotterCurve.3
 CATLINKS+=AG_FixedPlotter.cat3:AG_FixedPlotterCurve.cat3
 MANLINKS+=AG_FixedPlotter.3:AG_FixedPlotterDatum.3
 CATLINKS+=AG_FixedPlotter.cat3:AG_FixedPlotterDatum.cat3
+MANLINKS+=AG_FixedPlotter.3:AG_FixedPlotterData.3
+CATLINKS+=AG_FixedPlotter.cat3:AG_FixedPlotterData.cat3
+MANLINKS+=AG_FixedPlotter.3:AG_FixedPlotterGetValue.3
+CATLINKS+=AG_FixedPlotter.cat3:AG_FixedPlotterGetValue.cat3
+MANLINKS+=AG_FixedPlotter.3:AG_FixedPlotterSetScale.3
+CATLINKS+=AG_FixedPlotter.cat3:AG_FixedPlotterSetScale.cat3
 MANLINKS+=AG_Checkbox.3:AG_CheckboxNew.3
 CATLINKS+=AG_Checkbox.cat3:AG_CheckboxNew.cat3
 MANLINKS+=AG_Checkbox.3:AG_CheckboxNewS.3
@@ -449,6 +459,8 @@ MANLINKS+=AG_Tlist.3:AG_TlistSetChangedFn.3
 CATLINKS+=AG_Tlist.cat3:AG_TlistSetChangedFn.cat3
 MANLINKS+=AG_Tlist.3:AG_TlistSetCompareFn.3
 CATLINKS+=AG_Tlist.cat3:AG_TlistSetCompareFn.cat3
+MANLINKS+=AG_Tlist.3:AG_TlistSetHashFn.3
+CATLINKS+=AG_Tlist.cat3:AG_TlistSetHashFn.cat3
 MANLINKS+=AG_Tlist.3:AG_TlistItem.3
 CATLINKS+=AG_Tlist.cat3:AG_TlistItem.cat3
 MANLINKS+=AG_Tlist.3:AG_TlistAdd.3
@@ -559,6 +571,14 @@ MANLINKS+=AG_Text.3:AG_TextSizeMulti.3
 CATLINKS+=AG_Text.cat3:AG_TextSizeMulti.cat3
 MANLINKS+=AG_Text.3:AG_TextSizeMultiUCS4.3
 CATLINKS+=AG_Text.cat3:AG_TextSizeMultiUCS4.cat3
+MANLINKS+=AG_Text.3:AG_TextSetGlyphCacheBudget.3
+CATLINKS+=AG_Text.cat3:AG_TextSetGlyphCacheBudget.cat3
+MANLINKS+=AG_Text.3:AG_GlyphAtlasGetStats.3
+CATLINKS+=AG_Text.cat3:AG_GlyphAtlasGetStats.cat3
+MANLINKS+=AG_Text.3:AG_TTFSetCacheBudget.3
+CATLINKS+=AG_Text.cat3:AG_TTFSetCacheBudget.cat3
+MANLINKS+=AG_Text.3:AG_TTFGetCacheStats.3
+CATLINKS+=AG_Text.cat3:AG_TTFGetCacheStats.cat3
 MANLINKS+=AG_Text.3:AG_TextMsg.3
 CATLINKS+=AG_Text.cat3:AG_TextMsg.cat3
 MANLINKS+=AG_Text.3:AG_TextMsgS.3
@@ -589,6 +609,8 @@ MANLINKS+=AG_Text.3:AG_FetchFont.3
 CATLINKS+=AG_Text.cat3:AG_FetchFont.cat3
 MANLINKS+=AG_Text.3:AG_UnusedFont.3
 CATLINKS+=AG_Text.cat3:AG_UnusedFont.cat3
+MANLINKS+=AG_Text.3:AG_TextNextFont.3
+CATLINKS+=AG_Text.cat3:AG_TextNextFont.cat3
 MANLINKS+=AG_Text.3:AG_SetDefaultFont.3
 CATLINKS+=AG_Text.cat3:AG_SetDefaultFont.cat3
 MANLINKS+=AG_Text.3:AG_SetRTL.3
@@ -825,6 +847,8 @@ MANLINKS+=AG_Table.3:AG_TableColSelected.3
 CATLINKS+=AG_Table.cat3:AG_TableColSelected.cat3
 MANLINKS+=AG_Table.3:AG_TableAddRow.3
 CATLINKS+=AG_Table.cat3:AG_TableAddRow.cat3
+MANLINKS+=AG_Table.3:AG_TableAddRowID.3
+CATLINKS+=AG_Table.cat3:AG_TableAddRowID.cat3
 MANLINKS+=AG_Table.3:AG_TableSelectRow.3
 CATLINKS+=AG_Table.cat3:AG_TableSelectRow.cat3
 MANLINKS+=AG_Table.3:AG_TableDeselectRow.3
@@ -847,6 +871,12 @@ MANLINKS+=AG_Table.3:AG_TableCompareCells.3
 CATLINKS+=AG_Table.cat3:AG_TableCompareCells.cat3
 MANLINKS+=AG_Table.3:AG_TablePrintCell.3
 CATLINKS+=AG_Table.cat3:AG_TablePrintCell.cat3
+MANLINKS+=AG_Table.3:AG_TableSetModel.3
+CATLINKS+=AG_Table.cat3:AG_TableSetModel.cat3
+MANLINKS+=AG_Table.3:AG_TableModelChanged.3
+CATLINKS+=AG_Table.cat3:AG_TableModelChanged.cat3
+MANLINKS+=AG_Table.3:AG_TableModelRow.3
+CATLINKS+=AG_Table.cat3:AG_TableModelRow.cat3
 MANLINKS+=AG_Table.3:AG_TableSaveASCII.3
 CATLINKS+=AG_Table.cat3:AG_TableSaveASCII.cat3
 MANLINKS+=AG_Pane.3:AG_PaneNewHoriz.3
@@ -995,10 +1025,14 @@ MANLINKS+=AG_Console.3:AG_ConsoleSetPadding.3
 CATLINKS+=AG_Console.cat3:AG_ConsoleSetPadding.cat3
 MANLINKS+=AG_Console.3:AG_ConsoleSetFont.3
 CATLINKS+=AG_Console.cat3:AG_ConsoleSetFont.cat3
+MANLINKS+=AG_Console.3:AG_ConsoleSetMaxLines.3
+CATLINKS+=AG_Console.cat3:AG_ConsoleSetMaxLines.cat3
 MANLINKS+=AG_Console.3:AG_ConsoleMsg.3
 CATLINKS+=AG_Console.cat3:AG_ConsoleMsg.cat3
 MANLINKS+=AG_Console.3:AG_ConsoleMsgS.3
 CATLINKS+=AG_Console.cat3:AG_ConsoleMsgS.cat3
+MANLINKS+=AG_Console.3:AG_ConsoleAppendLines.3
+CATLINKS+=AG_Console.cat3:AG_ConsoleAppendLines.cat3
 MANLINKS+=AG_Console.3:AG_ConsoleMsgEdit.3
 CATLINKS+=AG_Console.cat3:AG_ConsoleMsgEdit.cat3
 MANLINKS+=AG_Console.3:AG_ConsoleMsgPtr.3
@@ -1255,6 +1289,8 @@ MANLINKS+=AG_Editable.3:AG_EditableClearBuffer.3
 CATLINKS+=AG_Editable.cat3:AG_EditableClearBuffer.cat3
 MANLINKS+=AG_Editable.3:AG_EditableGrowBuffer.3
 CATLINKS+=AG_Editable.cat3:AG_EditableGrowBuffer.cat3
+MANLINKS+=AG_Editable.3:AG_EditableBufferChanged.3
+CATLINKS+=AG_Editable.cat3:AG_EditableBufferChanged.cat3
 MANLINKS+=AG_Editable.3:AG_EditableCut.3
 CATLINKS+=AG_Editable.cat3:AG_EditableCut.cat3
 MANLINKS+=AG_Editable.3:AG_EditableCopyChunk.3
@@ -1325,6 +1361,8 @@ MANLINKS+=AG_Surface.3:AG_SurfaceResize.3
 CATLINKS+=AG_Surface.cat3:AG_SurfaceResize.cat3
 MANLINKS+=AG_Surface.3:AG_SurfaceFree.3
 CATLINKS+=AG_Surface.cat3:AG_SurfaceFree.cat3
+MANLINKS+=AG_Surface.3:AG_SurfaceTouch.3
+CATLINKS+=AG_Surface.cat3:AG_SurfaceTouch.cat3
 MANLINKS+=AG_Surface.3:AG_FillRect.3
 CATLINKS+=AG_Surface.cat3:AG_FillRect.cat3
 MANLINKS+=AG_Surface.3:AG_SurfaceBlit.3
@@ -1341,6 +1379,8 @@ MANLINKS+=AG_Surface.3:AG_SurfaceConvert.3
 CATLINKS+=AG_Surface.cat3:AG_SurfaceConvert.cat3
 MANLINKS+=AG_Surface.3:AG_ScaleSurface.3
 CATLINKS+=AG_Surface.cat3:AG_ScaleSurface.cat3
+MANLINKS+=AG_Surface.3:AG_ScaleSurfaceFiltered.3
+CATLINKS+=AG_Surface.cat3:AG_ScaleSurfaceFiltered.cat3
 MANLINKS+=AG_Surface.3:AG_SetAlphaPixels.3
 CATLINKS+=AG_Surface.cat3:AG_SetAlphaPixels.cat3
 MANLINKS+=AG_Surface.3:AG_SurfaceExportFile.3
@@ -1601,6 +1641,8 @@ MANLINKS+=AG_InitGraphics.3:AG_InitGUI.3
 CATLINKS+=AG_InitGraphics.cat3:AG_InitGUI.cat3
 MANLINKS+=AG_InitGraphics.3:AG_DestroyGUI.3
 CATLINKS+=AG_InitGraphics.cat3:AG_DestroyGUI.cat3
+MANLINKS+=AG_DriverSw.3:AG_WM_AddDamage.3
+CATLINKS+=AG_DriverSw.cat3:AG_WM_AddDamage.cat3
 MANLINKS+=AG_GL.3:AG_GL_InitContext.3
 CATLINKS+=AG_GL.cat3:AG_GL_InitContext.cat3
 MANLINKS+=AG_GL.3:AG_GL_SetViewport.3
@@ -1785,3 +1827,5 @@ MANLINKS+=AG_StyleSheet.3:AG_LoadStyleSheet.3
 CATLINKS+=AG_StyleSheet.cat3:AG_LoadStyleSheet.cat3
 MANLINKS+=AG_StyleSheet.3:AG_LookupStyleSheet.3
 CATLINKS+=AG_StyleSheet.cat3:AG_LookupStyleSheet.cat3
+MANLINKS+=AG_StyleSheet.3:AG_LookupStyleSheetValues.3
+CATLINKS+=AG_StyleSheet.cat3:AG_LookupStyleSheetValues.cat3
@@ -154,7 +154,7 @@ AG_ConsoleExportText(AG_Console *cons, int nativeNL)
 	for (i = cons->pos;
 	     (i >= 0 && i < cons->nLines);
 	     i += dir) {
-		AG_ConsoleLine *ln = cons->lines[i];
+		AG_ConsoleLine *ln = AG_ConsoleGetLine(cons, i);
 		sizeReq += ln->len + 2; /* \r\n */
 		if (i == cons->pos+cons->sel)
 			break;
@@ -167,7 +167,7 @@ AG_ConsoleExportText(AG_Console *cons, int nativeNL)
 	for (i = cons->pos;
 	     (i >= 0 && i < cons->nLines);
 	     i += dir) {
-		AG_ConsoleLine *ln = cons->lines[i];
+		AG_ConsoleLine *ln = AG_ConsoleGetLine(cons, i);
 		memcpy(ps, ln->text, ln->len);
 #ifdef _WIN32
 		if (nativeNL) {
@@ -367,27 +367,75 @@ ComputeVisible(AG_Console *cons)
 	                               (float)cons->lineskip);
 }
 
+/* Unmap the cached surfaces of a line. */
+static void
+UncacheLine(AG_Console *cons, AG_ConsoleLine *ln)
+{
+	int i;
+
+	if (ln->surface[0] == -1 && ln->surface[1] == -1) {
+		return;
+	}
+	for (i = 0; i < 2; i++) {
+		if (ln->surface[i] != -1) {
+			AG_WidgetUnmapSurface(cons, ln->surface[i]);
+			ln->surface[i] = -1;
+		}
+	}
+	AG_TAILQ_REMOVE(&cons->cache, ln, cache);
+	cons->nCached--;
+}
+
+/*
+ * Map a rendered surface for a line. Only recently drawn lines keep their
+ * surfaces; once the cache is full, the surface handle of the least
+ * recently drawn line is reused.
+ */
+static void
+CacheLine(AG_Console *cons, AG_ConsoleLine *ln, int suIdx, AG_Surface *su)
+{
+	AG_ConsoleLine *lnOld;
+	Uint nMax = MAX(AG_CONSOLE_CACHE_MIN, cons->rVisible*2);
+	int i, name;
+
+	if (ln->surface[0] != -1 || ln->surface[1] != -1) {
+		ln->surface[suIdx] = AG_WidgetMapSurface(cons, su);
+		AG_TAILQ_REMOVE(&cons->cache, ln, cache);
+		AG_TAILQ_INSERT_HEAD(&cons->cache, ln, cache);
+		return;
+	}
+	if (cons->nCached >= nMax &&
+	    (lnOld = AG_TAILQ_LAST(&cons->cache, ag_console_lineq)) != NULL) {
+		i = (lnOld->surface[0] != -1) ? 0 : 1;
+		name = lnOld->surface[i];
+		lnOld->surface[i] = -1;
+		if (lnOld->surface[!i] != -1) {
+			AG_WidgetUnmapSurface(cons, lnOld->surface[!i]);
+			lnOld->surface[!i] = -1;
+		}
+		AG_TAILQ_REMOVE(&cons->cache, lnOld, cache);
+		cons->nCached--;
+		AG_WidgetReplaceSurface(cons, name, su);
+		ln->surface[suIdx] = name;
+	} else {
+		ln->surface[suIdx] = AG_WidgetMapSurface(cons, su);
+	}
+	AG_TAILQ_INSERT_HEAD(&cons->cache, ln, cache);
+	cons->nCached++;
+}
+
 static void
 OnFontChange(AG_Event *event)
 {
 	AG_Console *cons = AG_SELF();
-	Uint i;
-	int j;
+	AG_ConsoleLine *ln;
 
 	cons->lineskip = WIDGET(cons)->font->lineskip + 1;
 	cons->rOffs = 0;
 	ComputeVisible(cons);
 
-	for (i = 0; i < cons->nLines; i++) {
-		AG_ConsoleLine *ln = cons->lines[i];
-
-		for (j = 0; j < 2; j++) {
-			if (ln->surface[j] != -1) {
-				AG_WidgetUnmapSurface(cons, ln->surface[j]);
-				ln->surface[j] = -1;
-			}
-		}
-	}
+	while ((ln = AG_TAILQ_FIRST(&cons->cache)) != NULL)
+		UncacheLine(cons, ln);
 }
 
 static void
@@ -402,6 +450,13 @@ Init(void *obj)
 	cons->lines = NULL;
 	cons->lineskip = 0;
 	cons->nLines = 0;
+	cons->lineFirst = 0;
+	cons->linesMax = 0;
+	cons->maxLines = 0;
+	cons->chunk = NULL;
+	cons->chunkSpare = NULL;
+	cons->nCached = 0;
+	AG_TAILQ_INIT(&cons->cache);
 	cons->rOffs = 0;
 	cons->rVisible = 0;
 	cons->pm = NULL;
@@ -507,7 +562,7 @@ Draw(void *p)
 	for (lnIdx = cons->rOffs;
 	     lnIdx < cons->nLines && rDst.y < WIDGET(cons)->h;
 	     lnIdx++) {
-		AG_ConsoleLine *ln = cons->lines[lnIdx];
+		AG_ConsoleLine *ln = AG_ConsoleGetLine(cons, lnIdx);
 		AG_Color cTxt = WCOLOR(cons,AG_TEXT_COLOR);
 		int suIdx = 0;
 
@@ -531,7 +586,10 @@ Draw(void *p)
 			if ((su = AG_TextRender(ln->text)) == NULL) {
 				continue;
 			}
-			ln->surface[suIdx] = AG_WidgetMapSurface(cons, su);
+			CacheLine(cons, ln, suIdx, su);
+		} else if (ln != AG_TAILQ_FIRST(&cons->cache)) {
+			AG_TAILQ_REMOVE(&cons->cache, ln, cache);
+			AG_TAILQ_INSERT_HEAD(&cons->cache, ln, cache);
 		}
 		AG_WidgetBlitSurface(cons, ln->surface[suIdx], rDst.x, rDst.y);
 		rDst.y += cons->lineskip;
@@ -541,19 +599,188 @@ out:
 	AG_WidgetDraw(cons->vBar);
 }
 
+/* Release the chunk holding the text of a line. */
+static void
+ReleaseText(AG_Console *cons, AG_ConsoleLine *ln)
+{
+	AG_ConsoleChunk *ch = ln->chunk;
+
+	ln->text = NULL;
+	ln->len = 0;
+	if (ch == NULL) {
+		return;
+	}
+	ln->chunk = NULL;
+	if (--ch->nRefs > 0) {
+		return;
+	}
+	if (ch == cons->chunk) {
+		ch->len = 0;
+	} else if (cons->chunkSpare == NULL &&
+	           ch->size == AG_CONSOLE_CHUNK_SIZE) {
+		cons->chunkSpare = ch;
+	} else {
+		free(ch);
+	}
+}
+
+/*
+ * Copy len bytes of line text into the current chunk, starting a new chunk
+ * if it is full. Lines longer than a chunk get a chunk of their own.
+ */
+static int
+AllocText(AG_Console *cons, AG_ConsoleLine *ln, const char *s, size_t len)
+{
+	AG_ConsoleChunk *ch = cons->chunk;
+	size_t size;
+
+	if (ch == NULL || ch->size - ch->len < len+1) {
+		if (ch != NULL && ch->nRefs == 0) {
+			free(ch);
+		}
+		if (len+1 <= AG_CONSOLE_CHUNK_SIZE && cons->chunkSpare != NULL) {
+			ch = cons->chunkSpare;
+			cons->chunkSpare = NULL;
+		} else {
+			size = MAX(AG_CONSOLE_CHUNK_SIZE, len+1);
+			if ((ch = TryMalloc(sizeof(AG_ConsoleChunk) + size))
+			    == NULL) {
+				cons->chunk = NULL;
+				return (-1);
+			}
+			ch->data = (char *)&ch[1];
+			ch->size = size;
+		}
+		ch->nRefs = 0;
+		ch->len = 0;
+		cons->chunk = ch;
+	}
+	ln->text = &ch->data[ch->len];
+	ln->len = len;
+	ln->chunk = ch;
+	memcpy(ln->text, s, len);
+	ln->text[len] = '\0';
+	ch->len += len+1;
+	ch->nRefs++;
+	return (0);
+}
+
+/* Reallocate the line array, moving the first line to index 0. */
+static int
+ResizeLines(AG_Console *cons, Uint maxNew)
+{
+	AG_ConsoleLine **linesNew;
+	Uint i;
+
+	if ((linesNew = TryMalloc(maxNew*sizeof(AG_ConsoleLine *))) == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < cons->nLines; i++) {
+		linesNew[i] = AG_ConsoleGetLine(cons, i);
+	}
+	Free(cons->lines);
+	cons->lines = linesNew;
+	cons->lineFirst = 0;
+	cons->linesMax = maxNew;
+	return (0);
+}
+
+/*
+ * Remove the oldest line from the buffer and release its text and surfaces.
+ * The view and the selection are shifted so they stay on the same lines.
+ */
+static AG_ConsoleLine *
+PopLine(AG_Console *cons)
+{
+	AG_ConsoleLine *ln;
+
+	ln = cons->lines[cons->lineFirst];
+	cons->lineFirst = (cons->lineFirst + 1) % cons->linesMax;
+	cons->nLines--;
+	ReleaseText(cons, ln);
+	UncacheLine(cons, ln);
+
+	if (cons->rOffs > 0) {
+		cons->rOffs--;
+	}
+	if (cons->pos != -1) {
+		if (--cons->pos < 0) {
+			if (cons->sel > 0) {
+				cons->pos = 0;
+				cons->sel--;
+			} else {
+				cons->pos = -1;
+				cons->sel = 0;
+			}
+		} else if (cons->pos + cons->sel < 0) {
+			cons->sel = -cons->pos;
+		}
+	}
+	return (ln);
+}
+
+/*
+ * Append a line to the buffer. If the buffer is full, the oldest line is
+ * evicted and its structure is reused.
+ */
+static AG_ConsoleLine *
+AppendLine(AG_Console *cons, const char *s, size_t len)
+{
+	AG_ConsoleLine *ln;
+	Uint maxNew;
+
+	if (cons->maxLines > 0 && cons->nLines >= cons->maxLines) {
+		ln = PopLine(cons);
+	} else {
+		if ((ln = TryMalloc(sizeof(AG_ConsoleLine))) == NULL) {
+			return (NULL);
+		}
+		if (cons->nLines == cons->linesMax) {
+			maxNew = (cons->linesMax > 0) ? cons->linesMax*2 : 64;
+			if (cons->maxLines > 0 && maxNew > cons->maxLines) {
+				maxNew = cons->maxLines;
+			}
+			if (ResizeLines(cons, maxNew) == -1) {
+				free(ln);
+				return (NULL);
+			}
+		}
+	}
+	ln->text = NULL;
+	ln->len = 0;
+	ln->chunk = NULL;
+	if (s != NULL && AllocText(cons, ln, s, len) == -1) {
+		free(ln);
+		return (NULL);
+	}
+	cons->lines[(cons->lineFirst + cons->nLines) % cons->linesMax] = ln;
+	cons->nLines++;
+
+	ln->cons = cons;
+	ln->p = NULL;
+	ln->icon = -1;
+	ln->surface[0] = -1;
+	ln->surface[1] = -1;
+	ln->cAlt = AG_ColorRGBA(0,0,0,0);
+	return (ln);
+}
+
 static void
 FreeLines(AG_Console *cons)
 {
 	Uint i;
 	
 	for (i = 0; i < cons->nLines; i++) {
-		AG_ConsoleLine *ln = cons->lines[i];
-		Free(ln->text);
+		AG_ConsoleLine *ln = AG_ConsoleGetLine(cons, i);
+		ReleaseText(cons, ln);
+		UncacheLine(cons, ln);
 		free(ln);
 	}
 	Free(cons->lines);
 	cons->lines = NULL;
 	cons->nLines = 0;
+	cons->lineFirst = 0;
+	cons->linesMax = 0;
 }
 
 static void
@@ -565,6 +792,8 @@ Destroy(void *p)
 		AG_PopupDestroy(cons->pm);
 	}
 	FreeLines(cons);
+	Free(cons->chunk);
+	Free(cons->chunkSpare);
 }
 
 /* Configure padding in pixels */
@@ -576,39 +805,38 @@ AG_ConsoleSetPadding(AG_Console *cons, int padding)
 	AG_ObjectUnlock(cons);
 }
 
+/*
+ * Limit the number of lines kept in the buffer (0 = no limit). Once the
+ * limit is reached, appending a line discards the oldest line.
+ */
+void
+AG_ConsoleSetMaxLines(AG_Console *cons, Uint nMax)
+{
+	AG_ObjectLock(cons);
+	cons->maxLines = nMax;
+	if (nMax > 0) {
+		while (cons->nLines > nMax) {
+			free(PopLine(cons));
+		}
+		if (cons->linesMax > nMax) {
+			(void)ResizeLines(cons, nMax);
+		}
+	}
+	AG_Redraw(cons);
+	AG_ObjectUnlock(cons);
+}
+
 /* Append a line to the log */
 AG_ConsoleLine *
 AG_ConsoleAppendLine(AG_Console *cons, const char *s)
 {
 	AG_ConsoleLine *ln;
-	AG_ConsoleLine **linesNew;
-	
-	if ((ln = TryMalloc(sizeof(AG_ConsoleLine))) == NULL)
-		return (NULL);
 
 	AG_ObjectLock(cons);
-
-	if ((linesNew = TryRealloc(cons->lines,
-	    (cons->nLines+1)*sizeof(AG_ConsoleLine *))) == NULL) {
+	if ((ln = AppendLine(cons, s, (s != NULL) ? strlen(s) : 0)) == NULL) {
 		AG_ObjectUnlock(cons);
-		free(ln);
 		return (NULL);
 	}
-	cons->lines = linesNew;
-	cons->lines[cons->nLines++] = ln;
-	if (s != NULL) {
-		ln->text = Strdup(s);
-		ln->len = strlen(s);
-	} else {
-		ln->text = NULL;
-		ln->len = 0;
-	}
-	ln->cons = cons;
-	ln->p = NULL;
-	ln->surface[0] = -1;
-	ln->surface[1] = -1;
-	ln->cAlt = AG_ColorRGBA(0,0,0,0);
-
 	if ((cons->flags & AG_CONSOLE_NOAUTOSCROLL) == 0) {
 		cons->scrollTo = &cons->nLines;
 	}
@@ -617,48 +845,47 @@ AG_ConsoleAppendLine(AG_Console *cons, const char *s)
 	return (ln);
 }
 
+/*
+ * Append n lines to the log at once. Returns the number of lines appended
+ * (less than n if we ran out of memory).
+ */
+int
+AG_ConsoleAppendLines(AG_Console *cons, const char **s, Uint n)
+{
+	Uint i;
+
+	AG_ObjectLock(cons);
+	for (i = 0; i < n; i++) {
+		if (AppendLine(cons, s[i], (s[i] != NULL) ? strlen(s[i]) : 0)
+		    == NULL)
+			break;
+	}
+	if (i > 0) {
+		if ((cons->flags & AG_CONSOLE_NOAUTOSCROLL) == 0) {
+			cons->scrollTo = &cons->nLines;
+		}
+		AG_Redraw(cons);
+	}
+	AG_ObjectUnlock(cons);
+	return ((int)i);
+}
+
 /* Append a message to the console (format string). */
 AG_ConsoleLine *
 AG_ConsoleMsg(AG_Console *cons, const char *fmt, ...)
 {
 	AG_ConsoleLine *ln;
 	va_list args;
-	size_t len;
 	char *s;
 
-	if (cons == NULL) {
-		va_start(args, fmt);
-		if (TryVasprintf(&s, fmt, args) == -1) {
-			return (NULL);
-		}
+	va_start(args, fmt);
+	if (TryVasprintf(&s, fmt, args) == -1) {
 		va_end(args);
-		Verbose("%s", s);
-		if ((len = strlen(s)) > 1 && s[len - 1] != '\n') {
-			Verbose("\n");
-		}
-		Free(s);
 		return (NULL);
 	}
-
-	AG_ObjectLock(cons);
-
-	if ((ln = AG_ConsoleAppendLine(cons, NULL)) != NULL) {
-		va_start(args, fmt);
-		if (TryVasprintf(&ln->text, fmt, args) == -1) {
-			va_end(args);
-			FreeLines(cons);
-			ln = NULL;
-			goto out;
-		}
-		va_end(args);
-		ln->len = strlen(ln->text);
-		if (ln->len > 1 && ln->text[ln->len - 1] == '\n') {
-			ln->text[ln->len - 1] = '\0';
-			ln->len--;
-		}
-	}
-out:
-	AG_ObjectUnlock(cons);
+	va_end(args);
+	ln = AG_ConsoleMsgS(cons, s);
+	Free(s);
 	return (ln);
 }
 
@@ -676,13 +903,15 @@ AG_ConsoleMsgS(AG_Console *cons, const char *s)
 		}
 		return (NULL);
 	}
-
+	if ((len = strlen(s)) > 1 && s[len - 1] == '\n') {
+		len--;
+	}
 	AG_ObjectLock(cons);
-	if ((ln = AG_ConsoleAppendLine(cons, s)) != NULL) {
-		if (ln->len > 1 && ln->text[ln->len - 1] == '\n') {
-			ln->text[ln->len - 1] = '\0';
-			ln->len--;
+	if ((ln = AppendLine(cons, s, len)) != NULL) {
+		if ((cons->flags & AG_CONSOLE_NOAUTOSCROLL) == 0) {
+			cons->scrollTo = &cons->nLines;
 		}
+		AG_Redraw(cons);
 	}
 	AG_ObjectUnlock(cons);
 	return (ln);
@@ -692,20 +921,14 @@ AG_ConsoleMsgS(AG_Console *cons, const char *s)
 void
 AG_ConsoleMsgEdit(AG_ConsoleLine *ln, const char *s)
 {
-	int i;
+	AG_Console *cons = ln->cons;
 
-	AG_ObjectLock(ln->cons);
-	Free(ln->text);
-	ln->text = Strdup(s);
-	ln->len = strlen(s);
-	for (i = 0; i < 2; i++) {
-		if (ln->surface[i] != -1) {
-			AG_WidgetUnmapSurface(ln->cons, ln->surface[i]);
-			ln->surface[i] = -1;
-		}
-	}
-	AG_Redraw(ln->cons);
-	AG_ObjectUnlock(ln->cons);
+	AG_ObjectLock(cons);
+	ReleaseText(cons, ln);
+	(void)AllocText(cons, ln, s, strlen(s));
+	UncacheLine(cons, ln);
+	AG_Redraw(cons);
+	AG_ObjectUnlock(cons);
 }
 
 void
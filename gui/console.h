@@ -10,10 +10,20 @@
 #include <agar/gui/begin.h>
 
 #define AG_CONSOLE_LINE_MAX	1024
+#define AG_CONSOLE_CHUNK_SIZE	65536	/* Size of line text chunks */
+#define AG_CONSOLE_CACHE_MIN	64	/* Minimum lines with cached surfaces */
 
 struct ag_console;
 struct ag_popup_menu;
 
+/* Storage for the text of consecutive lines. */
+typedef struct ag_console_chunk {
+	Uint nRefs;			/* Lines with text in this chunk */
+	size_t len;			/* Bytes used */
+	size_t size;			/* Bytes allocated */
+	char *data;
+} AG_ConsoleChunk;
+
 typedef struct ag_console_line {
 	char *text;			/* Line text */
 	size_t len;			/* Length not including NUL */
@@ -22,6 +32,8 @@ typedef struct ag_console_line {
 	AG_Color cAlt;			/* Alternate text color */
 	void *p;			/* User pointer */
 	struct ag_console *cons;	/* Back pointer to Console */
+	AG_ConsoleChunk *chunk;		/* Chunk containing text (or NULL) */
+	AG_TAILQ_ENTRY(ag_console_line) cache; /* In surface cache */
 } AG_ConsoleLine;
 
 typedef struct ag_console {
@@ -35,8 +47,15 @@ typedef struct ag_console {
 #define AG_CONSOLE_SELECTING	0x10	/* Selection in progress */
 	int padding;			/* Padding in pixels */
 	int lineskip;			/* Space between lines */
-	AG_ConsoleLine **lines;		/* Lines in buffer */
+	AG_ConsoleLine **lines;		/* Lines in buffer (circular) */
 	Uint nLines;			/* Line count */
+	Uint lineFirst;			/* Index of first line in lines[] */
+	Uint linesMax;			/* Allocated lines[] entries */
+	Uint maxLines;			/* Line limit (0 = unlimited) */
+	AG_ConsoleChunk *chunk;		/* Current text chunk */
+	AG_ConsoleChunk *chunkSpare;	/* Recycled text chunk */
+	Uint nCached;			/* Lines with mapped surfaces */
+	AG_TAILQ_HEAD(ag_console_lineq, ag_console_line) cache; /* LRU */
 	Uint rOffs;			/* Row display offset */
 	AG_Scrollbar *vBar;		/* Scrollbar */
 	AG_Rect r;			/* View area */
@@ -52,7 +71,9 @@ extern AG_WidgetClass agConsoleClass;
 AG_Console     *AG_ConsoleNew(void *, Uint);
 void		AG_ConsoleSetPadding(AG_Console *, int);
 void            AG_ConsoleSetFont(AG_Console *, AG_Font *);
+void		AG_ConsoleSetMaxLines(AG_Console *, Uint);
 AG_ConsoleLine *AG_ConsoleAppendLine(AG_Console *, const char *);
+int		AG_ConsoleAppendLines(AG_Console *, const char **, Uint);
 AG_ConsoleLine *AG_ConsoleMsg(AG_Console *, const char *, ...)
                               FORMAT_ATTRIBUTE(printf, 2, 3)
                               NONNULL_ATTRIBUTE(2);
@@ -64,6 +85,13 @@ void            AG_ConsoleMsgColor(AG_ConsoleLine *, const AG_Color *);
 void		AG_ConsoleClear(AG_Console *);
 char           *AG_ConsoleExportText(AG_Console *, int);
 
+/* Return the line at index i (0 = oldest line). */
+static __inline__ AG_ConsoleLine *
+AG_ConsoleGetLine(AG_Console *cons, Uint i)
+{
+	return (cons->lines[(cons->lineFirst + i) % cons->linesMax]);
+}
+
 #ifdef AG_LEGACY
 # define AG_ConsoleSetFont(cons,font) AG_SetFont((cons),(font))
 #endif
@@ -45,6 +45,7 @@
 #include <agar/gui/notebook.h>
 #include <agar/gui/pane.h>
 #include <agar/gui/scrollview.h>
+#include <agar/gui/ttf.h>
 
 #include <string.h>
 
@@ -135,6 +136,50 @@ PollWidgets(AG_Event *event)
 	AG_TlistRestore(tl);
 }
 
+static void
+PollGlyphCaches(AG_Event *event)
+{
+	AG_Tlist *tl = AG_SELF();
+	AG_Driver *drv;
+#ifdef HAVE_FREETYPE
+	AG_Font *font;
+#endif
+
+	AG_TlistBegin(tl);
+	AG_MutexLock(&agTextLock);
+	AGOBJECT_FOREACH_CHILD(drv, &agDrivers, ag_driver) {
+		AG_GlyphCache *gc = drv->glyphCache;
+
+		if (gc == NULL) {
+			continue;
+		}
+		AG_TlistAdd(tl, NULL,
+		    "%s: %u glyphs (%u/%uK), %u hits, %u misses, %u evicted",
+		    OBJECT(drv)->name, gc->nGlyphs, gc->size/1024,
+		    gc->budget/1024, gc->nHits, gc->nMisses, gc->nEvicted);
+	}
+#ifdef HAVE_FREETYPE
+	for (font = AG_TextNextFont(NULL);
+	     font != NULL;
+	     font = AG_TextNextFont(font)) {
+		AG_TTFCacheStats st;
+
+		if (font->spec.type != AG_FONT_VECTOR || font->ttf == NULL) {
+			continue;
+		}
+		AG_TTFGetCacheStats(font->ttf, &st);
+		AG_TlistAdd(tl, NULL,
+		    "%s (%.0fpt): %u glyphs (%u/%uK), %u hits, %u misses, "
+		    "%u evicted",
+		    OBJECT(font)->name, font->spec.size, st.nGlyphs,
+		    st.size/1024, st.budget/1024, st.nHits, st.nMisses,
+		    st.nEvicted);
+	}
+#endif
+	AG_MutexUnlock(&agTextLock);
+	AG_TlistEnd(tl);
+}
+
 static void
 ShowWindow(AG_Event *event)
 {
@@ -306,6 +351,8 @@ AG_GuiDebugger(void *obj)
 {
 	AG_Window *win;
 	AG_Pane *pane;
+	AG_Notebook *nb;
+	AG_NotebookTab *nTab;
 	AG_Tlist *tl;
 	AG_MenuItem *mi;
 
@@ -321,8 +368,10 @@ AG_GuiDebugger(void *obj)
 	}
 
 	pane = AG_PaneNewHoriz(win, AG_PANE_EXPAND);
+	nb = AG_NotebookNew(pane->div[0], AG_NOTEBOOK_EXPAND);
 
-	tl = AG_TlistNewPolled(pane->div[0], 0, PollWidgets, "%p", obj);
+	nTab = AG_NotebookAdd(nb, _("Widgets"), AG_BOX_VERT);
+	tl = AG_TlistNewPolled(nTab, 0, PollWidgets, "%p", obj);
 	AG_TlistSizeHint(tl, "<XXXXXXXXXXXXXXXXXXXX>", 10);
 	AG_SetEvent(tl, "tlist-dblclick", WidgetSelected, "%p", pane->div[1]);
 	AG_Expand(tl);
@@ -331,6 +380,10 @@ AG_GuiDebugger(void *obj)
 	mi = AG_TlistSetPopup(tl, "window");
 	AG_MenuSetPollFn(mi, ContextualMenu, "%p", tl);
 
+	nTab = AG_NotebookAdd(nb, _("Glyph Caches"), AG_BOX_VERT);
+	tl = AG_TlistNewPolled(nTab, AG_TLIST_EXPAND, PollGlyphCaches, NULL);
+	AG_TlistSetRefresh(tl, 1000);
+
 	AG_WindowSetGeometryAligned(win, AG_WINDOW_MR, 640, 300);
 	AG_WindowSetCloseAction(win, AG_WINDOW_DETACH);
 	return (win);
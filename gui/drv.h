@@ -135,6 +135,7 @@ typedef struct ag_driver {
 	AG_TAILQ_HEAD_(ag_cursor) cursors; /* Registered cursors */
 	Uint                     nCursors;
 	struct ag_glyph_cache *glyphCache; /* Cache of rendered glyphs */
+	struct ag_glyph_atlas *glyphAtlas; /* Texture atlas of glyphs */
 	void *gl;			/* AG_GL_Context (for GL drivers) */
 } AG_Driver;
 
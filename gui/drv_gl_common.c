@@ -123,6 +123,7 @@ AG_GL_DestroyContext(void *obj)
 {
 	AG_Driver *drv = obj;
 	AG_GL_Context *gl = drv->gl;
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
 	AG_Glyph *glyph;
 	int i;
 
@@ -140,13 +141,23 @@ AG_GL_DestroyContext(void *obj)
 	else			{ glDisable(GL_CLIP_PLANE3); }
 	
 	/* Invalidate any cached glyph renderings. */
-	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		SLIST_FOREACH(glyph, &drv->glyphCache[i].glyphs, glyphs) {
-			if (glyph->texture != 0) {
-				glDeleteTextures(1, (GLuint *)&glyph->texture);
-				glyph->texture = 0;
+	AG_TAILQ_FOREACH(glyph, &drv->glyphCache->glyphs, glyphs) {
+		if (glyph->page == -1 && glyph->texture != 0) {
+			glDeleteTextures(1, (GLuint *)&glyph->texture);
+			glyph->texture = 0;
+			glyph->flags |= AG_GLYPH_STALE;
+		}
+	}
+	if (ga != NULL) {
+		for (i = 0; i < (int)ga->nPages; i++) {
+			GLuint texture = (GLuint)ga->pages[i].texture;
+
+			if (texture != 0) {
+				glDeleteTextures(1, &texture);
+				ga->pages[i].texture = 0;
 			}
 		}
+		AG_GlyphAtlasClear(drv);
 	}
 	
 	/* Destroy any texture or display list queued for deletion. */
@@ -341,8 +352,8 @@ AG_GL_StdUpdateTexture(void *obj, void *texture, AG_Surface *su, AG_TexCoord *tc
 	if (tc != NULL) {
 		tc->x = 0.0f;
 		tc->y = 0.0f;
-		tc->w = (float)gsu->w / (float)su->w;
-		tc->h = (float)gsu->h / (float)su->h;
+		tc->w = (float)su->w / (float)gsu->w;
+		tc->h = (float)su->h / (float)gsu->h;
 	}
 
 	glBindTexture(GL_TEXTURE_2D, *((GLuint*)texture)); //WDZ - Textures
@@ -359,18 +370,84 @@ AG_GL_StdUpdateTexture(void *obj, void *texture, AG_Surface *su, AG_TexCoord *tc
 	return (0);
 }
 
+/*
+ * Upload only the region r of su to an existing texture of matching size
+ * using glTexSubImage2D(). Return -1 if a full update is required.
+ */
+static int
+UpdateTextureRect(GLuint texture, AG_Surface *su, AG_Rect r)
+{
+	AG_Surface *gsu, sv;
+	GLint tw, th;
+	int Bpp = su->format->BytesPerPixel;
+
+	if (r.x < 0) { r.w += r.x; r.x = 0; }
+	if (r.y < 0) { r.h += r.y; r.y = 0; }
+	if (r.x+r.w > su->w) { r.w = su->w - r.x; }
+	if (r.y+r.h > su->h) { r.h = su->h - r.y; }
+	if (r.w <= 0 || r.h <= 0) {
+		return (0);
+	}
+	if (r.w == su->w && r.h == su->h)
+		return (-1);
+
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &tw);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &th);
+	if (su->flags & AG_SURFACE_GLTEXTURE) {
+		if (tw != su->w || th != su->h) {
+			goto fail;
+		}
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, su->pitch/4);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.w, r.h,
+		    GL_RGBA, GL_UNSIGNED_BYTE,
+		    (Uint8 *)su->pixels + r.y*su->pitch + r.x*Bpp);
+	} else {
+		if (tw != PowOf2i(su->w) || th != PowOf2i(su->h)) {
+			goto fail;
+		}
+		/* Convert only the modified region. */
+		sv = *su;
+		sv.pixels = (Uint8 *)su->pixels + r.y*su->pitch + r.x*Bpp;
+		sv.w = r.w;
+		sv.h = r.h;
+		sv.padding = su->pitch - r.w*Bpp;
+		if ((gsu = AG_SurfaceStdGL(r.w, r.h)) == NULL) {
+			goto fail;
+		}
+		AG_SurfaceCopy(gsu, &sv);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, gsu->pitch/4);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.w, r.h,
+		    GL_RGBA, GL_UNSIGNED_BYTE, gsu->pixels);
+		AG_SurfaceFree(gsu);
+	}
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return (0);
+fail:
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return (-1);
+}
+
 /* Prepare a widget-bound texture for rendering. */
 void
 AG_GL_PrepareTexture(void *obj, int s)
 {
 	AG_Widget *wid = obj;
 	AG_Driver *drv = wid->drv;
+	Uint flags = wid->surfaceFlags[s];
 
 	if (wid->textures[s] == 0) {
 		AG_GL_UploadTexture(drv, &wid->textures[s], wid->surfaces[s],
 		    &wid->texcoords[s]);
-	} else if (wid->surfaceFlags[s] & AG_WIDGET_SURFACE_REGEN) {
-		wid->surfaceFlags[s] &= ~(AG_WIDGET_SURFACE_REGEN);
+	} else if (flags & AG_WIDGET_SURFACE_REGEN) {
+		wid->surfaceFlags[s] &= ~(AG_WIDGET_SURFACE_REGEN|
+		                          AG_WIDGET_SURFACE_REGEN_RECT);
+		if ((flags & AG_WIDGET_SURFACE_REGEN_RECT) &&
+		    UpdateTextureRect(*(GLuint *)&wid->textures[s],
+		    wid->surfaces[s], wid->surfaceDirty[s]) == 0) {
+			return;
+		}
 		AG_GL_UpdateTexture(drv, &wid->textures[s], // WDZ - Textures
 		    wid->surfaces[s], &wid->texcoords[s]);
 	}
@@ -1073,17 +1150,85 @@ AG_GL_DrawRectBlended(void *obj, AG_Rect r, AG_Color C, AG_BlendFn fnSrc,
 		AGDRIVER_CLASS(obj)->popBlendingMode(obj);
 }
 
+/* Create the texture of a glyph atlas page. */
+static void
+CreateGlyphPage(AG_GlyphPage *pg)
+{
+	GLuint texture;
+	void *pixels;
+
+	/* Clear the padding between glyphs. */
+	pixels = Malloc(pg->w*pg->h*4);
+	memset(pixels, 0, pg->w*pg->h*4);
+
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, pg->w, pg->h, 0,
+	    GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	Free(pixels);
+
+	pg->texture = (Uint64)texture;
+}
+
+/*
+ * Pack a glyph into the glyph atlas. Glyphs too large for an atlas page
+ * get a texture of their own.
+ */
 void
 AG_GL_UpdateGlyph(void *obj, AG_Glyph *gl)
 {
-	AG_GL_UploadTexture(obj, &gl->texture, gl->su, &gl->texcoords);
+	AG_Driver *drv = obj;
+	AG_GlyphPage *pg;
+	AG_Surface *gsu;
+	int p;
+
+	if (gl->su->w == 0 || gl->su->h == 0) {
+		return;
+	}
+	gsu = AG_GlyphAtlasSurface(gl);
+
+	if ((p = AG_GlyphAtlasAlloc(drv, gl)) == -1) {
+		AG_GL_UploadTexture(obj, &gl->texture, gsu, &gl->texcoords);
+		AG_SurfaceFree(gsu);
+		return;
+	}
+	pg = &drv->glyphAtlas->pages[p];
+	if (pg->texture == 0) {
+		CreateGlyphPage(pg);
+	}
+
+	glBindTexture(GL_TEXTURE_2D, (GLuint)pg->texture);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, gsu->pitch/4);
+	glTexSubImage2D(GL_TEXTURE_2D, 0,
+	    gl->rAtlas.x, gl->rAtlas.y, gl->rAtlas.w, gl->rAtlas.h,
+	    GL_RGBA, GL_UNSIGNED_BYTE, gsu->pixels);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	AG_SurfaceFree(gsu);
+	gl->texture = pg->texture;
 }
 
+/* Draw a glyph, modulating its coverage by the current text color. */
 void
 AG_GL_DrawGlyph(void *obj, const AG_Glyph *gl, int x, int y)
 {
 	AG_Surface *su = gl->su;
 	const AG_TexCoord *tc = &gl->texcoords;
+	AG_Color C = agTextState->color;
+	GLint texEnvMode;
+
+	if (gl->texture == 0)
+		return;
+
+	AG_GlyphAtlasTouch(obj, gl);
+
+	glGetTexEnviv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, &texEnvMode);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	glColor4ub(C.r, C.g, C.b, C.a);
 
 	glBindTexture(GL_TEXTURE_2D, (GLuint)gl->texture); //WDZ - Texture
 	glBegin(GL_POLYGON);
@@ -1095,4 +1240,7 @@ AG_GL_DrawGlyph(void *obj, const AG_Glyph *gl, int x, int y)
 	}
 	glEnd();
 	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glColor4ub(255, 255, 255, 255);
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, texEnvMode);
 }
@@ -44,6 +44,26 @@
 static	Uint		ntexturemaps = 0;
 static	Uint		maxtextures = 0;
 
+/*
+ * Cache of textures created by SDL2_BlitSurface(), keyed by surface and
+ * surface generation (see AG_SurfaceTouch()).
+ */
+#define AG_SDL2_TEXCACHE_BUCKETS 256			/* Hash table size */
+#define AG_SDL2_TEXCACHE_BUDGET	 (16*1024*1024)		/* Default budget */
+#define AG_SDL2_TEXCACHE_REUSE	 8			/* LRU entries to scan */
+
+typedef struct ag_sdl2_texcache_ent {
+	const AG_Surface *su;		/* Source surface (not dereferenced) */
+	Uint gen;			/* Surface generation at upload */
+	SDL_Texture *tex;		/* Cached texture */
+	Uint32 texFmt;			/* Texture format (0 = not updatable) */
+	int w, h;			/* Texture size */
+	Uint size;			/* Texture size in bytes */
+	Uint frame;			/* Frame of last use */
+	AG_LIST_ENTRY(ag_sdl2_texcache_ent) bucket;
+	AG_TAILQ_ENTRY(ag_sdl2_texcache_ent) lru;
+} AG_SDL2_TexCacheEnt;
+
 typedef struct ag_sdl2_driver {
 	struct ag_driver_mw _inherit;
 	Uint mwflags;
@@ -54,6 +74,11 @@ typedef struct ag_sdl2_driver {
 	Uint32		wid;
 	AG_ClipRect *clipRects;		/* Clipping rectangle stack */
 	Uint        nClipRects;
+	AG_LIST_HEAD_(ag_sdl2_texcache_ent) texCache[AG_SDL2_TEXCACHE_BUCKETS];
+	AG_TAILQ_HEAD(ag_sdl2_texcache_entq,
+	              ag_sdl2_texcache_ent) texCacheLRU; /* Most recent first */
+	AG_SDL2_TextureCacheStats texCacheStats;
+	Uint texFrame;			/* Frame counter */
 } AG_DriverSDL2;
 
 AG_EventSink *sdlEventSpinner = NULL;	/* Standard event sink */
@@ -66,23 +91,254 @@ static int nDrivers = 0;			/* Opened driver instances */
 static int initedSDL = 0;			/* Used SDL_Init() */
 static int initedSDLVideo = 0;			/* Used SDL_INIT_VIDEO */
 
+#define AG_SDL2_WAIT_MAX 100		/* Maximum event wait (ms) */
+#define AG_SDL2_WAIT_IO	 10		/* Maximum wait with I/O sinks (ms) */
+static Uint32 sdl2WakeupEvent = (Uint32)-1;	/* Wakeup event type */
+static SDL_atomic_t sdl2WakeupPending;		/* Wakeup event queued */
+
 static void SDL2_DrawRectFilled(void *, AG_Rect, AG_Color);
 static void SDL2_UpdateRegion(void *, AG_Rect);
 
 static void SDL2_PostResizeCallback(AG_Window *, AG_SizeAlloc *);
 static void SDL2_PostMoveCallback(AG_Window *, AG_SizeAlloc *);
 static void SDL2_SetTransientFor(AG_Window *, AG_Window *);
+static void SDL2_Wakeup(void);
 void *AG_SDL2_SurfaceExportSDL2(const AG_Surface *);
 
 int AG_SDL2_EventSink(AG_EventSink *, AG_Event *);
 int AG_SDL2_EventEpilogue(AG_EventSink *, AG_Event *);
 AG_EventSink *sdl2EventSpinner = NULL;	/* For agTimeOps_renderer */
 
+static __inline__ Uint
+TexCacheHash(const AG_Surface *su)
+{
+	uintptr_t v = (uintptr_t)su;
+
+	return (Uint)((v >> 4) ^ (v >> 12)) & (AG_SDL2_TEXCACHE_BUCKETS-1);
+}
+
+/* Destroy a cached texture. */
+static void
+TexCacheFree(AG_DriverSDL2 *sdl, AG_SDL2_TexCacheEnt *ent)
+{
+	AG_LIST_REMOVE(ent, bucket);
+	AG_TAILQ_REMOVE(&sdl->texCacheLRU, ent, lru);
+	sdl->texCacheStats.size -= ent->size;
+	sdl->texCacheStats.nEntries--;
+	SDL_DestroyTexture(ent->tex);
+	Free(ent);
+}
+
+/* Destroy all cached textures (before the renderer goes away). */
+static void
+TexCacheClear(AG_DriverSDL2 *sdl)
+{
+	AG_SDL2_TexCacheEnt *ent;
+
+	while ((ent = AG_TAILQ_FIRST(&sdl->texCacheLRU)) != NULL)
+		TexCacheFree(sdl, ent);
+}
+
+/*
+ * Destroy the glyph atlas page textures and any standalone glyph texture
+ * (before the renderer goes away). Glyphs are uploaded again on next use.
+ */
+static void
+GlyphTexturesClear(AG_DriverSDL2 *sdl)
+{
+	AG_Driver *drv = (AG_Driver *)sdl;
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+	AG_Glyph *gl;
+	Uint i;
+
+	if (drv->glyphCache != NULL) {
+		AG_TAILQ_FOREACH(gl, &drv->glyphCache->glyphs, glyphs) {
+			if (gl->page != -1 || gl->texture == 0) {
+				continue;
+			}
+			SDL_DestroyTexture((SDL_Texture *)(uintptr_t)gl->texture);
+			gl->texture = 0;
+			gl->flags |= AG_GLYPH_STALE;
+		}
+	}
+	if (ga == NULL) {
+		return;
+	}
+	for (i = 0; i < ga->nPages; i++) {
+		AG_GlyphPage *pg = &ga->pages[i];
+
+		if (pg->texture != 0) {
+			SDL_DestroyTexture((SDL_Texture *)(uintptr_t)pg->texture);
+			pg->texture = 0;
+		}
+	}
+	AG_GlyphAtlasClear(drv);
+}
+
+/*
+ * Evict least recently used textures until the cache fits its budget.
+ * Textures drawn in the current frame are never evicted.
+ */
+static void
+TexCacheTrim(AG_DriverSDL2 *sdl)
+{
+	AG_SDL2_TexCacheEnt *ent;
+
+	while (sdl->texCacheStats.size > sdl->texCacheStats.budget &&
+	      (ent = AG_TAILQ_LAST(&sdl->texCacheLRU, ag_sdl2_texcache_entq))
+	       != NULL) {
+		if (ent->frame == sdl->texFrame) {
+			break;
+		}
+		TexCacheFree(sdl, ent);
+		sdl->texCacheStats.nEvicted++;
+	}
+}
+
+/* Rebind an entry to the given surface (and move it to the LRU head). */
+static void
+TexCacheBind(AG_DriverSDL2 *sdl, AG_SDL2_TexCacheEnt *ent,
+    const AG_Surface *su)
+{
+	AG_LIST_REMOVE(ent, bucket);
+	ent->su = su;
+	ent->gen = su->gen;
+	ent->frame = sdl->texFrame;
+	AG_LIST_INSERT_HEAD(&sdl->texCache[TexCacheHash(su)], ent, bucket);
+	AG_TAILQ_REMOVE(&sdl->texCacheLRU, ent, lru);
+	AG_TAILQ_INSERT_HEAD(&sdl->texCacheLRU, ent, lru);
+}
+
+/*
+ * Return a texture for the given surface. Textures are reused as long as
+ * the surface generation is unchanged. A stale texture of the same size is
+ * updated in place; otherwise an old texture of the same size which was
+ * not drawn in this frame is recycled before a new one is created.
+ */
+static SDL_Texture *
+TexCacheGet(AG_DriverSDL2 *sdl, AG_Surface *su)
+{
+	AG_SDL2_TextureCacheStats *st = &sdl->texCacheStats;
+	AG_SDL2_TexCacheEnt *ent;
+	Uint32 fmt = SDL_PIXELFORMAT_UNKNOWN;
+	SDL_Surface *ss;
+	Uint i;
+
+	AG_LIST_FOREACH(ent, &sdl->texCache[TexCacheHash(su)], bucket) {
+		if (ent->su == su)
+			break;
+	}
+	if (ent != NULL && ent->gen == su->gen &&
+	    ent->w == su->w && ent->h == su->h) {
+		TexCacheBind(sdl, ent, su);
+		st->nHits++;
+		return (ent->tex);
+	}
+	st->nMisses++;
+
+	if (su->format->palette == NULL) {
+		fmt = SDL_MasksToPixelFormatEnum(su->format->BitsPerPixel,
+		    su->format->Rmask, su->format->Gmask, su->format->Bmask,
+		    su->format->Amask);
+	}
+	if (ent != NULL && (fmt == SDL_PIXELFORMAT_UNKNOWN ||
+	    ent->texFmt != fmt || ent->w != su->w || ent->h != su->h)) {
+		TexCacheFree(sdl, ent);			/* Unusable */
+		ent = NULL;
+	}
+	if (ent == NULL && fmt != SDL_PIXELFORMAT_UNKNOWN) {
+		i = 0;
+		AG_TAILQ_FOREACH_REVERSE(ent, &sdl->texCacheLRU,
+		    ag_sdl2_texcache_entq, lru) {
+			if (++i > AG_SDL2_TEXCACHE_REUSE ||
+			    ent->frame == sdl->texFrame) {
+				ent = NULL;
+				break;
+			}
+			if (ent->texFmt == fmt &&
+			    ent->w == su->w && ent->h == su->h)
+				break;
+		}
+	}
+	if (ent != NULL) {
+		if (SDL_UpdateTexture(ent->tex, NULL, su->pixels, su->pitch)
+		    == 0) {
+			TexCacheBind(sdl, ent, su);
+			st->nUpdated++;
+			return (ent->tex);
+		}
+		TexCacheFree(sdl, ent);
+	}
+
+	if ((ent = TryMalloc(sizeof(AG_SDL2_TexCacheEnt))) == NULL) {
+		return (NULL);
+	}
+	if (fmt != SDL_PIXELFORMAT_UNKNOWN) {
+		ent->tex = SDL_CreateTexture(sdl->r, fmt,
+		    SDL_TEXTUREACCESS_STATIC, su->w, su->h);
+		if (ent->tex != NULL &&
+		    SDL_UpdateTexture(ent->tex, NULL, su->pixels, su->pitch)
+		    != 0) {
+			SDL_DestroyTexture(ent->tex);
+			ent->tex = NULL;
+		}
+		ent->texFmt = fmt;
+	} else {
+		if ((ss = AG_SDL2_SurfaceExportSDL2(su)) == NULL) {
+			Free(ent);
+			return (NULL);
+		}
+		ent->tex = SDL_CreateTextureFromSurface(sdl->r, ss);
+		SDL_FreeSurface(ss);
+		ent->texFmt = 0;
+	}
+	if (ent->tex == NULL) {
+		AG_SetError("SDL_CreateTexture: %s", SDL_GetError());
+		Free(ent);
+		return (NULL);
+	}
+	SDL_SetTextureBlendMode(ent->tex, SDL_BLENDMODE_BLEND);
+	SDL_SetTextureAlphaMod(ent->tex, 255);
+	ent->su = su;
+	ent->gen = su->gen;
+	ent->w = su->w;
+	ent->h = su->h;
+	ent->size = su->w*su->h*4;
+	ent->frame = sdl->texFrame;
+	AG_LIST_INSERT_HEAD(&sdl->texCache[TexCacheHash(su)], ent, bucket);
+	AG_TAILQ_INSERT_HEAD(&sdl->texCacheLRU, ent, lru);
+	st->nCreated++;
+	st->nEntries++;
+	st->size += ent->size;
+	TexCacheTrim(sdl);
+	return (ent->tex);
+}
+
+/* Return texture cache statistics for an SDL2 driver instance. */
+void
+AG_SDL2_GetTextureCacheStats(void *obj, AG_SDL2_TextureCacheStats *st)
+{
+	AG_DriverSDL2 *sdl = obj;
+
+	memcpy(st, &sdl->texCacheStats, sizeof(AG_SDL2_TextureCacheStats));
+}
+
+/* Set the maximum size of cached textures in bytes for a driver instance. */
+void
+AG_SDL2_SetTextureCacheBudget(void *obj, Uint budget)
+{
+	AG_DriverSDL2 *sdl = obj;
+
+	sdl->texCacheStats.budget = budget;
+	TexCacheTrim(sdl);
+}
+
 static void
 Init(void *obj)
 {
 	AG_DriverSDL2 *sdl = obj;
 	AG_DriverMw *dmw = obj;
+	Uint i;
 
 	dmw->flags |= AG_DRIVER_MW_ANYPOS_AVAIL;
 	sdl->w = NULL;
@@ -93,6 +349,14 @@ Init(void *obj)
 	sdl->wid = 0;
 	sdl->f = 0;
 	sdl->mwflags = 0;
+
+	for (i = 0; i < AG_SDL2_TEXCACHE_BUCKETS; i++) {
+		AG_LIST_INIT(&sdl->texCache[i]);
+	}
+	AG_TAILQ_INIT(&sdl->texCacheLRU);
+	memset(&sdl->texCacheStats, 0, sizeof(AG_SDL2_TextureCacheStats));
+	sdl->texCacheStats.budget = AG_SDL2_TEXCACHE_BUDGET;
+	sdl->texFrame = 0;
 }
 
 static void
@@ -100,6 +364,8 @@ Destroy(void *obj)
 {
 	AG_DriverSDL2 *sdl = obj;
 
+	TexCacheClear(sdl);
+	GlyphTexturesClear(sdl);
 	Free(sdl->clipRects);
 }
 
@@ -157,6 +423,13 @@ SDL2_Open(void *obj, const char *spec)
 			(sdlEventEpilogue = AG_AddEventEpilogue(AG_SDL2_EventEpilogue, NULL)) == NULL) {
 			goto fail1;
 		}
+		if (sdl2WakeupEvent == (Uint32)-1) {
+			sdl2WakeupEvent = SDL_RegisterEvents(1);
+		}
+		if (sdl2WakeupEvent != (Uint32)-1) {
+			SDL_AtomicSet(&sdl2WakeupPending, 0);
+			AG_SetWakeupCallback(SDL2_Wakeup);
+		}
 	}
 
 // #if defined(HAVE_CLOCK_GETTIME) && defined(HAVE_PTHREADS)
@@ -184,6 +457,7 @@ SDL2_Close(void *obj)
 	AG_DriverSDL2 *sdl = obj;
 	
 	if (--nDrivers == 0) {
+		AG_SetWakeupCallback(NULL);
 		if(sdlEventSpinner != NULL)
 		{
 			AG_DelEventSink(sdlEventSpinner); sdlEventSpinner = NULL;
@@ -562,6 +836,12 @@ AG_SDL2_GetNextEvent(void *obj, AG_DriverEvent *dev)
 	{
 		return (0);
 	}
+	if (ev.type == sdl2WakeupEvent) {
+		SDL_AtomicSet(&sdl2WakeupPending, 0);
+		dev->type = AG_DRIVER_UNKNOWN;
+		dev->win = NULL;
+		return (1);
+	}
 	
 	switch (ev.type) {
 	case SDL_MOUSEMOTION:
@@ -865,11 +1145,59 @@ AG_SDL2_ProcessEvent(void *obj, AG_DriverEvent *dev)
 }
 
 /*
- * Standard event sink for AG_EventLoop().
- *
- * TODO where AG_SINK_READ capability and pipes are available,
- * could we create a separate thread running SDL_WaitEvent() and
- * sending notifications over a pipe, instead of using a spinner?
+ * Wake up the event sink from another thread (see AG_WakeupEventLoop()).
+ * Only one wakeup event is queued at any time.
+ */
+static void
+SDL2_Wakeup(void)
+{
+	SDL_Event ev;
+
+	if (!SDL_AtomicCAS(&sdl2WakeupPending, 0, 1)) {
+		return;
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.type = sdl2WakeupEvent;
+	if (SDL_PushEvent(&ev) != 1)
+		SDL_AtomicSet(&sdl2WakeupPending, 0);
+}
+
+/*
+ * Return the time in ms the event sink may block for: until the next timer
+ * is due, or right away if a window is still waiting to be redrawn. I/O
+ * sinks are only polled between waits, so the wait is shorter if any exist.
+ */
+static int
+SDL2_GetWaitTimeout(void)
+{
+	AG_Driver *drv;
+	AG_Window *win;
+	Uint32 t;
+
+	AG_LockVFS(&agDrivers);
+	AGOBJECT_FOREACH_CHILD(drv, &agDrivers, ag_driver) {
+		if (!AGDRIVER_IS_SDL2(drv)) {
+			continue;
+		}
+		if ((win = AGDRIVER_MW(drv)->win) != NULL &&
+		    win->visible && win->dirty) {
+			AG_UnlockVFS(&agDrivers);
+			return (1);
+		}
+	}
+	AG_UnlockVFS(&agDrivers);
+
+	t = AG_GetEventSourceTimeout();
+	if (!TAILQ_EMPTY(&AG_GetEventSource()->sinks)) {
+		return (int)MIN(t, AG_SDL2_WAIT_IO);
+	}
+	return (int)MIN(t, AG_SDL2_WAIT_MAX);
+}
+
+/*
+ * Standard event sink for AG_EventLoop(). Rather than polling, block in
+ * SDL_WaitEventTimeout() until an SDL event arrives or the next timer is
+ * due. Other threads interrupt the wait with AG_WakeupEventLoop().
  */
 int
 AG_SDL2_EventSink(AG_EventSink *es, AG_Event *event)
@@ -878,11 +1206,9 @@ AG_SDL2_EventSink(AG_EventSink *es, AG_Event *event)
 	AG_Driver *drv = AG_PTR(1);
 	int rv = 0;
 
-	if (SDL_PollEvent(NULL) != 0) {
+	if (SDL_WaitEventTimeout(NULL, SDL2_GetWaitTimeout()) != 0) {
 		while (AG_SDL2_GetNextEvent(drv, &dev) == 1)
 			rv = AG_SDL2_ProcessEvent(drv, &dev);
-	} else {
-		AG_Delay(1);
 	}
 	return (rv); // was zero
 }
@@ -899,6 +1225,8 @@ static void
 SDL2_BeginRendering(void *obj)
 {
 	AG_DriverSDL2 *sdl = obj;
+
+	sdl->texFrame++;
 }
 
 static void
@@ -1291,6 +1619,29 @@ AG_SDL2_GetDisplaySize(Uint *w, Uint *h)
  * See widget.c and widget.h for more comments. 
  */
 
+/*
+ * Copy surface pixels to a locked texture, one row at a time since the
+ * texture pitch may differ from the surface pitch.
+ */
+static void
+SDL2_CopyToTexture(void *pixels, int pitch, const AG_Surface *su)
+{
+	Uint8 *pDst = pixels;
+	const Uint8 *pSrc = su->pixels;
+	Uint len = MIN((Uint)pitch, su->w*su->format->BytesPerPixel);
+	Uint y;
+
+	if ((Uint)pitch == su->pitch) {
+		memcpy(pDst, pSrc, su->pitch*(su->h-1) + len);
+		return;
+	}
+	for (y = 0; y < su->h; y++) {
+		memcpy(pDst, pSrc, len);
+		pDst += pitch;
+		pSrc += su->pitch;
+	}
+}
+
 void
 SDL2_UploadTexture(void *drv, void *rtexture, AG_Surface *su, AG_TexCoord *tc)
 {
@@ -1323,10 +1674,10 @@ SDL2_UploadTexture(void *drv, void *rtexture, AG_Surface *su, AG_TexCoord *tc)
 
 	ntexturemaps++;
 
-	if (pt != NULL)
+	if (pt != NULL &&
+	    SDL_LockTexture(pt, NULL, &pixels, &pitch) == 0)
 	{
-		SDL_LockTexture(pt, NULL, &pixels, &pitch);
-		memcpy(pixels, su->pixels, pitch * su->h);
+		SDL2_CopyToTexture(pixels, pitch, su);
 		SDL_UnlockTexture(pt);
 	}
 
@@ -1374,10 +1725,10 @@ SDL2_UpdateTexture(void *drv, void *textureID, AG_Surface *su, AG_TexCoord *tc)
 
 	// fprintf(stderr, "Update Texture\n");
 
-	if (pt != NULL)
+	if (pt != NULL &&
+	    SDL_LockTexture(pt, NULL, &pixels, &pitch) == 0)
 	{
-		SDL_LockTexture(pt, NULL, &pixels, &pitch);
-		memcpy(pixels, su->pixels, pitch * su->h);
+		SDL2_CopyToTexture(pixels, pitch, su);
 		SDL_UnlockTexture(pt);
 	}
 
@@ -1386,6 +1737,38 @@ SDL2_UpdateTexture(void *drv, void *textureID, AG_Surface *su, AG_TexCoord *tc)
 	return (0);
 }
 
+/*
+ * Upload only the region r of su to an existing texture of the same size.
+ * Return -1 if a full update is required.
+ */
+static int
+SDL2_UpdateTextureRect(AG_DriverSDL2 *sdl, SDL_Texture *pt, AG_Surface *su,
+    AG_Rect r)
+{
+	SDL_Rect sr;
+	int tw, th;
+
+	if (pt == NULL ||
+	    SDL_QueryTexture(pt, NULL, NULL, &tw, &th) != 0 ||
+	    tw != su->w || th != su->h) {
+		return (-1);
+	}
+	if (r.x < 0) { r.w += r.x; r.x = 0; }
+	if (r.y < 0) { r.h += r.y; r.y = 0; }
+	if (r.x+r.w > su->w) { r.w = su->w - r.x; }
+	if (r.y+r.h > su->h) { r.h = su->h - r.y; }
+	if (r.w <= 0 || r.h <= 0) {
+		return (0);
+	}
+	sr.x = r.x;
+	sr.y = r.y;
+	sr.w = r.w;
+	sr.h = r.h;
+	return SDL_UpdateTexture(pt, &sr,
+	    (Uint8 *)su->pixels + r.y*su->pitch + r.x*su->format->BytesPerPixel,
+	    su->pitch);
+}
+
 void
 SDL2_DeleteTexture(void *obj, void *textureID)
 {
@@ -1412,10 +1795,19 @@ SDL2_PrepareTexture(void *obj, int s)
 	AG_Widget *wid = obj;
 	AG_Driver *drv = wid->drv;
 
+	Uint flags = wid->surfaceFlags[s];
+
 	if (wid->textures[s] == 0) {
 		SDL2_UploadTexture(drv, &wid->textures[s], wid->surfaces[s], &wid->texcoords[s]);
-	} else if (wid->surfaceFlags[s] & AG_WIDGET_SURFACE_REGEN) {
-		wid->surfaceFlags[s] &= ~(AG_WIDGET_SURFACE_REGEN);
+	} else if (flags & AG_WIDGET_SURFACE_REGEN) {
+		wid->surfaceFlags[s] &= ~(AG_WIDGET_SURFACE_REGEN|
+		                          AG_WIDGET_SURFACE_REGEN_RECT);
+		if ((flags & AG_WIDGET_SURFACE_REGEN_RECT) &&
+		    SDL2_UpdateTextureRect((AG_DriverSDL2 *)drv,
+		    *(SDL_Texture **)&wid->textures[s], wid->surfaces[s],
+		    wid->surfaceDirty[s]) == 0) {
+			return;
+		}
 		SDL2_UpdateTexture(drv, &wid->textures[s], wid->surfaces[s], &wid->texcoords[s]);
 	}
 }
@@ -1440,25 +1832,21 @@ static void
 SDL2_BlitSurface(void *drv, AG_Widget *wid, AG_Surface *s, int x, int y)
 {
 	AG_DriverSDL2 *sdl = drv;
-	AG_TexCoord tc;
 	SDL_Rect dr;
 	SDL_Texture *texture;
-	SDL_Surface *ss;
 
 	AG_ASSERT_CLASS(drv, "AG_Driver:*");
 	AG_ASSERT_CLASS(wid, "AG_Widget:*");
 
+	if ((texture = TexCacheGet(sdl, s)) == NULL)
+		return;
+
 	dr.x = x;
 	dr.y = y;
 	dr.w = s->w;
 	dr.h = s->h;
 
-	ss = (SDL_Surface*)AG_SDL2_SurfaceExportSDL2(s);
-	texture = SDL_CreateTextureFromSurface(sdl->r, ss);
-	
 	SDL2_PushBlendingMode(drv, AG_ALPHA_SRC, AG_ALPHA_ONE_MINUS_SRC);
-	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
-	SDL_SetTextureAlphaMod(texture, 255);
 	SDL_RenderCopy(sdl->r, texture, NULL, &dr);
 	SDL2_PopBlendingMode(drv);
 }
@@ -2009,55 +2397,107 @@ SDL2_DrawRectDithered(void *obj, AG_Rect r, AG_Color C)
 	}
 }
 
-static void
-SDL2_UpdateGlyph(void *drv, AG_Glyph *gl)
+/*
+ * Create a texture for glyphs, in the pixel format returned by
+ * AG_GlyphAtlasSurface().
+ */
+static SDL_Texture *
+SDL2_CreateGlyphTexture(AG_DriverSDL2 *sdl, int w, int h)
 {
-	AG_DriverSDL2 *sdl = drv;
-	SDL_Texture *texture = NULL;
-	SDL_Surface *ss = NULL;
-	int pitch, depth;
+	SDL_Texture *texture;
 
-	if (gl->su->w == 0 || gl->su->h == 0) return ;
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+	texture = SDL_CreateTexture(sdl->r, SDL_PIXELFORMAT_RGBA8888,
+	    SDL_TEXTUREACCESS_STATIC, w, h);
+#else
+	texture = SDL_CreateTexture(sdl->r, SDL_PIXELFORMAT_ABGR8888,
+	    SDL_TEXTUREACCESS_STATIC, w, h);
+#endif
+	if (texture == NULL) {
+		AG_SetError("SDL_CreateTexture: %s", SDL_GetError());
+		return (NULL);
+	}
+	SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+	return (texture);
+}
 
-	pitch = gl->su->pitch;
-	depth = pitch / gl->su->w * 8;
+/* Create the texture of a glyph atlas page. */
+static int
+SDL2_CreateGlyphPage(AG_DriverSDL2 *sdl, AG_GlyphPage *pg)
+{
+	SDL_Texture *texture;
+	void *pixels;
 
-	texture = (SDL_Texture*)gl->texture;
+	if ((texture = SDL2_CreateGlyphTexture(sdl, pg->w, pg->h)) == NULL) {
+		return (-1);
+	}
+	/* Clear the padding between glyphs. */
+	if ((pixels = TryMalloc(pg->w*pg->h*4)) != NULL) {
+		memset(pixels, 0, pg->w*pg->h*4);
+		SDL_UpdateTexture(texture, NULL, pixels, pg->w*4);
+		Free(pixels);
+	}
+	pg->texture = (Uint64)(uintptr_t)texture;
+	return (0);
+}
 
-	if (texture != NULL)
-	{
-		int tw, th;
+/*
+ * Pack a glyph into the glyph atlas. Glyphs too large for an atlas page
+ * get a texture of their own.
+ */
+static void
+SDL2_UpdateGlyph(void *drv, AG_Glyph *gl)
+{
+	AG_DriverSDL2 *sdl = drv;
+	AG_GlyphPage *pg;
+	AG_Surface *gsu;
+	SDL_Texture *texture;
+	SDL_Rect r;
+	int p;
 
-		SDL_QueryTexture(texture, NULL, NULL, &tw, &th);
+	if (gl->su->w == 0 || gl->su->h == 0) return ;
 
-		// Only Update if the required texture size is different from the previous size
+	gsu = AG_GlyphAtlasSurface(gl);
 
-		if (tw != gl->su->w || th != gl->su->h)
-		{
-			SDL_DestroyTexture(texture);
-			texture = NULL;
+	if ((p = AG_GlyphAtlasAlloc(drv, gl)) != -1) {
+		pg = &AGDRIVER(drv)->glyphAtlas->pages[p];
+		if (pg->texture == 0 &&
+		    SDL2_CreateGlyphPage(sdl, pg) == -1) {
+			AG_GlyphAtlasFree(drv, gl);
+			goto standalone;
 		}
+		r.x = gl->rAtlas.x;
+		r.y = gl->rAtlas.y;
+		r.w = gl->rAtlas.w;
+		r.h = gl->rAtlas.h;
+		SDL_UpdateTexture((SDL_Texture *)(uintptr_t)pg->texture, &r,
+		    gsu->pixels, gsu->pitch);
+		gl->texture = pg->texture;
+		AG_SurfaceFree(gsu);
+		return;
 	}
-	
-	if (texture == NULL)
-	{
-		ss = SDL_CreateRGBSurfaceFrom(gl->su->pixels, gl->su->w, gl->su->h, depth, pitch, 
-			gl->su->format->Rmask, gl->su->format->Gmask, gl->su->format->Bmask, gl->su->format->Amask);
-		texture = SDL_CreateTextureFromSurface(sdl->r, ss);
-		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
-		SDL_SetTextureAlphaMod(texture, 255);
-		SDL_FreeSurface(ss);
+standalone:
+	gl->page = -1;
+	if (gl->texture == 0 &&
+	    (texture = SDL2_CreateGlyphTexture(sdl, gsu->w, gsu->h)) != NULL) {
+		SDL_UpdateTexture(texture, NULL, gsu->pixels, gsu->pitch);
+		gl->texture = (Uint64)(uintptr_t)texture;
 	}
-
-	gl->texture = (Uint64)texture;
+	AG_SurfaceFree(gsu);
 }
 
+/*
+ * Draw a glyph in the current text color. Successive glyphs from the same
+ * atlas page share a texture, which lets the SDL renderer batch them into
+ * a single geometry submission.
+ */
 static void
 SDL2_DrawGlyph(void *drv, AG_Glyph *gl, int x, int y)
 {
 	AG_DriverSDL2 *sdl = drv;
+	AG_Color C = agTextState->color;
 	SDL_Texture *texture = NULL;
-	SDL_Rect dr = { 0, 0, 0, 0 };
+	SDL_Rect sr, dr = { 0, 0, 0, 0 };
 
 	if (gl->su->w == 0 || gl->su->h == 0) return ;
 
@@ -2073,7 +2513,19 @@ SDL2_DrawGlyph(void *drv, AG_Glyph *gl, int x, int y)
 
 	if (texture == NULL) return;
 
-	SDL_RenderCopy(sdl->r, texture, NULL, &dr);
+	SDL_SetTextureColorMod(texture, C.r, C.g, C.b);
+	SDL_SetTextureAlphaMod(texture, C.a);
+
+	if (gl->page != -1) {
+		AG_GlyphAtlasTouch(drv, gl);
+		sr.x = gl->rAtlas.x;
+		sr.y = gl->rAtlas.y;
+		sr.w = gl->rAtlas.w;
+		sr.h = gl->rAtlas.h;
+		SDL_RenderCopy(sdl->r, texture, &sr, &dr);
+	} else {
+		SDL_RenderCopy(sdl->r, texture, NULL, &dr);
+	}
 }
 
 /*
@@ -2124,6 +2576,10 @@ SDL2_OpenWindow(AG_Window *win, AG_Rect r, int depthReq, Uint mwFlags)
 	sdl->mwflags = mwFlags; /* some of the flags that can't be used now are useful later so record the flags */
 
 	sdl->w = SDL_CreateWindow("AGAR:Untitled", r.x, r.y, r.w, r.h, winflags | SDL_WINDOW_HIDDEN);
+#ifdef SDL_HINT_RENDER_BATCHING
+	/* Merge successive copies from the same texture (e.g., glyph atlas). */
+	SDL_SetHint(SDL_HINT_RENDER_BATCHING, "1");
+#endif
 	sdl->r = SDL_CreateRenderer(sdl->w, -1, SDL_RENDERER_PRESENTVSYNC | SDL_RENDERER_ACCELERATED);
 	sdl->f = SDL_GetWindowPixelFormat(sdl->w); /* The pixel format will be checked alot so... */
 	sdl->pf = SDL_AllocFormat(sdl->f); /* The pixel format will be checked alot so... */
@@ -2175,6 +2631,10 @@ SDL2_CloseWindow(AG_Window *win)
 	/* Release allocated cursors. */
 	AG_FreeCursors(drv);
 
+	/* Cached textures belong to the renderer. */
+	TexCacheClear(sdl);
+	GlyphTexturesClear(sdl);
+
 	if(sdl->pf != NULL)
 	{
 		SDL_FreeFormat(sdl->pf);
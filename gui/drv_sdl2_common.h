@@ -33,6 +33,18 @@
 
 #include <agar/gui/begin.h>
 
+/* Statistics for the texture cache of the SDL2 driver. */
+typedef struct ag_sdl2_texture_cache_stats {
+	Uint nHits;			/* Surface blits using a cached texture */
+	Uint nMisses;			/* Surface blits requiring an upload */
+	Uint nCreated;			/* Textures created */
+	Uint nUpdated;			/* Textures updated in place */
+	Uint nEvicted;			/* Textures evicted (over budget) */
+	Uint nEntries;			/* Textures currently cached */
+	Uint size;			/* Bytes resident */
+	Uint budget;			/* Maximum bytes resident */
+} AG_SDL2_TextureCacheStats;
+
 __BEGIN_DECLS
 AG_PixelFormat *AG_SDL2_GetPixelFormat(SDL_Surface *);
 AG_Surface     *AG_SDL2_ImportSurface(SDL_Surface *);
@@ -57,6 +69,9 @@ int             AG_SDL2_ProcessEvent(void *, AG_DriverEvent *);
 int             AG_SDL2_EventSink(AG_EventSink *, AG_Event *);
 int             AG_SDL2_EventEpilogue(AG_EventSink *, AG_Event *);
 void            AG_SDL2_EndEventProcessing(void *);
+
+void            AG_SDL2_GetTextureCacheStats(void *, AG_SDL2_TextureCacheStats *);
+void            AG_SDL2_SetTextureCacheBudget(void *, Uint);
 __END_DECLS
 
 #include <agar/gui/close.h>
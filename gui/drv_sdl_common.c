@@ -294,6 +294,51 @@ AG_SDL_BlitSurface(const AG_Surface *ss, const AG_Rect *srcRect,
 		SDL_UnlockSurface(ds);
 }
 
+/*
+ * Blend an 8-bit coverage mask (such as a cached glyph) onto a SDL surface
+ * at xDst,yDst using color C, with clipping.
+ */
+void
+AG_SDL_BlitMask(const AG_Surface *sm, SDL_Surface *ds, int xDst, int yDst,
+    AG_Color C)
+{
+	SDL_Rect *rc = &ds->clip_rect;
+	int x1 = MAX(xDst, rc->x), x2 = MIN(xDst+(int)sm->w, rc->x+rc->w);
+	int y1 = MAX(yDst, rc->y), y2 = MIN(yDst+(int)sm->h, rc->y+rc->h);
+	Uint8 *pSrc, *pDst;
+	Uint32 px;
+	AG_Color Cpx = C;
+	int x, y;
+
+	if (x1 >= x2 || y1 >= y2) {
+		return;
+	}
+	px = SDL_MapRGB(ds->format, C.r, C.g, C.b);
+	if (SDL_MUSTLOCK(ds)) {
+		SDL_LockSurface(ds);
+	}
+	for (y = y1; y < y2; y++) {
+		pSrc = (Uint8 *)sm->pixels + (y-yDst)*sm->pitch + (x1-xDst);
+		pDst = (Uint8 *)ds->pixels + y*ds->pitch +
+		    x1*ds->format->BytesPerPixel;
+		for (x = x1; x < x2; x++) {
+			Uint a = ((Uint)(*pSrc++) * C.a + 127) / 255;
+
+			if (a == AG_ALPHA_OPAQUE) {
+				AG_PACKEDPIXEL_PUT(ds->format->BytesPerPixel,
+				    pDst, px);
+			} else if (a != 0) {
+				Cpx.a = (Uint8)a;
+				AG_SDL_SurfaceBlendPixel(ds, pDst, Cpx,
+				    AG_ALPHA_SRC);
+			}
+			pDst += ds->format->BytesPerPixel;
+		}
+	}
+	if (SDL_MUSTLOCK(ds))
+		SDL_UnlockSurface(ds);
+}
+
 #if 0
 #define AG_SDL_GET_PIXEL_COMPONENT(rv, mask, shift, loss)		\
 	tmp = (pc & mask) >> shift;					\
@@ -37,6 +37,8 @@ __BEGIN_DECLS
 AG_PixelFormat *AG_SDL_GetPixelFormat(SDL_Surface *);
 void            AG_SDL_BlitSurface(const AG_Surface *, const AG_Rect *,
                                    SDL_Surface *, int, int);
+void            AG_SDL_BlitMask(const AG_Surface *, SDL_Surface *, int, int,
+                                AG_Color);
 AG_Surface     *AG_SDL_ImportSurface(SDL_Surface *);
 
 int             AG_SDL_SetRefreshRate(void *, int);
@@ -218,9 +218,9 @@ SDLFB_UpdateRegion(void *obj, AG_Rect rp)
 	AG_DriverSDLFB *sfb = obj;
 	SDL_Rect *sr;
 	AG_Rect2 r = AG_RectToRect2(rp);
+	Uint i;
 	int n;
 
-	/* TODO Compute intersections? */
 	if (r.x1 < 0) { r.x1 = 0; }
 	if (r.y1 < 0) { r.y1 = 0; }
 	if (r.x2 > dsw->w) { r.x2 = dsw->w; r.w = r.x2-r.x1; }
@@ -228,6 +228,23 @@ SDLFB_UpdateRegion(void *obj, AG_Rect rp)
 	if (r.w < 0) { r.x1 = 0; r.x2 = r.w = dsw->w; }
 	if (r.h < 0) { r.y1 = 0; r.y2 = r.h = dsw->h; }
 
+	/* Skip regions already queued; replace queued regions we contain. */
+	for (i = 0; i < sfb->nDirty; i++) {
+		sr = &sfb->dirty[i];
+		if (r.x1 >= sr->x && r.y1 >= sr->y &&
+		    r.x2 <= sr->x+sr->w && r.y2 <= sr->y+sr->h) {
+			return;
+		}
+		if (sr->x >= r.x1 && sr->y >= r.y1 &&
+		    sr->x+sr->w <= r.x2 && sr->y+sr->h <= r.y2) {
+			sr->x = r.x1;
+			sr->y = r.y1;
+			sr->w = r.w;
+			sr->h = r.h;
+			return;
+		}
+	}
+
 	n = sfb->nDirty++;
 	if (n+1 > sfb->maxDirty) {
 		sfb->maxDirty *= 2;
@@ -1177,12 +1194,13 @@ SDLFB_UpdateGlyph(void *drv, AG_Glyph *gl)
 	/* Nothing to do */
 }
 
+/* Draw a glyph in the current text color. */
 static void
 SDLFB_DrawGlyph(void *drv, const AG_Glyph *gl, int x, int y)
 {
 	AG_DriverSDLFB *sfb = drv;
 	
-	AG_SDL_BlitSurface(gl->su, NULL, sfb->s, x,y);
+	AG_SDL_BlitMask(gl->su, sfb->s, x,y, agTextState->color);
 }
 
 /* Initialize the clipping rectangle stack. */
@@ -1509,7 +1527,7 @@ AG_DriverSwClass agDriverSDLFB = {
 		SDLFB_DrawGlyph,
 		NULL				/* deleteList */
 	},
-	0,
+	AG_DRIVER_SW_CLASS_DAMAGE,
 	SDLFB_OpenVideo,
 	SDLFB_OpenVideoContext,
 	SDLFB_SetVideoContext,
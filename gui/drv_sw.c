@@ -58,6 +58,9 @@ Init(void *obj)
 	dsw->windowBotOutLimit = 32;
 	dsw->windowIconWidth = 32;
 	dsw->windowIconHeight = 32;
+	dsw->nDamage = 0;
+	dsw->nPixelsDrawn = 0;
+	AG_MutexInitRecursive(&dsw->damageLock);
 
 	if ((dsw->Lmodal = AG_ListNew()) == NULL)
 		AG_FatalError(NULL);
@@ -72,6 +75,8 @@ Destroy(void *obj)
 	
 	if (dsw->Lmodal != NULL)
 		AG_ListDestroy(dsw->Lmodal);
+
+	AG_MutexDestroy(&dsw->damageLock);
 }
 
 /*
@@ -273,11 +278,13 @@ WM_Move(AG_Window *win, int xRel, int yRel)
 			AGDRIVER_CLASS(dsw)->fillRect(dsw, rFill1, dsw->bgColor);
 			if (AGDRIVER_CLASS(dsw)->updateRegion != NULL)
 				AGDRIVER_CLASS(dsw)->updateRegion(dsw, rFill1);
+			AG_WM_AddDamage(dsw, rFill1);
 		}
 		if (rFill2.w > 0) {
 			AGDRIVER_CLASS(dsw)->fillRect(dsw, rFill2, dsw->bgColor);
 			if (AGDRIVER_CLASS(dsw)->updateRegion != NULL)
 				AGDRIVER_CLASS(dsw)->updateRegion(dsw, rFill2);
+			AG_WM_AddDamage(dsw, rFill2);
 		}
 	}
 
@@ -381,6 +388,57 @@ AG_WM_MouseMotion(AG_DriverSw *dsw, AG_Window *win, int xRel, int yRel)
 	}
 }
 
+/*
+ * Add a rectangle (in display coordinates) to the damaged region of the
+ * display. On drivers with AG_DRIVER_SW_CLASS_DAMAGE, the next rendering
+ * pass redraws only the windows and widgets intersecting the damaged region.
+ * Overlapping rectangles are merged; if too many distinct rectangles are
+ * queued, they are collapsed into their bounding box.
+ */
+void
+AG_WM_AddDamage(AG_DriverSw *dsw, AG_Rect r)
+{
+	AG_Rect2 rd, *d;
+	Uint i;
+
+	rd.x1 = AG_MAX(r.x, 0);
+	rd.y1 = AG_MAX(r.y, 0);
+	rd.x2 = AG_MIN(r.x+r.w, (int)dsw->w);
+	rd.y2 = AG_MIN(r.y+r.h, (int)dsw->h);
+	if (rd.x2 <= rd.x1 || rd.y2 <= rd.y1)
+		return;
+
+	AG_MutexLock(&dsw->damageLock);
+	for (i = 0; i < dsw->nDamage; i++) {
+		d = &dsw->damage[i];
+		if (rd.x1 < d->x2 && rd.x2 > d->x1 &&
+		    rd.y1 < d->y2 && rd.y2 > d->y1)
+			break;
+	}
+	if (i == dsw->nDamage) {
+		if (dsw->nDamage < AG_DRIVER_SW_DAMAGE_MAX) {
+			d = &dsw->damage[dsw->nDamage++];
+			*d = rd;
+			goto out;
+		}
+		for (i = 1, d = &dsw->damage[0]; i < dsw->nDamage; i++) {
+			d->x1 = AG_MIN(d->x1, dsw->damage[i].x1);
+			d->y1 = AG_MIN(d->y1, dsw->damage[i].y1);
+			d->x2 = AG_MAX(d->x2, dsw->damage[i].x2);
+			d->y2 = AG_MAX(d->y2, dsw->damage[i].y2);
+		}
+		dsw->nDamage = 1;
+	}
+	d->x1 = AG_MIN(d->x1, rd.x1);
+	d->y1 = AG_MIN(d->y1, rd.y1);
+	d->x2 = AG_MAX(d->x2, rd.x2);
+	d->y2 = AG_MAX(d->y2, rd.y2);
+out:
+	d->w = d->x2 - d->x1;
+	d->h = d->y2 - d->y1;
+	AG_MutexUnlock(&dsw->damageLock);
+}
+
 /*
  * Reorder the window list and post the appropriate Window events following
  * a change in focus (single-display drivers only).
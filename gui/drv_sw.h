@@ -9,6 +9,8 @@
 typedef struct ag_driver_sw_class {
 	struct ag_driver_class _inherit;
 	Uint flags;
+#define AG_DRIVER_SW_CLASS_DAMAGE 0x01	/* Supports partial redraw of
+					   damaged regions (see updateRegion) */
 	/* Create or attach to a graphics display */
 	int  (*openVideo)(void *drv, Uint w, Uint h, int depth, Uint flags);
 	int  (*openVideoContext)(void *drv, void *ctx, Uint flags);
@@ -48,6 +50,8 @@ enum ag_wm_operation {
 	AG_WINOP_HRESIZE	/* Resize (via horizontal control) */
 };
 
+#define AG_DRIVER_SW_DAMAGE_MAX 16	/* Maximum distinct damage rects */
+
 /* Single-window driver instance */
 typedef struct ag_driver_sw {
 	struct ag_driver _inherit;
@@ -57,6 +61,7 @@ typedef struct ag_driver_sw {
 #define AG_DRIVER_SW_BGPOPUP	0x02	/* Enable generic background popup */
 #define AG_DRIVER_SW_FULLSCREEN	0x04	/* Currently in full-screen mode */
 #define AG_DRIVER_SW_REDRAW	0x08	/* Global redraw request */
+#define AG_DRIVER_SW_DAMAGE_PASS 0x10	/* Redrawing damage (read-only) */
 
 	struct ag_window *winSelected;	/* Window being moved/resized/etc */
 	struct ag_window *winLastKeydown; /* For keyboard processing */
@@ -71,6 +76,11 @@ typedef struct ag_driver_sw {
 	int rCur;			/* Effective refresh rate (ms) */
 	AG_Color bgColor;		/* "bgColor" setting */
 	Uint rLast;			/* Refresh rate timestamp */
+	AG_Mutex damageLock;		/* Lock on damage region */
+	AG_Rect2 damage[AG_DRIVER_SW_DAMAGE_MAX]; /* Damaged display region */
+	Uint nDamage;
+	AG_Rect2 rDamage;		/* Damage rect being redrawn */
+	Uint nPixelsDrawn;		/* Pixels repainted in last frame */
 } AG_DriverSw;
 
 #define AGDRIVER_SW(obj) ((AG_DriverSw *)(obj))
@@ -96,6 +106,7 @@ void AG_WM_GetPrefPosition(struct ag_window *, int *, int *, int, int);
 void AG_WM_MoveBegin(struct ag_window *);
 void AG_WM_MoveEnd(struct ag_window *);
 void AG_WM_MouseMotion(AG_DriverSw *, struct ag_window *, int, int);
+void AG_WM_AddDamage(AG_DriverSw *, AG_Rect);
 
 /* Blank the display background. */
 static __inline__ void
@@ -50,18 +50,128 @@
 AG_EditableClipboard agEditableClipbrd;		/* For Copy/Cut/Paste */
 AG_EditableClipboard agEditableKillring;	/* For Emacs-style Kill/Yank */
 
+/* Clear a working buffer. */
+static __inline__ void
+ClearBuffer(AG_EditableBuffer *buf)
+{
+	AG_Free(buf->s);
+	buf->s = NULL;
+	buf->len = 0;
+	buf->maxLen = 0;
+}
+
+/*
+ * Invalidate the layout index of the working buffer. It is rebuilt on the
+ * next draw, and the next commit will export the whole string.
+ */
+static __inline__ void
+InvalidateLines(AG_Editable *ed)
+{
+	ed->nLines = 0;
+	ed->wMax = -1;
+	ed->chgLo = -1;
+	ed->chgHi = -1;
+	ed->lenBound = (size_t)-1;
+}
+
+/*
+ * Return the bound string and the size of its buffer. The variable must
+ * be locked.
+ */
+static char *
+GetBoundString(AG_Editable *ed, AG_EditableBuffer *buf, size_t *size)
+{
+	if (buf->reallocable) {
+		AG_Text *txt = buf->var->data.p;
+		AG_TextEnt *te = &txt->ent[ed->lang];
+
+		if (te->buf == NULL) {
+			*size = 1;
+			return ("");
+		}
+		*size = te->maxLen;
+		return (te->buf);
+	}
+	*size = buf->var->info.size;
+	return (buf->var->data.s);
+}
+
+/* Grow the copy of the bound string to hold len bytes and a NUL. */
+static int
+GrowShadow(AG_Editable *ed, size_t len)
+{
+	char *sNew;
+	size_t maxNew;
+
+	if (len+1 <= ed->maxEnc) {
+		return (0);
+	}
+	maxNew = MAX(len+1, ed->maxEnc*2);
+	if ((sNew = TryRealloc(ed->sEnc, maxNew)) == NULL) {
+		ed->lenEnc = (size_t)-1;
+		return (-1);
+	}
+	ed->sEnc = sNew;
+	ed->maxEnc = maxNew;
+	return (0);
+}
+
+/*
+ * Remember the contents of the bound string, such that the working buffer
+ * can be reused for as long as it remains unchanged (in non-exclusive mode).
+ */
+static void
+SetShadow(AG_Editable *ed, const char *s)
+{
+	size_t len;
+
+	if (ed->flags & AG_EDITABLE_EXCL) {
+		ed->lenEnc = (size_t)-1;
+		return;
+	}
+	len = strlen(s);
+	if (GrowShadow(ed, len) == -1) {
+		return;
+	}
+	memcpy(ed->sEnc, s, len+1);
+	ed->lenEnc = len;
+}
+
 /*
- * Return a new working buffer. The variable is returned locked; the caller
+ * Check whether the bound string still matches the last string imported
+ * or committed. External writes do not go through Agar, so the whole
+ * string is compared; this is still much cheaper than importing it again.
+ */
+static int
+ShadowValid(AG_Editable *ed, const char *s, size_t size)
+{
+	size_t len = ed->lenEnc;
+
+	if (len >= size || s[len] != '\0') {
+		return (0);
+	}
+	return (memcmp(s, ed->sEnc, len) == 0);
+}
+
+/*
+ * Return the working buffer. The variable is returned locked; the caller
  * should invoke ReleaseBuffer() after use.
+ *
+ * The UCS-4 buffer is kept across calls. In exclusive mode, it is imported
+ * only once. Otherwise, it is imported again whenever the bound string no
+ * longer matches the last string imported or committed (see ShadowValid()).
  */
-static __inline__ AG_EditableBuffer *
+static AG_EditableBuffer *
 GetBuffer(AG_Editable *ed)
 {
 	AG_EditableBuffer *buf;
+	AG_Text *txt = NULL;
+	char *s;
+	size_t size;
 
-	if (ed->flags & AG_EDITABLE_EXCL) {
+	if (ed->sBuf.var == NULL) {
 		buf = &ed->sBuf;
-	} else {
+	} else {				/* Nested access (from handler) */
 		if ((buf = TryMalloc(sizeof(AG_EditableBuffer))) == NULL) {
 			return (NULL);
 		}
@@ -70,96 +180,178 @@ GetBuffer(AG_Editable *ed)
 		buf->maxLen = 0;
 	}
 	if (AG_Defined(ed, "text")) {			/* AG_Text element */
-		AG_Text *txt;
-
 		buf->var = AG_GetVariable(ed, "text", &txt);
 		buf->reallocable = 1;
-
 		AG_MutexLock(&txt->lock);
-
-		if ((ed->flags & AG_EDITABLE_EXCL) == 0 ||
-		    buf->s == NULL) {
-			AG_TextEnt *te = &txt->ent[ed->lang];
-
-			if (te->buf != NULL) {
-				buf->s = AG_ImportUnicode("UTF-8", te->buf,
-				    &buf->len, &buf->maxLen);
-			} else {
-				if ((buf->s = TryMalloc(sizeof(Uint32))) != NULL) {
-					buf->s[0] = (Uint32)'\0';
-				}
-				buf->len = 0;
-			}
-			if (buf->s == NULL) {
-				AG_MutexUnlock(&txt->lock);
-				AG_UnlockVariable(buf->var);
-				buf->var = NULL;
-				goto fail;
-			}
-		}
 	} else {					/* Fixed-size buffer */
-		char *s;
-
 		buf->var = AG_GetVariable(ed, "string", &s);
 		buf->reallocable = 0;
+	}
+	s = GetBoundString(ed, buf, &size);
 
-		if ((ed->flags & AG_EDITABLE_EXCL) == 0 ||
-		    buf->s == NULL) {
-			buf->s = AG_ImportUnicode(ed->encoding, s, &buf->len,
-			    &buf->maxLen);
-			if (buf->s == NULL) {
-				AG_UnlockVariable(buf->var);
-				goto fail;
-			}
+	if (buf == &ed->sBuf && buf->s != NULL) {
+		if (ed->flags & AG_EDITABLE_EXCL) {
+			return (buf);
+		}
+		if (ShadowValid(ed, s, size))
+			return (buf);
+	}
+
+	ClearBuffer(buf);
+	buf->s = AG_ImportUnicode(buf->reallocable ? "UTF-8" : ed->encoding,
+	    s, &buf->len, &buf->maxLen);
+	if (buf->s == NULL) {
+		if (txt != NULL) {
+			AG_MutexUnlock(&txt->lock);
 		}
+		AG_UnlockVariable(buf->var);
+		buf->var = NULL;
+		if (buf != &ed->sBuf) { Free(buf); }
+		return (NULL);
+	}
+	if (buf == &ed->sBuf) {
+		InvalidateLines(ed);
+		SetShadow(ed, s);
 	}
 	return (buf);
-fail:
-	if ((ed->flags & AG_EDITABLE_EXCL) == 0) { Free(buf); }
-	return (NULL);
 }
 
-/* Clear a working buffer. */
-static __inline__ void
-ClearBuffer(AG_EditableBuffer *buf)
+/* Export the whole working buffer to the bound string. */
+static int
+CommitAll(AG_Editable *ed, AG_EditableBuffer *buf)
 {
-	AG_Free(buf->s);
-	buf->s = NULL;
-	buf->len = 0;
-	buf->maxLen = 0;
-}
+	char *s;
 
-/* Commit changes to the working buffer. */
-static void
-CommitBuffer(AG_Editable *ed, AG_EditableBuffer *buf)
-{
-	if (AG_Defined(ed, "text")) {			/* AG_Text binding */
+	if (buf->reallocable) {
 		AG_Text *txt = buf->var->data.p;
 		AG_TextEnt *te = &txt->ent[ed->lang];
 		size_t lenEnc;
 
 		if (AG_LengthUTF8FromUCS4(buf->s, &lenEnc) == -1) {
-			goto fail;
+			return (-1);
 		}
-		lenEnc++;
-
-		if (lenEnc > te->maxLen &&
-		    AG_TextRealloc(te, lenEnc) == -1) {
-			goto fail;
+		if (lenEnc+1 > te->maxLen &&
+		    AG_TextRealloc(te, MAX(lenEnc+1, te->maxLen*2)) == -1) {
+			return (-1);
 		}
 		if (AG_ExportUnicode(ed->encoding, te->buf, buf->s,
-		    te->maxLen+1) == -1) {
-			goto fail;
+		    te->maxLen) == -1) {
+			return (-1);
 		}
-	} else {					/* C string binding */
-		if (AG_ExportUnicode(ed->encoding, buf->var->data.s, buf->s,
+		te->len = lenEnc;
+		s = te->buf;
+	} else {
+		s = buf->var->data.s;
+		if (AG_ExportUnicode(ed->encoding, s, buf->s,
 		    buf->var->info.size) == -1)
+			return (-1);
+	}
+	if (buf == &ed->sBuf) {
+		ed->lenBound = strlen(s);
+		SetShadow(ed, s);
+	} else {
+		ed->lenBound = (size_t)-1;	/* Working buffer is stale */
+	}
+	return (0);
+}
+
+/*
+ * Export only the lines modified since the last commit, moving the rest of
+ * the bound string as needed. This requires the layout index to describe
+ * the bound string as it was last committed.
+ *
+ * The bound string is contiguous, so moving its tail (and that of the copy
+ * in sEnc) remains proportional to the text following the edit.
+ */
+static int
+CommitLines(AG_Editable *ed, AG_EditableBuffer *buf)
+{
+	AG_EditableLine *lnLo, *lnHi;
+	size_t lenNew, lenMod, tail, offsHi;
+	char *s, cSave;
+	Uint32 chSave;
+	int rv;
+
+	if (ed->nLines == 0 || ed->chgLo == -1 ||
+	    ed->lenBound == (size_t)-1 ||
+	    (strcmp(ed->encoding, "UTF-8") != 0 &&
+	     strcmp(ed->encoding, "US-ASCII") != 0)) {
+		return (-1);
+	}
+	lnLo = &ed->lines[ed->chgLo];
+	lnHi = &ed->lines[ed->chgHi];
+	lenNew = ed->lines[ed->nLines].offs;
+	lenMod = lnHi->offs - lnLo->offs;
+	tail = lenNew - lnHi->offs;
+	if (tail > ed->lenBound || ed->lenBound - tail < lnLo->offs) {
+		return (-1);
+	}
+	offsHi = ed->lenBound - tail;
+
+	if (buf->reallocable) {
+		AG_Text *txt = buf->var->data.p;
+		AG_TextEnt *te = &txt->ent[ed->lang];
+
+		if (lenNew+1 > te->maxLen &&
+		    AG_TextRealloc(te, MAX(lenNew+1, te->maxLen*2)) == -1) {
+			return (-1);
+		}
+		s = te->buf;
+	} else {
+		if (lenNew+1 > buf->var->info.size) {
+			AG_SetError("%u > %u bytes", (Uint)lenNew+1,
+			    (Uint)buf->var->info.size);
+			return (-1);
+		}
+		s = buf->var->data.s;
+	}
+	memmove(&s[lnHi->offs], &s[offsHi], tail+1);
+
+	/* Encode the modified lines; preserve the characters that follow. */
+	cSave = s[lnHi->offs];
+	chSave = buf->s[lnHi->pos];
+	buf->s[lnHi->pos] = '\0';
+	rv = AG_ExportUnicode(ed->encoding, &s[lnLo->offs], &buf->s[lnLo->pos],
+	    lenMod+1);
+	buf->s[lnHi->pos] = chSave;
+	s[lnHi->offs] = cSave;
+	if (rv == -1) {
+		return (-1);
+	}
+	if (buf->reallocable) {
+		AG_Text *txt = buf->var->data.p;
+		txt->ent[ed->lang].len = lenNew;
+	}
+	if (ed->lenEnc != (size_t)-1 && GrowShadow(ed, lenNew) == 0) {
+		memmove(&ed->sEnc[lnHi->offs], &ed->sEnc[ed->lenEnc - tail],
+		    tail+1);
+		memcpy(&ed->sEnc[lnLo->offs], &s[lnLo->offs], lenMod);
+		ed->lenEnc = lenNew;
+	}
+	ed->lenBound = lenNew;
+	return (0);
+}
+
+/* Commit changes to the working buffer. */
+static void
+CommitBuffer(AG_Editable *ed, AG_EditableBuffer *buf)
+{
+	if (buf != &ed->sBuf || CommitLines(ed, buf) == -1) {
+		if (CommitAll(ed, buf) == -1)
 			goto fail;
 	}
+	if (buf == &ed->sBuf) {
+		ed->chgLo = -1;
+		ed->chgHi = -1;
+	}
 	ed->flags |= AG_EDITABLE_MARKPREF;
 	AG_PostEvent(NULL, ed, "editable-postchg", NULL);
 	return;
 fail:
+	if (buf == &ed->sBuf) {
+		ed->lenEnc = (size_t)-1;	/* Import again if not EXCL */
+		ed->lenBound = (size_t)-1;
+	}
 	Verbose("CommitBuffer: %s; ignoring\n", AG_GetError());
 }
 
@@ -167,7 +359,7 @@ fail:
 static __inline__ void
 ReleaseBuffer(AG_Editable *ed, AG_EditableBuffer *buf)
 {
-	if (AG_Defined(ed, "text")) {
+	if (buf->reallocable) {
 		AG_Text *txt = buf->var->data.p;
 		AG_MutexUnlock(&txt->lock);
 	}
@@ -175,7 +367,7 @@ ReleaseBuffer(AG_Editable *ed, AG_EditableBuffer *buf)
 		AG_UnlockVariable(buf->var);
 		buf->var = NULL;
 	}
-	if (!(ed->flags & AG_EDITABLE_EXCL)) {
+	if (buf != &ed->sBuf) {
 		ClearBuffer(buf);
 		Free(buf);
 	}
@@ -194,6 +386,8 @@ void
 AG_EditableClearBuffer(AG_Editable *ed, AG_EditableBuffer *buf)
 {
 	ClearBuffer(buf);
+	if (buf == &ed->sBuf)
+		InvalidateLines(ed);
 }
 
 /* Increase the working buffer size to accomodate new characters. */
@@ -207,33 +401,39 @@ AG_EditableGrowBuffer(AG_Editable *ed, AG_EditableBuffer *buf, Uint32 *ins,
 
 	ucsSize = (buf->len + nIns + 1)*sizeof(Uint32);
 
-	if (Strcasecmp(ed->encoding, "UTF-8") == 0) {
-		size_t sLen, insLen;
+	if (!buf->reallocable) {		/* AG_Text grows on commit */
+		if (strcmp(ed->encoding, "UTF-8") == 0) {
+			size_t sLen, insLen;
 
-		if (AG_LengthUTF8FromUCS4(buf->s, &sLen) == -1 ||
-		    AG_LengthUTF8FromUCS4(ins, &insLen) == -1) {
-			return (-1);
+			if (buf == &ed->sBuf && ed->nLines > 0 &&
+			    ed->lines[ed->nLines].pos == buf->len) {
+				sLen = ed->lines[ed->nLines].offs;
+			} else if (AG_LengthUTF8FromUCS4(buf->s, &sLen) == -1) {
+				return (-1);
+			}
+			if (AG_LengthUTF8FromUCS4(ins, &insLen) == -1) {
+				return (-1);
+			}
+			convLen = sLen + insLen + 1;
+		} else if (Strcasecmp(ed->encoding, "US-ASCII") == 0) {
+			convLen = buf->len + nIns + 1;
+		} else {
+			/* TODO Proper estimates for other charsets */
+			convLen = ucsSize;
 		}
-		convLen = sLen + insLen + 1;
-	} else if (Strcasecmp(ed->encoding, "US-ASCII") == 0) {
-		convLen = AG_LengthUCS4(buf->s) + nIns + 1;
-	} else {
-		/* TODO Proper estimates for other charsets */
-		convLen = ucsSize;
-	}
-	
-	if (!buf->reallocable) {
 		if (convLen > buf->var->info.size) {
 			AG_SetError("%u > %u bytes", (Uint)convLen, (Uint)buf->var->info.size);
 			return (-1);
 		}
 	}
 	if (ucsSize > buf->maxLen) {
-		if ((sNew = TryRealloc(buf->s, ucsSize)) == NULL) {
+		size_t maxNew = MAX(ucsSize, buf->maxLen*2);
+
+		if ((sNew = TryRealloc(buf->s, maxNew)) == NULL) {
 			return (-1);
 		}
 		buf->s = sNew;
-		buf->maxLen = ucsSize;
+		buf->maxLen = maxNew;
 	}
 	return (0);
 }
@@ -242,6 +442,10 @@ AG_EditableGrowBuffer(AG_Editable *ed, AG_EditableBuffer *buf, Uint32 *ins,
 void
 AG_EditableReleaseBuffer(AG_Editable *ed, AG_EditableBuffer *buf)
 {
+	if (buf == &ed->sBuf && ed->nLines > 0 &&
+	    ed->lines[ed->nLines].pos != buf->len) {
+		InvalidateLines(ed);	/* Modified without notification */
+	}
 	ReleaseBuffer(ed, buf);
 	AG_ObjectUnlock(ed);
 }
@@ -358,6 +562,7 @@ AG_EditableSetExcl(AG_Editable *ed, int enable)
 {
 	AG_ObjectLock(ed);
 	ClearBuffer(&ed->sBuf);
+	InvalidateLines(ed);
 
 	if (enable) {
 		ed->flags |= AG_EDITABLE_EXCL;
@@ -512,7 +717,7 @@ BlinkTimeout(AG_Timer *to, AG_Event *event)
 
 	if ((ed->flags & AG_EDITABLE_CURSOR_MOVING) == 0) {
 		AG_INVFLAGS(ed->flags, AG_EDITABLE_BLINK_ON);
-		AG_Redraw(ed);
+		AG_WidgetRedrawRect(ed, AG_RECT(0, 0, WIDTH(ed), HEIGHT(ed)));
 	}
 	return (to->ival);
 }
@@ -594,181 +799,357 @@ IsSpaceUCS4(Uint32 c)
 	return (0);
 }
 
-/* Evaluate word wrapping at given character. */
+/* Return the width of a character in the layout. */
 static __inline__ int
-WrapAtChar(AG_Editable *ed, int x, Uint32 *s)
+CharWidth(AG_Editable *ed, AG_Driver *drv, Uint32 c)
 {
-	AG_Driver *drv = WIDGET(ed)->drv;
-	AG_Glyph *gl;
-	Uint32 *t;
-	int x2;
+	switch (c) {
+	case '\n':
+		return (0);
+	case '\t':
+		return (agTextTabWidth);
+	}
+	if (ed->flags & AG_EDITABLE_PASSWORD) {
+		c = '*';
+	}
+	return (AG_TextRenderGlyph(drv, c)->advance);
+}
+
+/* Evaluate word wrapping at character i of a line, at x. */
+static int
+WrapAtChar(AG_Editable *ed, AG_Driver *drv, AG_EditableBuffer *buf, size_t i,
+    int x)
+{
+	size_t j;
 
-	if (!(ed->flags & AG_EDITABLE_WORDWRAP) ||
-	    x == 0 || !IsSpaceUCS4(*s)) {
+	if (x == 0 || !IsSpaceUCS4(buf->s[i])) {
 		return (0);
 	}
-	for (t = &s[1], x2 = x;
-	     *t != '\0';
-	     t++) {
-		gl = AG_TextRenderGlyph(drv, *t);
-		x2 += gl->advance;
-		if (IsSpaceUCS4(*t) || *t == '\n') {
-			if (x2 > WIDTH(ed)) {
-				return (1);
-			} else {
-				break;
+	for (j = i+1; j < buf->len; j++) {
+		x += CharWidth(ed, drv, buf->s[j]);
+		if (IsSpaceUCS4(buf->s[j]) || buf->s[j] == '\n')
+			return (x > ed->lineW);
+	}
+	return (0);
+}
+
+/* Append a line to an array of lines. */
+static int
+AddLine(AG_EditableLine **lines, Uint *nLines, Uint *maxLines, size_t pos,
+    Uint offs, int w)
+{
+	AG_EditableLine *linesNew, *ln;
+	Uint maxNew;
+
+	if (*nLines+1 >= *maxLines) {		/* Keep room for sentinel */
+		maxNew = (*maxLines > 0) ? (*maxLines)*2 : 64;
+		if ((linesNew = TryRealloc(*lines,
+		    maxNew*sizeof(AG_EditableLine))) == NULL) {
+			return (-1);
+		}
+		*lines = linesNew;
+		*maxLines = maxNew;
+	}
+	ln = &(*lines)[(*nLines)++];
+	ln->pos = (Uint)pos;
+	ln->offs = offs;
+	ln->w = w;
+	return (0);
+}
+
+/*
+ * Break the paragraphs in [pos,end) of the buffer into visual lines, and
+ * append them to the given array. If last is set, a line is also added for
+ * the characters following the last newline. Returns the byte offset of
+ * end, or -1 if out of memory.
+ */
+static long
+LayoutLines(AG_Editable *ed, AG_Driver *drv, AG_EditableBuffer *buf,
+    size_t pos, size_t end, Uint offs, int last, AG_EditableLine **lines,
+    Uint *nLines, Uint *maxLines)
+{
+	int utf8 = (strcmp(ed->encoding, "UTF-8") == 0);
+	size_t i, lineStart = pos;
+	Uint lineOffs = offs;
+	int x = 0;
+
+	for (i = pos; i < end; i++) {
+		Uint32 c = buf->s[i];
+
+		if (ed->lineW != -1 && WrapAtChar(ed, drv, buf, i, x)) {
+			if (AddLine(lines, nLines, maxLines, lineStart,
+			    lineOffs, x) == -1) {
+				return (-1);
 			}
+			lineStart = i;
+			lineOffs = offs;
+			x = 0;
+		}
+		offs += (utf8 && c >= 0x80) ? AG_CharLengthUTF8FromUCS4(c) : 1;
+		if (c == '\n') {
+			if (AddLine(lines, nLines, maxLines, lineStart,
+			    lineOffs, x) == -1) {
+				return (-1);
+			}
+			lineStart = i+1;
+			lineOffs = offs;
+			x = 0;
+		} else {
+			x += CharWidth(ed, drv, c);
 		}
 	}
+	if (last &&
+	    AddLine(lines, nLines, maxLines, lineStart, lineOffs, x) == -1) {
+		return (-1);
+	}
+	return ((long)offs);
+}
+
+/* Evaluate whether the layout index matches the widget settings. */
+static __inline__ int
+LinesValid(AG_Editable *ed)
+{
+	return (ed->nLines > 0 &&
+	        ed->lineFont == WIDGET(ed)->font &&
+	        ed->lineW == ((ed->flags & AG_EDITABLE_WORDWRAP) ?
+	                      WIDTH(ed) : -1) &&
+	        ed->lineFlags == (ed->flags & AG_EDITABLE_PASSWORD));
+}
+
+/* Rebuild the layout index of the working buffer if needed. */
+static int
+UpdateLines(AG_Editable *ed, AG_EditableBuffer *buf)
+{
+	AG_Driver *drv = WIDGET(ed)->drv;
+	AG_EditableLine *ln;
+	long offs;
+
+	if (LinesValid(ed) && ed->lines[ed->nLines].pos == buf->len) {
+		return (0);
+	}
+	if (drv == NULL) {
+		AG_SetError("Editable is not attached");
+		return (-1);
+	}
+	if (ed->chgLo != -1) {
+		ed->lenBound = (size_t)-1;	/* Uncommitted changes */
+	}
+	ed->nLines = 0;
+	ed->wMax = -1;
+	ed->chgLo = -1;
+	ed->chgHi = -1;
+	ed->lineFont = WIDGET(ed)->font;
+	ed->lineW = (ed->flags & AG_EDITABLE_WORDWRAP) ? WIDTH(ed) : -1;
+	ed->lineFlags = (ed->flags & AG_EDITABLE_PASSWORD);
+
+	AG_PushTextState();
+	AG_TextFont(WIDGET(ed)->font);
+	offs = LayoutLines(ed, drv, buf, 0, buf->len, 0, 1,
+	    &ed->lines, &ed->nLines, &ed->maxLines);
+	AG_PopTextState();
+	if (offs == -1) {
+		ed->nLines = 0;
+		return (-1);
+	}
+	ln = &ed->lines[ed->nLines];			/* Sentinel */
+	ln->pos = (Uint)buf->len;
+	ln->offs = (Uint)offs;
+	ln->w = 0;
 	return (0);
 }
 
+/* Return the index of the line containing character pos. */
+static Uint
+FindLine(AG_Editable *ed, size_t pos)
+{
+	Uint lo = 0, hi = ed->nLines-1, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo + 1)/2;
+		if (ed->lines[mid].pos <= pos) {
+			lo = mid;
+		} else {
+			hi = mid-1;
+		}
+	}
+	return (lo);
+}
+
+/*
+ * Return the line and x coordinate of the cursor at character pos.
+ * At a word wrap, the cursor is at the end of the preceding line.
+ */
+static int
+LocateChar(AG_Editable *ed, AG_EditableBuffer *buf, size_t pos, int *x)
+{
+	AG_Driver *drv = WIDGET(ed)->drv;
+	Uint ln = FindLine(ed, pos);
+	size_t i;
+
+	if (ln > 0 && pos == ed->lines[ln].pos && buf->s[pos-1] != '\n') {
+		ln--;
+	}
+	*x = 0;
+	for (i = ed->lines[ln].pos; i < pos; i++) {
+		*x += CharWidth(ed, drv, buf->s[i]);
+	}
+	return ((int)ln);
+}
+
+/*
+ * Update the layout index after nDel characters at pos in the working
+ * buffer have been replaced by nIns characters. Only the paragraphs
+ * affected by the change are laid out again.
+ */
+void
+AG_EditableBufferChanged(AG_Editable *ed, AG_EditableBuffer *buf, size_t pos,
+    size_t nDel, size_t nIns)
+{
+	AG_Driver *drv = WIDGET(ed)->drv;
+	AG_EditableLine *lnNew = NULL, *ln;
+	Uint nNew = 0, maxNew = 0, nOld, a, b, i;
+	Uint endOld, endNew, offsEnd, dPos, dOffs;
+	long offs;
+
+	AG_ObjectLock(ed);
+	if (buf != &ed->sBuf || !LinesValid(ed) ||
+	    pos+nDel > ed->lines[ed->nLines].pos ||
+	    ed->lines[ed->nLines].pos - nDel + nIns != buf->len ||
+	    drv == NULL)
+		goto invalidate;
+	
+	/* Extend the change to whole paragraphs. */
+	a = FindLine(ed, pos);
+	while (a > 0 && buf->s[ed->lines[a].pos - 1] != '\n') {
+		a--;
+	}
+	for (b = FindLine(ed, pos+nDel); b < ed->nLines-1; b++) {
+		if (buf->s[ed->lines[b+1].pos - 1 - nDel + nIns] == '\n')
+			break;
+	}
+	b++;
+	endOld = ed->lines[b].pos;
+	endNew = endOld - (Uint)nDel + (Uint)nIns;
+
+	AG_PushTextState();
+	AG_TextFont(WIDGET(ed)->font);
+	offs = LayoutLines(ed, drv, buf, ed->lines[a].pos, endNew,
+	    ed->lines[a].offs, (b == ed->nLines), &lnNew, &nNew, &maxNew);
+	AG_PopTextState();
+	if (offs == -1) {
+		goto invalidate;
+	}
+	offsEnd = (Uint)offs;
+
+	/* Replace lines [a,b) with the new lines. */
+	nOld = b - a;
+	if (ed->nLines - nOld + nNew + 1 > ed->maxLines) {
+		Uint maxLinesNew = MAX(ed->nLines - nOld + nNew + 1,
+		                       ed->maxLines*2);
+
+		if ((ln = TryRealloc(ed->lines,
+		    maxLinesNew*sizeof(AG_EditableLine))) == NULL) {
+			goto invalidate;
+		}
+		ed->lines = ln;
+		ed->maxLines = maxLinesNew;
+	}
+	dPos = endNew - endOld;				/* Modulo 2^n */
+	dOffs = offsEnd - ed->lines[b].offs;
+	for (i = a; i < b && ed->wMax != -1; i++) {
+		if (ed->lines[i].w >= ed->wMax)
+			ed->wMax = -1;		/* Widest line replaced */
+	}
+	for (i = 0; i < nNew && ed->wMax != -1; i++) {
+		ed->wMax = MAX(ed->wMax, lnNew[i].w);
+	}
+	memmove(&ed->lines[a+nNew], &ed->lines[b],
+	    (ed->nLines - b + 1)*sizeof(AG_EditableLine));
+	memcpy(&ed->lines[a], lnNew, nNew*sizeof(AG_EditableLine));
+	ed->nLines = ed->nLines - nOld + nNew;
+
+	/* Renumber the following lines (proportional to their count). */
+	for (i = a+nNew; i <= ed->nLines; i++) {
+		ed->lines[i].pos += dPos;
+		ed->lines[i].offs += dOffs;
+	}
+
+	/* Extend the range of lines to commit. */
+	if (ed->chgLo == -1) {
+		ed->chgLo = (int)a;
+		ed->chgHi = (int)(a+nNew);
+	} else {
+		ed->chgLo = MIN(ed->chgLo, (int)a);
+		ed->chgHi = (ed->chgHi >= (int)b) ?
+		            ed->chgHi - (int)nOld + (int)nNew :
+			    (int)(a+nNew);
+	}
+	Free(lnNew);
+	AG_ObjectUnlock(ed);
+	return;
+invalidate:
+	Free(lnNew);
+	if (buf == &ed->sBuf) {
+		InvalidateLines(ed);
+	} else {
+		ed->lenBound = (size_t)-1;
+	}
+	AG_ObjectUnlock(ed);
+}
+
 /*
  * Map mouse coordinates to a position within the buffer.
  */
-#define ON_LINE(my,y)       ((my) >= (y) && (my) <= (y)+ed->lineSkip)
-#define ON_CHAR(mx,x,glyph) ((mx) >= (x) && (mx) <= (x)+(glyph)->advance)
 int
 AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
     int *pos)
 {
 	AG_Driver *drv = WIDGET(ed)->drv;
-	AG_Font *font = WIDGET(ed)->font;
-	Uint32 ch;
-	int i, x, y, line = 0;
-	int nLines = 1;
-	int yMouse;
+	AG_EditableLine *ln;
+	Uint32 c;
+	Uint i, line;
+	int x, w, yMouse, rv = 0;
 	
 	AG_ObjectLock(ed);
+	AG_PushTextState();
+	AG_TextFont(WIDGET(ed)->font);
 
 	yMouse = my + ed->y*ed->lineSkip;
 	if (yMouse < 0) {
 		*pos = 0;
 		goto out;
 	}
-
-	x = 0;
-	y = 0;
- 	for (i = 0; i < buf->len; i++) {
-		Uint32 ch = buf->s[i];
-
-		if (WrapAtChar(ed, x, &buf->s[i])) {
-			x = 0;
-			nLines++;
-		}
-		if (ch == '\n') {
-			x = 0;
-			nLines++;
-		} else if (ch == '\t') {
-			x += agTextTabWidth;
-		} else {
-			switch (font->spec.type) {
-#ifdef HAVE_FREETYPE
-			case AG_FONT_VECTOR:
-				{
-					AG_TTFFont *ttf = font->ttf;
-					AG_TTFGlyph *glyph;
-
-					if (AG_TTFFindGlyph(ttf, ch,
-					    TTF_CACHED_METRICS|TTF_CACHED_BITMAP) != 0) {
-						continue;
-					}
-					glyph = ttf->current;
-					x += glyph->advance;
-				}
-				break;
-#endif /* HAVE_FREETYPE */
-			case AG_FONT_BITMAP:
-				{
-					AG_Glyph *gl;
-			
-					gl = AG_TextRenderGlyph(drv, ch);
-					x += gl->su->w;
-				}
-				break;
-			}
-		}
+	if (UpdateLines(ed, buf) == -1) {
+		rv = -1;
+		goto out;
 	}
-
-	x = 0;
-	for (i = 0; i < buf->len; i++) {
-		ch = buf->s[i];
-		if (mx <= 0 && ON_LINE(yMouse,y)) {
-			*pos = i;
+	if ((line = (Uint)(yMouse / ed->lineSkip)) >= ed->nLines) {
+		*pos = (int)buf->len;
+		goto out;
+	}
+	ln = &ed->lines[line];
+	if (mx <= 0) {
+		*pos = (int)ln->pos;
+		goto out;
+	}
+	for (i = ln->pos, x = 0; i < ln[1].pos; i++) {
+		if ((c = buf->s[i]) == '\n') {
+			*pos = (int)i;
 			goto out;
 		}
-		if (WrapAtChar(ed, x, &buf->s[i])) {
-			if (ON_LINE(yMouse,y) && mx > x) {
-				*pos = i;
-				goto out;
-			}
-			y += ed->lineSkip;
-			x = 0;
-			line++;
-		}
-		if (ch == '\n') {
-			if (ON_LINE(yMouse,y) && mx > x) {
-				*pos = i;
-				goto out;
-			}
-			y += ed->lineSkip;
-			x = 0;
-			line++;
-			continue;
-		} else if (ch == '\t') {
-			if (ON_LINE(yMouse,y) &&
-			    mx >= x && mx <= x+agTextTabWidth) {
-				*pos = (mx < x + agTextTabWidth/2) ? i : i+1;
-				goto out;
-			}
-			x += agTextTabWidth;
-			continue;
-		}
-		
-		switch (font->spec.type) {
-#ifdef HAVE_FREETYPE
-		case AG_FONT_VECTOR:
-			{
-				AG_TTFFont *ttf = font->ttf;
-				AG_TTFGlyph *glyph;
-
-				if (AG_TTFFindGlyph(ttf, ch,
-				    TTF_CACHED_METRICS|TTF_CACHED_BITMAP) != 0) {
-					continue;
-				}
-				glyph = ttf->current;
-
-				if (ON_LINE(yMouse,y) && ON_CHAR(mx,x,glyph)) {
-					*pos = (mx < x+glyph->advance/2) ? i : i+1;
-					goto out;
-				}
-				x += glyph->advance;
-			}
-			break;
-#endif /* HAVE_FREETYPE */
-		case AG_FONT_BITMAP:
-			{
-				AG_Glyph *gl;
-			
-				gl = AG_TextRenderGlyph(drv, ch);
-				if (ON_LINE(yMouse,y) && mx >= x && mx <= x+gl->su->w) {
-					*pos = i;
-					goto out;
-				}
-				x += gl->su->w;
-			}
-			break;
-		default:
-			AG_FatalError("AG_Editable: Unknown font format");
+		w = CharWidth(ed, drv, c);
+		if (mx >= x && mx <= x+w) {
+			*pos = (mx < x + w/2) ? (int)i : (int)i+1;
+			goto out;
 		}
+		x += w;
 	}
-	*pos = buf->len;
+	*pos = (int)ln[1].pos;		/* Word wrap or end of text */
 out:
+	AG_PopTextState();
 	AG_ObjectUnlock(ed);
-	return (0);
+	return (rv);
 }
-#undef ON_LINE
-#undef ON_CHAR
 
 /* Move cursor to the given position in pixels. */
 void
@@ -842,13 +1223,18 @@ Draw(void *obj)
 	AG_Driver *drv = WIDGET(ed)->drv;
 	AG_DriverClass *drvOps = WIDGET(ed)->drvOps;
 	AG_EditableBuffer *buf;
+	AG_EditableLine *ln;
 	AG_Rect2 rClip;
-	int i, dx, dy, x, y;
-	int inSel = 0;
+	Uint i, l, lEnd, selStart, selEnd;
+	int dx, dy, x, y;
 
 	if ((buf = GetBuffer(ed)) == NULL) {
 		return;
 	}
+	if (UpdateLines(ed, buf) == -1) {
+		ReleaseBuffer(ed, buf);
+		return;
+	}
 	AG_EditableValidateSelection(ed, buf);
 	
 	rClip = WIDGET(ed)->rView;
@@ -857,94 +1243,87 @@ Draw(void *obj)
 	rClip.x2 += ed->fontMaxHeight*2;
 	rClip.y2 += ed->lineSkip;
 
+	if (ed->wMax == -1) {
+		/* Only after a layout or once the widest line has shrunk. */
+		for (l = 0, ed->wMax = 0; l < ed->nLines; l++)
+			ed->wMax = MAX(ed->wMax, ed->lines[l].w);
+	}
+	ed->xMax = (ed->nLines > 1) ? ed->wMax+10 : ed->wMax;
+	ed->yMax = (int)ed->nLines;
+
+	/* Locate the cursor and the selection. */
+	ed->yCurs = LocateChar(ed, buf, ed->pos, &ed->xCurs);
+	if (ed->flags & AG_EDITABLE_MARKPREF) {
+		ed->flags &= ~(AG_EDITABLE_MARKPREF);
+		ed->xCursPref = ed->xCurs;
+	}
+	if (ed->sel != 0) {
+		selStart = (Uint)MIN(ed->pos, ed->pos + ed->sel);
+		selEnd = (Uint)MAX(ed->pos, ed->pos + ed->sel);
+		ed->ySelStart = LocateChar(ed, buf, selStart, &ed->xSelStart);
+		ed->ySelEnd = LocateChar(ed, buf, selEnd, &ed->xSelEnd);
+	} else {
+		selStart = 0;
+		selEnd = 0;
+	}
+
 	AG_PushBlendingMode(ed, AG_ALPHA_SRC, AG_ALPHA_ONE_MINUS_SRC);
 	AG_PushClipRect(ed, ed->r);
 
-	x = 0;
-	y = -ed->y * ed->lineSkip;
-	ed->xMax = 10;
-	ed->yMax = 1;
-	for (i = 0; i <= buf->len; i++) {
-		AG_Glyph *gl;
-		Uint32 c = buf->s[i];
+	if (ed->sel == 0 &&
+	    (ed->flags & AG_EDITABLE_BLINK_ON) &&
+	    (ed->y >= 0 && ed->y <= ed->yMax-1) &&
+	    AG_WidgetIsFocused(ed)) {
+		y = (ed->yCurs - ed->y)*ed->lineSkip;
+		AG_DrawLineV(ed,
+		    ed->xCurs - ed->x, (y + 1),
+		    (y + ed->lineSkip - 1),
+		    WCOLOR(ed,TEXT_COLOR));
+	}
+
+	/* Draw only the visible lines. */
+	l = (ed->y > 0) ? (Uint)(ed->y - 1) : 0;
+	lEnd = (Uint)MAX(0, ed->y + ed->yVis + 2);
+	for (; l < ed->nLines && l < lEnd; l++) {
+		ln = &ed->lines[l];
+		y = ((int)l - ed->y)*ed->lineSkip;
+		dy = WIDGET(ed)->rView.y1 + y;
+		for (i = ln->pos, x = 0; i < ln[1].pos; i++) {
+			AG_Glyph *gl;
+			Uint32 c = buf->s[i];
+			int inSel = (i >= selStart && i < selEnd);
 
-		if (i == ed->pos) {			/* At cursor */
-			if (ed->sel == 0 &&
-			    (ed->flags & AG_EDITABLE_BLINK_ON) &&
-			    (ed->y >= 0 && ed->y <= ed->yMax-1) &&
-			    AG_WidgetIsFocused(ed)) {
-				AG_DrawLineV(ed,
-				    x - ed->x, (y + 1),
-				    (y + ed->lineSkip - 1),
-				    WCOLOR(ed,TEXT_COLOR));
-			}
-			ed->xCurs = x;
-			if (ed->flags & AG_EDITABLE_MARKPREF) {
-				ed->flags &= ~(AG_EDITABLE_MARKPREF);
-				ed->xCursPref = x;
+			if (c == '\n') {
+				break;
+			} else if (c == '\t') {
+				if (inSel) {
+					AG_DrawRectFilled(ed,
+					    AG_RECT(x - ed->x, y,
+					            agTextTabWidth+1,
+						    ed->lineSkip+1),
+					    WCOLOR_SEL(ed,0));
+				}
+				x += agTextTabWidth;
+				continue;
 			}
-			ed->yCurs = y/ed->lineSkip + ed->y;
-		}
-		if ((ed->sel > 0 && i >= ed->pos && i < ed->pos + ed->sel) ||
-		    (ed->sel < 0 && i <  ed->pos && i > ed->pos + ed->sel - 1)) {
-			if (!inSel) {
-				inSel = 1;
-				ed->xSelStart = x;
-				ed->ySelStart = y/ed->lineSkip + ed->y;
+			dx = WIDGET(ed)->rView.x1 + x - ed->x;
+			if (dx > rClip.x2) {
+				break;				/* Clipped */
 			}
-		} else {
-			if (inSel) {
-				inSel = 0;
-				ed->xSelEnd = x;
-				ed->ySelEnd = y/ed->lineSkip + ed->y;
-			}
-		}
-		if (i == buf->len)
-			break;
-
-		if (WrapAtChar(ed, x, &buf->s[i])) {
-			y += ed->lineSkip;
-			ed->xMax = MAX(ed->xMax, x);
-			ed->yMax++;
-			x = 0;
-		}
-		if (c == '\n') {
-			y += ed->lineSkip;
-			ed->xMax = MAX(ed->xMax, x+10);
-			ed->yMax++;
-			x = 0;
-			continue;
-		} else if (c == '\t') {
-			if (inSel) {
-				AG_DrawRectFilled(ed,
-				    AG_RECT(x - ed->x, y,
-				            agTextTabWidth+1,
-					    ed->lineSkip+1),
-				    WCOLOR_SEL(ed,0));
+			c = (ed->flags & AG_EDITABLE_PASSWORD) ? '*' : c;
+			gl = AG_TextRenderGlyph(drv, c);
+			if (AG_RectInside2(&rClip, dx, dy)) {
+				if (inSel) {
+					AG_DrawRectFilled(ed,
+					    AG_RECT(x - ed->x, y,
+					            gl->su->w + 1, gl->su->h),
+					    WCOLOR_SEL(ed,0));
+				}
+				drvOps->drawGlyph(drv, gl, dx,dy);
 			}
-			x += agTextTabWidth;
-			continue;
-		}
-
-		c = (ed->flags & AG_EDITABLE_PASSWORD) ? '*' : c;
-		gl = AG_TextRenderGlyph(drv, c);
-		dx = WIDGET(ed)->rView.x1 + x - ed->x;
-		dy = WIDGET(ed)->rView.y1 + y;
-
-		if (!AG_RectInside2(&rClip, dx, dy)) {
 			x += gl->advance;
-			continue;
-		}
-		if (inSel) {
-			AG_DrawRectFilled(ed,
-			    AG_RECT(x - ed->x, y, gl->su->w + 1, gl->su->h),
-			    WCOLOR_SEL(ed,0));
 		}
-		drvOps->drawGlyph(drv, gl, dx,dy);
-		x += gl->advance;
 	}
-	if (ed->yMax == 1)
-		ed->xMax = x;
 	
 	/* Process any scrolling requests. */
 	if (ed->flags & AG_EDITABLE_KEEPVISCURSOR) {
@@ -1244,6 +1623,7 @@ AG_EditablePaste(AG_Editable *ed, AG_EditableBuffer *buf,
 	memcpy(&buf->s[ed->pos], cb->s, cb->len*sizeof(Uint32));
 	buf->len += cb->len;
 	buf->s[buf->len] = '\0';
+	AG_EditableBufferChanged(ed, buf, ed->pos, 0, cb->len);
 	ed->pos += cb->len;
 	ed->xScrollTo = &ed->xCurs;
 	ed->yScrollTo = &ed->yCurs;
@@ -1272,6 +1652,7 @@ AG_EditableDelete(AG_Editable *ed, AG_EditableBuffer *buf)
 		    (buf->len - ed->sel + 1 - ed->pos)*sizeof(Uint32));
 	}
 	buf->len -= ed->sel;
+	AG_EditableBufferChanged(ed, buf, ed->pos, ed->sel, 0);
 	ed->sel = 0;
 	ed->xScrollTo = &ed->xCurs;
 	ed->yScrollTo = &ed->yCurs;
@@ -1620,6 +2001,9 @@ AG_EditableSetString(AG_Editable *ed, const char *text)
 		}
 	}
 	ed->sel = 0;
+	if (buf == &ed->sBuf) {
+		InvalidateLines(ed);
+	}
 	CommitBuffer(ed, buf);
 	ReleaseBuffer(ed, buf);
 out:
@@ -1672,6 +2056,9 @@ AG_EditablePrintf(void *obj, const char *fmt, ...)
 		buf->len = 0;
 	}
 	ed->sel = 0;
+	if (buf == &ed->sBuf) {
+		InvalidateLines(ed);
+	}
 	CommitBuffer(ed, buf);
 	ReleaseBuffer(ed, buf);
 out:
@@ -1792,6 +2179,10 @@ OnBindingChange(AG_Event *event)
 	} else if (strcmp(binding->name, "text") == 0) {
 		AG_Unset(ed, "string");
 	}
+	if (ed->sBuf.var == NULL) {			/* Import again */
+		ClearBuffer(&ed->sBuf);
+		InvalidateLines(ed);
+	}
 }
 
 static void
@@ -1844,6 +2235,19 @@ Init(void *obj)
 	ed->sBuf.len = 0;
 	ed->sBuf.maxLen = 0;
 	ed->sBuf.reallocable = 0;
+	ed->sEnc = NULL;
+	ed->lenEnc = (size_t)-1;
+	ed->maxEnc = 0;
+	ed->lenBound = (size_t)-1;
+	ed->lines = NULL;
+	ed->nLines = 0;
+	ed->wMax = -1;
+	ed->maxLines = 0;
+	ed->chgLo = -1;
+	ed->chgHi = -1;
+	ed->lineFont = NULL;
+	ed->lineW = -1;
+	ed->lineFlags = 0;
 
 	AG_InitTimer(&ed->toRepeat, "repeat", 0);
 	AG_InitTimer(&ed->toCursorBlink, "cursorBlink", 0);
@@ -1886,8 +2290,9 @@ Destroy(void *obj)
 	if (ed->pm != NULL) {
 		AG_PopupDestroy(ed->pm);
 	}
-	if (ed->flags & AG_EDITABLE_EXCL)
-		Free(ed->sBuf.s);
+	Free(ed->sBuf.s);
+	Free(ed->sEnc);
+	Free(ed->lines);
 
 	AG_TextFree(ed->text);
 }
@@ -19,6 +19,13 @@ typedef struct ag_editable_buffer {
 	int reallocable;		/* Buffer can be realloc'd */
 } AG_EditableBuffer;
 
+/* Visual line in the layout index */
+typedef struct ag_editable_line {
+	Uint pos;			/* Offset of first character */
+	Uint offs;			/* Offset of first byte (encoded) */
+	int w;				/* Width (px) */
+} AG_EditableLine;
+
 /* Internal clipboard for copy/paste and kill/yank */
 typedef struct ag_editable_clipboard {
 	AG_Mutex lock;
@@ -70,7 +77,17 @@ typedef struct ag_editable {
 	int yMax;			/* Lowest y (lines) */
 	int yVis;			/* Maximum visible area (lines) */
 	Uint32 wheelTicks;		/* For wheel acceleration */
-	AG_EditableBuffer sBuf;		/* Working buffer (for STATIC) */
+	AG_EditableBuffer sBuf;		/* Working buffer */
+	char *sEnc;			/* Text last imported or committed */
+	size_t lenEnc, maxEnc;		/* Length of sEnc (bytes) or -1 */
+	size_t lenBound;		/* Length of bound string or -1 */
+	AG_EditableLine *lines;		/* Layout index (+ end sentinel) */
+	Uint nLines, maxLines;
+	int wMax;			/* Width of widest line (or -1) */
+	int chgLo, chgHi;		/* Uncommitted lines (or -1) */
+	AG_Font *lineFont;		/* Font of layout index */
+	int lineW;			/* Wrap width of layout index */
+	Uint lineFlags;			/* Flags of layout index */
 	AG_Rect r;			/* View area */
 	AG_CursorArea *ca;		/* Text cursor-change area */
 	int fontMaxHeight;		/* Maximum character height */
@@ -106,6 +123,8 @@ void               AG_EditableReleaseBuffer(AG_Editable *, AG_EditableBuffer *);
 void               AG_EditableClearBuffer(AG_Editable *, AG_EditableBuffer *);
 int                AG_EditableGrowBuffer(AG_Editable *, AG_EditableBuffer *,
                                          Uint32 *, size_t);
+void               AG_EditableBufferChanged(AG_Editable *, AG_EditableBuffer *,
+                                            size_t, size_t, size_t);
 
 int  AG_EditableCut(AG_Editable *, AG_EditableBuffer *, AG_EditableClipboard *);
 int  AG_EditableCopy(AG_Editable *, AG_EditableBuffer *, AG_EditableClipboard *);
@@ -29,8 +29,7 @@
 #include <agar/gui/primitive.h>
 
 enum {
-	NITEMS_INIT =	32,
-	NITEMS_GROW =	16
+	NITEMS_INIT =	32
 };
 
 static void KeyDown(AG_Event *);
@@ -67,6 +66,7 @@ Init(void *obj)
 	fpl->xoffs = 0;
 	fpl->yOrigin = 50;
 	fpl->yrange = 100;
+	fpl->xScale = 0;
 	TAILQ_INIT(&fpl->items);
 
 	AG_SetEvent(fpl, "mouse-motion", MouseMotion, NULL);
@@ -84,6 +84,20 @@ AG_FixedPlotterSetRange(AG_FixedPlotter *fpl, AG_FixedPlotterValue range)
 	AG_Redraw(fpl);
 }
 
+/*
+ * Set the number of values plotted per pixel column. Each column is drawn
+ * as a line between the minimum and maximum of its values. If 0, every
+ * value is plotted, 2 pixels apart.
+ */
+void
+AG_FixedPlotterSetScale(AG_FixedPlotter *fpl, Uint32 scale)
+{
+	AG_ObjectLock(fpl);
+	fpl->xScale = scale;
+	AG_ObjectUnlock(fpl);
+	AG_Redraw(fpl);
+}
+
 static void
 KeyDown(AG_Event *event)
 {
@@ -168,6 +182,70 @@ SizeAllocate(void *obj, const AG_SizeAlloc *a)
 	return (a->w > 2 && a->h > 4) ? 0 : -1;
 }
 
+/* Compute the minimum, maximum and last of values [i, i+n). */
+static void
+GetRange(const AG_FixedPlotterItem *gi, Uint32 i, Uint32 n,
+    int *vMin, int *vMax, int *vLast)
+{
+	const AG_FixedPlotterValue *v, *vEnd;
+	Uint32 j, nSeg;
+	int min = *vMin, max = *vMax, last = *vLast;
+
+	j = (gi->first + i) % gi->maxvals;
+	while (n > 0) {
+		nSeg = MIN(n, gi->maxvals - j);
+		for (v = &gi->vals[j], vEnd = v+nSeg; v < vEnd; v++) {
+			if (*v < min) { min = *v; }
+			if (*v > max) { max = *v; }
+		}
+		last = vEnd[-1];
+		n -= nSeg;
+		j = 0;
+	}
+	*vMin = min;
+	*vMax = max;
+	*vLast = last;
+}
+
+/*
+ * Draw a curve with xScale values per pixel column, so that the number of
+ * primitives is bounded by the widget width.
+ */
+static void
+DrawDecimated(AG_FixedPlotter *fpl, AG_FixedPlotterItem *gi, int yOrigin)
+{
+	int h = HEIGHT(fpl);
+	int x, y1, y2, yLast = -1, vMin, vMax, vLast = 0;
+	Uint32 i, n;
+
+	for (x = 0, i = fpl->xoffs;
+	     x < WIDTH(fpl) && i < gi->nvals;
+	     x++, i += n) {
+		n = MIN(fpl->xScale, gi->nvals - i);
+		vMin = AG_INT_MAX;
+		vMax = AG_INT_MIN;
+		GetRange(gi, i, n, &vMin, &vMax, &vLast);
+
+		y1 = yOrigin - vMax*h/fpl->yrange;
+		y2 = yOrigin - vMin*h/fpl->yrange;
+		if (fpl->type == AG_FIXED_PLOTTER_LINES && yLast != -1) {
+			if (yLast < y1) { y1 = yLast; }
+			if (yLast > y2) { y2 = yLast; }
+		}
+		if (y1 < 0) { y1 = 0; }
+		if (y2 < 0) { y2 = 0; }
+		if (y1 > h) { y1 = h; }
+		if (y2 > h) { y2 = h; }
+
+		if (y1 == y2) {
+			AG_PutPixel(fpl, x, y1, gi->color);
+		} else {
+			AG_DrawLineV(fpl, x, y1, y2, gi->color);
+		}
+		yLast = yOrigin - vLast*h/fpl->yrange;
+	}
+}
+
 static void
 Draw(void *obj)
 {
@@ -190,15 +268,20 @@ Draw(void *obj)
 		if (fpl->xoffs > gi->nvals || fpl->xoffs < 0)
 			continue;
 
+		if (fpl->xScale > 0) {
+			DrawDecimated(fpl, gi, yOrigin);
+			continue;
+		}
 		for (x = 2, ox = 0, i = fpl->xoffs;
 		     ++i < gi->nvals && x < WIDGET(fpl)->w;
 		     ox = x, x += 2) {
 
-			oval = gi->vals[i] * WIDGET(fpl)->h / fpl->yrange;
+			oval = AG_FixedPlotterGetValue(gi, i) * WIDGET(fpl)->h /
+			       fpl->yrange;
 			y = yOrigin - oval;
 			if (i > 1) {
-				oval = gi->vals[i-1] * WIDGET(fpl)->h /
-				       fpl->yrange;
+				oval = AG_FixedPlotterGetValue(gi, i-1) *
+				       WIDGET(fpl)->h / fpl->yrange;
 				oy = yOrigin - oval;
 			} else {
 				oy = yOrigin;
@@ -230,11 +313,17 @@ AG_FixedPlotterCurve(AG_FixedPlotter *fpl, const char *name,
  	gi = Malloc(sizeof(AG_FixedPlotterItem));
 	Strlcpy(gi->name, name, sizeof(gi->name));
 	gi->color = AG_ColorRGB(r,g,b);
-	gi->vals = Malloc(NITEMS_INIT*sizeof(AG_FixedPlotterValue));
-	gi->maxvals = NITEMS_INIT;
+	/* As with the former linear buffer, at most limit-1 values are kept. */
+	if (limit == 0) {
+		gi->limit = 0xffffffff-2;
+	} else {
+		gi->limit = (limit > 1) ? limit-1 : 1;
+	}
+	gi->maxvals = MIN(NITEMS_INIT, gi->limit);
+	gi->vals = Malloc(gi->maxvals*sizeof(AG_FixedPlotterValue));
 	gi->nvals = 0;
+	gi->first = 0;
 	gi->fpl = fpl;
-	gi->limit = limit>0 ? limit : (0xffffffff-1);
 
 	AG_ObjectLock(fpl);
 	TAILQ_INSERT_HEAD(&fpl->items, gi, items);
@@ -244,29 +333,76 @@ AG_FixedPlotterCurve(AG_FixedPlotter *fpl, const char *name,
 	return (gi);
 }
 
+/* Reallocate the value array, moving the first value to index 0. */
+static void
+GrowValues(AG_FixedPlotterItem *gi, Uint32 maxNew)
+{
+	AG_FixedPlotterValue *valsNew;
+	Uint32 n1 = MIN(gi->nvals, gi->maxvals - gi->first);
+
+	valsNew = Malloc(maxNew*sizeof(AG_FixedPlotterValue));
+	memcpy(valsNew, &gi->vals[gi->first],
+	    n1*sizeof(AG_FixedPlotterValue));
+	memcpy(&valsNew[n1], gi->vals,
+	    (gi->nvals - n1)*sizeof(AG_FixedPlotterValue));
+	Free(gi->vals);
+	gi->vals = valsNew;
+	gi->maxvals = maxNew;
+	gi->first = 0;
+}
+
+/*
+ * Append n values to a curve. Once the curve limit is reached, the oldest
+ * values are overwritten.
+ */
 void
-AG_FixedPlotterDatum(AG_FixedPlotterItem *gi, AG_FixedPlotterValue val)
+AG_FixedPlotterData(AG_FixedPlotterItem *gi, const AG_FixedPlotterValue *vals,
+    Uint32 n)
 {
-	AG_ObjectLock(gi->fpl);
-	
-	gi->vals[gi->nvals] = val;
+	AG_FixedPlotter *fpl = gi->fpl;
+	Uint32 maxNew, nvalsNew, i, nCopy;
+	int full;
 
-	if (gi->nvals+1 >= gi->limit) {
-		memmove(gi->vals, gi->vals+1,
-		        gi->nvals*sizeof(AG_FixedPlotterValue));
-		gi->fpl->flags &= ~(AG_FIXED_PLOTTER_SCROLL);
-	} else {
-		if (gi->nvals+1 >= gi->maxvals) {
-			gi->vals = Realloc(gi->vals,
-			    (gi->maxvals+NITEMS_GROW) *
-			    sizeof(AG_FixedPlotterValue));
-			gi->maxvals += NITEMS_GROW;
-		}
-		gi->nvals++;
+	if (n > gi->limit) {
+		vals += n - gi->limit;
+		n = gi->limit;
 	}
-	
-	AG_ObjectUnlock(gi->fpl);
-	AG_Redraw(gi->fpl);
+	AG_ObjectLock(fpl);
+
+	if (n > gi->maxvals - gi->nvals && gi->maxvals < gi->limit) {
+		for (maxNew = gi->maxvals;
+		     maxNew < gi->limit && n > maxNew - gi->nvals;
+		     maxNew = (maxNew > gi->limit/2) ? gi->limit : maxNew*2)
+			;
+		GrowValues(gi, maxNew);
+	}
+	if (n > gi->maxvals - gi->nvals) {
+		fpl->flags &= ~(AG_FIXED_PLOTTER_SCROLL);
+	}
+	full = (n >= gi->maxvals - gi->nvals);
+	nvalsNew = full ? gi->maxvals : gi->nvals+n;
+
+	i = (gi->first + gi->nvals) % gi->maxvals;
+	while (n > 0) {
+		nCopy = MIN(n, gi->maxvals - i);
+		memcpy(&gi->vals[i], vals, nCopy*sizeof(AG_FixedPlotterValue));
+		vals += nCopy;
+		n -= nCopy;
+		i = (i + nCopy) % gi->maxvals;
+	}
+	if (full) {
+		gi->first = i;
+	}
+	gi->nvals = nvalsNew;
+
+	AG_ObjectUnlock(fpl);
+	AG_Redraw(fpl);
+}
+
+void
+AG_FixedPlotterDatum(AG_FixedPlotterItem *gi, AG_FixedPlotterValue val)
+{
+	AG_FixedPlotterData(gi, &val, 1);
 }
 
 void
@@ -15,10 +15,11 @@ struct ag_fixed_plotter;
 typedef struct ag_fixed_plotter_item {
 	char name[AG_LABEL_MAX];		/* Description */
 	AG_Color color;				/* Line color */
-	AG_FixedPlotterValue *vals;		/* Value array */
-	Uint32 nvals;
-	Uint32 maxvals;
-	Uint32 limit;
+	AG_FixedPlotterValue *vals;		/* Value array (circular) */
+	Uint32 nvals;				/* Value count */
+	Uint32 maxvals;				/* Allocated values */
+	Uint32 limit;				/* Values retained (limit-1) */
+	Uint32 first;				/* Index of first value in vals[] */
 	struct ag_fixed_plotter *fpl;			/* Back pointer */
 	AG_TAILQ_ENTRY(ag_fixed_plotter_item) items;
 } AG_FixedPlotterItem;
@@ -43,6 +44,7 @@ typedef struct ag_fixed_plotter {
 	AG_FixedPlotterValue yrange;		/* Max. value */
 	AG_FixedPlotterValue xoffs;		/* Display offset */
 	int yOrigin;				/* Origin position (%) */
+	Uint32 xScale;				/* Values per column (or 0) */
 	struct ag_fixed_plotter_itemq items;	/* Items to plot */
 } AG_FixedPlotter;
 
@@ -54,7 +56,17 @@ AG_FixedPlotterItem *AG_FixedPlotterCurve(AG_FixedPlotter *, const char *,
 		                          Uint8, Uint8, Uint8, Uint32);
 void AG_FixedPlotterFreeItems(AG_FixedPlotter *);
 void AG_FixedPlotterSetRange(AG_FixedPlotter *, AG_FixedPlotterValue);
+void AG_FixedPlotterSetScale(AG_FixedPlotter *, Uint32);
 void AG_FixedPlotterDatum(AG_FixedPlotterItem *, AG_FixedPlotterValue);
+void AG_FixedPlotterData(AG_FixedPlotterItem *, const AG_FixedPlotterValue *,
+                         Uint32);
+
+/* Return value i of a curve (0 = oldest value). */
+static __inline__ AG_FixedPlotterValue
+AG_FixedPlotterGetValue(const AG_FixedPlotterItem *gi, Uint32 i)
+{
+	return (gi->vals[(gi->first + i) % gi->maxvals]);
+}
 
 static __inline__ void
 AG_FixedPlotterScroll(AG_FixedPlotter *fpl, int i)
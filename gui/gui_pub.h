@@ -56,6 +56,7 @@
 #include <agar/gui/treetbl.h>
 #include <agar/gui/textbox.h>
 #include <agar/gui/text_cache.h>
+#include <agar/gui/sort_keys.h>
 #include <agar/gui/tlist.h>
 #include <agar/gui/toolbar.h>
 #include <agar/gui/ucombo.h>
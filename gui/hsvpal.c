@@ -360,7 +360,7 @@ UpdateSV(AG_HSVPal *pal, int ax, int ay)
 
 	UpdatePixelFromHSVA(pal);
 	AG_PostEvent(NULL, pal, "sv-changed", NULL);
-	pal->flags |= AG_HSVPAL_DIRTY;
+	pal->flags |= AG_HSVPAL_DIRTY_PREVIEW;	/* Triangle depends on hue */
 	AG_Redraw(pal);
 }
 
@@ -736,22 +736,72 @@ Init(void *obj)
 	AG_AddEvent(pal, "attached", OnAttach, NULL);
 }
 
+/*
+ * Render the color preview and alpha selector, which depend on the current
+ * hue, saturation and value (but not alpha).
+ */
+static void
+RenderPreview(AG_HSVPal *pal)
+{
+	AG_Surface *ds = pal->surface;
+	float cur_h, cur_s, cur_v;
+	AG_Color C;
+/*	Uint8 da; */
+	int x, y;
+	AG_Rect rd;
+
+	cur_h = (AG_GetFloat(pal, "hue")/360) * 2*AG_PI;
+	cur_s = AG_GetFloat(pal, "saturation");
+	cur_v = AG_GetFloat(pal, "value");
+
+	rd = AG_RECT(0, pal->rAlpha.y+8, ds->w, ds->h - pal->rAlpha.y - 8);
+	AG_FillRect(ds, &rd, AG_ColorRGB(0,0,0));
+
+	/* XXX overblending */
+	for (y = 8; y < pal->rAlpha.h+16; y+=8) {
+		for (x = 0; x < pal->rAlpha.w; x+=16) {
+			rd.w = 8;
+			rd.h = 8;
+			rd.x = pal->rAlpha.x+x;
+			rd.y = pal->rAlpha.y+y;
+			AG_FillRect(ds, &rd, pal->cTile);
+		}
+		y += 8;
+		for (x = 8; x < pal->rAlpha.w; x+=16) {
+			rd.w = 8;
+			rd.h = 8;
+			rd.x = pal->rAlpha.x+x;
+			rd.y = pal->rAlpha.y+y;
+			AG_FillRect(ds, &rd, pal->cTile);
+		}
+	}
+	AG_HSV2RGB((cur_h/(2*AG_PI))*360.0, cur_s, cur_v,
+	    &C.r, &C.g, &C.b);
+/*	da = MIN(1, ds->w/255); */
+	for (y = pal->rAlpha.y+8; y < ds->h; y++) {
+		for (x = 0, C.a = 0;
+		     x < ds->w;
+		     x++) {
+			AG_BLEND_RGBA2(ds, x, y,
+			    C.r, C.g, C.b, C.a, AG_ALPHA_SRC);
+			C.a = x*255/ds->w;
+		}
+	}
+	AG_SurfaceTouch(ds);
+}
+
 static void
 RenderPalette(AG_HSVPal *pal)
 {
 	AG_Surface *ds = pal->surface;
-	float h, cur_h, cur_s, cur_v;
+	float h, cur_h;
 	AG_Color C;
 	Uint32 px;
-/*	Uint8 da; */
 	int x, y, i;
-	AG_Rect rd;
 
 	AG_FillRect(ds, NULL, AG_ColorRGB(0,0,0));
 
 	cur_h = (AG_GetFloat(pal, "hue")/360) * 2*AG_PI;
-	cur_s = AG_GetFloat(pal, "saturation");
-	cur_v = AG_GetFloat(pal, "value");
 
 	/* Render the circle of hues. */
 	for (h = 0.0; h < 2*AG_PI; h += pal->circle.dh) {
@@ -790,39 +840,10 @@ RenderPalette(AG_HSVPal *pal)
 		}
 	}
 
-	if (!(pal->flags & AG_HSVPAL_NOALPHA)) {
-		/* Render the color preview. */
-		/* XXX overblending */
-		for (y = 8; y < pal->rAlpha.h+16; y+=8) {
-			for (x = 0; x < pal->rAlpha.w; x+=16) {
-				rd.w = 8;
-				rd.h = 8;
-				rd.x = pal->rAlpha.x+x;
-				rd.y = pal->rAlpha.y+y;
-				AG_FillRect(ds, &rd, pal->cTile);
-			}
-			y += 8;
-			for (x = 8; x < pal->rAlpha.w; x+=16) {
-				rd.w = 8;
-				rd.h = 8;
-				rd.x = pal->rAlpha.x+x;
-				rd.y = pal->rAlpha.y+y;
-				AG_FillRect(ds, &rd, pal->cTile);
-			}
-		}
-		AG_HSV2RGB((cur_h/(2*AG_PI))*360.0, cur_s, cur_v,
-		    &C.r, &C.g, &C.b);
-/*		da = MIN(1, ds->w/255); */
-		for (y = pal->rAlpha.y+8; y < ds->h; y++) {
-			for (x = 0, C.a = 0;
-			     x < ds->w;
-			     x++) {
-				AG_BLEND_RGBA2(ds, x, y,
-				    C.r, C.g, C.b, C.a, AG_ALPHA_SRC);
-				C.a = x*255/ds->w;
-			}
-		}
-	}
+	AG_SurfaceTouch(ds);
+
+	if (!(pal->flags & AG_HSVPAL_NOALPHA))
+		RenderPreview(pal);
 }
 
 static void
@@ -881,9 +902,17 @@ Draw(void *obj)
 		pal->surfaceId = AG_WidgetMapSurface(pal, pal->surface);
 	}
 	if (pal->flags & AG_HSVPAL_DIRTY) {
-		pal->flags &= ~(AG_HSVPAL_DIRTY);
+		pal->flags &= ~(AG_HSVPAL_DIRTY|AG_HSVPAL_DIRTY_PREVIEW);
 		RenderPalette(pal);
 		AG_WidgetUpdateSurface(pal, pal->surfaceId);
+	} else if (pal->flags & AG_HSVPAL_DIRTY_PREVIEW) {
+		pal->flags &= ~(AG_HSVPAL_DIRTY_PREVIEW);
+		if (!(pal->flags & AG_HSVPAL_NOALPHA)) {
+			RenderPreview(pal);
+			AG_WidgetUpdateSurfaceRect(pal, pal->surfaceId,
+			    AG_RECT(0, pal->rAlpha.y+8, pal->surface->w,
+			            pal->surface->h - pal->rAlpha.y - 8));
+		}
 	}
 
 	cur_h = (AG_GetFloat(pal, "hue") / 360.0) * 2*AG_PI;
@@ -110,6 +110,7 @@ Insert(AG_Editable *ed, AG_EditableBuffer *buf, AG_KeySym keysym, Uint keymod, U
 	}
 	buf->len += nIns;
 	buf->s[buf->len] = '\0';
+	AG_EditableBufferChanged(ed, buf, ed->pos, 0, nIns);
 	ed->pos += nIns;
 
 	if (!(ed->flags & AG_EDITABLE_MULTILINE)) {	/* Optimize case */
@@ -128,7 +129,6 @@ Insert(AG_Editable *ed, AG_EditableBuffer *buf, AG_KeySym keysym, Uint keymod, U
 static int
 Delete(AG_Editable *ed, AG_EditableBuffer *buf, AG_KeySym keysym, Uint keymod, Uint32 unicode)
 {
-	Uint32 *c;
 	int wDel;
 
 	if (buf->len == 0)
@@ -144,6 +144,7 @@ Delete(AG_Editable *ed, AG_EditableBuffer *buf, AG_KeySym keysym, Uint keymod, U
 	if (ed->pos == buf->len) { 
 		ed->pos--;
 		buf->s[--buf->len] = '\0';
+		AG_EditableBufferChanged(ed, buf, buf->len, 1, 0);
 
 		if (ed->flags & AG_EDITABLE_MULTILINE) {
 			ed->xScrollTo = &ed->xCurs;
@@ -169,14 +170,10 @@ Delete(AG_Editable *ed, AG_EditableBuffer *buf, AG_KeySym keysym, Uint keymod, U
 		if (ed->x > 0) { ed->x -= wDel; }
 	}
 
-	for (c = &buf->s[ed->pos];
-	     c < &buf->s[buf->len + 1];
-	     c++) {
-		*c = c[1];
-		if (*c == '\0')
-			break;
-	}
+	memmove(&buf->s[ed->pos], &buf->s[ed->pos + 1],
+	    (buf->len - ed->pos)*sizeof(Uint32));
 	buf->len--;
+	AG_EditableBufferChanged(ed, buf, ed->pos, 1, 0);
 	return (1);
 }
 
@@ -215,7 +215,6 @@ PostMouseButtonDown(AG_Window *win, AG_Widget *wid, int x, int y,
     AG_MouseButton button)
 {
 	AG_Widget *chld;
-	AG_Event *ev;
 	
 	AG_ObjectLock(wid);
 
@@ -226,11 +225,7 @@ PostMouseButtonDown(AG_Window *win, AG_Widget *wid, int x, int y,
 	if ((wid->flags & AG_WIDGET_VISIBLE) &&
 	   !(wid->flags & AG_WIDGET_DISABLED) && 
 	    AG_WidgetSensitive(wid, x, y)) {
-		TAILQ_FOREACH(ev, &OBJECT(wid)->events, events) {
-			if (strcmp(ev->name, "mouse-button-down") == 0)
-				break;
-		}
-		if (ev != NULL) {
+		if (AG_FindEventHandler(wid, "mouse-button-down") != NULL) {
 			AG_PostEvent(NULL, wid, "mouse-button-down",
 			    "%i(button),%i(x),%i(y)",
 			    (int)button,
@@ -0,0 +1,279 @@
+/*	Public domain	*/
+
+/*
+ * Sorting of elements by precomputed keys. Numeric keys are sorted with
+ * an LSD radix sort; collation keys (generated once per element with
+ * strxfrm(3)) are sorted with a merge sort using strcmp(3), in parallel
+ * when there are many of them. Both sorts are stable.
+ */
+
+#include <agar/core/core.h>
+#include <agar/gui/sort_keys.h>
+
+#include <string.h>
+
+#define SORT_KEYS_RUN	16	/* Insertion sort runs of this length */
+#define SORT_KEYS_JOBS	8	/* Maximum number of sorting threads */
+
+void
+AG_SortKeysInit(AG_SortKeys *sk, int type)
+{
+	sk->keys = NULL;
+	sk->nKeys = 0;
+	sk->maxKeys = 0;
+	sk->buf = NULL;
+	sk->bufLen = 0;
+	sk->bufMax = 0;
+	sk->type = type;
+}
+
+void
+AG_SortKeysFree(AG_SortKeys *sk)
+{
+	Free(sk->keys);
+	Free(sk->buf);
+	sk->keys = NULL;
+	sk->buf = NULL;
+}
+
+static int
+GrowKeys(AG_SortKeys *sk)
+{
+	AG_SortKey *keysNew;
+	Uint maxNew;
+
+	if (sk->nKeys < sk->maxKeys) {
+		return (0);
+	}
+	maxNew = (sk->maxKeys > 0) ? sk->maxKeys*2 : 256;
+	if ((keysNew = TryRealloc(sk->keys, maxNew*sizeof(AG_SortKey)))
+	    == NULL) {
+		return (-1);
+	}
+	sk->keys = keysNew;
+	sk->maxKeys = maxNew;
+	return (0);
+}
+
+/* Add a numeric key for element idx. */
+int
+AG_SortKeysAddNum(AG_SortKeys *sk, AG_SortKeyNum n, Uint idx)
+{
+	AG_SortKey *key;
+
+	if (GrowKeys(sk) == -1) {
+		return (-1);
+	}
+	key = &sk->keys[sk->nKeys++];
+	key->k.n = n;
+	key->idx = idx;
+	return (0);
+}
+
+/* Generate and add the collation key of string s for element idx. */
+int
+AG_SortKeysAddStr(AG_SortKeys *sk, const char *s, Uint idx)
+{
+	AG_SortKey *key;
+	char *bufNew;
+	size_t len, maxNew;
+
+	if (GrowKeys(sk) == -1) {
+		return (-1);
+	}
+	for (;;) {
+		len = 64;
+		if (sk->bufMax - sk->bufLen >= len) {
+			len = strxfrm(&sk->buf[sk->bufLen], s,
+			    sk->bufMax - sk->bufLen);
+			if (len < sk->bufMax - sk->bufLen)
+				break;
+		}
+		maxNew = MAX(sk->bufMax*2, sk->bufLen+len+1);
+		if ((bufNew = TryRealloc(sk->buf, maxNew)) == NULL) {
+			return (-1);
+		}
+		sk->buf = bufNew;
+		sk->bufMax = maxNew;
+	}
+	/* Store the offset; it is converted to a pointer when sorting. */
+	key = &sk->keys[sk->nKeys++];
+	key->k.n = (AG_SortKeyNum)sk->bufLen;
+	key->idx = idx;
+	sk->bufLen += len+1;
+	return (0);
+}
+
+/* Stable LSD radix sort of numeric keys, skipping uniform digits. */
+static void
+RadixSortNum(AG_SortKey *a, AG_SortKey *tmp, Uint n)
+{
+	AG_SortKey *src = a, *dst = tmp, *t;
+	Uint count[256];
+	Uint shift, i, sum, c;
+
+	for (shift = 0; shift < sizeof(AG_SortKeyNum)*8; shift += 8) {
+		memset(count, 0, sizeof(count));
+		for (i = 0; i < n; i++) {
+			count[(src[i].k.n >> shift) & 0xff]++;
+		}
+		if (count[(src[0].k.n >> shift) & 0xff] == n) {
+			continue;
+		}
+		for (i = 0, sum = 0; i < 256; i++) {
+			c = count[i];
+			count[i] = sum;
+			sum += c;
+		}
+		for (i = 0; i < n; i++) {
+			dst[count[(src[i].k.n >> shift) & 0xff]++] = src[i];
+		}
+		t = src;
+		src = dst;
+		dst = t;
+	}
+	if (src != a)
+		memcpy(a, src, n*sizeof(AG_SortKey));
+}
+
+/* Merge the sorted runs a[lo..mid) and a[mid..hi). */
+static void
+MergeRuns(AG_SortKey *a, AG_SortKey *tmp, Uint lo, Uint mid, Uint hi)
+{
+	Uint p = lo, q = mid, k = lo;
+
+	if (mid == lo || mid == hi ||
+	    strcmp(a[mid-1].k.s, a[mid].k.s) <= 0) {
+		return;					/* Already in order */
+	}
+	while (p < mid && q < hi) {
+		tmp[k++] = (strcmp(a[q].k.s, a[p].k.s) < 0) ? a[q++] : a[p++];
+	}
+	while (p < mid) { tmp[k++] = a[p++]; }
+	while (q < hi) { tmp[k++] = a[q++]; }
+	memcpy(&a[lo], &tmp[lo], (hi-lo)*sizeof(AG_SortKey));
+}
+
+/* Stable merge sort of collation keys. */
+static void
+MergeSortStr(AG_SortKey *a, AG_SortKey *tmp, Uint n)
+{
+	AG_SortKey key;
+	Uint lo, hi, i, j, w;
+
+	for (lo = 0; lo < n; lo += SORT_KEYS_RUN) {
+		hi = MIN(lo+SORT_KEYS_RUN, n);
+		for (i = lo+1; i < hi; i++) {
+			key = a[i];
+			for (j = i; j > lo && strcmp(key.k.s, a[j-1].k.s) < 0;
+			     j--) {
+				a[j] = a[j-1];
+			}
+			a[j] = key;
+		}
+	}
+	for (w = SORT_KEYS_RUN; w < n; w *= 2) {
+		for (lo = 0; lo < n-w; lo += 2*w)
+			MergeRuns(a, tmp, lo, lo+w, MIN(lo+2*w, n));
+	}
+}
+
+#ifdef AG_THREADS
+typedef struct ag_sort_keys_job {
+	AG_SortKey *a, *tmp;
+	Uint n;
+} AG_SortKeysJob;
+
+static void *
+SortKeysThread(void *p)
+{
+	AG_SortKeysJob *job = p;
+
+	MergeSortStr(job->a, job->tmp, job->n);
+	return (NULL);
+}
+
+/*
+ * Sort contiguous chunks of the keys in separate threads, then merge the
+ * chunks pairwise. Chunks for which no thread could be created are sorted
+ * by the calling thread.
+ */
+static void
+MergeSortStrParallel(AG_SortKey *a, AG_SortKey *tmp, Uint n, Uint nJobs)
+{
+	AG_SortKeysJob jobs[SORT_KEYS_JOBS];
+	AG_Thread th[SORT_KEYS_JOBS];
+	int started[SORT_KEYS_JOBS];
+	Uint bounds[SORT_KEYS_JOBS+1];
+	Uint i, w;
+
+	for (i = 0; i < nJobs; i++) {
+		bounds[i] = (n/nJobs)*i;
+	}
+	bounds[nJobs] = n;
+	for (i = 0; i < nJobs; i++) {
+		jobs[i].a = &a[bounds[i]];
+		jobs[i].tmp = &tmp[bounds[i]];
+		jobs[i].n = bounds[i+1] - bounds[i];
+		started[i] = (i > 0 &&
+		    AG_ThreadTryCreate(&th[i], SortKeysThread, &jobs[i]) == 0);
+	}
+	SortKeysThread(&jobs[0]);
+	for (i = 1; i < nJobs; i++) {
+		if (started[i]) {
+			AG_ThreadJoin(th[i], NULL);
+		} else {
+			SortKeysThread(&jobs[i]);
+		}
+	}
+	for (w = 1; w < nJobs; w *= 2) {
+		for (i = 0; i+w < nJobs; i += 2*w)
+			MergeRuns(a, tmp, bounds[i], bounds[i+w],
+			    bounds[MIN(i+2*w, nJobs)]);
+	}
+}
+#endif /* AG_THREADS */
+
+/*
+ * Sort the keys in ascending (or descending) order. The element indices
+ * may then be read from keys[].idx. Returns -1 if out of memory.
+ */
+int
+AG_SortKeysSort(AG_SortKeys *sk, int descending)
+{
+	AG_SortKey *tmp, key;
+	Uint i, n = sk->nKeys;
+
+	if (n < 2) {
+		return (0);
+	}
+	if ((tmp = TryMalloc(n*sizeof(AG_SortKey))) == NULL) {
+		return (-1);
+	}
+	if (sk->type == AG_SORT_KEYS_STR) {
+		for (i = 0; i < n; i++) {
+			sk->keys[i].k.s = &sk->buf[(size_t)sk->keys[i].k.n];
+		}
+#ifdef AG_THREADS
+		if (n >= AG_SORT_KEYS_PARALLEL && agCPU.nCPUs > 1) {
+			MergeSortStrParallel(sk->keys, tmp, n,
+			    MIN((Uint)agCPU.nCPUs, SORT_KEYS_JOBS));
+		} else
+#endif
+		{
+			MergeSortStr(sk->keys, tmp, n);
+		}
+	} else {
+		RadixSortNum(sk->keys, tmp, n);
+	}
+	Free(tmp);
+
+	if (descending) {
+		for (i = 0; i < n/2; i++) {
+			key = sk->keys[i];
+			sk->keys[i] = sk->keys[n-1-i];
+			sk->keys[n-1-i] = key;
+		}
+	}
+	return (0);
+}
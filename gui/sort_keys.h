@@ -0,0 +1,86 @@
+/*	Public domain	*/
+
+#ifndef _AGAR_GUI_SORT_KEYS_H_
+#define _AGAR_GUI_SORT_KEYS_H_
+
+#include <agar/gui/begin.h>
+
+#ifdef AG_HAVE_64BIT
+typedef Uint64 AG_SortKeyNum;
+#else
+typedef Uint32 AG_SortKeyNum;
+#endif
+
+/* Precomputed sort key of an element. */
+typedef struct ag_sort_key {
+	union {
+		AG_SortKeyNum n;	/* Order-preserving numeric key */
+		const char *s;		/* Collation key (see strxfrm(3)) */
+	} k;
+	Uint idx;			/* Index of element */
+} AG_SortKey;
+
+/* Array of sort keys. */
+typedef struct ag_sort_keys {
+	AG_SortKey *keys;
+	Uint nKeys, maxKeys;
+	char *buf;			/* Collation key storage */
+	size_t bufLen, bufMax;
+	int type;
+#define AG_SORT_KEYS_NUM 0		/* Numeric keys (radix sort) */
+#define AG_SORT_KEYS_STR 1		/* Collation keys (merge sort) */
+} AG_SortKeys;
+
+/* Number of keys above which collation keys are sorted in parallel. */
+#define AG_SORT_KEYS_PARALLEL 32768
+
+__BEGIN_DECLS
+void AG_SortKeysInit(AG_SortKeys *, int);
+void AG_SortKeysFree(AG_SortKeys *);
+int  AG_SortKeysAddNum(AG_SortKeys *, AG_SortKeyNum, Uint);
+int  AG_SortKeysAddStr(AG_SortKeys *, const char *, Uint);
+int  AG_SortKeysSort(AG_SortKeys *, int);
+
+/* Order-preserving encodings of numbers as unsigned keys. */
+static __inline__ AG_SortKeyNum
+AG_SortKeyUint(Ulong v)
+{
+	return ((AG_SortKeyNum)v);
+}
+static __inline__ AG_SortKeyNum
+AG_SortKeyInt(long v)
+{
+	return ((AG_SortKeyNum)v ^
+	        ((AG_SortKeyNum)1 << (sizeof(AG_SortKeyNum)*8 - 1)));
+}
+static __inline__ AG_SortKeyNum
+AG_SortKeyDouble(double v)
+{
+#ifdef AG_HAVE_64BIT
+	union { double f; Uint64 u; } x;
+#else
+	union { float f; Uint32 u; } x;
+#endif
+	AG_SortKeyNum u;
+
+	x.f = v;
+	u = x.u;
+	if (v != v) {					/* NaN sorts last */
+		return (~(AG_SortKeyNum)0);
+	}
+	if (u >> (sizeof(u)*8 - 1)) {
+		return (~u);
+	}
+	return (u | ((AG_SortKeyNum)1 << (sizeof(u)*8 - 1)));
+}
+#ifdef AG_HAVE_64BIT
+static __inline__ AG_SortKeyNum
+AG_SortKeySint64(Sint64 v)
+{
+	return ((Uint64)v ^ ((Uint64)1 << 63));
+}
+#endif
+__END_DECLS
+
+#include <agar/gui/close.h>
+#endif /* _AGAR_GUI_SORT_KEYS_H_ */
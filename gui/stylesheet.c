@@ -29,6 +29,7 @@
 #include <agar/gui/style_data.h>
 
 #include <ctype.h>
+#include <string.h>
 
 AG_StyleSheet agDefaultCSS;
 
@@ -41,6 +42,7 @@ void
 AG_InitStyleSheet(AG_StyleSheet *css)
 {
 	TAILQ_INIT(&css->blks);
+	memset(css->classes, 0, sizeof(css->classes));
 }
 
 void
@@ -48,6 +50,8 @@ AG_DestroyStyleSheet(AG_StyleSheet *css)
 {
 	AG_StyleBlock *blk, *blkNext;
 	AG_StyleEntry *ent, *entNext;
+	AG_StyleClass *sc, *scNext;
+	int i;
 
 	for (blk = TAILQ_FIRST(&css->blks);
 	     blk != TAILQ_END(&css->blks);
@@ -62,6 +66,15 @@ AG_DestroyStyleSheet(AG_StyleSheet *css)
 		free(blk);
 	}
 	TAILQ_INIT(&css->blks);
+
+	for (i = 0; i < AG_STYLE_CLASS_HASH; i++) {
+		for (sc = css->classes[i]; sc != NULL; sc = scNext) {
+			scNext = sc->next;
+			Free(sc->vals);
+			free(sc);
+		}
+		css->classes[i] = NULL;
+	}
 }
 
 /*
@@ -199,51 +212,115 @@ fail_parse:
 	return (NULL);
 }
 
-/* Lookup a style sheet entry. */
-int
-AG_LookupStyleSheet(AG_StyleSheet *css, void *obj, const char *key, char **rv)
+/* Find the block matching the class of an object. */
+static AG_StyleBlock *
+MatchBlock(AG_StyleSheet *css, void *obj)
 {
-	AG_ObjectClass **hier;
 	AG_StyleBlock *blk;
-	AG_StyleEntry *ent;
-	int nHier;
-
-	if (AG_ObjectGetInheritHier(obj, &hier, &nHier) != 0)
-		return (0);
 
 	/* Match an exact class ID */
 	TAILQ_FOREACH(blk, &css->blks, blks) {
 		if (Strcasecmp(blk->match, AGOBJECT_CLASS(obj)->hier) == 0)
-			break;
+			return (blk);
 	}
-	if (blk == NULL) {
-		/* Match a general class hierarchy pattern */
-		TAILQ_FOREACH(blk, &css->blks, blks) {
-			if (AG_OfClass(obj, blk->match))
-				break;
-		}
-		if (blk == NULL) {
-			/* Match a short class name */
-			TAILQ_FOREACH(blk, &css->blks, blks) {
-				if (Strcasecmp(hier[nHier-1]->name, blk->match) == 0)
-					break;
-			}
- 			if (blk == NULL)
-				goto fail;
-		}
+	/* Match a general class hierarchy pattern */
+	TAILQ_FOREACH(blk, &css->blks, blks) {
+		if (AG_OfClass(obj, blk->match))
+			return (blk);
+	}
+	/* Match a short class name */
+	TAILQ_FOREACH(blk, &css->blks, blks) {
+		if (Strcasecmp(AGOBJECT_CLASS(obj)->name, blk->match) == 0)
+			return (blk);
 	}
+	return (NULL);
+}
+
+/* Find the value of a key in a block. */
+static const char *
+MatchEntry(AG_StyleBlock *blk, const char *key)
+{
+	AG_StyleEntry *ent;
+
 	TAILQ_FOREACH(ent, &blk->ents, ents) {
-		if (Strcasecmp(ent->key, key) == 0) {
-			*rv = ent->value;
-			break;
-		}
+		if (Strcasecmp(ent->key, key) == 0)
+			return (ent->value);
 	}
-	if (ent == NULL) {
-		goto fail;
+	return (NULL);
+}
+
+/*
+ * Return the resolved style of the class of an object. Blocks are matched
+ * only once per class and style sheet.
+ */
+static AG_StyleClass *
+GetStyleClass(AG_StyleSheet *css, void *obj)
+{
+	AG_ObjectClass *cls = AGOBJECT_CLASS(obj);
+	Uint h = (Uint)(((size_t)cls >> 4) % AG_STYLE_CLASS_HASH);
+	AG_StyleClass *sc;
+
+	for (sc = css->classes[h]; sc != NULL; sc = sc->next) {
+		if (sc->cls == cls)
+			return (sc);
+	}
+	if ((sc = TryMalloc(sizeof(AG_StyleClass))) == NULL) {
+		return (NULL);
+	}
+	sc->cls = cls;
+	sc->blk = MatchBlock(css, obj);
+	sc->keys = NULL;
+	sc->vals = NULL;
+	sc->nKeys = 0;
+	sc->next = css->classes[h];
+	css->classes[h] = sc;
+	return (sc);
+}
+
+/* Lookup a style sheet entry. */
+int
+AG_LookupStyleSheet(AG_StyleSheet *css, void *obj, const char *key, char **rv)
+{
+	AG_StyleClass *sc;
+	const char *v;
+
+	if ((sc = GetStyleClass(css, obj)) == NULL || sc->blk == NULL ||
+	    (v = MatchEntry(sc->blk, key)) == NULL) {
+		return (0);
 	}
-	free(hier);
+	*rv = (char *)v;
 	return (1);
-fail:
-	free(hier);
-	return (0);
+}
+
+/*
+ * Lookup the values of nKeys style sheet entries at once, returning an
+ * array of values (NULL = undefined). The results are cached per class,
+ * so repeated calls with the same keys array (compared by address) reduce
+ * to a table lookup. Returns NULL if insufficient memory is available.
+ */
+const char **
+AG_LookupStyleSheetValues(AG_StyleSheet *css, void *obj, const char **keys,
+    int nKeys)
+{
+	AG_StyleClass *sc;
+	const char **valsNew;
+	int i;
+
+	if ((sc = GetStyleClass(css, obj)) == NULL) {
+		return (NULL);
+	}
+	if (sc->keys == keys && sc->nKeys == nKeys) {
+		return (sc->vals);
+	}
+	if ((valsNew = TryRealloc(sc->vals, nKeys*sizeof(char *))) == NULL) {
+		return (NULL);
+	}
+	for (i = 0; i < nKeys; i++) {
+		valsNew[i] = (sc->blk != NULL) ? MatchEntry(sc->blk, keys[i]) :
+		                                 NULL;
+	}
+	sc->vals = valsNew;
+	sc->keys = keys;
+	sc->nKeys = nKeys;
+	return (valsNew);
 }
@@ -5,6 +5,7 @@
 #include <agar/gui/begin.h>
 
 #define AG_STYLE_VALUE_MAX 128
+#define AG_STYLE_CLASS_HASH 64
 
 typedef struct ag_style_entry {
 	char key[AG_VARIABLE_NAME_MAX];			/* Target parameter */
@@ -18,8 +19,19 @@ typedef struct ag_style_block {
 	AG_TAILQ_ENTRY(ag_style_block) blks;
 } AG_StyleBlock;
 
+/* Style block and values resolved for a class. */
+typedef struct ag_style_class {
+	AG_ObjectClass *cls;				/* Object class */
+	AG_StyleBlock *blk;				/* Matching block */
+	const char **keys;				/* Resolved keys */
+	const char **vals;				/* Values (or NULL) */
+	int nKeys;
+	struct ag_style_class *next;			/* In hash bucket */
+} AG_StyleClass;
+
 typedef struct ag_style_sheet {
 	AG_TAILQ_HEAD_(ag_style_block) blks;		/* By widget class */
+	AG_StyleClass *classes[AG_STYLE_CLASS_HASH];	/* Resolved classes */
 } AG_StyleSheet;
 
 /* Description of a built-in stylesheet. */
@@ -39,6 +51,8 @@ void           AG_InitStyleSheet(AG_StyleSheet *);
 void           AG_DestroyStyleSheet(AG_StyleSheet *);
 AG_StyleSheet *AG_LoadStyleSheet(void *, const char *);
 int            AG_LookupStyleSheet(AG_StyleSheet *, void *, const char *, char **);
+const char   **AG_LookupStyleSheetValues(AG_StyleSheet *, void *,
+                                         const char **, int);
 __END_DECLS
 
 #include <agar/gui/close.h>
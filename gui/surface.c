@@ -29,6 +29,12 @@
 
 #include <string.h>
 
+#include <agar/config/have_sse2.h>
+#if defined(HAVE_SSE2) && defined(__SSE2__)
+# include <emmintrin.h>
+# define SURFACE_SSE2
+#endif
+
 const char *agBlendFuncNames[] = {
 	"dst+src",
 	"src",
@@ -39,6 +45,7 @@ const char *agBlendFuncNames[] = {
 };
 
 AG_PixelFormat *agSurfaceFmt = NULL;  /* Recommended format for GUI surfaces */
+static volatile Uint agSurfaceGen = 0; /* Last surface generation number */
 
 #define COMPUTE_SHIFTLOSS(mask, shift, loss) \
 	shift = 0; \
@@ -255,6 +262,7 @@ AG_SurfaceNew(enum ag_surface_type type, Uint w, Uint h,
 	s->pitch = (pitch + 3) & ~3;
 	s->padding = s->pitch - w*pf->BytesPerPixel;
 	s->clipRect = AG_RECT(0,0,w,h);
+	s->gen = AG_AtomicIncUint(&agSurfaceGen);
 
 	if (h*s->pitch > 0) {
 		if ((s->pixels = TryMalloc(h*s->pitch)) == NULL)
@@ -462,6 +470,7 @@ AG_SurfaceSetPalette(AG_Surface *su, AG_Color *c, Uint offs, Uint count)
 	for (i = 0; i < count; i++) {
 		su->format->palette->colors[offs+i] = c[i];
 	}
+	su->gen = AG_AtomicIncUint(&agSurfaceGen);
 	return (0);
 }
 
@@ -497,6 +506,216 @@ AG_SurfaceConvert(const AG_Surface *ss, const AG_PixelFormat *pf)
 	return (ds);
 }
 
+/*
+ * Fast paths for packed 32-bit formats with 8-bit components at byte
+ * boundaries (e.g., RGBA, ARGB, BGRA). They produce the same results as
+ * the generic AG_GetColorRGBA() / AG_MapColorRGB[A]() / AG_SurfaceBlendPixel()
+ * path. SSE2 kernels are selected at runtime from agCPU.
+ */
+static __inline__ int
+IsPacked8888(const AG_PixelFormat *pf)
+{
+	return (pf->palette == NULL && pf->BytesPerPixel == 4 &&
+	        pf->Rmask == (0xffU << pf->Rshift) && (pf->Rshift & 7) == 0 &&
+	        pf->Gmask == (0xffU << pf->Gshift) && (pf->Gshift & 7) == 0 &&
+	        pf->Bmask == (0xffU << pf->Bshift) && (pf->Bshift & 7) == 0 &&
+	       (pf->Amask == 0 ||
+	       (pf->Amask == (0xffU << pf->Ashift) && (pf->Ashift & 7) == 0)));
+}
+
+/* Convert a pixel between packed 8888 formats (as AG_MapColorRGBA()). */
+static __inline__ Uint32
+Convert8888(Uint32 px, const AG_PixelFormat *sf, const AG_PixelFormat *df)
+{
+	Uint32 a = (sf->Amask != 0) ? (px >> sf->Ashift) & 0xff : 0xff;
+
+	return (((px >> sf->Rshift) & 0xff) << df->Rshift |
+	        ((px >> sf->Gshift) & 0xff) << df->Gshift |
+	        ((px >> sf->Bshift) & 0xff) << df->Bshift |
+	        ((a << df->Ashift) & df->Amask));
+}
+
+/*
+ * Convert a row of packed 8888 pixels. If opaque is set, force the
+ * destination alpha to opaque (as AG_MapColorRGB()).
+ */
+static void
+ConvertRow8888(const Uint32 *pSrc, Uint32 *pDst, Uint n,
+    const AG_PixelFormat *sf, const AG_PixelFormat *df, int opaque)
+{
+	Uint32 aOr = opaque ? df->Amask : 0;
+	Uint i = 0;
+
+#ifdef SURFACE_SSE2
+	if (agCPU.ext & AG_EXT_SSE2) {
+		const __m128i ff = _mm_set1_epi32(0xff);
+		const __m128i sR = _mm_cvtsi32_si128(sf->Rshift);
+		const __m128i sG = _mm_cvtsi32_si128(sf->Gshift);
+		const __m128i sB = _mm_cvtsi32_si128(sf->Bshift);
+		const __m128i sA = _mm_cvtsi32_si128(sf->Ashift);
+		const __m128i dR = _mm_cvtsi32_si128(df->Rshift);
+		const __m128i dG = _mm_cvtsi32_si128(df->Gshift);
+		const __m128i dB = _mm_cvtsi32_si128(df->Bshift);
+		const __m128i dA = _mm_cvtsi32_si128(df->Ashift);
+		const __m128i aMask = _mm_set1_epi32(df->Amask);
+		const __m128i aOrV = _mm_set1_epi32(aOr);
+		__m128i s, d, a;
+
+		for (; i+4 <= n; i += 4) {
+			s = _mm_loadu_si128((const __m128i *)&pSrc[i]);
+			d = _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(s,sR),ff),dR);
+			d = _mm_or_si128(d,
+			    _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(s,sG),ff),dG));
+			d = _mm_or_si128(d,
+			    _mm_sll_epi32(_mm_and_si128(_mm_srl_epi32(s,sB),ff),dB));
+			a = (sf->Amask != 0) ?
+			    _mm_and_si128(_mm_srl_epi32(s,sA), ff) : ff;
+			d = _mm_or_si128(d,
+			    _mm_and_si128(_mm_sll_epi32(a,dA), aMask));
+			d = _mm_or_si128(d, aOrV);
+			_mm_storeu_si128((__m128i *)&pDst[i], d);
+		}
+	}
+#endif
+	for (; i < n; i++)
+		pDst[i] = Convert8888(pSrc[i], sf, df) | aOr;
+}
+
+/* Blit a row of packed 8888 pixels (scalar version). */
+static void
+BlitRow8888(const Uint32 *pSrc, Uint32 *pDst, Uint n, const AG_Surface *ss,
+    const AG_Surface *ds)
+{
+	const AG_PixelFormat *sf = ss->format, *df = ds->format;
+	Uint32 rgbMask = df->Rmask | df->Gmask | df->Bmask;
+	int blend = ((ss->flags & AG_SRCALPHA) && sf->Amask != 0);
+	Uint32 px, pxDst, pxOut, a;
+	int cs, cd;
+	Uint i;
+
+	for (i = 0; i < n; i++) {
+		px = pSrc[i];
+		if ((ss->flags & AG_SRCCOLORKEY) && px == sf->colorkey) {
+			continue;
+		}
+		a = (sf->Amask != 0) ? (px >> sf->Ashift) & 0xff : 0xff;
+		if (!blend || a == AG_ALPHA_OPAQUE) {
+			pDst[i] = (Convert8888(px, sf, df) & rgbMask) | df->Amask;
+			continue;
+		}
+		pxDst = pDst[i];
+		if ((ds->flags & AG_SRCCOLORKEY) && pxDst == df->colorkey) {
+			pDst[i] = Convert8888(px, sf, df);
+			continue;
+		}
+		pxOut = pxDst & df->Amask;
+		cs = (px >> sf->Rshift) & 0xff;
+		cd = (pxDst >> df->Rshift) & 0xff;
+		pxOut |= (Uint32)((((cs - cd)*(int)a) >> 8) + cd) << df->Rshift;
+		cs = (px >> sf->Gshift) & 0xff;
+		cd = (pxDst >> df->Gshift) & 0xff;
+		pxOut |= (Uint32)((((cs - cd)*(int)a) >> 8) + cd) << df->Gshift;
+		cs = (px >> sf->Bshift) & 0xff;
+		cd = (pxDst >> df->Bshift) & 0xff;
+		pxOut |= (Uint32)((((cs - cd)*(int)a) >> 8) + cd) << df->Bshift;
+		pDst[i] = pxOut;
+	}
+}
+
+#ifdef SURFACE_SSE2
+/*
+ * Blit a row of packed 8888 pixels (SSE2 version). The destination must
+ * not use a colorkey. Blending uses mulhi on (cs-cd)<<7 and a<<1, which
+ * yields exactly ((cs-cd)*a) >> 8.
+ */
+static void
+BlitRow8888_SSE2(const Uint32 *pSrc, Uint32 *pDst, Uint n,
+    const AG_Surface *ss, const AG_Surface *ds)
+{
+	const AG_PixelFormat *sf = ss->format, *df = ds->format;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i ff = _mm_set1_epi32(0xff);
+	const __m128i rgbMask = _mm_set1_epi32(df->Rmask|df->Gmask|df->Bmask);
+	const __m128i aMask = _mm_set1_epi32(df->Amask);
+	const __m128i key = _mm_set1_epi32(sf->colorkey);
+	const __m128i sA = _mm_cvtsi32_si128(sf->Ashift);
+	const int blend = ((ss->flags & AG_SRCALPHA) && sf->Amask != 0);
+	const int keySrc = (ss->flags & AG_SRCCOLORKEY);
+	const int sameRGB = (sf->Rshift == df->Rshift &&
+	                     sf->Gshift == df->Gshift &&
+	                     sf->Bshift == df->Bshift);
+	__m128i s, c, d, a, a16, aLo, aHi, cLo, cHi, dLo, dHi, r, m;
+	Uint32 cv[4];
+	Uint i, j;
+
+	for (i = 0; i+4 <= n; i += 4) {
+		s = _mm_loadu_si128((const __m128i *)&pSrc[i]);
+		if (sameRGB) {
+			c = s;
+		} else {
+			for (j = 0; j < 4; j++) {
+				cv[j] = Convert8888(pSrc[i+j], sf, df);
+			}
+			c = _mm_loadu_si128((const __m128i *)cv);
+		}
+		/* Opaque source pixels (as AG_MapColorRGB()) */
+		r = _mm_or_si128(_mm_and_si128(c, rgbMask), aMask);
+		d = _mm_loadu_si128((const __m128i *)&pDst[i]);
+		if (blend) {
+			a = _mm_and_si128(_mm_srl_epi32(s, sA), ff);
+			a16 = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+			aLo = _mm_slli_epi16(_mm_unpacklo_epi32(a16, a16), 1);
+			aHi = _mm_slli_epi16(_mm_unpackhi_epi32(a16, a16), 1);
+			cLo = _mm_unpacklo_epi8(c, zero);
+			cHi = _mm_unpackhi_epi8(c, zero);
+			dLo = _mm_unpacklo_epi8(d, zero);
+			dHi = _mm_unpackhi_epi8(d, zero);
+			cLo = _mm_add_epi16(dLo, _mm_mulhi_epi16(
+			    _mm_slli_epi16(_mm_sub_epi16(cLo, dLo), 7), aLo));
+			cHi = _mm_add_epi16(dHi, _mm_mulhi_epi16(
+			    _mm_slli_epi16(_mm_sub_epi16(cHi, dHi), 7), aHi));
+			c = _mm_packus_epi16(cLo, cHi);
+			/* Keep the destination alpha (as AG_SurfaceBlendPixel()) */
+			c = _mm_or_si128(_mm_and_si128(c, rgbMask),
+			                 _mm_and_si128(d, aMask));
+			m = _mm_cmpeq_epi32(a, ff);
+			r = _mm_or_si128(_mm_and_si128(m, r),
+			                 _mm_andnot_si128(m, c));
+		}
+		if (keySrc) {
+			m = _mm_cmpeq_epi32(s, key);
+			r = _mm_or_si128(_mm_and_si128(m, d),
+			                 _mm_andnot_si128(m, r));
+		}
+		_mm_storeu_si128((__m128i *)&pDst[i], r);
+	}
+	if (i < n)
+		BlitRow8888(&pSrc[i], &pDst[i], n-i, ss, ds);
+}
+#endif /* SURFACE_SSE2 */
+
+/* Fill a row of 32-bit pixels. */
+static void
+FillRow32(Uint32 *p, Uint32 px, Uint n)
+{
+	Uint i = 0;
+
+	if ((px & 0xff) * 0x01010101U == px) {
+		memset(p, px & 0xff, n*sizeof(Uint32));
+		return;
+	}
+#ifdef SURFACE_SSE2
+	if (agCPU.ext & AG_EXT_SSE2) {
+		const __m128i v = _mm_set1_epi32(px);
+
+		for (; i+4 <= n; i += 4)
+			_mm_storeu_si128((__m128i *)&p[i], v);
+	}
+#endif
+	for (; i < n; i++)
+		p[i] = px;
+}
+
 /*
  * Copy pixel data from a source to a destination surface. Perform
  * conversion if pixel format differs. Perform clipping if dimensions
@@ -510,6 +729,8 @@ AG_SurfaceCopy(AG_Surface *ds, const AG_Surface *ss)
 	const Uint8 *pSrc;
 	Uint8 *pDst;
 
+	ds->gen = AG_AtomicIncUint(&agSurfaceGen);
+
 	if (ds->w > ss->w) {
 		w = ss->w;
 		padDst = (ds->w - ss->w)*ds->format->BytesPerPixel;
@@ -536,6 +757,13 @@ AG_SurfaceCopy(AG_Surface *ds, const AG_Surface *ss)
 			pDst += w*ds->format->BytesPerPixel + padDst;
 			pSrc += w*ss->format->BytesPerPixel + padSrc;
 		}
+	} else if (IsPacked8888(ss->format) && IsPacked8888(ds->format)) {
+		for (y = 0; y < h; y++) {
+			ConvertRow8888((const Uint32 *)pSrc, (Uint32 *)pDst, w,
+			    ss->format, ds->format, 0);
+			pDst += w*4 + padDst;
+			pSrc += w*4 + padSrc;
+		}
 	} else {					/* Format conversion */
 		Uint32 px;
 		AG_Color C;
@@ -590,8 +818,27 @@ AG_SurfaceBlit(const AG_Surface *ss, const AG_Rect *srcRect, AG_Surface *ds,
 	        (ds->clipRect.x+ds->clipRect.w - dr.x) : sr.w;
 	dr.h = (dr.y+sr.h > ds->clipRect.y+ds->clipRect.h) ?
 	        (ds->clipRect.y+ds->clipRect.h - dr.y) : sr.h;
+	if (dr.w <= 0 || dr.h <= 0)
+		return;
+
+	ds->gen = AG_AtomicIncUint(&agSurfaceGen);
+
+	if (ss->format->alpha == AG_ALPHA_OPAQUE &&
+	    IsPacked8888(ss->format) && IsPacked8888(ds->format)) {
+		void (*fn)(const Uint32 *, Uint32 *, Uint, const AG_Surface *,
+		           const AG_Surface *) = BlitRow8888;
+#ifdef SURFACE_SSE2
+		if ((agCPU.ext & AG_EXT_SSE2) && !(ds->flags & AG_SRCCOLORKEY))
+			fn = BlitRow8888_SSE2;
+#endif
+		for (y = 0; y < dr.h; y++) {
+			pSrc = (Uint8 *)ss->pixels + (sr.y+y)*ss->pitch + sr.x*4;
+			pDst = (Uint8 *)ds->pixels + (dr.y+y)*ds->pitch + dr.x*4;
+			fn((const Uint32 *)pSrc, (Uint32 *)pDst, dr.w, ss, ds);
+		}
+		return;
+	}
 
-	/* XXX TODO optimized cases */
 	for (y = 0; y < dr.h; y++) {
 		pSrc = (Uint8 *)ss->pixels + (sr.y+y)*ss->pitch +
 		    sr.x*ss->format->BytesPerPixel;
@@ -640,9 +887,21 @@ AG_SurfaceResize(AG_Surface *s, Uint w, Uint h)
 	s->w = w;
 	s->h = h;
 	s->clipRect = AG_RECT(0,0,w,h);
+	s->gen = AG_AtomicIncUint(&agSurfaceGen);
 	return (0);
 }
 
+/*
+ * Mark the contents of a surface as modified. Must be called after writing
+ * to the pixels directly, so that cached copies (e.g., textures cached by
+ * the SDL2 driver) are refreshed.
+ */
+void
+AG_SurfaceTouch(AG_Surface *su)
+{
+	su->gen = AG_AtomicIncUint(&agSurfaceGen);
+}
+
 /* Free the specified surface. */
 void
 AG_SurfaceFree(AG_Surface *s)
@@ -654,7 +913,8 @@ AG_SurfaceFree(AG_Surface *s)
 
 /*
  * Blend the specified components with the pixel at s:[x,y], using the
- * given alpha function. No clipping is done.
+ * given alpha function. No clipping is done. As with AG_SurfacePutPixel(),
+ * the caller must use AG_SurfaceTouch() once done writing.
  */
 void
 AG_SurfaceBlendPixel(AG_Surface *s, Uint8 *pDst, AG_Color Cnew, AG_BlendFn fn)
@@ -784,14 +1044,248 @@ AG_HSV2RGB(float h, float s, float v, Uint8 *r, Uint8 *g, Uint8 *b)
 }
 
 /*
- * Allocate a new surface containing a pixmap of ss scaled to wxh.
- * XXX TODO optimize; filtering
+ * Surface scaling. Source coordinates are computed once per column into
+ * a table (and once per row), so no divisions are done per pixel. Large
+ * operations are split into bands of destination rows which are scaled
+ * in parallel.
+ */
+#define AG_SCALE_BANDS_MAX	8		/* Maximum number of bands */
+#define AG_SCALE_BAND_MIN	(128*1024)	/* Minimum work for threading */
+
+typedef struct ag_scale_band {
+	const AG_Surface *ss;		/* Source surface */
+	AG_Surface *ds;			/* Destination surface */
+	enum ag_scale_filter filter;
+	int sameFormat;			/* Formats are identical */
+	const Uint32 *xs;		/* Source column table (dw+1 entries) */
+	const Uint32 *xf;		/* Bilinear weights (dw entries) */
+	Uint y1, y2;			/* Destination rows [y1,y2) */
+	Uint32 *buf;			/* Scratch row */
+} AG_ScaleBand;
+
+/* Linear interpolation of the four 8-bit channels of a and b (w in 0..255). */
+static __inline__ Uint32
+Lerp8888(Uint32 a, Uint32 b, Uint32 w)
+{
+	Uint32 wa = 256 - w;
+
+	return (((((a & 0x00ff00ff)*wa + (b & 0x00ff00ff)*w) >> 8) & 0x00ff00ff) |
+	        ((((a >> 8) & 0x00ff00ff)*wa + ((b >> 8) & 0x00ff00ff)*w) &
+		 0xff00ff00));
+}
+
+/* Interpolate between two rows of packed 8888 pixels. */
+static void
+LerpRow8888(const Uint32 *a, const Uint32 *b, Uint32 *d, Uint n, Uint32 w)
+{
+	Uint i = 0;
+
+#ifdef SURFACE_SSE2
+	if (agCPU.ext & AG_EXT_SSE2) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i vw = _mm_set1_epi16((short)(w << 1));
+		__m128i va, vb, lo, hi;
+
+		/* a + ((b-a)*w >> 8), identical to Lerp8888(). */
+		for (; i+4 <= n; i += 4) {
+			va = _mm_loadu_si128((const __m128i *)&a[i]);
+			vb = _mm_loadu_si128((const __m128i *)&b[i]);
+			lo = _mm_unpacklo_epi8(va, zero);
+			hi = _mm_unpackhi_epi8(va, zero);
+			lo = _mm_add_epi16(lo, _mm_mulhi_epi16(_mm_slli_epi16(
+			    _mm_sub_epi16(_mm_unpacklo_epi8(vb,zero), lo), 7), vw));
+			hi = _mm_add_epi16(hi, _mm_mulhi_epi16(_mm_slli_epi16(
+			    _mm_sub_epi16(_mm_unpackhi_epi8(vb,zero), hi), 7), vw));
+			_mm_storeu_si128((__m128i *)&d[i], _mm_packus_epi16(lo,hi));
+		}
+	}
+#endif
+	for (; i < n; i++)
+		d[i] = Lerp8888(a[i], b[i], w);
+}
+
+/* Nearest-neighbour scaling of a band (any pixel format). */
+static void
+ScaleBandNearest(AG_ScaleBand *sb)
+{
+	const AG_Surface *ss = sb->ss;
+	AG_Surface *ds = sb->ds;
+	const Uint32 *xs = sb->xs;
+	Uint dw = ds->w, x, y;
+	int SBpp = ss->format->BytesPerPixel;
+	int DBpp = ds->format->BytesPerPixel;
+	int fast8888 = (IsPacked8888(ss->format) && IsPacked8888(ds->format));
+
+	for (y = sb->y1; y < sb->y2; y++) {
+		const Uint8 *pSrc = (const Uint8 *)ss->pixels +
+		    (y*ss->h/ds->h)*ss->pitch;
+		Uint8 *pDst = (Uint8 *)ds->pixels + y*ds->pitch;
+
+		if (fast8888) {
+			const Uint32 *s = (const Uint32 *)pSrc;
+			Uint32 *d = (Uint32 *)pDst;
+
+			if (sb->sameFormat) {
+				for (x = 0; x < dw; x++)
+					d[x] = s[xs[x]];
+			} else {
+				for (x = 0; x < dw; x++)
+					d[x] = Convert8888(s[xs[x]], ss->format,
+					    ds->format);
+			}
+			continue;
+		}
+		for (x = 0; x < dw; x++) {
+			Uint32 px;
+
+			px = AG_GET_PIXEL(ss, (Uint8 *)&pSrc[xs[x]*SBpp]);
+			if (!sb->sameFormat) {
+				px = AG_MapColorRGBA(ds->format,
+				    AG_GetColorRGBA(px, ss->format));
+			}
+			AG_SurfacePutPixel(ds, pDst, px);
+			pDst += DBpp;
+		}
+	}
+}
+
+/* Bilinear scaling of a band (packed 8888 formats only). */
+static void
+ScaleBandBilinear(AG_ScaleBand *sb)
+{
+	const AG_Surface *ss = sb->ss;
+	AG_Surface *ds = sb->ds;
+	const Uint32 *xs = sb->xs, *xf = sb->xf;
+	Uint32 stepY = ((Uint32)ss->h << 16) / ds->h;
+	Uint dw = ds->w, x, y;
+
+	for (y = sb->y1; y < sb->y2; y++) {
+		Uint32 pos = y*stepY + (stepY >> 1), y0, fy;
+		const Uint32 *s;
+		Uint32 *d = (Uint32 *)((Uint8 *)ds->pixels + y*ds->pitch);
+		Uint32 px;
+
+		pos = (pos >= 0x8000) ? pos - 0x8000 : 0;
+		if ((y0 = pos >> 16) >= ss->h-1) {
+			y0 = ss->h-1;
+			fy = 0;
+		} else {
+			fy = (pos >> 8) & 0xff;
+		}
+		s = (const Uint32 *)((const Uint8 *)ss->pixels + y0*ss->pitch);
+		if (fy != 0) {
+			LerpRow8888(s, (const Uint32 *)((const Uint8 *)s +
+			    ss->pitch), sb->buf, ss->w, fy);
+			s = sb->buf;
+		}
+		for (x = 0; x < dw; x++) {
+			px = (xf[x] != 0) ? Lerp8888(s[xs[x]], s[xs[x]+1], xf[x]) :
+			                    s[xs[x]];
+			d[x] = (sb->sameFormat) ? px :
+			    Convert8888(px, ss->format, ds->format);
+		}
+	}
+}
+
+/* Box (area-averaging) scaling of a band (packed 8888 formats only). */
+static void
+ScaleBandBox(AG_ScaleBand *sb)
+{
+	const AG_Surface *ss = sb->ss;
+	AG_Surface *ds = sb->ds;
+	const Uint32 *xs = sb->xs;
+	Uint32 *acc = sb->buf;
+	Uint dw = ds->w, x, y, sy, sx, sy1, sy2;
+	Uint maxRows = 0x1000000 / (ss->w/dw + 1);  /* Keep 32-bit sums */
+
+	for (y = sb->y1; y < sb->y2; y++) {
+		Uint32 *d = (Uint32 *)((Uint8 *)ds->pixels + y*ds->pitch);
+
+		sy1 = y*ss->h/ds->h;
+		sy2 = (y+1)*ss->h/ds->h;
+		if (sy2 <= sy1) { sy2 = sy1+1; }
+		if (sy2 - sy1 > maxRows) { sy2 = sy1 + maxRows; }
+
+		memset(acc, 0, dw*4*sizeof(Uint32));
+		for (sy = sy1; sy < sy2; sy++) {
+			const Uint32 *s = (const Uint32 *)((const Uint8 *)
+			    ss->pixels + sy*ss->pitch);
+			Uint32 *a = acc;
+
+			for (x = 0; x < dw; x++, a += 4) {
+				Uint sx2 = (xs[x+1] > xs[x]) ? xs[x+1] : xs[x]+1;
+
+				for (sx = xs[x]; sx < sx2; sx++) {
+					Uint32 px = s[sx];
+
+					a[0] += px & 0xff;
+					a[1] += (px >> 8) & 0xff;
+					a[2] += (px >> 16) & 0xff;
+					a[3] += px >> 24;
+				}
+			}
+		}
+		for (x = 0; x < dw; x++) {
+			Uint32 *a = &acc[x*4], px;
+			Uint32 n = ((xs[x+1] > xs[x]) ? xs[x+1]-xs[x] : 1) *
+			           (sy2 - sy1);
+			Uint32 h = n >> 1;
+
+			px = ((a[0]+h)/n) | ((a[1]+h)/n) << 8 |
+			     ((a[2]+h)/n) << 16 | ((a[3]+h)/n) << 24;
+			d[x] = (sb->sameFormat) ? px :
+			    Convert8888(px, ss->format, ds->format);
+		}
+	}
+}
+
+static void
+ScaleBand(AG_ScaleBand *sb)
+{
+	switch (sb->filter) {
+	case AG_SCALE_BILINEAR:
+		ScaleBandBilinear(sb);
+		break;
+	case AG_SCALE_BOX:
+		ScaleBandBox(sb);
+		break;
+	default:
+		ScaleBandNearest(sb);
+		break;
+	}
+}
+
+#ifdef AG_THREADS
+static void *
+ScaleBandThread(void *p)
+{
+	ScaleBand((AG_ScaleBand *)p);
+	return (NULL);
+}
+#endif
+
+/*
+ * Allocate a new surface containing a pixmap of ss scaled to wxh, using
+ * nearest-neighbour sampling.
  */
 int
 AG_ScaleSurface(const AG_Surface *ss, Uint16 w, Uint16 h, AG_Surface **ds)
 {
-	Uint8 *pDst;
-	int x, y;
+	return AG_ScaleSurfaceFiltered(ss, w, h, AG_SCALE_NEAREST, ds);
+}
+
+/*
+ * Scale ss to wxh into *ds (allocating a new surface if *ds is NULL),
+ * using the given filter. Filtering is done on packed 32-bit surfaces
+ * without a colorkey; other surfaces are scaled with AG_SCALE_NEAREST.
+ */
+int
+AG_ScaleSurfaceFiltered(const AG_Surface *ss, Uint16 w, Uint16 h,
+    enum ag_scale_filter filter, AG_Surface **ds)
+{
+	AG_ScaleBand sb[AG_SCALE_BANDS_MAX];
+	Uint32 *tab, *xs, *xf = NULL, *buf = NULL;
+	Uint sw = ss->w, sh = ss->h, dw, dh, x, i, nBands = 1, bufLen = 0;
 	int sameFormat;
 
 	if (*ds == NULL) {
@@ -806,35 +1300,106 @@ AG_ScaleSurface(const AG_Surface *ss, Uint16 w, Uint16 h, AG_Surface **ds)
 		(*ds)->format->colorkey = ss->format->colorkey;
 		sameFormat = 1;
 	} else {
-		//sameFormat = !AG_PixelFormatCompare((*ds)->format, ss->format);
-		sameFormat = 0;
+		sameFormat = !AG_PixelFormatCompare((*ds)->format, ss->format);
 	}
 
 	if (ss->w == w && ss->h == h) {
 		AG_SurfaceCopy(*ds, ss);
 		return (0);
 	}
+	dw = (*ds)->w;
+	dh = (*ds)->h;
+	if (dw == 0 || dh == 0 || sw == 0 || sh == 0)
+		return (0);
 
-	pDst = (Uint8 *)(*ds)->pixels;
-	for (y = 0; y < (*ds)->h; y++) {
-		for (x = 0; x < (*ds)->w; x++) {
-			Uint8 *pSrc = (Uint8 *)ss->pixels +
-			    (y*ss->h/(*ds)->h)*ss->pitch +
-			    (x*ss->w/(*ds)->w)*ss->format->BytesPerPixel;
-			Uint32 pxSrc, pxDst;
-			AG_Color C;
+	if (filter != AG_SCALE_NEAREST &&
+	    (!IsPacked8888(ss->format) || !IsPacked8888((*ds)->format) ||
+	     (ss->flags & AG_SRCCOLORKEY))) {
+		filter = AG_SCALE_NEAREST;
+	}
+	if (filter == AG_SCALE_BOX && dw >= sw && dh >= sh)
+		filter = AG_SCALE_NEAREST;		/* Same result */
+
+	if ((tab = TryMalloc((dw*2 + 1)*sizeof(Uint32))) == NULL) {
+		return (-1);
+	}
+	xs = &tab[0];
+	if (filter == AG_SCALE_BILINEAR) {
+		Uint32 stepX = ((Uint32)sw << 16) / dw, pos;
+
+		xf = &tab[dw+1];
+		for (x = 0; x < dw; x++) {
+			pos = x*stepX + (stepX >> 1);
+			pos = (pos >= 0x8000) ? pos - 0x8000 : 0;
+			if ((xs[x] = pos >> 16) >= sw-1) {
+				xs[x] = sw-1;
+				xf[x] = 0;
+			} else {
+				xf[x] = (pos >> 8) & 0xff;
+			}
+		}
+		bufLen = sw;
+	} else {
+		Uint32 q = 0, r = 0;
+
+		/* xs[x] = x*sw/dw, for x in [0,dw] */
+		for (x = 0; x <= dw; x++) {
+			xs[x] = q;
+			for (r += sw; r >= dw; r -= dw)
+				q++;
+		}
+		if (filter == AG_SCALE_BOX)
+			bufLen = dw*4;
+	}
 
-			pxSrc = AG_GET_PIXEL(ss,pSrc);
-			if (sameFormat) {
-				pxDst = pxSrc;
+#ifdef AG_THREADS
+	if (agCPU.nCPUs > 1 &&
+	    dw*dh + (filter == AG_SCALE_BOX ? sw*sh : 0) >= AG_SCALE_BAND_MIN) {
+		nBands = MIN((Uint)agCPU.nCPUs, AG_SCALE_BANDS_MAX);
+		nBands = MIN(nBands, dh);
+	}
+#endif
+	if (bufLen > 0 &&
+	    (buf = TryMalloc(nBands*bufLen*sizeof(Uint32))) == NULL) {
+		Free(tab);
+		return (-1);
+	}
+	(*ds)->gen = AG_AtomicIncUint(&agSurfaceGen);
+	for (i = 0; i < nBands; i++) {
+		sb[i].ss = ss;
+		sb[i].ds = *ds;
+		sb[i].filter = filter;
+		sb[i].sameFormat = sameFormat;
+		sb[i].xs = xs;
+		sb[i].xf = xf;
+		sb[i].y1 = dh*i/nBands;
+		sb[i].y2 = dh*(i+1)/nBands;
+		sb[i].buf = (buf != NULL) ? &buf[i*bufLen] : NULL;
+	}
+#ifdef AG_THREADS
+	if (nBands > 1) {
+		AG_Thread th[AG_SCALE_BANDS_MAX];
+		int started[AG_SCALE_BANDS_MAX];
+
+		for (i = 1; i < nBands; i++) {
+			started[i] = (AG_ThreadTryCreate(&th[i], ScaleBandThread,
+			                                 &sb[i]) == 0);
+		}
+		ScaleBand(&sb[0]);
+		for (i = 1; i < nBands; i++) {
+			if (started[i]) {
+				AG_ThreadJoin(th[i], NULL);
 			} else {
-				C = AG_GetColorRGBA(pxSrc, ss->format);
-				pxDst = AG_MapColorRGBA((*ds)->format, C);
+				ScaleBand(&sb[i]);
 			}
-			AG_SurfacePutPixel((*ds), pDst, pxDst);
-			pDst += (*ds)->format->BytesPerPixel;
 		}
+	} else
+#endif
+	{
+		ScaleBand(&sb[0]);
 	}
+	Free(buf);
+	Free(tab);
 	return (0);
 }
 
@@ -846,6 +1411,8 @@ AG_SetAlphaPixels(AG_Surface *su, Uint8 alpha)
 	int x, y;
 	AG_Color C;
 
+	su->gen = AG_AtomicIncUint(&agSurfaceGen);
+
 	for (y = 0; y < su->h; y++) {
 		for (x = 0; x < su->w; x++) {
 			/* XXX unnecessary conversion */
@@ -877,9 +1444,27 @@ AG_FillRect(AG_Surface *su, const AG_Rect *rDst, AG_Color C)
 	} else {
 		r = su->clipRect;
 	}
+	if (r.w <= 0 || r.h <= 0)
+		return;
+
+	su->gen = AG_AtomicIncUint(&agSurfaceGen);
+
 	px = AG_MapColorRGBA(su->format, C);
 
-	/* XXX TODO optimize */
+	switch (su->format->BytesPerPixel) {
+	case 4:
+		for (y = 0; y < r.h; y++) {
+			FillRow32((Uint32 *)((Uint8 *)su->pixels +
+			    (r.y+y)*su->pitch + r.x*4), px, r.w);
+		}
+		return;
+	case 1:
+		for (y = 0; y < r.h; y++) {
+			memset((Uint8 *)su->pixels + (r.y+y)*su->pitch + r.x,
+			    (int)px, r.w);
+		}
+		return;
+	}
 	for (y = 0; y < r.h; y++) {
 		for (x = 0; x < r.w; x++) {
 			AG_PUT_PIXEL2(su,
@@ -47,6 +47,7 @@ typedef struct ag_surface {
 	void *pixels;			/* Raw pixel data */
 	AG_Rect clipRect;		/* Clipping rect for blit as dst */
 	Uint padding;			/* Scanline end padding in bytes */
+	Uint gen;			/* Generation (see AG_SurfaceTouch()) */
 } AG_Surface;
 
 typedef enum ag_blend_func {
@@ -69,6 +70,13 @@ typedef enum ag_blend_func {
 #define AG_ALPHA_TRANSPARENT	0		/* Transparent alpha value */
 #define AG_ALPHA_OPAQUE		255		/* Opaque alpha value */
 
+/* Filters for AG_ScaleSurfaceFiltered() */
+enum ag_scale_filter {
+	AG_SCALE_NEAREST,		/* Nearest-neighbour sampling */
+	AG_SCALE_BILINEAR,		/* Bilinear interpolation */
+	AG_SCALE_BOX			/* Box filter (area averaging) */
+};
+
 /* Flags for AG_SurfaceExportPNG() */
 #define AG_EXPORT_PNG_ADAM7	0x01		/* Enable Adam7 interlacing */
 
@@ -110,6 +118,7 @@ void            AG_SurfaceBlit(const AG_Surface *, const AG_Rect *,
                                AG_Surface *, int, int);
 int             AG_SurfaceResize(AG_Surface *, Uint, Uint);
 void            AG_SurfaceFree(AG_Surface *);
+void            AG_SurfaceTouch(AG_Surface *);
 
 AG_Surface     *AG_SurfaceFromFile(const char *);
 int             AG_SurfaceExportFile(const AG_Surface *, const char *);
@@ -133,6 +142,8 @@ void   AG_SurfaceBlendPixel(AG_Surface *, Uint8 *, AG_Color, AG_BlendFn);
 void   AG_RGB2HSV(Uint8, Uint8, Uint8, float *, float *, float *);
 void   AG_HSV2RGB(float, float, float, Uint8 *, Uint8 *, Uint8 *);
 int    AG_ScaleSurface(const AG_Surface *, Uint16, Uint16, AG_Surface **);
+int    AG_ScaleSurfaceFiltered(const AG_Surface *, Uint16, Uint16,
+                               enum ag_scale_filter, AG_Surface **);
 void   AG_SetAlphaPixels(AG_Surface *, Uint8);
 void   AG_FillRect(AG_Surface *, const AG_Rect *, AG_Color);
 Uint32 AG_MapPixelIndexedRGB(const AG_PixelFormat *, Uint8, Uint8, Uint8);
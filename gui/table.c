@@ -28,6 +28,7 @@
 #include <agar/gui/primitive.h>
 #include <agar/gui/cursors.h>
 #include <agar/gui/keyboard.h>
+#include <agar/gui/sort_keys.h>
 
 #include <string.h>
 #include <stdarg.h>
@@ -543,6 +544,199 @@ blit:
 	    rd->y + t->hRow/2 - WSURFACE(t,c->surface)->h/2);
 }
 
+#define VCELL_HASH(t,row,col) (((row)*31 + (Uint)(col)) & ((t)->nVHash-1))
+
+/* Virtual mode: return the model row displayed at row m. */
+static __inline__ Uint
+ModelRow(const AG_Table *t, int m)
+{
+	return (t->perm != NULL) ? t->perm[m] : (Uint)m;
+}
+
+/* Virtual mode: test whether the given model row is selected. */
+static __inline__ int
+VirtualRowSelected(const AG_Table *t, Uint row)
+{
+	return (row < t->nSelRows*8 &&
+	        (t->selRows[row >> 3] & (1 << (row & 7))));
+}
+
+/* Virtual mode: obtain the cell at displayed row m from the model. */
+static __inline__ void
+GetModelCell(AG_Table *t, int m, int n, AG_TableCell *c)
+{
+	AG_TableInitCell(t, c);
+	t->model->getCell(t->modelArg, ModelRow(t,m), n, c);
+}
+
+/* Virtual mode: discard all cached cell surfaces. */
+static void
+FlushVirtualCells(AG_Table *t)
+{
+	AG_TableVCell *vc, *vcNext;
+
+	for (vc = TAILQ_FIRST(&t->vLRU);
+	     vc != TAILQ_END(&t->vLRU);
+	     vc = vcNext) {
+		vcNext = TAILQ_NEXT(vc, lru);
+		if (vc->surface != -1) {
+			AG_WidgetUnmapSurface(t, vc->surface);
+		}
+		Free(vc);
+	}
+	TAILQ_INIT(&t->vLRU);
+	if (t->nVHash > 0) {
+		memset(t->vHash, 0, t->nVHash*sizeof(AG_TableVCell *));
+	}
+	t->nVCells = 0;
+}
+
+/*
+ * Virtual mode: size the cell surface cache to hold about two viewports
+ * worth of cells, and flush it if a redraw of the cells was requested.
+ */
+static void
+PrepareVirtualCells(AG_Table *t)
+{
+	Uint nMax = MAX(64, 2*(t->mVis+1)*t->n);
+
+	if (t->flags & AG_TABLE_REDRAW_CELLS) {
+		FlushVirtualCells(t);
+	}
+	if (nMax > t->nVCellsMax) {
+		Uint nHash = 64;
+
+		while (nHash < nMax) {
+			nHash <<= 1;
+		}
+		if (nHash != t->nVHash) {
+			FlushVirtualCells(t);
+			t->vHash = Realloc(t->vHash,
+			    nHash*sizeof(AG_TableVCell *));
+			memset(t->vHash, 0, nHash*sizeof(AG_TableVCell *));
+			t->nVHash = nHash;
+		}
+		t->nVCellsMax = nMax;
+	}
+}
+
+/* Virtual mode: render a cell obtained from the model. */
+static AG_Surface *
+RenderModelCell(AG_TableCell *c, const AG_Rect *rd, int *nodup)
+{
+	char txt[AG_TABLE_TXT_MAX];
+
+	switch (c->type) {
+	case AG_CELL_STRING:
+		return AG_TextRender(c->data.s);
+	case AG_CELL_PSTRING:
+		return AG_TextRender((char *)c->data.p);
+	case AG_CELL_FN_SU:
+		return c->fnSu(c->data.p, rd->x, rd->y);
+	case AG_CELL_FN_SU_NODUP:
+		*nodup = 1;
+		return c->fnSu(c->data.p, rd->x, rd->y);
+	case AG_CELL_WIDGET:			/* Unsupported in virtual mode */
+		return (NULL);
+	case AG_CELL_NULL:
+		return (c->fmt[0] != '\0') ? AG_TextRender(c->fmt) : NULL;
+	default:
+		AG_TablePrintCell(c, txt, sizeof(txt));
+		return AG_TextRender(txt);
+	}
+}
+
+/*
+ * Virtual mode: draw the cell at displayed row m and column n. Rendered
+ * cells are cached by model row; on a miss with a full cache, the least
+ * recently drawn entry is recycled along with its surface mapping.
+ */
+static void
+DrawVirtualCell(AG_Table *t, int m, int n, AG_Rect *rd)
+{
+	AG_TableCell c;
+	AG_TableVCell *vc, **pvc;
+	AG_Surface *su;
+	Uint row = ModelRow(t, m);
+	Uint h = VCELL_HASH(t, row, n);
+	int nodup = 0;
+
+	for (vc = t->vHash[h]; vc != NULL; vc = vc->hnext) {
+		if (vc->row == row && vc->col == n) {
+			TAILQ_REMOVE(&t->vLRU, vc, lru);
+			TAILQ_INSERT_HEAD(&t->vLRU, vc, lru);
+			goto blit;
+		}
+	}
+
+	GetModelCell(t, m, n, &c);
+	su = RenderModelCell(&c, rd, &nodup);
+
+	if (t->nVCells >= t->nVCellsMax &&
+	    (vc = TAILQ_LAST(&t->vLRU, ag_table_vcellq)) != NULL) {
+		TAILQ_REMOVE(&t->vLRU, vc, lru);
+		pvc = &t->vHash[VCELL_HASH(t, vc->row, vc->col)];
+		while (*pvc != vc) {
+			pvc = &(*pvc)->hnext;
+		}
+		*pvc = vc->hnext;
+	} else {
+		vc = Malloc(sizeof(AG_TableVCell));
+		vc->surface = -1;
+		t->nVCells++;
+	}
+	if (vc->surface == -1) {
+		if (su != NULL) {
+			vc->surface = nodup ? AG_WidgetMapSurfaceNODUP(t, su) :
+			                      AG_WidgetMapSurface(t, su);
+		}
+	} else {
+		if (nodup) {
+			AG_WidgetReplaceSurfaceNODUP(t, vc->surface, su);
+		} else {
+			AG_WidgetReplaceSurface(t, vc->surface, su);
+		}
+	}
+	vc->row = row;
+	vc->col = n;
+	vc->hnext = t->vHash[h];
+	t->vHash[h] = vc;
+	TAILQ_INSERT_HEAD(&t->vLRU, vc, lru);
+blit:
+	if (vc->surface != -1 && (su = WSURFACE(t,vc->surface)) != NULL)
+		AG_WidgetBlitSurface(t, vc->surface,
+		    rd->x,
+		    rd->y + t->hRow/2 - su->h/2);
+}
+
+/*
+ * Return the first (or last) selected row, or -1. In virtual mode, the
+ * last row selected is tried before scanning.
+ */
+static int
+FindSelectedRow(AG_Table *t, int last)
+{
+	int m;
+
+	if ((t->flags & AG_TABLE_VIRTUAL) &&
+	    t->mSelLast >= 0 && t->mSelLast < t->m &&
+	    AG_TableRowSelected(t, t->mSelLast)) {
+		return (t->mSelLast);
+	}
+	if (last) {
+		for (m = t->m-1; m >= 0; m--) {
+			if (AG_TableRowSelected(t,m))
+				return (m);
+		}
+	} else {
+		for (m = 0; m < t->m; m++) {
+			if (AG_TableRowSelected(t,m))
+				return (m);
+		}
+	}
+	return (-1);
+}
+
 static void
 ScrollToSelection(AG_Table *t)
 {
@@ -551,6 +745,14 @@ ScrollToSelection(AG_Table *t)
 	if (t->n < 1) {
 		return;
 	}
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		if ((m = FindSelectedRow(t, 0)) != -1) {
+			t->mOffs = (t->mOffs > m) ? m :
+			    MAX(0, m - t->mVis + 2);
+			AG_Redraw(t);
+		}
+		return;
+	}
 	for (m = 0; m < t->m; m++) {
 		if (!t->cells[m][0].selected) {
 			continue;
@@ -590,7 +792,14 @@ SelectionVisible(AG_Table *t)
 {
 	int n, m;
 	int x, y;
-	
+
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		for (m = t->mOffs; m < MIN(t->m, t->mOffs+t->mVis-1); m++) {
+			if (VirtualRowSelected(t, ModelRow(t,m)))
+				return (1);
+		}
+		return (0);
+	}
 	for (n = 0, x = -t->xOffs;
 	     n < t->n && x < t->r.w;
 	     n++) {
@@ -634,6 +843,9 @@ Draw(void *obj)
 	    t->flags & AG_TABLE_NEEDSORT)
 		AG_TableSort(t);
 
+	if (t->flags & AG_TABLE_VIRTUAL)
+		PrepareVirtualCells(t);
+
 	rCol.y = 0;
 	rCol.h = t->hCol + t->r.h - 2;
 	rCell.h = t->hRow;
@@ -700,14 +912,22 @@ Draw(void *obj)
 		for (m = t->mOffs, rCell.y = t->hCol;
 		     m < t->m && (rCell.y < rCol.h);
 		     m++) {
-			AG_TableCell *c = &t->cells[m][n];
-
 			AG_DrawLineH(t, 0, t->r.w, rCell.y, WCOLOR(t,LINE_COLOR));
 
-			DrawCell(t, c, &rCell);
-			if (c->selected) {
-				AG_DrawRectBlended(t, rCell, t->selColor,
-				    AG_ALPHA_SRC);
+			if (t->flags & AG_TABLE_VIRTUAL) {
+				DrawVirtualCell(t, m, n, &rCell);
+				if (VirtualRowSelected(t, ModelRow(t,m))) {
+					AG_DrawRectBlended(t, rCell,
+					    t->selColor, AG_ALPHA_SRC);
+				}
+			} else {
+				AG_TableCell *c = &t->cells[m][n];
+
+				DrawCell(t, c, &rCell);
+				if (c->selected) {
+					AG_DrawRectBlended(t, rCell,
+					    t->selColor, AG_ALPHA_SRC);
+				}
 			}
 			rCell.y += t->hRow;
 		}
@@ -863,33 +1083,142 @@ HashPrevCell(AG_Table *t, const AG_TableCell *c)
 	return (h % t->nPrevBuckets);
 }
 
+/* Return a row array of t->n cells, recycled if possible. */
+static AG_TableCell *
+AllocRow(AG_Table *t)
+{
+	if (t->nRowsFree > 0) {
+		return (t->rowsFree[--t->nRowsFree]);
+	}
+	return TryMalloc(MAX(1,t->n)*sizeof(AG_TableCell));
+}
+
+/* Release a row array whose surfaces have been unmapped. */
+static void
+RecycleRow(AG_Table *t, AG_TableCell *row)
+{
+	if (t->nRowsFree == t->nRowsFreeMax) {
+		int maxNew = (t->nRowsFreeMax > 0) ? t->nRowsFreeMax*2 : 64;
+		AG_TableCell **rowsNew;
+
+		if ((rowsNew = TryRealloc(t->rowsFree,
+		    maxNew*sizeof(AG_TableCell *))) == NULL) {
+			Free(row);
+			return;
+		}
+		t->rowsFree = rowsNew;
+		t->nRowsFreeMax = maxNew;
+	}
+	t->rowsFree[t->nRowsFree++] = row;
+}
+
+/* Free the recycled row arrays (they are invalid once columns change). */
+static void
+FreeRecycledRows(AG_Table *t)
+{
+	int i;
+
+	for (i = 0; i < t->nRowsFree; i++) {
+		Free(t->rowsFree[i]);
+	}
+	t->nRowsFree = 0;
+}
+
+/* Index the saved rows which have a row ID. */
+static void
+HashPrevRows(AG_Table *t, int nKeyed)
+{
+	Uint n = 64, h;
+	int m;
+
+	while (n < (Uint)nKeyed*2) {
+		n <<= 1;
+	}
+	if (n > t->nRowHash) {
+		Free(t->rowHash);
+		t->rowHash = Malloc(n*sizeof(Uint));
+		t->nRowHash = n;
+	}
+	memset(t->rowHash, 0, t->nRowHash*sizeof(Uint));
+
+	for (m = 0; m < t->mPrev; m++) {
+		AG_TableCell *row = t->cPrevRows[m];
+
+		if (row[0].rowID == 0) {
+			continue;
+		}
+		h = (row[0].rowID*2654435761U) & (t->nRowHash-1);
+		while (t->rowHash[h] != 0) {
+			h = (h+1) & (t->nRowHash-1);
+		}
+		t->rowHash[h] = m+1;
+	}
+}
+
+/* Return the index of the unclaimed saved row with the given ID or -1. */
+static int
+FindPrevRow(AG_Table *t, Uint id)
+{
+	Uint h;
+
+	if (t->nRowHash == 0) {
+		return (-1);
+	}
+	for (h = (id*2654435761U) & (t->nRowHash-1);
+	     t->rowHash[h] != 0;
+	     h = (h+1) & (t->nRowHash-1)) {
+		AG_TableCell *row = t->cPrevRows[t->rowHash[h]-1];
+
+		if (row != NULL && row[0].rowID == id)
+			return (t->rowHash[h]-1);
+	}
+	return (-1);
+}
+
 /*
  * Clear the items on the table and save the selection state. The function
  * returns with the table locked.
+ *
+ * The row arrays are kept until AG_TableEnd(). Rows added with a row ID
+ * are matched by ID and updated in place; the cells of other rows are
+ * linked into the value hash and matched by contents.
  */
 void
 AG_TableBegin(AG_Table *t)
 {
-	int m, n;
+	int m, n, nKeyed = 0;
 
 	AG_ObjectLock(t);		/* Lock across TableBegin/End */
 
-	/* Copy the existing cells to the backing store and free the table. */
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		return;
+	}
+	if (t->m > t->mPrevMax) {
+		t->cPrevRows = Realloc(t->cPrevRows,
+		    t->m*sizeof(AG_TableCell *));
+		t->mPrevMax = t->m;
+	}
 	for (m = 0; m < t->m; m++) {
+		AG_TableCell *row = t->cells[m];
+
+		t->cPrevRows[m] = row;
+		if (t->n > 0 && row[0].rowID != 0) {
+			nKeyed++;
+			continue;
+		}
 		for (n = 0; n < t->n; n++) {
-			AG_TableCell *c = &t->cells[m][n], *cPrev;
+			AG_TableCell *c = &row[n];
 			AG_TableBucket *tbPrev = &t->cPrev[HashPrevCell(t,c)];
 
-			cPrev = Malloc(sizeof(AG_TableCell));
-			memcpy(cPrev, c, sizeof(AG_TableCell));
-			cPrev->nPrev = n;
-			TAILQ_INSERT_HEAD(&tbPrev->cells, cPrev, cells);
-			TAILQ_INSERT_HEAD(&t->cPrevList, cPrev, cells_list);
+			c->nPrev = n;
+			TAILQ_INSERT_HEAD(&tbPrev->cells, c, cells);
 		}
-		Free(t->cells[m]);
 	}
-	Free(t->cells);
-	t->cells = NULL;
+	t->mPrev = t->m;
+	t->nPrev = t->n;
+	if (nKeyed > 0) {
+		HashPrevRows(t, nKeyed);
+	}
 	t->m = 0;
 	t->flags &= ~(AG_TABLE_WIDGETS);
 }
@@ -987,6 +1316,9 @@ TableRestoreRowSelections(AG_Table *t)
 	int nMatched, nCompared;
 
 	for (m = 0; m < t->m; m++) {
+		if (t->cells[m][0].rowID != 0) {
+			continue;			/* Updated in place */
+		}
 		nMatched = 0;
 		nCompared = 0;
 		for (n = 0; n < t->n; n++) {
@@ -994,7 +1326,7 @@ TableRestoreRowSelections(AG_Table *t)
 			AG_TableCell *cPrev;
 			AG_TableBucket *tb;
 
-			if (c->type == AG_CELL_NULL) {
+			if (c->type == AG_CELL_NULL || c->rowID != 0) {
 				continue;
 			}
 			tb = &t->cPrev[HashPrevCell(t,c)];
@@ -1034,7 +1366,7 @@ TableRestoreCellSelections(AG_Table *t)
 			AG_TableCell *cPrev;
 			AG_TableBucket *tb;
 			
-			if (c->type == AG_CELL_NULL) {
+			if (c->type == AG_CELL_NULL || c->rowID != 0) {
 				continue;
 			}
 			tb = &t->cPrev[HashPrevCell(t,c)];
@@ -1065,7 +1397,7 @@ TableRestoreColSelections(AG_Table *t)
 			AG_TableCell *cPrev;
 			AG_TableBucket *tb;
 			
-			if (c->type == AG_CELL_NULL) {
+			if (c->type == AG_CELL_NULL || c->rowID != 0) {
 				continue;
 			}
 			tb = &t->cPrev[HashPrevCell(t,c)];
@@ -1088,39 +1420,56 @@ TableRestoreColSelections(AG_Table *t)
 void
 AG_TableEnd(AG_Table *t)
 {
-	AG_TableCell *tc, *tcNext;
+	int m, n;
 
-	if (t->n == 0)
-		goto out;
-	
-	/* Recover surfaces and selection state from the backing store. */
-	switch (t->selMode) {
-	case AG_TABLE_SEL_ROWS:
-		TableRestoreRowSelections(t);
-		break;
-	case AG_TABLE_SEL_CELLS:
-		TableRestoreCellSelections(t);
-		break;
-	case AG_TABLE_SEL_COLS:
-		TableRestoreColSelections(t);
-		break;
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		AG_ObjectUnlock(t);
+		return;
+	}
+	if (t->n > 0) {
+		/* Recover surfaces and selection state from the backing store. */
+		switch (t->selMode) {
+		case AG_TABLE_SEL_ROWS:
+			TableRestoreRowSelections(t);
+			break;
+		case AG_TABLE_SEL_CELLS:
+			TableRestoreCellSelections(t);
+			break;
+		case AG_TABLE_SEL_COLS:
+			TableRestoreColSelections(t);
+			break;
+		}
 	}
 
-	/* Clear the backing store. */
-	for (tc = TAILQ_FIRST(&t->cPrevList);
-	     tc != TAILQ_END(&t->cPrevList);
-	     tc = tcNext) {
-		tcNext = TAILQ_NEXT(tc, cells_list);
-		if (tc->surface != -1) {
-			AG_WidgetUnmapSurface(t, tc->surface);
+	/*
+	 * Recycle the saved rows which were not reused. Columns may have been
+	 * added since AG_TableBegin(), in which case the saved rows are
+	 * narrower than t->n and cannot be recycled.
+	 */
+	for (m = 0; m < t->mPrev; m++) {
+		AG_TableCell *row = t->cPrevRows[m];
+
+		if (row == NULL) {
+			continue;
+		}
+		for (n = 0; n < t->nPrev; n++) {
+			if (row[n].surface != -1)
+				AG_WidgetUnmapSurface(t, row[n].surface);
+		}
+		if (t->nPrev == t->n) {
+			RecycleRow(t, row);
+		} else {
+			Free(row);
 		}
-		Free(tc);
 	}
-	TAILQ_INIT(&t->cPrevList);
+	t->mPrev = 0;
+	t->nPrev = 0;
 
 	/* It is safe to use memset() in place of TAILQ_INIT() in a loop. */
 	memset(t->cPrev, 0, t->nPrevBuckets*sizeof(AG_TableBucket));
-out:
+	if (t->nRowHash > 0)
+		memset(t->rowHash, 0, t->nRowHash*sizeof(Uint));
+
 	AG_ObjectUnlock(t);		/* Lock across TableBegin/End */
 }
 
@@ -1152,11 +1501,243 @@ AG_TableSortCellsDsc(const void *p1, const void *p2)
 	return AG_TableCompareCells(&row2[t->nSorting], &row1[t->nSorting]);
 }
 
+/* Virtual mode: compare two model rows by the sorting column. */
+static int
+CompareModelRows(AG_Table *t, Uint r1, Uint r2)
+{
+	AG_TableCol *tc = &t->cols[t->nSorting];
+	AG_TableCell c1, c2;
+
+	if (t->model->compareRows != NULL) {
+		return t->model->compareRows(t->modelArg, r1, r2, t->nSorting);
+	}
+	AG_TableInitCell(t, &c1);
+	AG_TableInitCell(t, &c2);
+	t->model->getCell(t->modelArg, r1, t->nSorting, &c1);
+	t->model->getCell(t->modelArg, r2, t->nSorting, &c2);
+	if (tc->sortFn) {
+		return tc->sortFn(&c1, &c2);
+	}
+	return AG_TableCompareCells(&c1, &c2);
+}
+
+/*
+ * Virtual mode: sort the row permutation (stable bottom-up merge sort).
+ * The model itself is never reordered.
+ */
+static void
+SortModelRows(AG_Table *t, int dsc)
+{
+	Uint m = (Uint)t->m, w, i;
+	Uint *a, *b, *tmp;
+
+	if (t->perm == NULL) {
+		if ((t->perm = TryMalloc(m*sizeof(Uint))) == NULL) {
+			return;
+		}
+		for (i = 0; i < m; i++)
+			t->perm[i] = i;
+	}
+	if (m < 2 || (b = TryMalloc(m*sizeof(Uint))) == NULL) {
+		return;
+	}
+	a = t->perm;
+	for (w = 1; w < m; w *= 2) {
+		for (i = 0; i < m; i += 2*w) {
+			Uint p = i, pEnd = MIN(i+w, m);
+			Uint q = pEnd, qEnd = MIN(i+2*w, m);
+			Uint k = i;
+
+			while (p < pEnd && q < qEnd) {
+				int cmp = CompareModelRows(t, a[q], a[p]);
+
+				if (dsc) { cmp = -cmp; }
+				b[k++] = (cmp < 0) ? a[q++] : a[p++];
+			}
+			while (p < pEnd) { b[k++] = a[p++]; }
+			while (q < qEnd) { b[k++] = a[q++]; }
+		}
+		tmp = a;
+		a = b;
+		b = tmp;
+	}
+	if (a != t->perm) {
+		memcpy(t->perm, a, m*sizeof(Uint));
+		Free(a);
+	} else {
+		Free(b);
+	}
+	t->mSelLast = -1;
+}
+
+/* Add the sort key of a cell; return -1 if the cell type is unordered. */
+static int
+CellSortKey(AG_SortKeys *sk, const AG_TableCell *c, Uint idx)
+{
+	char txt[AG_TABLE_TXT_MAX];
+	AG_SortKeyNum k;
+
+	if (c->id != 0) {
+		return AG_SortKeysAddNum(sk, AG_SortKeyUint(c->id), idx);
+	}
+	switch (c->type) {
+	case AG_CELL_STRING:
+		return AG_SortKeysAddStr(sk, c->data.s, idx);
+	case AG_CELL_PSTRING:
+		return AG_SortKeysAddStr(sk, (char *)c->data.p, idx);
+	case AG_CELL_FN_TXT:
+		c->fnTxt(c->data.p, txt, sizeof(txt));
+		return AG_SortKeysAddStr(sk, txt, idx);
+	case AG_CELL_INT:
+		k = AG_SortKeyInt(c->data.i);
+		break;
+	case AG_CELL_UINT:
+		k = AG_SortKeyUint((Uint)c->data.i);
+		break;
+	case AG_CELL_LONG:
+		k = AG_SortKeyInt(c->data.l);
+		break;
+	case AG_CELL_ULONG:
+		k = AG_SortKeyUint((Ulong)c->data.l);
+		break;
+	case AG_CELL_FLOAT:
+	case AG_CELL_DOUBLE:
+		k = AG_SortKeyDouble(c->data.f);
+		break;
+#ifdef AG_HAVE_64BIT
+	case AG_CELL_INT64:
+		k = AG_SortKeySint64((Sint64)c->data.u64);
+		break;
+	case AG_CELL_UINT64:
+		k = c->data.u64;
+		break;
+	case AG_CELL_PINT64:
+		k = AG_SortKeySint64(*(Sint64 *)c->data.p);
+		break;
+	case AG_CELL_PUINT64:
+		k = *(Uint64 *)c->data.p;
+		break;
+#endif
+	case AG_CELL_PINT:
+		k = AG_SortKeyInt(*(int *)c->data.p);
+		break;
+	case AG_CELL_PUINT:
+		k = AG_SortKeyUint(*(Uint *)c->data.p);
+		break;
+	case AG_CELL_PLONG:
+		k = AG_SortKeyInt(*(long *)c->data.p);
+		break;
+	case AG_CELL_PULONG:
+		k = AG_SortKeyUint(*(Ulong *)c->data.p);
+		break;
+	case AG_CELL_PUINT8:
+		k = AG_SortKeyUint(*(Uint8 *)c->data.p);
+		break;
+	case AG_CELL_PSINT8:
+		k = AG_SortKeyInt(*(Sint8 *)c->data.p);
+		break;
+	case AG_CELL_PUINT16:
+		k = AG_SortKeyUint(*(Uint16 *)c->data.p);
+		break;
+	case AG_CELL_PSINT16:
+		k = AG_SortKeyInt(*(Sint16 *)c->data.p);
+		break;
+	case AG_CELL_PUINT32:
+		k = AG_SortKeyUint(*(Uint32 *)c->data.p);
+		break;
+	case AG_CELL_PSINT32:
+		k = AG_SortKeyInt(*(Sint32 *)c->data.p);
+		break;
+	case AG_CELL_PFLOAT:
+		k = AG_SortKeyDouble(*(float *)c->data.p);
+		break;
+	case AG_CELL_PDOUBLE:
+		k = AG_SortKeyDouble(*(double *)c->data.p);
+		break;
+	default:
+		return (-1);
+	}
+	return AG_SortKeysAddNum(sk, k, idx);
+}
+
+/*
+ * Sort the rows by keys extracted once per row from the sorting column
+ * (collation keys for text, order-preserving integers for numbers).
+ * Returns -1 if the column has a custom sortFn, mixed cell types or an
+ * unordered type, in which case the caller sorts by comparison.
+ */
+static int
+SortRowsByKeys(AG_Table *t, int dsc)
+{
+	AG_SortKeys sk;
+	AG_TableCell cFirst, cModel;
+	const AG_TableCell *c;
+	AG_TableCell **rows;
+	int n = t->nSorting;
+	Uint i, m = (Uint)t->m;
+	int rv = -1;
+
+	if (t->cols[n].sortFn != NULL || m < 2 ||
+	    ((t->flags & AG_TABLE_VIRTUAL) && t->model->compareRows != NULL))
+		return (-1);
+
+	AG_SortKeysInit(&sk, AG_SORT_KEYS_NUM);
+	for (i = 0; i < m; i++) {
+		if (t->flags & AG_TABLE_VIRTUAL) {
+			AG_TableInitCell(t, &cModel);
+			t->model->getCell(t->modelArg, i, n, &cModel);
+			c = &cModel;
+		} else {
+			c = &t->cells[i][n];
+		}
+		if (i == 0) {
+			cFirst = *c;
+			if (c->id == 0 &&
+			    (c->type == AG_CELL_STRING ||
+			     c->type == AG_CELL_PSTRING ||
+			     c->type == AG_CELL_FN_TXT))
+				sk.type = AG_SORT_KEYS_STR;
+		} else if (c->type != cFirst.type ||
+		    (c->id != 0) != (cFirst.id != 0) ||
+		    strcmp(c->fmt, cFirst.fmt) != 0) {
+			goto out;
+		}
+		if (CellSortKey(&sk, c, i) == -1)
+			goto out;
+	}
+	if (AG_SortKeysSort(&sk, dsc) == -1) {
+		goto out;
+	}
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		if (t->perm == NULL &&
+		    (t->perm = TryMalloc(m*sizeof(Uint))) == NULL) {
+			goto out;
+		}
+		for (i = 0; i < m; i++) {
+			t->perm[i] = sk.keys[i].idx;
+		}
+		t->mSelLast = -1;
+	} else {
+		if ((rows = TryMalloc(m*sizeof(AG_TableCell *))) == NULL) {
+			goto out;
+		}
+		for (i = 0; i < m; i++) {
+			rows[i] = t->cells[sk.keys[i].idx];
+		}
+		memcpy(t->cells, rows, m*sizeof(AG_TableCell *));
+		Free(rows);
+	}
+	rv = 0;
+out:
+	AG_SortKeysFree(&sk);
+	return (rv);
+}
+
 /* Sort the items in the table. */
 void
 AG_TableSort(AG_Table *t)
 {
-	int i;
+	int i, dsc;
 	int (*sortFn)(const void *, const void *) = NULL;
 
 	for (i = 0; i < t->n; i++) {
@@ -1174,10 +1755,112 @@ AG_TableSort(AG_Table *t)
 		return;
 	}
 	t->nSorting = i;
-	qsort(t->cells, t->m, sizeof(AG_TableCell *), sortFn);
+	dsc = (sortFn == AG_TableSortCellsDsc);
+	if (SortRowsByKeys(t, dsc) == -1) {
+		if (t->flags & AG_TABLE_VIRTUAL) {
+			SortModelRows(t, dsc);
+		} else {
+			qsort(t->cells, t->m, sizeof(AG_TableCell *), sortFn);
+		}
+	}
 	t->flags &= ~(AG_TABLE_NEEDSORT);
 }
 
+/*
+ * Switch the table to virtual mode, where rows are obtained on demand
+ * from the given data model, and only the visible cells are rendered.
+ * Any existing rows are discarded. A NULL model restores normal mode.
+ */
+void
+AG_TableSetModel(AG_Table *t, const AG_TableModel *model, void *p)
+{
+	int m, n;
+
+	AG_ObjectLock(t);
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		FlushVirtualCells(t);
+	} else {
+		for (m = 0; m < t->m; m++) {
+			for (n = 0; n < t->n; n++) {
+				AG_TableFreeCell(t, &t->cells[m][n]);
+			}
+			Free(t->cells[m]);
+		}
+		Free(t->cells);
+		t->cells = NULL;
+		t->mMax = 0;
+		t->flags &= ~(AG_TABLE_WIDGETS);
+	}
+	Free(t->perm);
+	t->perm = NULL;
+	Free(t->selRows);
+	t->selRows = NULL;
+	t->nSelRows = 0;
+	t->mSelLast = -1;
+	t->m = 0;
+	t->mOffs = 0;
+
+	if ((t->model = model) != NULL) {
+		t->modelArg = p;
+		t->flags |= AG_TABLE_VIRTUAL;
+		t->m = (int)model->rowCount(p);
+		t->flags |= AG_TABLE_NEEDSORT;
+	} else {
+		t->modelArg = NULL;
+		t->flags &= ~(AG_TABLE_VIRTUAL);
+	}
+	AG_ObjectUnlock(t);
+	AG_Redraw(t);
+}
+
+/*
+ * Notify a virtual table that the contents of its model have changed.
+ * The row count is updated, cached cells are discarded and the rows are
+ * sorted again. Row selections are preserved by model row.
+ */
+void
+AG_TableModelChanged(AG_Table *t)
+{
+	int m;
+
+	AG_ObjectLock(t);
+	if (!(t->flags & AG_TABLE_VIRTUAL)) {
+		goto out;
+	}
+	m = (int)t->model->rowCount(t->modelArg);
+	if (m != t->m) {
+		Free(t->perm);
+		t->perm = NULL;
+		if (t->nSelRows > (Uint)(m + 7)/8) {
+			memset(&t->selRows[(m + 7)/8], 0,
+			    t->nSelRows - (m + 7)/8);
+		}
+		if (m % 8 != 0 && (Uint)m/8 < t->nSelRows) {
+			t->selRows[m/8] &= (1 << (m % 8)) - 1;
+		}
+		t->m = m;
+		t->mSelLast = -1;
+		if (t->mOffs+t->mVis >= t->m)
+			t->mOffs = MAX(0, t->m - t->mVis);
+	}
+	t->flags |= (AG_TABLE_NEEDSORT|AG_TABLE_REDRAW_CELLS);
+out:
+	AG_ObjectUnlock(t);
+	AG_Redraw(t);
+}
+
+/* Return the model row displayed at row m of a virtual table. */
+Uint
+AG_TableModelRow(AG_Table *t, int m)
+{
+	Uint row;
+
+	AG_ObjectLock(t);
+	row = (t->flags & AG_TABLE_VIRTUAL) ? ModelRow(t,m) : (Uint)m;
+	AG_ObjectUnlock(t);
+	return (row);
+}
+
 /* Return true if multiple item selection is enabled. */
 static __inline__ int
 SelectingMultiple(AG_Table *t)
@@ -1337,6 +2020,7 @@ CellLeftClick(AG_Table *t, int mc, int x)
 {
 	AG_TableCell *c;
 	AG_TableCol *tc;
+	enum ag_table_selmode selMode = t->selMode;
 	int m, n, i, j, nc;
 	
 	for (nc = 0; nc < t->n; nc++) {
@@ -1347,14 +2031,13 @@ CellLeftClick(AG_Table *t, int mc, int x)
 	}
 	if (nc == t->n) { nc = t->n-1; }
 
-	switch (t->selMode) {
+	if ((t->flags & AG_TABLE_VIRTUAL) && selMode == AG_TABLE_SEL_CELLS)
+		selMode = AG_TABLE_SEL_ROWS;		/* No cell selections */
+
+	switch (selMode) {
 	case AG_TABLE_SEL_ROWS:
 		if (SelectingRange(t)) {
-			for (m = 0; m < t->m; m++) {
-				if (AG_TableRowSelected(t,m))
-					break;
-			}
-			if (m == t->m) {
+			if ((m = FindSelectedRow(t, 0)) == -1) {
 				break;
 			}
 			if (m < mc) {
@@ -1367,6 +2050,14 @@ CellLeftClick(AG_Table *t, int mc, int x)
 				AG_TableSelectRow(t, mc);
 			}
 		} else if (SelectingMultiple(t)) {
+			if (t->flags & AG_TABLE_VIRTUAL) {
+				if (AG_TableRowSelected(t, mc)) {
+					AG_TableDeselectRow(t, mc);
+				} else {
+					AG_TableSelectRow(t, mc);
+				}
+				break;
+			}
 			for (n = 0; n < t->n; n++) {
 				c = &t->cells[mc][n];
 				c->selected = !c->selected;
@@ -1587,14 +2278,9 @@ DecrementSelection(AG_Table *t, int inc)
 	if (t->m < 1) {
 		return;
 	}
-	for (m = 0; m < t->m; m++) {
-		if (AG_TableRowSelected(t,m)) {
-			m -= inc;
-			if (m < 0) { m = 0; }
-			break;
-		}
-	}
-	if (m < t->m) {
+	if ((m = FindSelectedRow(t, 0)) != -1) {
+		m -= inc;
+		if (m < 0) { m = 0; }
 		AG_TableDeselectAllRows(t);
 		AG_TableSelectRow(t, m);
 	} else {
@@ -1612,14 +2298,9 @@ IncrementSelection(AG_Table *t, int inc)
 	if (t->m < 1) {
 		return;
 	}
-	for (m = t->m-1; m >= 0; m--) {
-		if (AG_TableRowSelected(t,m)) {
-			m += inc;
-			if (m >= t->m) { m = t->m-1; }
-			break;
-		}
-	}
-	if (m >= 0) {
+	if ((m = FindSelectedRow(t, 1)) != -1) {
+		m += inc;
+		if (m >= t->m) { m = t->m-1; }
 		AG_TableDeselectAllRows(t);
 		AG_TableSelectRow(t, m);
 	} else {
@@ -1793,6 +2474,9 @@ OnFontChange(AG_Event *event)
 			AG_WidgetUnmapSurface(t, tc->surface);
 			tc->surface = -1;
 		}
+		if (t->flags & AG_TABLE_VIRTUAL) {
+			continue;
+		}
 		for (m = 0; m < t->m; m++) {
 			AG_TableCell *c = &t->cells[m][n];
 
@@ -1802,6 +2486,8 @@ OnFontChange(AG_Event *event)
 			}
 		}
 	}
+	if (t->flags & AG_TABLE_VIRTUAL)
+		FlushVirtualCells(t);
 }
 
 static void
@@ -1821,9 +2507,14 @@ AG_TableRowSelected(AG_Table *t, int m)
 	int n;
 
 	AG_ObjectLock(t);
-	if (m >= t->m) {
+	if (m < 0 || m >= t->m) {
 		goto out;
 	}
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		n = VirtualRowSelected(t, ModelRow(t,m));
+		AG_ObjectUnlock(t);
+		return (n);
+	}
 	for (n = 0; n < t->n; n++) {
 		if (t->cells[m][n].selected) {
 			AG_ObjectUnlock(t);
@@ -1841,11 +2532,28 @@ AG_TableSelectRow(AG_Table *t, int m)
 	int n;
 
 	AG_ObjectLock(t);
-	if (m < t->m) {
+	if (m < 0 || m >= t->m) {
+		goto out;
+	}
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		Uint row = ModelRow(t, m);
+
+		if (row >= t->nSelRows*8) {
+			Uint nSelRowsNew = (t->m + 7)/8;
+
+			t->selRows = Realloc(t->selRows, nSelRowsNew);
+			memset(&t->selRows[t->nSelRows], 0,
+			    nSelRowsNew - t->nSelRows);
+			t->nSelRows = nSelRowsNew;
+		}
+		t->selRows[row >> 3] |= (1 << (row & 7));
+		t->mSelLast = m;
+	} else {
 		for (n = 0; n < t->n; n++)
 			t->cells[m][n].selected = 1;
-		AG_PostEvent(NULL, t, "row-selected", "%i", m);
 	}
+	AG_PostEvent(NULL, t, "row-selected", "%i", m);
+out:
 	AG_ObjectUnlock(t);
 	AG_Redraw(t);
 }
@@ -1856,9 +2564,16 @@ AG_TableDeselectRow(AG_Table *t, int m)
 	int n;
 
 	AG_ObjectLock(t);
-	if (m < t->m) {
-		for (n = 0; n < t->n; n++)
-			t->cells[m][n].selected = 0;
+	if (m >= 0 && m < t->m) {
+		if (t->flags & AG_TABLE_VIRTUAL) {
+			Uint row = ModelRow(t, m);
+
+			if (row < t->nSelRows*8)
+				t->selRows[row >> 3] &= ~(1 << (row & 7));
+		} else {
+			for (n = 0; n < t->n; n++)
+				t->cells[m][n].selected = 0;
+		}
 	}
 	AG_ObjectUnlock(t);
 	AG_Redraw(t);
@@ -1870,10 +2585,28 @@ AG_TableSelectAllRows(AG_Table *t)
 	int m, n;
 
 	AG_ObjectLock(t);
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		Uint nSelRowsNew = (t->m + 7)/8;
+
+		if (nSelRowsNew > t->nSelRows) {
+			t->selRows = Realloc(t->selRows, nSelRowsNew);
+			t->nSelRows = nSelRowsNew;
+		}
+		/* Set the bits of rows [0, t->m) only. */
+		if (t->nSelRows > 0) {
+			memset(t->selRows, 0, t->nSelRows);
+			memset(t->selRows, 0xff, t->m/8);
+		}
+		if (t->m % 8 != 0) {
+			t->selRows[t->m/8] = (1 << (t->m % 8)) - 1;
+		}
+		goto out;
+	}
 	for (n = 0; n < t->n; n++) {
 		for (m = 0; m < t->m; m++)
 			t->cells[m][n].selected = 1;
 	}
+out:
 	AG_ObjectUnlock(t);
 	AG_Redraw(t);
 }
@@ -1884,10 +2617,18 @@ AG_TableDeselectAllRows(AG_Table *t)
 	int m, n;
 
 	AG_ObjectLock(t);
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		if (t->nSelRows > 0) {
+			memset(t->selRows, 0, t->nSelRows);
+		}
+		t->mSelLast = -1;
+		goto out;
+	}
 	for (n = 0; n < t->n; n++) {
 		for (m = 0; m < t->m; m++)
 			t->cells[m][n].selected = 0;
 	}
+out:
 	AG_ObjectUnlock(t);
 	AG_Redraw(t);
 }
@@ -1972,7 +2713,7 @@ AG_TableAddCol(AG_Table *t, const char *name, const char *size_spec,
 	}
 
 	/* Resize the row arrays. */
-	for (m = 0; m < t->m; m++) {
+	for (m = 0; m < t->m && !(t->flags & AG_TABLE_VIRTUAL); m++) {
 		AG_TableCell *cNew;
 
 		if ((cNew = TryRealloc(t->cells[m],
@@ -1981,7 +2722,10 @@ AG_TableAddCol(AG_Table *t, const char *name, const char *size_spec,
 		}
 		t->cells[m] = cNew;
 		AG_TableInitCell(t, &t->cells[m][t->n]);
+		if (t->n > 0)
+			cNew[t->n].rowID = cNew[0].rowID;
 	}
+	FreeRecycledRows(t);
 	n = t->n++;
 	t->flags |= AG_TABLE_NEEDSORT;
 	AG_ObjectUnlock(t);
@@ -2004,39 +2748,131 @@ AG_TableInitCell(AG_Table *t, AG_TableCell *c)
 	c->widget = NULL;
 	c->tbl = t;
 	c->id = 0;
+	c->rowID = 0;
 	c->flags = 0;
 	c->nPrev = 0;
 }
 
-int
-AG_TableAddRow(AG_Table *t, const char *fmtp, ...)
+/* Function cells point to themselves; fix them up after a copy. */
+static __inline__ void
+CopyCell(AG_TableCell *c, const AG_TableCell *cSrc)
+{
+	memcpy(c, cSrc, sizeof(AG_TableCell));
+	switch (c->type) {
+	case AG_CELL_FN_TXT:
+	case AG_CELL_FN_SU:
+	case AG_CELL_FN_SU_NODUP:
+		c->data.p = c;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Return 1 if a reused cell can keep its rendered surface. */
+static int
+CellUnchanged(const AG_TableCell *c, const AG_TableCell *cNew)
+{
+	if (c->type != cNew->type || strcmp(c->fmt, cNew->fmt) != 0) {
+		return (0);
+	}
+	switch (c->type) {
+	case AG_CELL_STRING:
+		return (strcmp(c->data.s, cNew->data.s) == 0);
+	case AG_CELL_INT:
+	case AG_CELL_UINT:
+		return (c->data.i == cNew->data.i);
+	case AG_CELL_LONG:
+	case AG_CELL_ULONG:
+		return (c->data.l == cNew->data.l);
+	case AG_CELL_FLOAT:
+	case AG_CELL_DOUBLE:
+		return (c->data.f == cNew->data.f);
+#ifdef HAVE_64BIT
+	case AG_CELL_INT64:
+	case AG_CELL_UINT64:
+		return (c->data.u64 == cNew->data.u64);
+#endif
+	case AG_CELL_FN_TXT:
+		return (c->fnTxt == cNew->fnTxt &&
+		        AG_TableCompareFnTxtCells(c, cNew) == 0);
+	case AG_CELL_FN_SU:
+	case AG_CELL_FN_SU_NODUP:
+	case AG_CELL_WIDGET:
+		return (0);
+	case AG_CELL_NULL:
+		return (1);
+	default:
+		/* Pointer cells are refreshed by AG_TableRedrawCells(). */
+		return (c->data.p == cNew->data.p);
+	}
+}
+
+/*
+ * Update a cell of a row reused by AG_TableAddRowID(), preserving its
+ * selection state and, if the contents are unchanged, its surface.
+ */
+static void
+UpdateCell(AG_Table *t, AG_TableCell *c, const AG_TableCell *cNew)
+{
+	int selected = c->selected;
+	int surface = c->surface;
+
+	if (surface != -1 && !CellUnchanged(c, cNew)) {
+		AG_WidgetUnmapSurface(t, surface);
+		surface = -1;
+	}
+	CopyCell(c, cNew);
+	c->selected = selected;
+	c->surface = surface;
+}
+
+static int
+AddRow(AG_Table *t, Uint id, const char *fmtp, va_list ap)
 {
 	char fmt[64], *sp = &fmt[0];
-	va_list ap;
-	int n, rv;
-	AG_TableCell **cNew;
+	AG_TableCell *row;
+	int n, mPrev, rv;
 
 	Strlcpy(fmt, fmtp, sizeof(fmt));
 
 	AG_ObjectLock(t);
 
-	if ((cNew = TryRealloc(t->cells, (t->m+1)*sizeof(AG_TableCell))) == NULL) {
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		AG_SetError("Table has a data model");
 		goto fail;
 	}
-	if ((cNew[t->m] = TryMalloc(t->n*sizeof(AG_TableCell))) == NULL) {
-		Free(cNew);
-		goto fail;
+	if (t->m+1 > t->mMax) {
+		int mMaxNew = (t->mMax > 0) ? t->mMax*2 : 64;
+		AG_TableCell **cellsNew;
+
+		if ((cellsNew = TryRealloc(t->cells,
+		    mMaxNew*sizeof(AG_TableCell *))) == NULL) {
+			goto fail;
+		}
+		t->cells = cellsNew;
+		t->mMax = mMaxNew;
 	}
-	t->cells = cNew;
+	if (t->n > t->nRowScratch) {
+		AG_TableCell *scratchNew;
 
-	va_start(ap, fmtp);
+		if ((scratchNew = TryRealloc(t->rowScratch,
+		    t->n*sizeof(AG_TableCell))) == NULL) {
+			goto fail;
+		}
+		t->rowScratch = scratchNew;
+		t->nRowScratch = t->n;
+	}
+
+	/* Parse the row into the scratch cells. */
 	for (n = 0; n < t->n; n++) {
-		AG_TableCell *c = &t->cells[t->m][n];
+		AG_TableCell *c = &t->rowScratch[n];
 		char *s = AG_Strsep(&sp, t->sep), *sc;
 		int ptr = 0, lflag = 0, ptr_long = 0;
 		int infmt = 0;
 
 		AG_TableInitCell(t, c);
+		c->rowID = id;
 		Strlcpy(c->fmt, s, sizeof(c->fmt));
 		for (sc = &s[0]; *sc != '\0'; sc++) {
 			if (*sc == '%') {
@@ -2203,7 +3039,22 @@ AG_TableAddRow(AG_Table *t, const char *fmtp, ...)
 			break;
 		}
 	}
-	va_end(ap);
+
+	if (id != 0 && t->nPrev == t->n &&
+	    (mPrev = FindPrevRow(t, id)) != -1) {
+		/* Update the saved row with this ID in place. */
+		row = t->cPrevRows[mPrev];
+		t->cPrevRows[mPrev] = NULL;
+		for (n = 0; n < t->n; n++)
+			UpdateCell(t, &row[n], &t->rowScratch[n]);
+	} else {
+		if ((row = AllocRow(t)) == NULL) {
+			goto fail;
+		}
+		for (n = 0; n < t->n; n++)
+			CopyCell(&row[n], &t->rowScratch[n]);
+	}
+	t->cells[t->m] = row;
 
 	rv = t->m++;
 	t->flags |= AG_TABLE_NEEDSORT;
@@ -2216,6 +3067,36 @@ fail:
 	return (-1);
 }
 
+/* Insert a new row. */
+int
+AG_TableAddRow(AG_Table *t, const char *fmt, ...)
+{
+	va_list ap;
+	int rv;
+
+	va_start(ap, fmt);
+	rv = AddRow(t, 0, fmt, ap);
+	va_end(ap);
+	return (rv);
+}
+
+/*
+ * Insert a new row identified by a nonzero ID. In polled tables, the row
+ * with the same ID from the previous AG_TableBegin() cycle is updated in
+ * place, keeping its selection state and the surfaces of unchanged cells.
+ */
+int
+AG_TableAddRowID(AG_Table *t, Uint id, const char *fmt, ...)
+{
+	va_list ap;
+	int rv;
+
+	va_start(ap, fmt);
+	rv = AddRow(t, id, fmt, ap);
+	va_end(ap);
+	return (rv);
+}
+
 int
 AG_TableSaveASCII(AG_Table *t, FILE *f, char sep)
 {
@@ -2236,7 +3117,15 @@ AG_TableSaveASCII(AG_Table *t, FILE *f, char sep)
 			if (t->cols[n].name[0] == '\0') {
 				continue;
 			}
-			AG_TablePrintCell(&t->cells[m][n], txt, sizeof(txt));
+			if (t->flags & AG_TABLE_VIRTUAL) {
+				AG_TableCell c;
+
+				GetModelCell(t, m, n, &c);
+				AG_TablePrintCell(&c, txt, sizeof(txt));
+			} else {
+				AG_TablePrintCell(&t->cells[m][n], txt,
+				    sizeof(txt));
+			}
 			fputs(txt, f);
 			fputc(sep, f);
 		}
@@ -2295,8 +3184,31 @@ Init(void *obj)
 	t->nResizing = -1;
 	t->cols = NULL;
 	t->cells = NULL;
+	t->cPrevRows = NULL;
+	t->mPrev = 0;
+	t->nPrev = 0;
+	t->mPrevMax = 0;
+	t->rowHash = NULL;
+	t->nRowHash = 0;
+	t->rowsFree = NULL;
+	t->nRowsFree = 0;
+	t->nRowsFreeMax = 0;
+	t->rowScratch = NULL;
+	t->nRowScratch = 0;
+	t->model = NULL;
+	t->modelArg = NULL;
+	t->perm = NULL;
+	t->selRows = NULL;
+	t->nSelRows = 0;
+	t->mSelLast = -1;
+	t->vHash = NULL;
+	t->nVHash = 0;
+	t->nVCells = 0;
+	t->nVCellsMax = 0;
+	TAILQ_INIT(&t->vLRU);
 	t->n = 0;
 	t->m = 0;
+	t->mMax = 0;
 	t->mVis = 0;
 	t->mOffs = 0;
 	t->xOffs = 0;
@@ -2317,7 +3229,6 @@ Init(void *obj)
 		AG_TableBucket *tb = &t->cPrev[i];
 		TAILQ_INIT(&tb->cells);
 	}
-	TAILQ_INIT(&t->cPrevList);
 
 	AG_AddEvent(t, "font-changed", OnFontChange, NULL);
 	AG_AddEvent(t, "widget-hidden", LostFocus, NULL);
@@ -2346,7 +3257,6 @@ Destroy(void *obj)
 {
 	AG_Table *t = obj;
 	AG_TablePopup *pop, *nPop;
-	AG_TableCell *c, *cNext;
 	int i;
 
 	/* Free the attached popup menus. */
@@ -2359,19 +3269,27 @@ Destroy(void *obj)
 	}
 
 	/* Free the active cells. */
-	for (i = 0; i < t->m; i++) {
-		Free(t->cells[i]);
+	if (t->flags & AG_TABLE_VIRTUAL) {
+		FlushVirtualCells(t);
+	} else {
+		for (i = 0; i < t->m; i++)
+			Free(t->cells[i]);
 	}
 	Free(t->cells);
+	Free(t->vHash);
+	Free(t->perm);
+	Free(t->selRows);
 
 	/* Free the backing store. */
-	for (c = TAILQ_FIRST(&t->cPrevList);
-	     c != TAILQ_END(&t->cPrevList);
-	     c = cNext) {
-		cNext = TAILQ_NEXT(c, cells_list);
-		Free(c);
+	for (i = 0; i < t->mPrev; i++) {
+		Free(t->cPrevRows[i]);
 	}
+	Free(t->cPrevRows);
 	Free(t->cPrev);
+	Free(t->rowHash);
+	FreeRecycledRows(t);
+	Free(t->rowsFree);
+	Free(t->rowScratch);
 
 	/* Free the columns. */
 	Free(t->cols);
@@ -86,14 +86,31 @@ typedef struct ag_table_cell {
 	int surface;				/* Named of mapped surface */
 	struct ag_table *tbl;			/* Back pointer to Table */
 	Uint id;				/* Optional user-specified ID */
+	Uint rowID;				/* Row ID (AG_TableAddRowID) */
 	Uint flags;
 #define AG_TABLE_CELL_NOCOMPARE	0x01		/* Ignore when comparing cells
 						   against backing store. */
 	AG_TAILQ_ENTRY(ag_table_cell) cells;	/* In AG_TableBucket */
-	AG_TAILQ_ENTRY(ag_table_cell) cells_list; /* In AG_Table */
 	Uint nPrev;				/* For SEL_ROWS mode */
 } AG_TableCell;
 
+/* Data model of a virtual table (see AG_TableSetModel()). */
+typedef struct ag_table_model {
+	Uint (*rowCount)(void *);			/* Return row count */
+	void (*getCell)(void *, Uint, int, AG_TableCell *); /* Fill in cell */
+	int  (*compareRows)(void *, Uint, Uint, int);	/* Compare two rows
+							   (or NULL) */
+} AG_TableModel;
+
+/* Cached surface of a visible cell of a virtual table. */
+typedef struct ag_table_vcell {
+	Uint row;				/* Model row */
+	int col;				/* Column */
+	int surface;				/* Mapped surface (or -1) */
+	struct ag_table_vcell *hnext;		/* In hash chain */
+	AG_TAILQ_ENTRY(ag_table_vcell) lru;	/* In LRU list */
+} AG_TableVCell;
+
 typedef struct ag_table_bucket {
 	AG_TAILQ_HEAD_(ag_table_cell) cells;
 } AG_TableBucket;
@@ -128,6 +145,7 @@ typedef struct ag_table {
 #define AG_TABLE_MULTIMODE	(AG_TABLE_MULTI|AG_TABLE_MULTITOGGLE)
 #define AG_TABLE_NOAUTOSORT	0x100	/* Disable automatic sorting */
 #define AG_TABLE_NEEDSORT	0x200	/* Need sorting */
+#define AG_TABLE_VIRTUAL	0x400	/* Rows are provided by a model */
 	enum ag_table_selmode selMode;	/* Selection mode */
 	int wHint, hHint;		/* Size hint */
 
@@ -145,10 +163,33 @@ typedef struct ag_table {
 	AG_TableCell   **cells;		/* Current cell data (sorted rows) */
 	AG_TableBucket *cPrev;		/* Saved cells (value hash) */
 	Uint            nPrevBuckets;
-	AG_TAILQ_HEAD_(ag_table_cell) cPrevList;	
+	AG_TableCell   **cPrevRows;	/* Rows saved by AG_TableBegin() */
+	int              mPrev;		/* Saved row count */
+	int              nPrev;		/* Saved row width (columns) */
+	int              mPrevMax;	/* Allocated cPrevRows[] entries */
+	Uint            *rowHash;	/* Saved rows by row ID (index+1) */
+	Uint             nRowHash;	/* Size of rowHash[] (power of 2) */
+	AG_TableCell   **rowsFree;	/* Recycled row arrays */
+	int              nRowsFree;
+	int              nRowsFreeMax;
+	AG_TableCell    *rowScratch;	/* For parsing rows */
+	int              nRowScratch;
+
+	const AG_TableModel *model;	/* Data model (virtual mode) */
+	void *modelArg;			/* Argument to model functions */
+	Uint *perm;			/* Sorted model rows (or NULL) */
+	Uint8 *selRows;			/* Selected model rows (bitmap) */
+	Uint nSelRows;			/* Size of selRows[] in bytes */
+	int mSelLast;			/* Last row selected (or -1) */
+	AG_TableVCell **vHash;		/* Cached cell surfaces */
+	Uint nVHash;			/* Size of vHash[] (power of 2) */
+	Uint nVCells;			/* Number of cached cells */
+	Uint nVCellsMax;		/* Cache capacity */
+	AG_TAILQ_HEAD(ag_table_vcellq, ag_table_vcell) vLRU;
 
 	int n;				/* Number of columns */
 	int m;				/* Number of rows */
+	int mMax;			/* Allocated cells[] entries */
 	int mVis;			/* Maximum number of visible rows */
 	int nResizing;			/* Column being resized (or -1) */
 	AG_Scrollbar *vbar;		/* Vertical scrollbar */
@@ -211,11 +252,16 @@ void	  AG_TableBegin(AG_Table *);
 void	  AG_TableEnd(AG_Table *);
 void      AG_TableSort(AG_Table *);
 
+void	  AG_TableSetModel(AG_Table *, const AG_TableModel *, void *);
+void	  AG_TableModelChanged(AG_Table *);
+Uint	  AG_TableModelRow(AG_Table *, int);
+
 void	  AG_TableInitCell(AG_Table *, AG_TableCell *);
 void	  AG_TablePrintCell(const AG_TableCell *, char *, size_t);
 void	  AG_TableFreeCell(AG_Table *, AG_TableCell *);
 
 int	  AG_TableAddRow(AG_Table *, const char *, ...);
+int	  AG_TableAddRowID(AG_Table *, Uint, const char *, ...);
 void	  AG_TableSelectRow(AG_Table *, int);
 void	  AG_TableDeselectRow(AG_Table *, int);
 void	  AG_TableSelectAllRows(AG_Table *);
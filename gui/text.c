@@ -449,6 +449,16 @@ AG_UnusedFont(AG_Font *font)
 	AG_MutexUnlock(&agTextLock);
 }
 
+/*
+ * Iterate over the loaded fonts; return the first font if font is NULL.
+ * The caller must hold agTextLock.
+ */
+AG_Font *
+AG_TextNextFont(AG_Font *font)
+{
+	return (font != NULL) ? TAILQ_NEXT(font, fonts) : TAILQ_FIRST(&fonts);
+}
+
 void
 AG_SetDefaultFont(AG_Font *font)
 {
@@ -651,55 +661,458 @@ AG_DestroyTextSubsystem(void)
 void
 AG_TextInitGlyphCache(AG_Driver *drv)
 {
-	Uint i;
+	AG_GlyphCache *gc;
+
+	gc = drv->glyphCache = Malloc(sizeof(AG_GlyphCache));
+	memset(gc, 0, sizeof(AG_GlyphCache));
+	gc->nSlots = AG_GLYPH_CACHE_INIT;
+	gc->slots = Malloc(gc->nSlots*sizeof(AG_Glyph *));
+	memset(gc->slots, 0, gc->nSlots*sizeof(AG_Glyph *));
+	gc->budget = AG_GLYPH_CACHE_BUDGET;
+	AG_TAILQ_INIT(&gc->glyphs);
+
+	drv->glyphAtlas = Malloc(sizeof(AG_GlyphAtlas));
+	memset(drv->glyphAtlas, 0, sizeof(AG_GlyphAtlas));
+	drv->glyphAtlas->maxPages = AG_GLYPH_ATLAS_PAGES;
+}
+
+/* Release a glyph and any texture of its own. */
+static void
+FreeGlyph(AG_Driver *drv, AG_Glyph *gl)
+{
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+	AG_DriverClass *dc = AGDRIVER_CLASS(drv);
+
+	if (gl->page != -1) {
+		AG_GlyphPage *pg = &ga->pages[gl->page];
 
-	drv->glyphCache = Malloc(AG_GLYPH_NBUCKETS*sizeof(AG_GlyphCache));
-	for (i = 0; i < AG_GLYPH_NBUCKETS; i++)
-		SLIST_INIT(&drv->glyphCache[i].glyphs);
+		pg->nGlyphs--;
+		pg->area -= (gl->rAtlas.w + 1)*(gl->rAtlas.h + 1);
+	} else if (gl->texture != 0 && dc->deleteTexture != NULL) {
+		dc->deleteTexture(drv, &gl->texture);
+	}
+	AG_SurfaceFree(gl->su);
+	Free(gl);
 }
 
 /* Clear the glyph cache. */
 void
 AG_TextClearGlyphCache(AG_Driver *drv)
 {
-	int i;
+	AG_GlyphCache *gc = drv->glyphCache;
 	AG_Glyph *gl, *ngl;
 
-	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		for (gl = SLIST_FIRST(&drv->glyphCache[i].glyphs);
-		     gl != SLIST_END(&drv->glyphCache[i].glyphs);
-		     gl = ngl) {
-			ngl = SLIST_NEXT(gl, glyphs);
-			AG_SurfaceFree(gl->su);
-			Free(gl);
-		}
-		SLIST_INIT(&drv->glyphCache[i].glyphs);
-	}
+	for (gl = AG_TAILQ_FIRST(&gc->glyphs);
+	     gl != AG_TAILQ_END(&gc->glyphs);
+	     gl = ngl) {
+		ngl = AG_TAILQ_NEXT(gl, glyphs);
+		FreeGlyph(drv, gl);
+	}
+	AG_TAILQ_INIT(&gc->glyphs);
+	memset(gc->slots, 0, gc->nSlots*sizeof(AG_Glyph *));
+	gc->nGlyphs = 0;
+	gc->size = 0;
+	AG_GlyphAtlasClear(drv);
 }
 
+/*
+ * Destroy the glyph cache. The driver is expected to have released
+ * the textures of the atlas pages.
+ */
 void
 AG_TextDestroyGlyphCache(AG_Driver *drv)
 {
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+	Uint i;
+
 	AG_TextClearGlyphCache(drv);
+	Free(drv->glyphCache->slots);
 	free(drv->glyphCache);
 	drv->glyphCache = NULL;
+
+	for (i = 0; i < ga->nPages; i++) {
+		Free(ga->pages[i].shelves);
+	}
+	Free(ga->pages);
+	free(ga);
+	drv->glyphAtlas = NULL;
+}
+
+/* Insert a glyph into the table (which must have a free slot). */
+static void
+GlyphCacheInsert(AG_GlyphCache *gc, AG_Glyph *gl)
+{
+	Uint i = AG_GlyphHash(gl->font, gl->ch) & (gc->nSlots - 1);
+
+	while (gc->slots[i] != NULL) {
+		i = (i + 1) & (gc->nSlots - 1);
+	}
+	gc->slots[i] = gl;
+}
+
+/* Remove a glyph from the table, shifting back any displaced entry. */
+static void
+GlyphCacheRemove(AG_GlyphCache *gc, AG_Glyph *gl)
+{
+	Uint mask = gc->nSlots - 1;
+	Uint i = AG_GlyphHash(gl->font, gl->ch) & mask;
+	Uint j, k;
+
+	while (gc->slots[i] != gl) {
+		i = (i + 1) & mask;
+	}
+	for (j = i; ; ) {
+		j = (j + 1) & mask;
+		if (gc->slots[j] == NULL) {
+			break;
+		}
+		k = AG_GlyphHash(gc->slots[j]->font, gc->slots[j]->ch) & mask;
+		if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+			continue;
+		}
+		gc->slots[i] = gc->slots[j];
+		i = j;
+	}
+	gc->slots[i] = NULL;
+}
+
+/* Double the size of the table. */
+static void
+GlyphCacheGrow(AG_GlyphCache *gc)
+{
+	AG_Glyph *gl;
+
+	Free(gc->slots);
+	gc->nSlots <<= 1;
+	gc->slots = Malloc(gc->nSlots*sizeof(AG_Glyph *));
+	memset(gc->slots, 0, gc->nSlots*sizeof(AG_Glyph *));
+	AG_TAILQ_FOREACH(gl, &gc->glyphs, glyphs)
+		GlyphCacheInsert(gc, gl);
+}
+
+/* Evict least recently used glyphs (except the most recent) over budget. */
+static void
+GlyphCacheTrim(AG_Driver *drv)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_Glyph *gl;
+
+	while (gc->size > gc->budget && gc->nGlyphs > 1) {
+		gl = AG_TAILQ_LAST(&gc->glyphs, ag_glyphq);
+		GlyphCacheRemove(gc, gl);
+		AG_TAILQ_REMOVE(&gc->glyphs, gl, glyphs);
+		gc->nGlyphs--;
+		gc->size -= gl->size;
+		gc->nEvicted++;
+		FreeGlyph(drv, gl);
+	}
+}
+
+/* Set the memory cap of the glyph cache in bytes. */
+void
+AG_TextSetGlyphCacheBudget(AG_Driver *drv, Uint budget)
+{
+	drv->glyphCache->budget = budget;
+	GlyphCacheTrim(drv);
+}
+
+/* Reset a page, invalidating any glyph packed into it. */
+static void
+GlyphAtlasResetPage(AG_Driver *drv, int p)
+{
+	AG_GlyphPage *pg = &drv->glyphAtlas->pages[p];
+	AG_Glyph *gl;
+
+	if (pg->nGlyphs > 0 && drv->glyphCache != NULL) {
+		AG_TAILQ_FOREACH(gl, &drv->glyphCache->glyphs, glyphs) {
+			if (gl->page == p) {
+				gl->page = -1;
+				gl->texture = 0;
+				gl->flags |= AG_GLYPH_STALE;
+			}
+		}
+	}
+	pg->nShelves = 0;
+	pg->yFree = 0;
+	pg->nGlyphs = 0;
+	pg->area = 0;
+}
+
+/* Try to pack a w x h rectangle into page pg using the best-fitting shelf. */
+static int
+GlyphAtlasPack(AG_GlyphPage *pg, int w, int h, int *x, int *y)
+{
+	AG_GlyphShelf *sh, *best = NULL;
+	Uint i;
+
+	for (i = 0; i < pg->nShelves; i++) {
+		sh = &pg->shelves[i];
+		if (sh->h >= h && sh->x+w <= pg->w &&
+		    (best == NULL || sh->h < best->h))
+			best = sh;
+	}
+	if ((best == NULL || best->h - h > h/2) && pg->yFree+h <= pg->h) {
+		/* Open a new shelf. */
+		sh = Realloc(pg->shelves, (pg->nShelves+1)*sizeof(AG_GlyphShelf));
+		pg->shelves = sh;
+		best = &sh[pg->nShelves++];
+		best->y = pg->yFree;
+		best->h = h;
+		best->x = 0;
+		pg->yFree += h;
+	}
+	if (best == NULL) {
+		return (-1);
+	}
+	*x = best->x;
+	*y = best->y;
+	best->x += w;
+	return (0);
+}
+
+/*
+ * Allocate space for the surface of a glyph in the driver's glyph atlas,
+ * growing the atlas or evicting the least recently used page as needed.
+ * On success, set the page, rAtlas and texcoords of the glyph and return
+ * the page index. A page with a zero texture has not been created by the
+ * driver yet. Return -1 if the glyph does not fit in a page.
+ */
+int
+AG_GlyphAtlasAlloc(AG_Driver *drv, AG_Glyph *gl)
+{
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+	AG_GlyphPage *pg;
+	int w = gl->su->w + 1;			/* Padding for filtering */
+	int h = gl->su->h + 1;
+	int p, x, y;
+	Uint i;
+
+	if (w > AG_GLYPH_ATLAS_W || h > AG_GLYPH_ATLAS_H) {
+		ga->nOversized++;
+		return (-1);
+	}
+	for (p = 0; p < (int)ga->nPages; p++) {
+		if (GlyphAtlasPack(&ga->pages[p], w, h, &x, &y) == 0)
+			goto out;
+	}
+	if (ga->nPages < ga->maxPages) {
+		ga->pages = Realloc(ga->pages, (ga->nPages+1) *
+		                               sizeof(AG_GlyphPage));
+		p = (int)ga->nPages++;
+		pg = &ga->pages[p];
+		memset(pg, 0, sizeof(AG_GlyphPage));
+		pg->w = AG_GLYPH_ATLAS_W;
+		pg->h = AG_GLYPH_ATLAS_H;
+	} else {
+		/* Evict the least recently used page. */
+		for (i = 1, p = 0; i < ga->nPages; i++) {
+			if (ga->pages[i].lastUsed < ga->pages[p].lastUsed)
+				p = (int)i;
+		}
+		ga->nEvicted++;
+		ga->nGlyphsEvicted += ga->pages[p].nGlyphs;
+		GlyphAtlasResetPage(drv, p);
+	}
+	if (GlyphAtlasPack(&ga->pages[p], w, h, &x, &y) == -1) {
+		return (-1);
+	}
+out:
+	pg = &ga->pages[p];
+	pg->nGlyphs++;
+	pg->area += w*h;
+	pg->lastUsed = ++ga->seq;
+
+	gl->flags &= ~(AG_GLYPH_STALE);
+	gl->page = p;
+	gl->rAtlas.x = x;
+	gl->rAtlas.y = y;
+	gl->rAtlas.w = gl->su->w;
+	gl->rAtlas.h = gl->su->h;
+	gl->texcoords.x = (float)x / (float)pg->w;
+	gl->texcoords.y = (float)y / (float)pg->h;
+	gl->texcoords.w = (float)(x + gl->su->w) / (float)pg->w;
+	gl->texcoords.h = (float)(y + gl->su->h) / (float)pg->h;
+	return (p);
+}
+
+/*
+ * Release the atlas space allocated to a glyph by AG_GlyphAtlasAlloc(),
+ * for drivers which fail to upload it and fall back to a texture of its
+ * own. Space is returned to its shelf if the glyph was the last packed.
+ */
+void
+AG_GlyphAtlasFree(AG_Driver *drv, AG_Glyph *gl)
+{
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+	AG_GlyphPage *pg;
+	AG_GlyphShelf *sh;
+	int w = gl->rAtlas.w + 1;
+	int h = gl->rAtlas.h + 1;
+	Uint i;
+
+	if (gl->page < 0 || gl->page >= (int)ga->nPages) {
+		return;
+	}
+	pg = &ga->pages[gl->page];
+	for (i = 0; i < pg->nShelves; i++) {
+		sh = &pg->shelves[i];
+		if (sh->y == gl->rAtlas.y && sh->x == gl->rAtlas.x+w) {
+			sh->x = gl->rAtlas.x;
+			break;
+		}
+	}
+	if (pg->nGlyphs > 0) {
+		pg->nGlyphs--;
+		pg->area -= w*h;
+	}
+	gl->page = -1;
+}
+
+/*
+ * Release all space in the glyph atlas. Page textures are retained for
+ * reuse; glyphs are uploaded again the next time they are looked up.
+ */
+void
+AG_GlyphAtlasClear(AG_Driver *drv)
+{
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+	Uint i;
+
+	if (ga == NULL) {
+		return;
+	}
+	for (i = 0; i < ga->nPages; i++)
+		GlyphAtlasResetPage(drv, (int)i);
 }
 
-/* Render a glyph following a cache miss; called from AG_TextRenderGlyph(). */
+/*
+ * Expand the coverage mask of a glyph to a new 32-bit surface in the pixel
+ * format of atlas pages (RGBA in memory byte order, as with
+ * AG_SurfaceStdGL()), with white color and alpha from coverage.
+ */
+AG_Surface *
+AG_GlyphAtlasSurface(AG_Glyph *gl)
+{
+	AG_Surface *su = gl->su, *gsu;
+	Uint8 *pSrc;
+	Uint32 *pDst;
+	Uint x, y;
+
+	gsu = AG_SurfaceRGBA(su->w, su->h, 32, 0,
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+		0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff
+#else
+		0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000
+#endif
+	);
+	if (gsu == NULL) {
+		AG_FatalError(NULL);
+	}
+	for (y = 0; y < su->h; y++) {
+		pSrc = (Uint8 *)su->pixels + y*su->pitch;
+		pDst = (Uint32 *)((Uint8 *)gsu->pixels + y*gsu->pitch);
+		for (x = 0; x < su->w; x++) {
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+			*pDst++ = 0xffffff00 | (Uint32)(*pSrc++);
+#else
+			*pDst++ = 0x00ffffff | ((Uint32)(*pSrc++) << 24);
+#endif
+		}
+	}
+	return (gsu);
+}
+
+/* Return glyph atlas occupancy and eviction statistics. */
+void
+AG_GlyphAtlasGetStats(AG_Driver *drv, AG_GlyphAtlasStats *st)
+{
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+	Uint i;
+
+	memset(st, 0, sizeof(AG_GlyphAtlasStats));
+	if (ga == NULL) {
+		return;
+	}
+	st->nPages = ga->nPages;
+	st->maxPages = ga->maxPages;
+	for (i = 0; i < ga->nPages; i++) {
+		AG_GlyphPage *pg = &ga->pages[i];
+
+		st->nGlyphs += pg->nGlyphs;
+		st->areaUsed += pg->area;
+		st->areaTotal += pg->w*pg->h;
+	}
+	st->nEvicted = ga->nEvicted;
+	st->nGlyphsEvicted = ga->nGlyphsEvicted;
+	st->nOversized = ga->nOversized;
+}
+
+/*
+ * Extract the coverage of a glyph rendered in opaque white to a new
+ * 8-bit alpha-only surface.
+ */
+static AG_Surface *
+GlyphCoverageMask(const AG_Surface *su)
+{
+	AG_Surface *sm;
+	const Uint8 *pSrc;
+	Uint8 *pDst;
+	Uint32 px;
+	Uint x, y;
+	Uint8 r, g, b, a;
+
+	if ((sm = AG_SurfaceRGBA(su->w, su->h, 8, 0, 0, 0, 0, 0xff)) == NULL) {
+		AG_FatalError(NULL);
+	}
+	for (y = 0; y < su->h; y++) {
+		pSrc = (const Uint8 *)su->pixels + y*su->pitch;
+		pDst = (Uint8 *)sm->pixels + y*sm->pitch;
+		for (x = 0; x < su->w; x++) {
+			AG_PACKEDPIXEL_GET(su->format->BytesPerPixel, px, pSrc);
+			if ((su->flags & AG_SRCCOLORKEY) &&
+			    px == su->format->colorkey) {
+				a = 0;
+			} else {
+				AG_GetPixelRGBA(px, su->format, &r,&g,&b,&a);
+			}
+			*pDst++ = a;
+			pSrc += su->format->BytesPerPixel;
+		}
+	}
+	return (sm);
+}
+
+/*
+ * Render a glyph following a cache miss and insert it into the glyph cache;
+ * called from AG_TextRenderGlyph().
+ */
 AG_Glyph *
 AG_TextRenderGlyphMiss(AG_Driver *drv, Uint32 ch)
 {
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_Color cSave = agTextState->color;
+	AG_Color cSaveBG = agTextState->colorBG;
 	AG_Glyph *gl;
+	AG_Surface *su;
 	Uint32 ucs[2];
 
 	gl = Malloc(sizeof(AG_Glyph));
 	gl->font = agTextState->font;
-	gl->color = agTextState->color;
 	gl->texture = 0; // WDZ - Textures (Should have always been initialised)
+	gl->flags = 0;
+	gl->page = -1;
 	gl->ch = ch;
 	ucs[0] = ch;
 	ucs[1] = '\0';
-	gl->su = AG_TextRenderUCS4(ucs);
+
+	/* Render in white on transparent; color is applied when drawing. */
+	agTextState->color = AG_ColorRGBA(255,255,255,AG_ALPHA_OPAQUE);
+	agTextState->colorBG = AG_ColorRGBA(0,0,0,0);
+	su = AG_TextRenderUCS4(ucs);
+	agTextState->color = cSave;
+	agTextState->colorBG = cSaveBG;
+	gl->su = GlyphCoverageMask(su);
+	AG_SurfaceFree(su);
 
 	switch (agTextState->font->spec.type) {
 #ifdef HAVE_FREETYPE
@@ -721,7 +1134,19 @@ AG_TextRenderGlyphMiss(AG_Driver *drv, Uint32 ch)
 		gl->advance = gl->su->w;
 		break;
 	}
+	gl->size = sizeof(AG_Glyph) + sizeof(AG_Surface) +
+	           gl->su->h*gl->su->pitch;
+
+	if ((gc->nGlyphs+1)*4 > gc->nSlots*3) {
+		GlyphCacheGrow(gc);
+	}
+	GlyphCacheInsert(gc, gl);
+	AG_TAILQ_INSERT_HEAD(&gc->glyphs, gl, glyphs);
+	gc->nGlyphs++;
+	gc->size += gl->size;
+
 	AGDRIVER_CLASS(drv)->updateGlyph(drv, gl);
+	GlyphCacheTrim(drv);
 	return (gl);
 }
 
@@ -8,8 +8,12 @@
 
 #include <agar/gui/begin.h>
 
-#define AG_GLYPH_NBUCKETS 1024	/* Buckets for glyph cache table */
+#define AG_GLYPH_CACHE_INIT 256	/* Initial size of glyph cache table */
+#define AG_GLYPH_CACHE_BUDGET 0x200000 /* Default glyph cache memory cap */
 #define AG_TEXT_STATES_MAX 128	/* Maximum number of saved text states */
+#define AG_GLYPH_ATLAS_W 512	/* Width of glyph atlas pages */
+#define AG_GLYPH_ATLAS_H 512	/* Height of glyph atlas pages */
+#define AG_GLYPH_ATLAS_PAGES 8	/* Atlas pages allowed before eviction */
 
 struct ag_window;
 struct ag_button;
@@ -59,18 +63,65 @@ typedef struct ag_font_spec {
 	} matrix;
 } AG_FontSpec;
 
-/* Cached glyph surface/texture information. */
+/*
+ * Cached glyph surface/texture information. Glyphs are stored as 8-bit
+ * coverage masks independently of color, which is applied when drawing.
+ */
 typedef struct ag_glyph {
 	struct ag_font *font;		/* Font face */
-	AG_Color        color;		/* Glyph color */
 	Uint32          ch;		/* Unicode character */
-	AG_Surface     *su;		/* Rendered surface */
+	AG_Surface     *su;		/* Coverage mask (8-bit alpha) */
 	int             advance;	/* Pixel advance */
 	Uint64          texture;	/* Cached texture (driver-specific) */ //WDZ - Textures
 	AG_TexCoord     texcoords;	/* Texture coordinates */
-	AG_SLIST_ENTRY(ag_glyph) glyphs;
+	Uint            flags;
+#define AG_GLYPH_STALE	0x01		/* Texture must be uploaded again */
+	int             page;		/* Atlas page (or -1) */
+	AG_Rect         rAtlas;		/* Location in atlas page */
+	Uint            size;		/* Memory used (bytes) */
+	AG_TAILQ_ENTRY(ag_glyph) glyphs; /* In LRU order */
 } AG_Glyph;
 
+/* Shelf of glyphs in an atlas page. */
+typedef struct ag_glyph_shelf {
+	int y, h;			/* Position and height of shelf */
+	int x;				/* First free column */
+} AG_GlyphShelf;
+
+/* Shelf-packed page of a glyph atlas. */
+typedef struct ag_glyph_page {
+	Uint64 texture;			/* Page texture (driver-specific) */
+	int w, h;			/* Page dimensions */
+	AG_GlyphShelf *shelves;		/* Allocated shelves */
+	Uint nShelves;
+	int yFree;			/* First row not in a shelf */
+	Uint nGlyphs;			/* Glyphs packed in this page */
+	Uint area;			/* Pixels allocated to glyphs */
+	Uint lastUsed;			/* Sequence number of last use */
+} AG_GlyphPage;
+
+/* Glyph atlas statistics. */
+typedef struct ag_glyph_atlas_stats {
+	Uint nPages;			/* Pages allocated */
+	Uint maxPages;			/* Pages allowed before eviction */
+	Uint nGlyphs;			/* Glyphs in atlas */
+	Uint areaUsed;			/* Pixels allocated to glyphs */
+	Uint areaTotal;			/* Total pixels in pages */
+	Uint nEvicted;			/* Pages evicted */
+	Uint nGlyphsEvicted;		/* Glyphs invalidated by eviction */
+	Uint nOversized;		/* Glyphs too large for a page */
+} AG_GlyphAtlasStats;
+
+/* Per-driver texture atlas of rendered glyphs. */
+typedef struct ag_glyph_atlas {
+	AG_GlyphPage *pages;
+	Uint nPages, maxPages;
+	Uint seq;			/* Use sequence (for LRU eviction) */
+	Uint nEvicted;
+	Uint nGlyphsEvicted;
+	Uint nOversized;
+} AG_GlyphAtlas;
+
 /* Loaded font */
 typedef struct ag_font {
 	struct ag_object obj;
@@ -122,8 +173,16 @@ typedef struct ag_text_metrics {
 	Uint  nLines;			/* Total line count */
 } AG_TextMetrics;
 
+/* Per-driver glyph cache (open addressing with linear probing). */
 typedef struct ag_glyph_cache {
-	AG_SLIST_HEAD_(ag_glyph) glyphs;
+	AG_Glyph **slots;		/* Hash table */
+	Uint nSlots;			/* Table size (power of 2) */
+	Uint nGlyphs;			/* Glyphs in cache */
+	Uint size;			/* Memory used by glyphs (bytes) */
+	Uint budget;			/* Memory cap (bytes) */
+	Uint nHits, nMisses;		/* Lookup statistics */
+	Uint nEvicted;			/* Glyphs evicted */
+	AG_TAILQ_HEAD(ag_glyphq, ag_glyph) glyphs; /* Most recent first */
 } AG_GlyphCache;
 
 /* Begin generated block */
@@ -146,6 +205,7 @@ extern DECLSPEC void AG_DestroyTextSubsystem(void);
 extern DECLSPEC void AG_TextParseFontSpec(const char *);
 extern DECLSPEC AG_Font *AG_FetchFont(const char *, int, int);
 extern DECLSPEC void AG_UnusedFont(AG_Font *);
+extern DECLSPEC AG_Font *AG_TextNextFont(AG_Font *);
 extern DECLSPEC void AG_SetDefaultFont(AG_Font *);
 extern DECLSPEC void AG_SetRTL(int);
 extern DECLSPEC void AG_PushTextState(void);
@@ -176,6 +236,12 @@ extern DECLSPEC void AG_TextInitGlyphCache(AG_Driver *);
 extern DECLSPEC void AG_TextClearGlyphCache(AG_Driver *);
 extern DECLSPEC void AG_TextDestroyGlyphCache(AG_Driver *);
 extern DECLSPEC AG_Glyph *AG_TextRenderGlyphMiss(AG_Driver *, Uint32);
+extern DECLSPEC void AG_TextSetGlyphCacheBudget(AG_Driver *, Uint);
+extern DECLSPEC int AG_GlyphAtlasAlloc(AG_Driver *, AG_Glyph *);
+extern DECLSPEC void AG_GlyphAtlasFree(AG_Driver *, AG_Glyph *);
+extern DECLSPEC void AG_GlyphAtlasClear(AG_Driver *);
+extern DECLSPEC AG_Surface *AG_GlyphAtlasSurface(AG_Glyph *);
+extern DECLSPEC void AG_GlyphAtlasGetStats(AG_Driver *, AG_GlyphAtlasStats *);
 extern DECLSPEC void AG_TextAlign(int *, int *, int, int, int, int, int, int, int, int, enum ag_text_justify, enum ag_text_valign);
 #define AG_TextMsgFromError() AG_TextMsgS(AG_MSG_ERROR, AG_GetError())
 
@@ -245,25 +311,52 @@ AG_TextRender(const char *text)
  * Must be called from GUI rendering context.
  */
 
+static __inline__ Uint
+AG_GlyphHash(const struct ag_font *font, Uint32 ch)
+{
+	return (Uint)((ch * 2654435761U) ^ (Uint32)((size_t)font >> 4));
+}
+
 static __inline__ AG_Glyph *
 AG_TextRenderGlyph(AG_Driver *drv, Uint32 ch)
 {
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_Font *font = agTextState->font;
 	AG_Glyph *gl;
-	Uint h = (Uint)(ch % AG_GLYPH_NBUCKETS);
+	Uint i = AG_GlyphHash(font, ch) & (gc->nSlots - 1);
 
-	AG_SLIST_FOREACH(gl, &drv->glyphCache[h].glyphs, glyphs) {
-		if (ch == gl->ch &&
-		    agTextState->font == gl->font &&
-		    AG_ColorCompare(agTextState->color,gl->color) == 0)
+	while ((gl = gc->slots[i]) != NULL) {
+		if (gl->ch == ch && gl->font == font) {
 			break;
+		}
+		i = (i + 1) & (gc->nSlots - 1);
 	}
 	if (gl == NULL) {
-		gl = AG_TextRenderGlyphMiss(drv, ch);
-		AG_SLIST_INSERT_HEAD(&drv->glyphCache[h].glyphs, gl, glyphs);
+		gc->nMisses++;
+		return AG_TextRenderGlyphMiss(drv, ch);
+	}
+	gc->nHits++;
+	if (gl != AG_TAILQ_FIRST(&gc->glyphs)) {
+		AG_TAILQ_REMOVE(&gc->glyphs, gl, glyphs);
+		AG_TAILQ_INSERT_HEAD(&gc->glyphs, gl, glyphs);
+	}
+	if (gl->flags & AG_GLYPH_STALE) {
+		gl->flags &= ~(AG_GLYPH_STALE);
+		AGDRIVER_CLASS(drv)->updateGlyph(drv, gl);
 	}
 	return (gl);
 }
 
+/* Mark the atlas page of a glyph as recently used. */
+static __inline__ void
+AG_GlyphAtlasTouch(AG_Driver *drv, const AG_Glyph *gl)
+{
+	AG_GlyphAtlas *ga = drv->glyphAtlas;
+
+	if (gl->page != -1)
+		ga->pages[gl->page].lastUsed = ++ga->seq;
+}
+
 static __inline__ void
 AG_TextColor(AG_Color C)
 {
@@ -26,6 +26,7 @@
 #include <agar/core/core.h>
 #include <agar/gui/tlist.h>
 #include <agar/gui/primitive.h>
+#include <agar/gui/sort_keys.h>
 
 #include <string.h>
 #include <stdarg.h>
@@ -35,6 +36,7 @@ static void KeyDown(AG_Event *);
 static void KeyUp(AG_Event *);
 
 static void FreeItem(AG_Tlist *, AG_TlistItem *);
+static void UpdateIndex(AG_Tlist *);
 static void SelectItem(AG_Tlist *, AG_TlistItem *);
 static void DeselectItem(AG_Tlist *, AG_TlistItem *);
 static void UpdateItemIcon(AG_Tlist *, AG_TlistItem *, AG_Surface *);
@@ -88,18 +90,16 @@ UpdatePolled(AG_Tlist *tl)
 static int
 SelectionVisible(AG_Tlist *tl)
 {
-	AG_TlistItem *it;
-	int y = 0, i = 0;
+	int y = 0, i;
 
 	UpdatePolled(tl);
+	UpdateIndex(tl);
 
-	TAILQ_FOREACH(it, &tl->items, items) {
-		if (i++ < tl->rOffs)
-			continue;
+	for (i = MAX(0,tl->rOffs); i < tl->nitems; i++) {
 		if (y > HEIGHT(tl) - tl->item_h)
 			break;
 
-		if (it->selected) {
+		if (tl->idx[i]->selected) {
 			return (1);
 		}
 		y += tl->item_h;
@@ -274,6 +274,15 @@ Init(void *obj)
 	tl->wheelTicks = 0;
 	tl->r = AG_RECT(0,0,0,0);
 	tl->rOffs = 0;
+	tl->hash_fn = AG_TlistHashPtrs;
+	tl->idx = NULL;
+	tl->idxSize = 0;
+	tl->idxValid = 1;
+	tl->selHash = NULL;
+	tl->nSelHash = 0;
+	tl->pool = NULL;
+	tl->poolBlocks = NULL;
+	tl->nPoolBlocks = 0;
 	TAILQ_INIT(&tl->items);
 	TAILQ_INIT(&tl->selitems);
 	TAILQ_INIT(&tl->popups);
@@ -351,6 +360,7 @@ Destroy(void *p)
 	AG_Tlist *tl = p;
 	AG_TlistItem *it, *nit;
 	AG_TlistPopup *tp, *ntp;
+	Uint i;
 
 	for (it = TAILQ_FIRST(&tl->selitems);
 	     it != TAILQ_END(&tl->selitems);
@@ -371,6 +381,12 @@ Destroy(void *p)
 		AG_ObjectDestroy(tp->menu);
 		Free(tp);
 	}
+	for (i = 0; i < tl->nPoolBlocks; i++) {
+		Free(tl->poolBlocks[i]);
+	}
+	Free(tl->poolBlocks);
+	Free(tl->selHash);
+	Free(tl->idx);
 }
 
 static void
@@ -440,25 +456,31 @@ Draw(void *obj)
 {
 	AG_Tlist *tl = obj;
 	AG_TlistItem *it;
-	int y = 0, i = 0, selSeen = 0, selPos = 1;
+	int y = 0, i, selSeen = 0, selPos = 1;
 
 	AG_DrawBox(tl, tl->r, -1, WCOLOR(tl,AG_COLOR));
 	AG_WidgetDraw(tl->sbar);
 	AG_PushClipRect(tl, tl->r);
 
 	UpdatePolled(tl);
+	UpdateIndex(tl);
 
-	TAILQ_FOREACH(it, &tl->items, items) {
-		int x = 2 + it->depth*tl->icon_w;
-
-		if (i++ < tl->rOffs) {
-			if (it->selected) {
+	if (tl->flags & AG_TLIST_SCROLLTOSEL) {
+		for (i = 0; i < tl->rOffs && i < tl->nitems; i++) {
+			if (tl->idx[i]->selected) {
 				selPos = -1;
+				break;
 			}
-			continue;
 		}
-		if (y > HEIGHT(tl) - tl->item_h)
+	}
+	for (i = MAX(0,tl->rOffs); i < tl->nitems; i++) {
+		int x;
+
+		if (y > HEIGHT(tl) - tl->item_h) {
 			break;
+		}
+		it = tl->idx[i];
+		x = 2 + it->depth*tl->icon_w;
 
 		if (it->selected) {
 		    	AG_Rect rSel;
@@ -530,7 +552,8 @@ FreeItem(AG_Tlist *tl, AG_TlistItem *it)
 	if (it->icon != -1) {
 		AG_WidgetUnmapSurface(tl, it->icon);
 	}
-	Free(it);
+	it->hnext = tl->pool;
+	tl->pool = it;
 }
 
 /* Remove a tlist item. */
@@ -540,6 +563,7 @@ AG_TlistDel(AG_Tlist *tl, AG_TlistItem *it)
 	AG_ObjectLock(tl);
 	TAILQ_REMOVE(&tl->items, it, items);
 	tl->nitems--;
+	tl->idxValid = 0;
 	FreeItem(tl, it);
 
 	/* Update the scrollbar range and offset accordingly. */
@@ -570,11 +594,87 @@ restart:							/* XXX */
 	AG_ObjectUnlock(tl);
 }
 
+/*
+ * Index the saved items by hash_fn() so that AG_TlistRestore() and
+ * AG_TlistVisibleChildren() do not need to scan the whole selitems list.
+ */
+static void
+HashSavedItems(AG_Tlist *tl, Uint nSaved)
+{
+	AG_TlistItem *sit;
+	Uint n;
+
+	if (tl->hash_fn == NULL || nSaved == 0) {
+		return;
+	}
+	n = 16;
+	while (n < nSaved*2) {
+		n <<= 1;
+	}
+	if (n > tl->nSelHash) {
+		Free(tl->selHash);
+		if ((tl->selHash = TryMalloc(n*sizeof(AG_TlistItem *))) == NULL) {
+			tl->nSelHash = 0;
+			return;
+		}
+		tl->nSelHash = n;
+	}
+	memset(tl->selHash, 0, tl->nSelHash*sizeof(AG_TlistItem *));
+
+	/*
+	 * Insert at the head of the chains (reversing the selitems order),
+	 * so the first match in a chain is the one a linear scan of selitems
+	 * would have applied last.
+	 */
+	TAILQ_FOREACH(sit, &tl->selitems, selitems) {
+		Uint h = tl->hash_fn(sit) & (tl->nSelHash-1);
+
+		sit->hnext = tl->selHash[h];
+		tl->selHash[h] = sit;
+	}
+}
+
+/*
+ * Return the first (or if last is set, the last) saved item in selitems
+ * matching cit, or NULL. The hash chains hold selitems in reverse order.
+ */
+static AG_TlistItem *
+FindSavedItem(AG_Tlist *tl, const AG_TlistItem *cit, int last)
+{
+	AG_TlistItem *sit, *sitFound = NULL;
+
+	if (tl->nSelHash > 0 && tl->hash_fn != NULL) {
+		Uint h = tl->hash_fn(cit) & (tl->nSelHash-1);
+
+		for (sit = tl->selHash[h]; sit != NULL; sit = sit->hnext) {
+			if (!tl->compare_fn(sit, cit)) {
+				continue;
+			}
+			if (last) {
+				return (sit);
+			}
+			sitFound = sit;
+		}
+		return (sitFound);
+	}
+	TAILQ_FOREACH(sit, &tl->selitems, selitems) {
+		if (!tl->compare_fn(sit, cit)) {
+			continue;
+		}
+		if (!last) {
+			return (sit);
+		}
+		sitFound = sit;
+	}
+	return (sitFound);
+}
+
 /* Clear the items on the list, save the selections if polling. */
 void
 AG_TlistClear(AG_Tlist *tl)
 {
 	AG_TlistItem *it, *nit;
+	Uint nSaved = 0;
 	
 	AG_ObjectLock(tl);
 
@@ -585,12 +685,15 @@ AG_TlistClear(AG_Tlist *tl)
 		if ((!(tl->flags & AG_TLIST_NOSELSTATE) && it->selected) ||
 		      (it->flags & AG_TLIST_HAS_CHILDREN)) {
 			TAILQ_INSERT_HEAD(&tl->selitems, it, selitems);
+			nSaved++;
 		} else {
 			FreeItem(tl, it);
 		}
 	}
 	TAILQ_INIT(&tl->items);
 	tl->nitems = 0;
+	tl->idxValid = 1;
+	HashSavedItems(tl, nSaved);
 	AG_ObjectUnlock(tl);
 
 	AG_Redraw(tl);
@@ -622,13 +725,60 @@ AG_TlistComparePtrsAndClasses(const AG_TlistItem *it1,
 		 (strcmp(it1->cat, it2->cat) == 0)));
 }
 
-/* Set an alternate compare function for items. */
+/* Hash routine consistent with AG_TlistCompareStrings(). */
+Uint
+AG_TlistHashStrings(const AG_TlistItem *it)
+{
+	const char *c;
+	Uint h = 2166136261U;
+
+	for (c = &it->text[0]; *c != '\0'; c++) {
+		h ^= (Uint)(unsigned char)*c;
+		h *= 16777619U;
+	}
+	return (h);
+}
+
+/*
+ * Hash routine consistent with AG_TlistComparePtrs() and
+ * AG_TlistComparePtrsAndClasses().
+ */
+Uint
+AG_TlistHashPtrs(const AG_TlistItem *it)
+{
+	return ((Uint)((size_t)it->p1 >> 3) * 2654435761U);
+}
+
+/*
+ * Set an alternate compare function for items. If it is one of the
+ * built-in routines, select the matching hash function.
+ */
 void
 AG_TlistSetCompareFn(AG_Tlist *tl,
     int (*fn)(const AG_TlistItem *, const AG_TlistItem *))
 {
 	AG_ObjectLock(tl);
 	tl->compare_fn = fn;
+	if (fn == AG_TlistComparePtrs ||
+	    fn == AG_TlistComparePtrsAndClasses) {
+		tl->hash_fn = AG_TlistHashPtrs;
+	} else if (fn == AG_TlistCompareStrings) {
+		tl->hash_fn = AG_TlistHashStrings;
+	} else {
+		tl->hash_fn = NULL;
+	}
+	AG_ObjectUnlock(tl);
+}
+
+/*
+ * Set the hash function used to look up saved items (NULL = linear search).
+ * Items which compare equal must have the same hash.
+ */
+void
+AG_TlistSetHashFn(AG_Tlist *tl, Uint (*fn)(const AG_TlistItem *))
+{
+	AG_ObjectLock(tl);
+	tl->hash_fn = fn;
 	AG_ObjectUnlock(tl);
 }
 
@@ -653,40 +803,78 @@ AG_TlistRestore(AG_Tlist *tl)
 
 	AG_ObjectLock(tl);
 
+	if (TAILQ_EMPTY(&tl->selitems)) {
+		goto out;
+	}
+	TAILQ_FOREACH(cit, &tl->items, items) {
+		/* As if applying every matching saved item in order. */
+		if ((sit = FindSavedItem(tl, cit, 1)) == NULL) {
+			continue;
+		}
+		if (!(tl->flags & AG_TLIST_NOSELSTATE)) {
+			cit->selected = sit->selected;
+		}
+		if (sit->flags & AG_TLIST_VISIBLE_CHILDREN) {
+			cit->flags |= AG_TLIST_VISIBLE_CHILDREN;
+		} else {
+			cit->flags &= ~(AG_TLIST_VISIBLE_CHILDREN);
+		}
+	}
 	for (sit = TAILQ_FIRST(&tl->selitems);
 	     sit != TAILQ_END(&tl->selitems);
 	     sit = nsit) {
 		nsit = TAILQ_NEXT(sit, selitems);
-		TAILQ_FOREACH(cit, &tl->items, items) {
-			if (!tl->compare_fn(sit, cit)) {
-				continue;
-			}
-			if (!(tl->flags & AG_TLIST_NOSELSTATE)) {
-				cit->selected = sit->selected;
-			}
-			if (sit->flags & AG_TLIST_VISIBLE_CHILDREN) {
-				cit->flags |= AG_TLIST_VISIBLE_CHILDREN;
-			} else {
-				cit->flags &= ~(AG_TLIST_VISIBLE_CHILDREN);
-			}
-		}
 		FreeItem(tl, sit);
 	}
 	TAILQ_INIT(&tl->selitems);
-
+	if (tl->nSelHash > 0) {
+		memset(tl->selHash, 0, tl->nSelHash*sizeof(AG_TlistItem *));
+	}
+out:
 	AG_ObjectUnlock(tl);
 }
 
 /*
- * Allocate a new tlist item.
- * XXX allocate from a pool, especially for polled items.
+ * Return the expanded state of the saved item matching cit. This is
+ * intended to be called from tlist-poll handlers of tree displays.
+ */
+int
+AG_TlistVisibleChildren(AG_Tlist *tl, AG_TlistItem *cit)
+{
+	AG_TlistItem *sit;
+
+	if ((sit = FindSavedItem(tl, cit, 0)) == NULL) {
+		return (0);			/* TODO default setting */
+	}
+	return (sit->flags & AG_TLIST_VISIBLE_CHILDREN);
+}
+
+/*
+ * Allocate a new tlist item. Items are carved out of blocks of
+ * AG_TLIST_POOL_BLOCK and recycled through tl->pool, so polled lists
+ * do not hit the allocator on every refresh.
  */
 static __inline__ AG_TlistItem *
 AllocItem(AG_Tlist *tl, AG_Surface *iconsrc)
 {
 	AG_TlistItem *it;
 
-	it = Malloc(sizeof(AG_TlistItem));
+	if (tl->pool == NULL) {
+		AG_TlistItem *block;
+		int i;
+
+		block = Malloc(AG_TLIST_POOL_BLOCK*sizeof(AG_TlistItem));
+		tl->poolBlocks = Realloc(tl->poolBlocks,
+		    (tl->nPoolBlocks+1)*sizeof(void *));
+		tl->poolBlocks[tl->nPoolBlocks++] = block;
+		for (i = AG_TLIST_POOL_BLOCK-1; i >= 0; i--) {
+			block[i].hnext = tl->pool;
+			tl->pool = &block[i];
+		}
+	}
+	it = tl->pool;
+	tl->pool = it->hnext;
+	it->hnext = NULL;
 	it->selected = 0;
 	it->cat = "";
 	it->depth = 0;
@@ -697,14 +885,44 @@ AllocItem(AG_Tlist *tl, AG_Surface *iconsrc)
 	return (it);
 }
 
+/* Rebuild the row index if needed. The Tlist must be locked. */
+static void
+UpdateIndex(AG_Tlist *tl)
+{
+	AG_TlistItem *it;
+	int i = 0;
+
+	if (tl->idxValid) {
+		return;
+	}
+	if ((Uint)tl->nitems > tl->idxSize) {
+		tl->idxSize = tl->nitems;
+		tl->idx = Realloc(tl->idx, tl->idxSize*sizeof(AG_TlistItem *));
+	}
+	TAILQ_FOREACH(it, &tl->items, items) {
+		tl->idx[i++] = it;
+	}
+	tl->idxValid = 1;
+}
+
 /* The Tlist must be locked. */
 static __inline__ void
 InsertItem(AG_Tlist *tl, AG_TlistItem *it, int ins_head)
 {
 	if (ins_head) {
 		TAILQ_INSERT_HEAD(&tl->items, it, items);
+		tl->idxValid = 0;
 	} else {
 		TAILQ_INSERT_TAIL(&tl->items, it, items);
+		if (tl->idxValid) {
+			if ((Uint)tl->nitems >= tl->idxSize) {
+				tl->idxSize = (tl->idxSize > 0) ?
+				              tl->idxSize*2 : 64;
+				tl->idx = Realloc(tl->idx,
+				    tl->idxSize*sizeof(AG_TlistItem *));
+			}
+			tl->idx[tl->nitems] = it;
+		}
 	}
 	tl->nitems++;
 
@@ -971,7 +1189,6 @@ MouseButtonDown(AG_Event *event)
 
 	tind = tl->rOffs + y/tl->item_h + 1;
 
-	/* XXX use array */
 	if ((ti = AG_TlistFindByIndex(tl, tind)) == NULL)
 		return;
 	
@@ -1172,18 +1389,15 @@ KeyUp(AG_Event *event)
 AG_TlistItem *
 AG_TlistFindByIndex(AG_Tlist *tl, int index)
 {
-	AG_TlistItem *it;
-	int i = 0;
+	AG_TlistItem *it = NULL;
 
 	AG_ObjectLock(tl);
-	TAILQ_FOREACH(it, &tl->items, items) {
-		if (++i == index) {
-			AG_ObjectUnlock(tl);
-			return (it);
-		}
+	if (index > 0 && index <= tl->nitems) {
+		UpdateIndex(tl);
+		it = tl->idx[index-1];
 	}
 	AG_ObjectUnlock(tl);
-	return (NULL);
+	return (it);
 }
 
 /*
@@ -1456,6 +1670,7 @@ int
 AG_TlistSort(AG_Tlist *tl)
 {
 	AG_TlistItem *it, **items;
+	AG_SortKeys sk;
 	Uint i = 0;
 
 	if ((items = TryMalloc(tl->nitems*sizeof(AG_TlistItem *))) == NULL) {
@@ -1464,12 +1679,27 @@ AG_TlistSort(AG_Tlist *tl)
 	TAILQ_FOREACH(it, &tl->items, items) {
 		items[i++] = it;
 	}
-	qsort(items, tl->nitems, sizeof(AG_TlistItem *), CompareText);
-	TAILQ_INIT(&tl->items);
+
+	/* Sort by collation keys, or fall back to strcoll() comparisons. */
+	AG_SortKeysInit(&sk, AG_SORT_KEYS_STR);
 	for (i = 0; i < tl->nitems; i++) {
-		TAILQ_INSERT_TAIL(&tl->items, items[i], items);
+		if (AG_SortKeysAddStr(&sk, items[i]->text, i) == -1)
+			break;
+	}
+	TAILQ_INIT(&tl->items);
+	if (i == tl->nitems && AG_SortKeysSort(&sk, 0) == 0) {
+		for (i = 0; i < tl->nitems; i++) {
+			it = items[sk.keys[i].idx];
+			TAILQ_INSERT_TAIL(&tl->items, it, items);
+		}
+	} else {
+		qsort(items, tl->nitems, sizeof(AG_TlistItem *), CompareText);
+		for (i = 0; i < tl->nitems; i++)
+			TAILQ_INSERT_TAIL(&tl->items, items[i], items);
 	}
+	AG_SortKeysFree(&sk);
 	free(items);
+	tl->idxValid = 0;
 	AG_Redraw(tl);
 	return (0);
 }
@@ -39,8 +39,11 @@ typedef struct ag_tlist_item {
 
 	AG_TAILQ_ENTRY(ag_tlist_item) items;	/* Items in list */
 	AG_TAILQ_ENTRY(ag_tlist_item) selitems;	/* Saved selection state */
+	struct ag_tlist_item *hnext;		/* In saved hash or pool */
 } AG_TlistItem;
 
+#define AG_TLIST_POOL_BLOCK 256		/* Items per pool allocation */
+
 typedef AG_TAILQ_HEAD(ag_tlist_itemq, ag_tlist_item) AG_TlistItemQ;
 
 typedef struct ag_tlist {
@@ -82,6 +85,15 @@ typedef struct ag_tlist {
 	int rOffs;			/* Row display offset */
 	AG_Timer dblClickTo;		/* Timer for detecting double clicks */
 	int lastKeyDown;		/* For key repeat */
+	Uint (*hash_fn)(const AG_TlistItem *);
+	AG_TlistItem **idx;		/* Items by row (if idxValid) */
+	Uint idxSize;			/* Allocated idx[] entries */
+	int idxValid;			/* idx[] is in sync with items */
+	AG_TlistItem **selHash;		/* Saved items by hash_fn() key */
+	Uint nSelHash;			/* Buckets in selHash (power of 2) */
+	AG_TlistItem *pool;		/* Free items for reuse */
+	void **poolBlocks;		/* Item blocks allocated */
+	Uint nPoolBlocks;
 } AG_Tlist;
 
 #define AG_TLIST_FOREACH(it, tl) \
@@ -146,29 +158,18 @@ void AG_TlistSetPopupFn(AG_Tlist *, AG_EventFn, const char *, ...);
 void AG_TlistSetChangedFn(AG_Tlist *, AG_EventFn, const char *, ...);
 void AG_TlistSetCompareFn(AG_Tlist *, int (*)(const AG_TlistItem *,
 		          const AG_TlistItem *));
+void AG_TlistSetHashFn(AG_Tlist *, Uint (*)(const AG_TlistItem *));
 int AG_TlistCompareStrings(const AG_TlistItem *, const AG_TlistItem *);
 int AG_TlistComparePtrs(const AG_TlistItem *, const AG_TlistItem *);
 int AG_TlistComparePtrsAndClasses(const AG_TlistItem *, const AG_TlistItem *);
+Uint AG_TlistHashStrings(const AG_TlistItem *);
+Uint AG_TlistHashPtrs(const AG_TlistItem *);
 int AG_TlistSort(AG_Tlist *);
+int AG_TlistVisibleChildren(AG_Tlist *, AG_TlistItem *);
 
 #define AG_TlistBegin AG_TlistClear
 #define AG_TlistEnd AG_TlistRestore
 
-static __inline__ int
-AG_TlistVisibleChildren(AG_Tlist *tl, AG_TlistItem *cit)
-{
-	AG_TlistItem *sit;
-
-	AG_TAILQ_FOREACH(sit, &tl->selitems, selitems) {
-		if (tl->compare_fn(sit, cit))
-			break;
-	}
-	if (sit == NULL) { 
-		return (0);			/* TODO default setting */
-	}
-	return (sit->flags & AG_TLIST_VISIBLE_CHILDREN);
-}
-
 static __inline__ void
 AG_TlistRefresh(AG_Tlist *tl)
 {
@@ -88,14 +88,132 @@ FlushGlyph(AG_TTFGlyph *glyph)
 static void
 FlushCache(AG_TTFFont *ttf)
 {
+	AG_TTFGlyph *gl, *glNext;
 	int i, size = sizeof(ttf->cache) / sizeof(ttf->cache[0]);
 
 	for (i = 0; i < size; i++) {
 		if (ttf->cache[i].cached)
 			FlushGlyph(&ttf->cache[i]);
 	}
-	if (ttf->scratch.cached)
-		FlushGlyph(&ttf->scratch);
+	for (gl = AG_TAILQ_FIRST(&ttf->lru);
+	     gl != AG_TAILQ_END(&ttf->lru);
+	     gl = glNext) {
+		glNext = AG_TAILQ_NEXT(gl, lru);
+		FlushGlyph(gl);
+		Free(gl);
+	}
+	AG_TAILQ_INIT(&ttf->lru);
+	Free(ttf->hash);
+	ttf->hash = NULL;
+	ttf->nBuckets = 0;
+	ttf->nGlyphs = 0;
+	ttf->size = 0;
+}
+
+static __inline__ Uint
+HashGlyph(const AG_TTFFont *ttf, Uint32 ch)
+{
+	return ((ch*2654435761U) & (ttf->nBuckets-1));
+}
+
+/* Double the number of hash buckets and rehash all entries. */
+static int
+GrowHash(AG_TTFFont *ttf)
+{
+	AG_TTFGlyph **hashNew, *gl;
+	Uint nBucketsNew = (ttf->nBuckets > 0) ? ttf->nBuckets*2 :
+	                                         AG_TTF_CACHE_INIT;
+
+	if ((hashNew = TryMalloc(nBucketsNew*sizeof(AG_TTFGlyph *))) == NULL) {
+		return (-1);
+	}
+	memset(hashNew, 0, nBucketsNew*sizeof(AG_TTFGlyph *));
+	Free(ttf->hash);
+	ttf->hash = hashNew;
+	ttf->nBuckets = nBucketsNew;
+
+	AG_TAILQ_FOREACH(gl, &ttf->lru, lru) {
+		Uint h = HashGlyph(ttf, gl->cached);
+
+		gl->hnext = ttf->hash[h];
+		ttf->hash[h] = gl;
+	}
+	return (0);
+}
+
+/* Unlink and free a hashed glyph. */
+static void
+RemoveGlyph(AG_TTFFont *ttf, AG_TTFGlyph *gl)
+{
+	AG_TTFGlyph **pgl;
+
+	for (pgl = &ttf->hash[HashGlyph(ttf, gl->cached)];
+	     *pgl != NULL;
+	     pgl = &(*pgl)->hnext) {
+		if (*pgl == gl) {
+			*pgl = gl->hnext;
+			break;
+		}
+	}
+	AG_TAILQ_REMOVE(&ttf->lru, gl, lru);
+	ttf->nGlyphs--;
+	ttf->size -= gl->size;
+	FlushGlyph(gl);
+	Free(gl);
+}
+
+/*
+ * Evict least recently used glyphs until the hashed glyphs fit within
+ * the budget. The current glyph is never evicted.
+ */
+static void
+TrimCache(AG_TTFFont *ttf)
+{
+	AG_TTFGlyph *gl;
+
+	while (ttf->size > ttf->budget &&
+	       (gl = AG_TAILQ_LAST(&ttf->lru, ag_ttf_glyphq)) != NULL &&
+	       gl != ttf->current) {
+		RemoveGlyph(ttf, gl);
+		ttf->nEvicted++;
+	}
+}
+
+/* Look up a glyph in the hash, creating an empty entry if needed. */
+static AG_TTFGlyph *
+LookupGlyph(AG_TTFFont *ttf, Uint32 ch)
+{
+	AG_TTFGlyph *gl;
+	Uint h;
+
+	if (ttf->nBuckets > 0) {
+		for (gl = ttf->hash[HashGlyph(ttf, ch)];
+		     gl != NULL;
+		     gl = gl->hnext) {
+			if (gl->cached == ch) {
+				if (gl != AG_TAILQ_FIRST(&ttf->lru)) {
+					AG_TAILQ_REMOVE(&ttf->lru, gl, lru);
+					AG_TAILQ_INSERT_HEAD(&ttf->lru, gl,
+					    lru);
+				}
+				return (gl);
+			}
+		}
+	}
+	if (ttf->nGlyphs >= ttf->nBuckets && GrowHash(ttf) == -1) {
+		return (NULL);
+	}
+	if ((gl = TryMalloc(sizeof(AG_TTFGlyph))) == NULL) {
+		return (NULL);
+	}
+	memset(gl, 0, sizeof(AG_TTFGlyph));
+	gl->cached = ch;
+	h = HashGlyph(ttf, ch);
+	gl->hnext = ttf->hash[h];
+	ttf->hash[h] = gl;
+	AG_TAILQ_INSERT_HEAD(&ttf->lru, gl, lru);
+	ttf->nGlyphs++;
+	return (gl);
 }
 
 /* Load a vector font (font->spec should be initialized). */
@@ -112,6 +230,8 @@ AG_TTFOpenFont(AG_Font *font)
 		return (-1);
 	}
 	memset(ttf, 0, sizeof(AG_TTFFont));
+	AG_TAILQ_INIT(&ttf->lru);
+	ttf->budget = AG_TTF_CACHE_BUDGET;
 
 	switch (spec->sourceType) {
 	case AG_FONT_SOURCE_FILE:
@@ -451,20 +571,65 @@ LoadGlyph(AG_TTFFont *ttf, Uint32 ch, AG_TTFGlyph *cached, int want)
 	return (0);
 }
 
-/* Load the glyph corresponding to the specified Unicode character. */
+/*
+ * Load the glyph corresponding to the specified Unicode character.
+ * Latin-1 glyphs live in a fixed table; other glyphs are kept in a
+ * hash table bounded by the font's cache budget (LRU eviction).
+ */
 int
 AG_TTFFindGlyph(AG_TTFFont *font, Uint32 ch, int want)
 {
+	AG_TTFGlyph *gl;
+	Uint sizePrev;
+	int rv;
+
 	if (ch < 256) {
-		font->current = &font->cache[ch];
+		gl = &font->cache[ch];
 	} else {
-		if (font->scratch.cached != ch) {
-			FlushGlyph(&font->scratch);
-		}
-		font->current = &font->scratch;
+		if ((gl = LookupGlyph(font, ch)) == NULL)
+			return (-1);
+	}
+	font->current = gl;
+
+	if ((gl->stored & want) == want) {
+		font->nHits++;
+		return (0);
+	}
+	font->nMisses++;
+
+	sizePrev = gl->size;
+	rv = LoadGlyph(font, ch, gl, want);
+	gl->size = gl->bitmap.pitch*gl->bitmap.rows +
+	           gl->pixmap.pitch*gl->pixmap.rows;
+	if (ch >= 256) {
+		gl->cached = ch;		/* Hash key */
+		font->size += gl->size - sizePrev;
+		TrimCache(font);
 	}
-	return (((font->current->stored & want) != want) ?
-	    LoadGlyph(font, ch, font->current, want) :
-	    0);
+	return (rv);
+}
+
+/*
+ * Set the maximum number of bytes of rendered glyphs (outside of the
+ * Latin-1 range) to keep cached for this font.
+ */
+void
+AG_TTFSetCacheBudget(AG_TTFFont *font, Uint budget)
+{
+	font->budget = budget;
+	font->current = NULL;
+	TrimCache(font);
+}
+
+/* Return glyph cache statistics for the given font. */
+void
+AG_TTFGetCacheStats(AG_TTFFont *font, AG_TTFCacheStats *st)
+{
+	st->nGlyphs = font->nGlyphs;
+	st->size = font->size;
+	st->budget = font->budget;
+	st->nHits = font->nHits;
+	st->nMisses = font->nMisses;
+	st->nEvicted = font->nEvicted;
 }
 #endif /* HAVE_FREETYPE */
@@ -26,8 +26,23 @@ typedef struct ag_ttf_glyph {
 	int yoffset;
 	int advance;
 	Uint32 cached;
+	Uint size;				/* Bitmap/pixmap bytes */
+	struct ag_ttf_glyph *hnext;		/* In hash bucket */
+	AG_TAILQ_ENTRY(ag_ttf_glyph) lru;	/* In LRU list */
 } AG_TTFGlyph;
 
+#define AG_TTF_CACHE_INIT	64		/* Initial hash buckets */
+#define AG_TTF_CACHE_BUDGET	0x100000	/* Default bytes per font */
+
+/* Glyph cache statistics. */
+typedef struct ag_ttf_cache_stats {
+	Uint nGlyphs;			/* Hashed glyphs */
+	Uint size;			/* Bytes used by hashed glyphs */
+	Uint budget;			/* Byte budget for hashed glyphs */
+	Uint nHits, nMisses;		/* Lookup statistics */
+	Uint nEvicted;			/* Glyphs evicted */
+} AG_TTFCacheStats;
+
 typedef struct ag_ttf_font {
 	FT_Face	face;
 	int height;
@@ -41,8 +56,16 @@ typedef struct ag_ttf_font {
 	int underline_height;
 
 	AG_TTFGlyph *current;
-	AG_TTFGlyph cache[256];	/* Transform cache */
-	AG_TTFGlyph scratch;
+	AG_TTFGlyph cache[256];	/* Transform cache (Latin-1) */
+
+	AG_TTFGlyph **hash;		/* Other glyphs (chained hash) */
+	Uint nBuckets;			/* Hash buckets (power of 2) */
+	Uint nGlyphs;			/* Glyphs in hash */
+	Uint size;			/* Bytes used by hashed glyphs */
+	Uint budget;			/* Byte budget for hashed glyphs */
+	Uint nHits, nMisses;		/* Lookup statistics */
+	Uint nEvicted;			/* Glyphs evicted */
+	AG_TAILQ_HEAD(ag_ttf_glyphq, ag_ttf_glyph) lru; /* Most recent first */
 	
 	int font_size_family;		/* For non-scalable formats */
 } AG_TTFFont;
@@ -60,6 +83,8 @@ void AG_TTFDestroy(void);
 int  AG_TTFOpenFont(struct ag_font *);
 void AG_TTFCloseFont(struct ag_font *);
 int  AG_TTFFindGlyph(AG_TTFFont *, Uint32, int);
+void AG_TTFSetCacheBudget(AG_TTFFont *, Uint);
+void AG_TTFGetCacheStats(AG_TTFFont *, AG_TTFCacheStats *);
 __END_DECLS
 
 #include <agar/gui/close.h>
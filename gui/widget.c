@@ -316,6 +316,7 @@ Init(void *obj)
 	wid->nsurfaces = 0;
 	wid->surfaces = NULL;
 	wid->surfaceFlags = NULL;
+	wid->surfaceDirty = NULL;
 	wid->textures = NULL;
 	wid->texcoords = NULL;
 	AG_TblInit(&wid->actions, 32, 0);
@@ -963,6 +964,7 @@ Destroy(void *obj)
 	}
 	Free(wid->surfaces);
 	Free(wid->surfaceFlags);
+	Free(wid->surfaceDirty);
 	Free(wid->textures);
 	Free(wid->texcoords);
 }
@@ -1212,6 +1214,15 @@ AG_WidgetDraw(void *p)
 	     WIDGET_OPS(wid)->draw == NULL)
 		goto out;
 
+	if (wid->drv != NULL && AGDRIVER_SINGLE(wid->drv) &&
+	    (AGDRIVER_SW(wid->drv)->flags & AG_DRIVER_SW_DAMAGE_PASS)) {
+		AG_Rect2 *rd = &AGDRIVER_SW(wid->drv)->rDamage;
+
+		if (wid->rView.x1 >= rd->x2 || wid->rView.x2 <= rd->x1 ||
+		    wid->rView.y1 >= rd->y2 || wid->rView.y2 <= rd->y1)
+			goto out;		/* Outside of damaged area */
+	}
+
 	if (wid->flags & AG_WIDGET_DISABLED) {       wid->cState = AG_DISABLED_STATE; }
 	else if (wid->flags & AG_WIDGET_MOUSEOVER) { wid->cState = AG_HOVER_STATE; }
 	else if (wid->flags & AG_WIDGET_FOCUSED) {   wid->cState = AG_FOCUSED_STATE; }
@@ -1242,6 +1253,35 @@ out:
 	AG_ObjectUnlock(wid);
 }
 
+/*
+ * Request a redraw of the given area of a widget (in widget coordinates).
+ * On single-window drivers supporting damage tracking, only the windows
+ * and widgets intersecting the area are redrawn. Otherwise, this is
+ * equivalent to AG_Redraw().
+ */
+void
+AG_WidgetRedrawRect(void *obj, AG_Rect r)
+{
+	AG_Widget *wid = obj;
+	AG_Window *win = wid->window;
+	AG_Driver *drv = wid->drv;
+	AG_Rect rView;
+
+	if (win == NULL) {
+		return;
+	}
+	if (drv == NULL || !AGDRIVER_SINGLE(drv) ||
+	    !(AGDRIVER_SW_CLASS(drv)->flags & AG_DRIVER_SW_CLASS_DAMAGE) ||
+	    !win->visible || win->dirty) {
+		win->dirty = 1;
+		return;
+	}
+	r.x += wid->rView.x1;
+	r.y += wid->rView.y1;
+	rView = AG_Rect2ToRect(wid->rView);
+	AG_WM_AddDamage(AGDRIVER_SW(drv), AG_RectIntersect(&r, &rView));
+}
+
 static void
 SizeRequest(void *p, AG_SizeReq *r)
 {
@@ -1327,7 +1367,7 @@ AG_WidgetSensitive(void *obj, int x, int y)
 	AG_Rect2 rx = wt->rSens;
 
 	while ((wtParent = OBJECT(wtParent)->parent) != NULL) {
-		if (AG_OfClass(wtParent, "AG_Widget:AG_Window:*")) {
+		if (AG_OfSubclass(wtParent, &agWindowClass)) {
 			break;
 		}
 		rx = AG_RectIntersect2(&rx, &wtParent->rSens);
@@ -1348,7 +1388,7 @@ AG_WidgetFindFocused(void *p)
 	AG_LockVFS(wid);
 	AG_ObjectLock(wid);
 
-	if (!AG_OfClass(wid, "AG_Widget:AG_Window:*")) {
+	if (!AG_OfSubclass(wid, &agWindowClass)) {
 		if ((wid->flags & AG_WIDGET_FOCUSED) == 0 ||
 		    (wid->flags & AG_WIDGET_VISIBLE) == 0 ||
 		    (wid->flags & AG_WIDGET_DISABLED)) {
@@ -1385,7 +1425,7 @@ AG_WidgetUpdateCoords(void *obj, int x, int y)
 	wid->flags &= ~(AG_WIDGET_UPDATE_WINDOW);
 
 	if (wid->drv != NULL && AGDRIVER_MULTIPLE(wid->drv) &&
-	    AG_OfClass(wid, "AG_Widget:AG_Window:*")) {
+	    AG_OfSubclass(wid, &agWindowClass)) {
 		/* Multiple-window drivers use window coordinate systems */
 		x = 0;
 		y = 0;
@@ -1674,6 +1714,8 @@ AG_WidgetMapSurface(void *obj, AG_Surface *su)
 		    (wid->nsurfaces+1)*sizeof(AG_Surface *));
 		wid->surfaceFlags = Realloc(wid->surfaceFlags,
 		    (wid->nsurfaces+1)*sizeof(Uint));
+		wid->surfaceDirty = Realloc(wid->surfaceDirty,
+		    (wid->nsurfaces+1)*sizeof(AG_Rect));
 		wid->textures = Realloc(wid->textures,
 		    (wid->nsurfaces+1)*sizeof(Uint64)); // WDZ - Texture
 		wid->texcoords = Realloc(wid->texcoords,
@@ -1718,43 +1760,108 @@ AG_WidgetReplaceSurface(void *obj, int s, AG_Surface *su)
 	AG_ObjectUnlock(wid);
 }
 
+/*
+ * Signal a change in the given region of a mapped surface. Drivers may
+ * then update only that part of the texture. Regions accumulate (as their
+ * bounding box) until the texture is next updated.
+ */
+void
+AG_WidgetUpdateSurfaceRect(void *obj, int s, AG_Rect r)
+{
+	AG_Widget *wid = obj;
+	Uint *flags;
+	AG_Rect *rd;
+
+	AG_ObjectLock(wid);
+#ifdef AG_DEBUG
+	if (s < 0 || s >= wid->nsurfaces)
+		AG_FatalError("Invalid surface handle");
+#endif
+	flags = &wid->surfaceFlags[s];
+	rd = &wid->surfaceDirty[s];
+	if (!(*flags & AG_WIDGET_SURFACE_REGEN)) {
+		*flags |= (AG_WIDGET_SURFACE_REGEN|AG_WIDGET_SURFACE_REGEN_RECT);
+		*rd = r;
+	} else if (*flags & AG_WIDGET_SURFACE_REGEN_RECT) {
+		int x2 = MAX(rd->x+rd->w, r.x+r.w);
+		int y2 = MAX(rd->y+rd->h, r.y+r.h);
+
+		rd->x = MIN(rd->x, r.x);
+		rd->y = MIN(rd->y, r.y);
+		rd->w = x2 - rd->x;
+		rd->h = y2 - rd->y;
+	}					/* Else entire surface is pending */
+	AG_ObjectUnlock(wid);
+}
+
+/*
+ * Style attributes resolved by CompileStyleRecursive(). The keys are
+ * looked up in style sheets as a set (see AG_LookupStyleSheetValues()).
+ */
+enum {
+	STYLE_FONT_FAMILY,
+	STYLE_FONT_SIZE,
+	STYLE_FONT_WEIGHT,
+	STYLE_COLORS,					/* "color#state" */
+	STYLE_COLORS_ANY = STYLE_COLORS +		/* "color" */
+	                   AG_WIDGET_NSTATES*AG_WIDGET_NCOLORS,
+	STYLE_LAST = STYLE_COLORS_ANY + AG_WIDGET_NCOLORS
+};
+static const char *styleKeys[STYLE_LAST];
+static char styleColorKeys[AG_WIDGET_NSTATES][AG_WIDGET_NCOLORS]
+                          [AG_VARIABLE_NAME_MAX];
+
+static void
+InitStyleKeys(void)
+{
+	int i, j;
+
+	styleKeys[STYLE_FONT_FAMILY] = "font-family";
+	styleKeys[STYLE_FONT_SIZE] = "font-size";
+	styleKeys[STYLE_FONT_WEIGHT] = "font-weight";
+	for (i = 0; i < AG_WIDGET_NSTATES; i++) {
+		for (j = 0; j < AG_WIDGET_NCOLORS; j++) {
+			char *key = styleColorKeys[i][j];
+
+			Strlcpy(key, agWidgetColorNames[j], AG_VARIABLE_NAME_MAX);
+			Strlcat(key, agWidgetStateNames[i], AG_VARIABLE_NAME_MAX);
+			styleKeys[STYLE_COLORS + i*AG_WIDGET_NCOLORS + j] = key;
+		}
+	}
+	for (j = 0; j < AG_WIDGET_NCOLORS; j++)
+		styleKeys[STYLE_COLORS_ANY + j] = agWidgetColorNames[j];
+}
+
 /*
  * Rebuild the effective style parameters of a widget and its descendants
  * based on its style attributes. Any required fonts are loaded. This
  * should be called whenever style attributes are changed.
  */
 static void
-CompileStyleRecursive(AG_Widget *wid, const char *parentFace,
-    double parentPtSize, Uint parentFlags,
+CompileStyleRecursive(AG_Widget *wid, AG_StyleSheet *css,
+    const char *parentFace, double parentPtSize, Uint parentFlags,
     AG_WidgetPalette parentPalette)
 {
-	AG_StyleSheet *css = &agDefaultCSS;
+	static const char *noVals[STYLE_LAST];
 	char face[256];
 	double ptSize;
 	Uint flags = parentFlags;
 	AG_Widget *chld;
 	AG_Variable *V;
 	int i, j;
-	AG_Object *po;
-	char *cssData;
+	const char **vals, *cssData;
 	double v;
 	char *ep;
 
-	/* Select the effective style sheet for this widget. */
-	for (po = OBJECT(wid);
-	     po->parent != NULL && AG_OfClass(po->parent, "AG_Widget:*");
-	     po = po->parent) {
-		if (WIDGET(po)->css != NULL) {
-			css = WIDGET(po)->css;
-			break;
-		}
-	}
+	if ((vals = AG_LookupStyleSheetValues(css, wid, styleKeys, STYLE_LAST))
+	    == NULL)
+		vals = noVals;
 
 	/* Set the font attributes. */
 	if ((V = AG_GetVariableLocked(wid, "font-family")) != NULL) {
 		Strlcpy(face, V->data.s, sizeof(face));
 		AG_UnlockVariable(V);
-	} else if (AG_LookupStyleSheet(css, wid, "font-family", &cssData)) {
+	} else if ((cssData = vals[STYLE_FONT_FAMILY]) != NULL) {
 		Strlcpy(face, cssData, sizeof(face));
 	} else {
 		Strlcpy(face, parentFace, sizeof(face));
@@ -1763,7 +1870,7 @@ CompileStyleRecursive(AG_Widget *wid, const char *parentFace,
 		v = strtod(V->data.s, &ep);
 		ptSize = (*ep == '%') ? parentPtSize*(v/100.0) : v;
 		AG_UnlockVariable(V);
-	} else if (AG_LookupStyleSheet(css, wid, "font-size", &cssData)) {
+	} else if ((cssData = vals[STYLE_FONT_SIZE]) != NULL) {
 		v = strtod(cssData, &ep);
 		ptSize = (*ep == '%') ? parentPtSize*(v/100.0) : v;
 	} else {
@@ -1776,7 +1883,7 @@ CompileStyleRecursive(AG_Widget *wid, const char *parentFace,
 			flags &= ~(AG_FONT_BOLD);
 		}
 		AG_UnlockVariable(V);
-	} else if (AG_LookupStyleSheet(css, wid, "font-weight", &cssData)) {
+	} else if ((cssData = vals[STYLE_FONT_WEIGHT]) != NULL) {
 		if (AG_Strcasecmp(cssData, "bold") == 0) {
 			flags |= AG_FONT_BOLD;
 		} else if (AG_Strcasecmp(cssData, "normal") == 0) {
@@ -1796,25 +1903,18 @@ CompileStyleRecursive(AG_Widget *wid, const char *parentFace,
 	for (i = 0; i < AG_WIDGET_NSTATES; i++) {
 		for (j = 0; j < AG_WIDGET_NCOLORS; j++) {
 			AG_Color *parentColor = &parentPalette.c[i][j];
-			char vName[AG_VARIABLE_NAME_MAX];
+			int k = STYLE_COLORS + i*AG_WIDGET_NCOLORS + j;
 
-			Strlcpy(vName, agWidgetColorNames[j], sizeof(vName));
-			Strlcat(vName, agWidgetStateNames[i], sizeof(vName));
-			if ((V = AG_GetVariableLocked(wid, vName)) != NULL) {
+			if ((V = AG_GetVariableLocked(wid, styleKeys[k])) != NULL) {
 				wid->pal.c[i][j] = AG_ColorFromString(V->data.s,
 				    parentColor);
 				AG_UnlockVariable(V);
-			} else if (AG_LookupStyleSheet(css, wid, vName, &cssData)) {
+			} else if ((cssData = vals[k]) != NULL ||
+			           (cssData = vals[STYLE_COLORS_ANY + j]) != NULL) {
 				wid->pal.c[i][j] = AG_ColorFromString(cssData,
 				    parentColor);
 			} else {
-				Strlcpy(vName, agWidgetColorNames[j], sizeof(vName));
-				if (AG_LookupStyleSheet(css, wid, vName, &cssData)) {
-					wid->pal.c[i][j] = AG_ColorFromString(cssData,
-					    parentColor);
-				} else {
-					wid->pal.c[i][j] = *parentColor;
-				}
+				wid->pal.c[i][j] = *parentColor;
 			}
 		}
 	}
@@ -1845,29 +1945,47 @@ CompileStyleRecursive(AG_Widget *wid, const char *parentFace,
 	}
 
 
-	OBJECT_FOREACH_CHILD(chld, wid, ag_widget)
-		CompileStyleRecursive(chld, face, ptSize, flags, wid->pal);
+	OBJECT_FOREACH_CHILD(chld, wid, ag_widget) {
+		CompileStyleRecursive(chld,
+		    (chld->css != NULL) ? chld->css : css,
+		    face, ptSize, flags, wid->pal);
+	}
 }
 void
 AG_WidgetCompileStyle(void *obj)
 {
 	AG_Widget *wid = obj;
 	AG_Widget *parent;
+	AG_StyleSheet *css = &agDefaultCSS;
+	AG_Object *po;
 
 	AG_LockVFS(wid);
 	AG_MutexLock(&agTextLock);
 
+	if (styleKeys[0] == NULL)
+		InitStyleKeys();
+
+	/* Select the effective style sheet for this widget. */
+	for (po = OBJECT(wid);
+	     po->parent != NULL && AG_OfSubclass(po->parent, &agWidgetClass);
+	     po = po->parent) {
+		if (WIDGET(po)->css != NULL) {
+			css = WIDGET(po)->css;
+			break;
+		}
+	}
+
 	if ((parent = OBJECT(wid)->parent) != NULL &&
-	    AG_OfClass(parent, "AG_Widget:*") &&
+	    AG_OfSubclass(parent, &agWidgetClass) &&
 	    parent->font != NULL) {
-		CompileStyleRecursive(wid,
+		CompileStyleRecursive(wid, css,
 		    OBJECT(parent->font)->name,
 		    parent->font->spec.size,
 		    parent->font->flags,
 		    parent->pal);
 	} else {
 
-		CompileStyleRecursive(wid,
+		CompileStyleRecursive(wid, css,
 		    OBJECT(agDefaultFont)->name,
 		    agDefaultFont->spec.size,
 		    agDefaultFont->flags,
@@ -204,6 +204,8 @@ typedef struct ag_widget {
 	Uint        *surfaceFlags;	/* Surface flags */
 #define AG_WIDGET_SURFACE_NODUP	0x01	/* Don't free on destroy */
 #define AG_WIDGET_SURFACE_REGEN	0x02	/* Texture needs to be regenerated */
+#define AG_WIDGET_SURFACE_REGEN_RECT 0x04 /* Only surfaceDirty[] changed */
+	AG_Rect     *surfaceDirty;	/* Modified regions (for REGEN_RECT) */
 	Uint        nsurfaces;
 	Uint64        *textures;		/* Cached textures (driver-specific) */ // WDZ - Textures
 	AG_TexCoord *texcoords;		/* Cached texture coordinates */
@@ -279,6 +281,7 @@ extern const char *agWidgetColorNames[];
 extern AG_WidgetPalette agDefaultPalette;
 
 void       AG_WidgetDraw(void *);
+void       AG_WidgetRedrawRect(void *, AG_Rect);
 void       AG_WidgetSizeReq(void *, AG_SizeReq *);
 void       AG_WidgetSizeAlloc(void *, AG_SizeAlloc *);
 void       AG_WidgetSetFocusable(void *, int);
@@ -293,6 +296,7 @@ void       AG_WidgetUpdateCoords(void *, int, int);
 
 int	 AG_WidgetMapSurface(void *, AG_Surface *);
 void	 AG_WidgetReplaceSurface(void *, int, AG_Surface *);
+void	 AG_WidgetUpdateSurfaceRect(void *, int, AG_Rect);
 #define	 AG_WidgetUnmapSurface(w, n) \
 	 AG_WidgetReplaceSurface((w),(n),NULL)
 #define  AG_WidgetBlitSurface(p,n,x,y) \
@@ -437,6 +441,8 @@ AG_ExpandVert(void *wid)
 #ifdef HAVE_OPENGL
 # define AG_WidgetUpdateSurface(wid,name) do { \
 	 AGWIDGET(wid)->surfaceFlags[(name)] |= AG_WIDGET_SURFACE_REGEN; \
+	 AGWIDGET(wid)->surfaceFlags[(name)] &= \
+	     ~(AG_WIDGET_SURFACE_REGEN_RECT); \
 } while (0)
 #else
 # define AG_WidgetUpdateSurface(wid,name)
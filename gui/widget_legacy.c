@@ -167,13 +167,10 @@ AG_WidgetBind(void *pObj, const char *name, enum ag_variable_type type, ...)
 
 	AG_ObjectLock(obj);
 
-	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_ObjectFindVariable(obj, name)) == NULL) {
 		V = Malloc(sizeof(AG_Variable));
 		Strlcpy(V->name, name, sizeof(V->name));
+		AG_ObjectInsertVariable(obj, V);
 	}
 	V->type = type;
 	V->mutex = NULL;
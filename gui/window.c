@@ -337,6 +337,7 @@ Detach(AG_Event *event)
 	 * until the end of the current event processing cycle.
 	 */
 	TAILQ_INSERT_TAIL(&agWindowDetachQ, win, detach);
+	AG_WakeupEventLoop();
 
 	/* Queued Show/Hide operations would be redundant. */
 	TAILQ_FOREACH(other, &agWindowHideQ, visibility) {
@@ -864,6 +865,9 @@ OnHide(AG_Event *event)
 				AGDRIVER_CLASS(drv)->updateRegion(drv,
 				    AG_RECT(WIDGET(win)->x, WIDGET(win)->y,
 				            WIDTH(win), HEIGHT(win)));
+			AG_WM_AddDamage(dsw,
+			    AG_RECT(WIDGET(win)->x, WIDGET(win)->y,
+			            WIDTH(win), HEIGHT(win)));
 		}
 		break;
 	case AG_WM_MULTIPLE:
@@ -948,6 +952,7 @@ AG_WindowShow(AG_Window *win)
 			AG_LockVFS(&agDrivers);
 			TAILQ_INSERT_TAIL(&agWindowShowQ, win, visibility);
 			AG_UnlockVFS(&agDrivers);
+			AG_WakeupEventLoop();
 		} else
 #endif
 		{
@@ -979,6 +984,7 @@ AG_WindowHide(AG_Window *win)
 			AG_LockVFS(&agDrivers);
 			TAILQ_INSERT_TAIL(&agWindowHideQ, win, visibility);
 			AG_UnlockVFS(&agDrivers);
+			AG_WakeupEventLoop();
 		} else
 #endif
 		{
@@ -992,6 +998,54 @@ out:
 	AG_UnlockVFS(&agDrivers);
 }
 
+/*
+ * Redraw the damaged regions of a single-window display. Only the windows
+ * (and widgets) intersecting a damage rectangle are rendered, clipped to
+ * that rectangle, and only the damaged areas are flushed to the display.
+ */
+static void
+DrawDamagedSW(AG_DriverSw *dsw)
+{
+	AG_Driver *drv = (AG_Driver *)dsw;
+	AG_Rect2 damage[AG_DRIVER_SW_DAMAGE_MAX], *rd;
+	AG_Rect r;
+	AG_Window *win;
+	Uint i, nDamage;
+
+	AG_MutexLock(&dsw->damageLock);
+	nDamage = dsw->nDamage;
+	memcpy(damage, dsw->damage, nDamage*sizeof(AG_Rect2));
+	dsw->nDamage = 0;
+	AG_MutexUnlock(&dsw->damageLock);
+
+	dsw->nPixelsDrawn = 0;
+	dsw->flags |= AG_DRIVER_SW_DAMAGE_PASS;
+	AG_BeginRendering(drv);
+	for (i = 0; i < nDamage; i++) {
+		rd = &damage[i];
+		r = AG_Rect2ToRect(*rd);
+		dsw->rDamage = *rd;
+		AGDRIVER_CLASS(drv)->pushClipRect(drv, r);
+		AG_FOREACH_WINDOW(win, drv) {
+			AG_ObjectLock(win);
+			if (win->visible &&
+			    WIDGET(win)->rView.x1 < rd->x2 &&
+			    WIDGET(win)->rView.x2 > rd->x1 &&
+			    WIDGET(win)->rView.y1 < rd->y2 &&
+			    WIDGET(win)->rView.y2 > rd->y1) {
+				AG_WidgetDraw(win);
+			}
+			win->dirty = 0;
+			AG_ObjectUnlock(win);
+		}
+		AGDRIVER_CLASS(drv)->popClipRect(drv);
+		AGDRIVER_CLASS(drv)->updateRegion(drv, r);
+		dsw->nPixelsDrawn += rd->w*rd->h;
+	}
+	AG_EndRendering(drv);
+	dsw->flags &= ~(AG_DRIVER_SW_DAMAGE_PASS);
+}
+
 /*
  * Render all windows that need to be redrawn. This is typically invoked
  * by the main event loop, once events have been processed.
@@ -1028,7 +1082,22 @@ AG_WindowDrawQueued(void)
 					goto out;
 				}
 				dsw->rLast = t;
-				
+
+				if ((AGDRIVER_SW_CLASS(drv)->flags &
+				     AG_DRIVER_SW_CLASS_DAMAGE) &&
+				    !(dsw->flags & AG_DRIVER_SW_REDRAW)) {
+					/* Redraw damaged regions only. */
+					AG_FOREACH_WINDOW(win, drv) {
+						if (win->visible && win->dirty)
+							AG_WM_AddDamage(dsw,
+							    AG_Rect2ToRect(
+							    WIDGET(win)->rView));
+					}
+					if (dsw->nDamage > 0) {
+						DrawDamagedSW(dsw);
+					}
+					break;
+				}
 				AG_FOREACH_WINDOW(win, drv) {
 					if (win->visible && win->dirty)
 						break;
@@ -1036,9 +1105,16 @@ AG_WindowDrawQueued(void)
 				if (win != NULL ||
 				    (dsw->flags & AG_DRIVER_SW_REDRAW)) {
 					dsw->flags &= ~(AG_DRIVER_SW_REDRAW);
+					dsw->nDamage = 0;
+					dsw->nPixelsDrawn = 0;
 					AG_BeginRendering(drv);
 					AG_FOREACH_WINDOW(win, drv) {
 						AG_ObjectLock(win);
+						if (win->visible) {
+							dsw->nPixelsDrawn +=
+							    WIDTH(win)*
+							    HEIGHT(win);
+						}
 						AG_WindowDraw(win);
 						AG_ObjectUnlock(win);
 					}
@@ -1255,6 +1331,7 @@ UpdateWindowBG(AG_Window *win, AG_Rect rPrev)
 		AGDRIVER_CLASS(drv)->fillRect(drv, r, AGDRIVER_SW(drv)->bgColor);
 		if (AGDRIVER_CLASS(drv)->updateRegion != NULL)
 			AGDRIVER_CLASS(drv)->updateRegion(drv, r);
+		AG_WM_AddDamage(AGDRIVER_SW(drv), r);
 	}
 	if (HEIGHT(win) < rPrev.h) {				/* H-resize */
 		r.x = rPrev.x;
@@ -1265,6 +1342,7 @@ UpdateWindowBG(AG_Window *win, AG_Rect rPrev)
 		AGDRIVER_CLASS(drv)->fillRect(drv, r, AGDRIVER_SW(drv)->bgColor);
 		if (AGDRIVER_CLASS(drv)->updateRegion != NULL)
 			AGDRIVER_CLASS(drv)->updateRegion(drv, r);
+		AG_WM_AddDamage(AGDRIVER_SW(drv), r);
 	}
 }
 
@@ -1539,6 +1617,7 @@ IconMotion(AG_Event *event)
 			r.h = AGDRIVER_SW(drv)->h;
 			AGDRIVER_CLASS(drv)->fillRect(drv, r,
 			    AGDRIVER_SW(drv)->bgColor);
+			AG_WM_AddDamage(AGDRIVER_SW(drv), r);
 			r = AG_Rect2ToRect(WIDGET(wDND)->rView);
 			if (AGDRIVER_CLASS(drv)->updateRegion != NULL)
 				AGDRIVER_CLASS(drv)->updateRegion(drv, r);
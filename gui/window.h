@@ -383,12 +383,16 @@ AG_WindowSetGeometryMax(AG_Window *win)
 	AG_WindowSetGeometry(win, 0, 0, wMax, hMax);
 }
 
-/* Request widget redraw. */
+/* Request widget redraw (waking up the event loop if needed). */
 static __inline__ void
 AG_Redraw(void *obj)
 {
-	if (AGWIDGET(obj)->window != NULL)
-		AGWIDGET(obj)->window->dirty = 1;
+	AG_Window *win = AGWIDGET(obj)->window;
+
+	if (win != NULL && !win->dirty) {
+		win->dirty = 1;
+		AG_WakeupEventLoop();
+	}
 }
 
 /*
@@ -12,10 +12,12 @@
 #include "config/datadir.h"
 
 extern const AG_TestCase charsetsTest;
+extern const AG_TestCase classPatternsTest;
 extern const AG_TestCase compositingTest;
 extern const AG_TestCase configSettingsTest;
 extern const AG_TestCase consoleTest;
 extern const AG_TestCase customWidgetTest;
+extern const AG_TestCase dataSourcesTest;
 extern const AG_TestCase fixedResTest;
 extern const AG_TestCase focusingTest;
 extern const AG_TestCase fontSelectorTest;
@@ -45,16 +47,20 @@ extern const AG_TestCase textboxTest;
 extern const AG_TestCase textDlgTest;
 extern const AG_TestCase threadsTest;
 extern const AG_TestCase timeoutsTest;
+extern const AG_TestCase tlistTest;
 extern const AG_TestCase unitconvTest;
+extern const AG_TestCase variablesTest;
 extern const AG_TestCase widgetsTest;
 extern const AG_TestCase windowsTest;
 
 const AG_TestCase *testCases[] = {
 	&charsetsTest,
+	&classPatternsTest,
 	&compositingTest,
 	&configSettingsTest,
 	&consoleTest,
 	&customWidgetTest,
+	&dataSourcesTest,
 	&fixedResTest,
 	&focusingTest,
 	&fontSelectorTest,
@@ -86,7 +92,9 @@ const AG_TestCase *testCases[] = {
 	&textDlgTest,
 	&threadsTest,
 	&timeoutsTest,
+	&tlistTest,
 	&unitconvTest,
+	&variablesTest,
 	&widgetsTest,
 	&windowsTest,
 	NULL
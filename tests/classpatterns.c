@@ -0,0 +1,200 @@
+/*	Public domain	*/
+
+/*
+ * This program tests the matching of object classes against class patterns
+ * (see AG_OfClass(3)), for registered classes as well as for classes which
+ * were never registered with AG_RegisterClass().
+ */
+
+#include "agartest.h"
+
+#include <string.h>
+
+static AG_ObjectClass baseClass = {
+	"ClassTestBase", sizeof(AG_Object), { 0,0 },
+	NULL, NULL, NULL, NULL, NULL, NULL
+};
+static AG_ObjectClass derivedClass = {
+	"ClassTestBase:ClassTestDerived", sizeof(AG_Object), { 0,0 },
+	NULL, NULL, NULL, NULL, NULL, NULL
+};
+static AG_ObjectClass lateClass = {		/* Registered during test */
+	"ClassTestBase:ClassTestLate", sizeof(AG_Object), { 0,0 },
+	NULL, NULL, NULL, NULL, NULL, NULL
+};
+static AG_ObjectClass unregClass = {		/* Never registered */
+	"ClassTestBase:ClassTestUnreg", sizeof(AG_Object), { 0,0 },
+	NULL, NULL, NULL, NULL, NULL, NULL
+};
+static AG_ObjectClass orphanClass = {		/* Never registered */
+	"ClassTestOther:ClassTestOrphan", sizeof(AG_Object), { 0,0 },
+	NULL, NULL, NULL, NULL, NULL, NULL
+};
+static AG_ObjectClass likeClass = {		/* Never registered */
+	"ClassTestBaseLike", sizeof(AG_Object), { 0,0 },
+	NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static AG_ObjectClass *classes[] = {
+	&baseClass, &derivedClass, &lateClass, &unregClass, &orphanClass,
+	&likeClass
+};
+#define NCLASSES (sizeof(classes)/sizeof(classes[0]))
+
+/* Patterns and expected result for each class (in order of classes[]). */
+static const struct {
+	const char *pat;
+	int match[NCLASSES];
+} patterns[] = {
+	{ ":*",					{ 1,1,1,1,1,1 } },
+	{ "ClassTestBase",			{ 1,0,0,0,0,0 } },
+	{ "ClassTestBase:*",			{ 1,1,1,1,0,0 } },
+	{ "ClassTestBase:ClassTestDerived",	{ 0,1,0,0,0,0 } },
+	{ "ClassTestBase:ClassTestDerived:*",	{ 0,1,0,0,0,0 } },
+	{ "ClassTestBase:ClassTestLate:*",	{ 0,0,1,0,0,0 } },
+	{ "ClassTestBase:ClassTestUnreg",	{ 0,0,0,1,0,0 } },
+	{ "ClassTestBase:ClassTestUnreg:*",	{ 0,0,0,1,0,0 } },
+	{ "ClassTestBaseLike:*",		{ 0,0,0,0,0,1 } },
+	{ "ClassTestOther:*",			{ 0,0,0,0,1,0 } },
+	{ "ClassTestOther:ClassTestOrphan",	{ 0,0,0,0,1,0 } },
+	{ "ClassTestBase:ClassTestOrphan",	{ 0,0,0,0,0,0 } },
+	{ "ClassTestNone:*",			{ 0,0,0,0,0,0 } },
+};
+#define NPATTERNS (sizeof(patterns)/sizeof(patterns[0]))
+
+/*
+ * Match every class against every pattern, both through the compiled
+ * (cached) pattern and the hierarchy string, against the expected result.
+ */
+static int
+MatchPatterns(AG_TestInstance *ti)
+{
+	AG_ClassPattern cp;
+	Uint i, j;
+	int rv, rvStr;
+
+	for (i = 0; i < NPATTERNS; i++) {
+		AG_CompileClassPattern(&cp, patterns[i].pat);
+		for (j = 0; j < NCLASSES; j++) {
+			rv = AG_ClassIsNamed(classes[j], patterns[i].pat);
+			rvStr = AG_ClassMatchPatternString(classes[j], &cp);
+			if (rv != patterns[i].match[j] ||
+			    rvStr != patterns[i].match[j]) {
+				AG_SetError("%s vs. \"%s\": %d (string: %d), "
+				            "expected %d", classes[j]->hier,
+					    patterns[i].pat, rv, rvStr,
+					    patterns[i].match[j]);
+				return (-1);
+			}
+		}
+	}
+	TestMsg(ti, "%u classes x %u patterns OK", (Uint)NCLASSES,
+	    (Uint)NPATTERNS);
+	return (0);
+}
+
+/* Patterns too long to be compiled must match no class. */
+static int
+MatchLongPatterns(AG_TestInstance *ti)
+{
+	char pat[AG_OBJECT_HIER_MAX+16];
+	AG_ClassPattern cp;
+	Uint j;
+
+	memset(pat, 'x', sizeof(pat));
+	memcpy(pat, "ClassTestBase:", 14);
+	pat[sizeof(pat)-3] = ':';
+	pat[sizeof(pat)-2] = '*';
+	pat[sizeof(pat)-1] = '\0';
+
+	AG_CompileClassPattern(&cp, pat);
+	if (cp.type != AG_CLASS_PATTERN_NONE) {
+		AG_SetError("Long pattern compiled to type %d", cp.type);
+		return (-1);
+	}
+	for (j = 0; j < NCLASSES; j++) {
+		if (AG_ClassIsNamed(classes[j], pat)) {
+			AG_SetError("%s matches a long pattern",
+			    classes[j]->hier);
+			return (-1);
+		}
+	}
+	TestMsgS(ti, "Long patterns OK");
+	return (0);
+}
+
+/* Test AG_ClassIsSubclass() on registered and unregistered classes. */
+static int
+MatchSubclasses(AG_TestInstance *ti)
+{
+	const struct {
+		AG_ObjectClass *cls, *sup;
+		int match;
+	} tests[] = {
+		{ &baseClass,	 &baseClass,	1 },
+		{ &derivedClass, &baseClass,	1 },
+		{ &baseClass,	 &derivedClass,	0 },
+		{ &unregClass,	 &baseClass,	1 },
+		{ &unregClass,	 &derivedClass,	0 },
+		{ &orphanClass,	 &baseClass,	0 },
+		{ &likeClass,	 &baseClass,	0 },
+		{ &derivedClass, &agObjectClass, 1 },
+		{ &unregClass,	 &agObjectClass, 1 },
+		{ &orphanClass,	 &agObjectClass, 1 },
+	};
+	Uint i;
+
+	for (i = 0; i < sizeof(tests)/sizeof(tests[0]); i++) {
+		if (AG_ClassIsSubclass(tests[i].cls, tests[i].sup) !=
+		    tests[i].match) {
+			AG_SetError("%s subclass of %s != %d",
+			    tests[i].cls->hier, tests[i].sup->hier,
+			    tests[i].match);
+			return (-1);
+		}
+	}
+	TestMsg(ti, "%u subclass tests OK", i);
+	return (0);
+}
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+	int rv = -1;
+
+	AG_RegisterClass(&baseClass);
+	AG_RegisterClass(&derivedClass);
+
+	/* Patterns naming lateClass are first compiled before it exists. */
+	TestMsgS(ti, "Before registering ClassTestLate:");
+	if (MatchPatterns(ti) == -1) {
+		goto out;
+	}
+	AG_RegisterClass(&lateClass);
+	TestMsgS(ti, "After registering ClassTestLate:");
+	if (MatchPatterns(ti) == -1 ||
+	    MatchLongPatterns(ti) == -1 ||
+	    MatchSubclasses(ti) == -1) {
+		goto out;
+	}
+	rv = 0;
+out:
+	AG_UnregisterClass(&lateClass);
+	AG_UnregisterClass(&derivedClass);
+	AG_UnregisterClass(&baseClass);
+	return (rv);
+}
+
+const AG_TestCase classPatternsTest = {
+	"classPatterns",
+	N_("Test class pattern matching (see AG_OfClass(3))"),
+	"1.5.0",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
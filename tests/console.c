@@ -5,6 +5,8 @@
 
 #include "agartest.h"
 
+#include <string.h>
+
 AG_Textbox *textbox;
 
 static void
@@ -69,6 +71,126 @@ TestGUI(void *obj, AG_Window *win)
 	return (0);
 }
 
+/* Append lines "line<first>" to "line<last>". */
+static void
+AppendLines(AG_Console *cons, int first, int last)
+{
+	char text[32];
+	int i;
+
+	for (i = first; i <= last; i++) {
+		Snprintf(text, sizeof(text), "line%d", i);
+		AG_ConsoleAppendLine(cons, text);
+	}
+}
+
+/* Check that line i of the buffer is "line<n>". */
+static int
+CheckLine(AG_Console *cons, int i, int n, const char *what)
+{
+	char text[32];
+
+	Snprintf(text, sizeof(text), "line%d", n);
+	if (i < 0 || (Uint)i >= cons->nLines) {
+		AG_SetError("%s: line %d out of range (%u lines)", what, i,
+		    cons->nLines);
+		return (-1);
+	}
+	if (strcmp(AG_ConsoleGetLine(cons, (Uint)i)->text, text) != 0) {
+		AG_SetError("%s: \"%s\", expected \"%s\"", what,
+		    AG_ConsoleGetLine(cons, (Uint)i)->text, text);
+		return (-1);
+	}
+	return (0);
+}
+
+/* Check that the buffer holds exactly "line<first>" to "line<last>". */
+static int
+CheckLines(AG_Console *cons, int first, int last)
+{
+	int i;
+
+	if (cons->nLines != (Uint)(last - first + 1)) {
+		AG_SetError("%u lines, expected %d", cons->nLines,
+		    last - first + 1);
+		return (-1);
+	}
+	for (i = first; i <= last; i++) {
+		if (CheckLine(cons, i - first, i, "Buffer") == -1)
+			return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Test that evicting the oldest lines of a bounded console keeps the
+ * view and the selection on the same lines of text.
+ */
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+	AG_Console *cons;
+	int rv = -1;
+
+	cons = AG_ConsoleNew(NULL, AG_CONSOLE_NOAUTOSCROLL);
+	AG_ConsoleSetMaxLines(cons, 100);
+
+	AppendLines(cons, 0, 99);
+	cons->rOffs = 40;			/* View from line40 */
+	cons->pos = 50;				/* Select line50-line60 */
+	cons->sel = 10;
+	AppendLines(cons, 100, 129);
+	if (CheckLines(cons, 30, 129) == -1 ||
+	    CheckLine(cons, (int)cons->rOffs, 40, "View") == -1 ||
+	    CheckLine(cons, cons->pos, 50, "Selection start") == -1 ||
+	    CheckLine(cons, cons->pos + cons->sel, 60, "Selection end") == -1)
+		goto out;
+	TestMsgS(ti, "View and selection follow evicted lines");
+
+	AppendLines(cons, 130, 154);		/* Evict line30-line54 */
+	if (cons->rOffs != 0 ||
+	    CheckLine(cons, cons->pos, 55, "Clipped selection start") == -1 ||
+	    CheckLine(cons, cons->pos + cons->sel, 60,
+	    "Clipped selection end") == -1)
+		goto out;
+
+	cons->pos = 10;				/* Select line65-line60 */
+	cons->sel = -5;
+	AppendLines(cons, 155, 162);		/* Evict line55-line62 */
+	if (CheckLine(cons, cons->pos, 65, "Reverse selection start") == -1 ||
+	    CheckLine(cons, cons->pos + cons->sel, 63,
+	    "Reverse selection end") == -1)
+		goto out;
+
+	AppendLines(cons, 163, 170);		/* Evict the selection */
+	if (cons->pos != -1 || cons->sel != 0) {
+		AG_SetError("Evicted selection remains (%d,%d)", cons->pos,
+		    cons->sel);
+		goto out;
+	}
+	TestMsgS(ti, "Selection clipped and cleared on eviction");
+
+	AppendLines(cons, 171, 1170);
+	if (CheckLines(cons, 1071, 1170) == -1) {
+		goto out;
+	}
+	AG_ConsoleSetMaxLines(cons, 10);
+	if (CheckLines(cons, 1161, 1170) == -1) {
+		goto out;
+	}
+	AG_ConsoleSetMaxLines(cons, 0);
+	AppendLines(cons, 1171, 1370);
+	if (CheckLines(cons, 1161, 1370) == -1) {
+		goto out;
+	}
+	TestMsgS(ti, "Line text preserved across eviction and resizing");
+	rv = 0;
+out:
+	AG_ObjectDestroy(cons);
+	return (rv);
+}
+
 const AG_TestCase consoleTest = {
 	"console",
 	N_("Test the AG_Console(3) widget"),
@@ -77,7 +199,7 @@ const AG_TestCase consoleTest = {
 	sizeof(AG_TestInstance),
 	NULL,		/* init */
 	NULL,		/* destroy */
-	NULL,		/* test */
+	Test,
 	TestGUI,
 	NULL		/* bench */
 };
@@ -0,0 +1,191 @@
+/*	Public domain	*/
+
+/*
+ * This program tests reading from memory-mapped files with and without
+ * locking (see AG_OpenFileMapped(3) and AG_DataSourceSetUnlocked(3)).
+ */
+
+#include "agartest.h"
+
+#include <string.h>
+
+#define NINTS 1000			/* Spans several pages */
+
+static const char tail[] = "end of test file";
+
+typedef struct {
+	AG_TestInstance _inherit;
+	char path[AG_PATHNAME_MAX];	/* Test file */
+	size_t size;			/* Test file size */
+} MyTestInstance;
+
+static int
+Init(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	if (AG_CreateDataDir() == -1) {
+		return (-1);
+	}
+	AG_GetString(agConfig, "tmp-path", ti->path, sizeof(ti->path));
+	Strlcat(ti->path, AG_PATHSEP, sizeof(ti->path));
+	Strlcat(ti->path, "datasources.dat", sizeof(ti->path));
+	ti->size = NINTS*sizeof(Uint32) + sizeof(tail);
+	return (0);
+}
+
+static void
+Destroy(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	(void)AG_FileDelete(ti->path);
+}
+
+/* Write the test file: NINTS big-endian integers and a string. */
+static int
+WriteTestFile(MyTestInstance *ti)
+{
+	AG_DataSource *ds;
+	Uint32 i;
+
+	if ((ds = AG_OpenFile(ti->path, "wb")) == NULL) {
+		return (-1);
+	}
+	AG_SetByteOrder(ds, AG_BYTEORDER_BE);
+	for (i = 0; i < NINTS; i++) {
+		AG_WriteUint32(ds, i*7);
+	}
+	if (AG_Write(ds, tail, sizeof(tail)) == -1) {
+		AG_CloseFile(ds);
+		return (-1);
+	}
+	AG_CloseFile(ds);
+	return (0);
+}
+
+/* Read the test file back through every read operation. */
+static int
+ReadTestFile(MyTestInstance *ti, AG_DataSource *ds)
+{
+	const char *s;
+	Uint32 i, v;
+
+	AG_SetByteOrder(ds, AG_BYTEORDER_BE);
+	for (i = 0; i < NINTS; i++) {
+		if (AG_ReadUint32v(ds, &v) == -1) {
+			return (-1);
+		}
+		if (v != i*7) {
+			AG_SetError("Integer %u: read %u", (Uint)i, (Uint)v);
+			return (-1);
+		}
+	}
+	if ((s = AG_ReadPtr(ds, sizeof(tail))) == NULL) {
+		return (-1);
+	}
+	if (memcmp(s, tail, sizeof(tail)) != 0) {
+		AG_SetError("String mismatch");
+		return (-1);
+	}
+	if (AG_Tell(ds) != (off_t)ti->size) {
+		AG_SetError("Bad position %ld at end", (long)AG_Tell(ds));
+		return (-1);
+	}
+
+	/* Reads past the end must fail, and not move the position. */
+	if (AG_ReadUint32v(ds, &v) == 0 || AG_ReadPtr(ds, 1) != NULL) {
+		AG_SetError("Read past end succeeded");
+		return (-1);
+	}
+	if (AG_Seek(ds, (off_t)ti->size + 1, AG_SEEK_SET) == 0) {
+		AG_SetError("Seek past end succeeded");
+		return (-1);
+	}
+	if (AG_Tell(ds) != (off_t)ti->size) {
+		AG_SetError("Bad position %ld after failed read",
+		    (long)AG_Tell(ds));
+		return (-1);
+	}
+
+	/* Random access, and a short read straddling the end. */
+	if (AG_Seek(ds, 10*sizeof(Uint32), AG_SEEK_SET) == -1 ||
+	    AG_ReadUint32v(ds, &v) == -1) {
+		return (-1);
+	}
+	if (v != 70) {
+		AG_SetError("Read %u after seek", (Uint)v);
+		return (-1);
+	}
+	if (AG_ReadAt(ds, &v, sizeof(v), 20*sizeof(Uint32)) == -1) {
+		return (-1);
+	}
+	if (AG_SwapBE32(v) != 140) {
+		AG_SetError("Read %u at offset", (Uint)AG_SwapBE32(v));
+		return (-1);
+	}
+	if (AG_Seek(ds, 4, AG_SEEK_END) == -1 ||
+	    AG_ReadPtr(ds, 8) != NULL) {
+		AG_SetError("Short zero-copy read succeeded");
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+Test(void *obj)
+{
+	MyTestInstance *ti = obj;
+	AG_DataSource *ds, *dsCore;
+	int rv;
+
+	if (WriteTestFile(ti) == -1)
+		return (-1);
+
+	TestMsg(ti, "Reading mapped file (%lu bytes)", (Ulong)ti->size);
+	if ((ds = AG_OpenFileMapped(ti->path)) == NULL) {
+		return (-1);
+	}
+	rv = ReadTestFile(ti, ds);
+	AG_CloseFileMapped(ds);
+	if (rv == -1)
+		return (-1);
+
+	TestMsgS(ti, "Reading mapped file (unlocked)");
+	if ((ds = AG_OpenFileMapped(ti->path)) == NULL) {
+		return (-1);
+	}
+	AG_DataSourceSetUnlocked(ds, 1);
+	rv = ReadTestFile(ti, ds);
+	AG_CloseFileMapped(ds);
+	if (rv == -1)
+		return (-1);
+
+	TestMsgS(ti, "Reading mapped contents from memory (unlocked)");
+	if ((ds = AG_OpenFileMapped(ti->path)) == NULL) {
+		return (-1);
+	}
+	if ((dsCore = AG_OpenConstCore(AG_FILE_MAPPED_SOURCE(ds)->data,
+	    AG_FILE_MAPPED_SOURCE(ds)->size)) == NULL) {
+		AG_CloseFileMapped(ds);
+		return (-1);
+	}
+	AG_DataSourceSetUnlocked(dsCore, 1);
+	rv = ReadTestFile(ti, dsCore);
+	AG_CloseConstCore(dsCore);
+	AG_CloseFileMapped(ds);
+	return (rv);
+}
+
+const AG_TestCase dataSourcesTest = {
+	"dataSources",
+	N_("Test reading from mapped files with AG_DataSource(3)"),
+	"1.5.0",
+	0,
+	sizeof(MyTestInstance),
+	Init,
+	Destroy,
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
@@ -296,6 +296,264 @@ CreateTableWithControls(AG_Event *event)
 	AG_WindowShow(win);
 }
 
+/*
+ * Rebuild a polled table of NROWS keyed rows (and NUNKEYED unkeyed rows)
+ * in reverse order, changing values and dropping rows with an ID of the
+ * form 10k+3. Each pass adds rows with IDs above NROWS.
+ */
+#define NROWS	 1000
+#define NUNKEYED 10
+
+static void
+RepopulateKeyed(AG_Table *t, int pass)
+{
+	char name[16];
+	Uint id;
+	int i;
+
+	AG_TableBegin(t);
+	for (id = NROWS + pass; id >= 1; id--) {
+		if (pass > 0 && (id % 10) == 3) {
+			continue;
+		}
+		Snprintf(name, sizeof(name), "row%u", id);
+		AG_TableAddRowID(t, id, "%s:%d", name, (int)id*(pass+1));
+	}
+	for (i = 0; i < NUNKEYED; i++) {
+		Snprintf(name, sizeof(name), "unkeyed%d", i);
+		AG_TableAddRow(t, "%s:%d", name, i);
+	}
+	AG_TableEnd(t);
+}
+
+static int
+CheckKeyed(AG_Table *t, int pass, AG_TableCell **rows)
+{
+	int m, nKeyed = 0, nExpected;
+
+	for (m = 0; m < t->m; m++) {
+		AG_TableCell *row = t->cells[m];
+		Uint id = row[0].rowID;
+		int sel = AG_TableRowSelected(t, m);
+
+		if (id == 0) {
+			if (sel != ((row[1].data.i % 3) == 0)) {
+				AG_SetError("Unkeyed row %d: selected=%d",
+				    row[1].data.i, sel);
+				return (-1);
+			}
+			continue;
+		}
+		if (pass > 0 && (id % 10) == 3) {
+			AG_SetError("Dropped row %u is present", id);
+			return (-1);
+		}
+		if (row[1].data.i != (int)id*(pass+1)) {
+			AG_SetError("Row %u: value %d not updated", id,
+			    row[1].data.i);
+			return (-1);
+		}
+		if (sel != (id <= NROWS && (id % 7) == 0)) {
+			AG_SetError("Row %u: selected=%d", id, sel);
+			return (-1);
+		}
+		if (id <= NROWS && rows[id-1] != NULL && rows[id-1] != row) {
+			AG_SetError("Row %u was not updated in place", id);
+			return (-1);
+		}
+		nKeyed++;
+	}
+	nExpected = (pass > 0) ? (NROWS + pass) - (NROWS + pass + 7)/10 :
+	                         NROWS;
+	if (nKeyed != nExpected || t->m != nKeyed + NUNKEYED) {
+		AG_SetError("Pass %d: %d keyed rows (expected %d)", pass,
+		    nKeyed, nExpected);
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+TestRowIDs(AG_TestInstance *ti)
+{
+	AG_TableCell **rows;
+	AG_Table *t;
+	int m, pass, rv = -1;
+
+	t = AG_TableNew(NULL, AG_TABLE_MULTI);
+	AG_TableAddCol(t, "Name", NULL, NULL);
+	AG_TableAddCol(t, "Value", NULL, NULL);
+	rows = Malloc(NROWS*sizeof(AG_TableCell *));
+
+	RepopulateKeyed(t, 0);
+	memset(rows, 0, NROWS*sizeof(AG_TableCell *));
+	for (m = 0; m < t->m; m++) {
+		AG_TableCell *row = t->cells[m];
+		Uint id = row[0].rowID;
+
+		if ((id != 0 && (id % 7) == 0) ||
+		    (id == 0 && (row[1].data.i % 3) == 0)) {
+			AG_TableSelectRow(t, m);
+		}
+		if (id != 0)
+			rows[id-1] = row;
+	}
+	for (pass = 1; pass < 4; pass++) {
+		RepopulateKeyed(t, pass);
+		if (CheckKeyed(t, pass, rows) == -1)
+			goto out;
+	}
+	TestMsg(ti, "Selection followed %d row IDs over %d passes", NROWS,
+	    pass-1);
+
+	/* Rows saved with fewer columns cannot be updated in place. */
+	AG_TableBegin(t);
+	AG_TableAddCol(t, "Extra", NULL, NULL);
+	for (m = 1; m <= NROWS; m++) {
+		AG_TableAddRowID(t, (Uint)m, "%s:%d:%d", "row", m, m);
+	}
+	AG_TableEnd(t);
+	if (t->m != NROWS || t->cells[NROWS-1][2].data.i != NROWS) {
+		AG_SetError("Bad table after adding a column (%d rows)", t->m);
+		goto out;
+	}
+	rv = 0;
+out:
+	Free(rows);
+	AG_ObjectDestroy(t);
+	return (rv);
+}
+
+/* Data model for the virtual table test. */
+typedef struct {
+	Uint nRows;
+} MyModel;
+
+static Uint
+MyRowCount(void *arg)
+{
+	MyModel *mm = arg;
+
+	return (mm->nRows);
+}
+
+static void
+MyGetCell(void *arg, Uint row, int col, AG_TableCell *c)
+{
+	if (col == 0) {
+		c->type = AG_CELL_INT;
+		c->data.i = (int)((row*37) % 101);
+		Strlcpy(c->fmt, "%d", sizeof(c->fmt));
+	} else {
+		c->type = AG_CELL_STRING;
+		Snprintf(c->data.s, sizeof(c->data.s), "row%u", row);
+		Strlcpy(c->fmt, "%s", sizeof(c->fmt));
+	}
+}
+
+static const AG_TableModel myModel = {
+	MyRowCount,
+	MyGetCell,
+	NULL		/* compareRows */
+};
+
+/* Check that exactly the model rows in [0, nSel) are selected. */
+static int
+CheckModelSelection(AG_Table *t, Uint nSel, const char *what)
+{
+	int m;
+
+	for (m = 0; m < t->m; m++) {
+		Uint row = AG_TableModelRow(t, m);
+
+		if (AG_TableRowSelected(t, m) != (row < nSel)) {
+			AG_SetError("%s: row %d (model row %u) selected=%d",
+			    what, m, row, AG_TableRowSelected(t, m));
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+static int
+TestModel(AG_TestInstance *ti)
+{
+	MyModel mm;
+	AG_Table *t;
+	int m, rv = -1;
+
+	t = AG_TableNew(NULL, AG_TABLE_MULTI);
+	AG_TableAddCol(t, "Value", NULL, NULL);
+	AG_TableAddCol(t, "Name", NULL, NULL);
+
+	mm.nRows = 100;
+	AG_TableSetModel(t, &myModel, &mm);
+	if (t->m != 100 || AG_TableAddRow(t, "%d:%s", 1, "x") != -1) {
+		AG_SetError("Bad virtual table (%d rows)", t->m);
+		goto out;
+	}
+
+	/* Sort by value in descending order. */
+	t->cols[0].flags |= AG_TABLE_SORT_DESCENDING;
+	AG_TableSort(t);
+	for (m = 0; m < t->m-1; m++) {
+		Uint r1 = AG_TableModelRow(t, m);
+		Uint r2 = AG_TableModelRow(t, m+1);
+
+		if ((r1*37) % 101 < (r2*37) % 101) {
+			AG_SetError("Rows %d and %d out of order", m, m+1);
+			goto out;
+		}
+	}
+
+	/* Selections follow the model rows across a change. */
+	for (m = 0; m < t->m; m++) {
+		if (AG_TableModelRow(t, m) < 20)
+			AG_TableSelectRow(t, m);
+	}
+	AG_TableModelChanged(t);
+	AG_TableSort(t);
+	if (CheckModelSelection(t, 20, "Unchanged model") == -1)
+		goto out;
+
+	/* Rows removed from the model must not come back selected. */
+	mm.nRows = 13;
+	AG_TableModelChanged(t);
+	mm.nRows = 40;
+	AG_TableModelChanged(t);
+	AG_TableSort(t);
+	if (CheckModelSelection(t, 13, "Shrunk model") == -1)
+		goto out;
+
+	AG_TableDeselectAllRows(t);
+	mm.nRows = 13;
+	AG_TableModelChanged(t);
+	AG_TableSelectAllRows(t);
+	mm.nRows = 20;
+	AG_TableModelChanged(t);
+	AG_TableSort(t);
+	if (CheckModelSelection(t, 13, "Select all") == -1)
+		goto out;
+
+	TestMsgS(ti, "Model selections preserved");
+	rv = 0;
+out:
+	AG_ObjectDestroy(t);
+	return (rv);
+}
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+
+	if (TestRowIDs(ti) == -1 ||
+	    TestModel(ti) == -1) {
+		return (-1);
+	}
+	return (0);
+}
+
 static int
 TestGUI(void *obj, AG_Window *win)
 {
@@ -313,7 +571,7 @@ const AG_TestCase tableTest = {
 	sizeof(AG_TestInstance),
 	NULL,		/* init */
 	NULL,		/* destroy */
-	NULL,		/* test */
+	Test,
 	TestGUI,
 	NULL		/* bench */
 };
@@ -244,6 +244,133 @@ TestGUI(void *obj, AG_Window *win)
 	return (0);
 }
 
+/* Simulate typing a string (ASCII or Latin-1) into an editable. */
+static void
+Type(AG_Editable *ed, const char *s)
+{
+	const unsigned char *c;
+
+	for (c = (const unsigned char *)s; *c != '\0'; c++) {
+		AG_PostEvent(NULL, ed, "key-down", "%i,%i,%lu",
+		    (int)*c, (int)AG_KEYMOD_NONE, (Ulong)*c);
+		AG_PostEvent(NULL, ed, "key-up", "%i,%i,%lu",
+		    (int)*c, (int)AG_KEYMOD_NONE, (Ulong)*c);
+	}
+}
+
+/* Simulate pressing a non-character key n times. */
+static void
+Press(AG_Editable *ed, AG_KeySym ks, int n)
+{
+	while (n-- > 0) {
+		AG_PostEvent(NULL, ed, "key-down", "%i,%i,%lu",
+		    (int)ks, (int)AG_KEYMOD_NONE, 0UL);
+		AG_PostEvent(NULL, ed, "key-up", "%i,%i,%lu",
+		    (int)ks, (int)AG_KEYMOD_NONE, 0UL);
+	}
+}
+
+/*
+ * Edit a bound string (s, as returned by fn) and check that every change
+ * is committed, including after the string is modified externally.
+ */
+static int
+TestEditing(AG_Editable *ed, char *(*fn)(void *), void *p, const char *what)
+{
+	const struct {
+		const char *ext;	/* External change (or NULL) */
+		int left;		/* Cursor movement from end */
+		const char *keys;	/* Keys typed */
+		int del;		/* Backspaces */
+		const char *expect;	/* Expected result */
+	} steps[] = {
+		{ "h\xc3\xa9llo w\xc3\xb6rld",0, "",	0, "h\xc3\xa9llo w\xc3\xb6rld" },
+		{ NULL,			6, "X",		0, "h\xc3\xa9lloX w\xc3\xb6rld" },
+		{ NULL,			6, "",		1, "h\xc3\xa9llo w\xc3\xb6rld" },
+		{ NULL,			0, "\xe9!",	0, "h\xc3\xa9llo w\xc3\xb6rld\xc3\xa9!" },
+		{ NULL,			0, "",		3, "h\xc3\xa9llo w\xc3\xb6rl" },
+		{ "x=10 y=20",		0, "",		0, "x=10 y=20" },
+		{ "x=11 y=20",		0, "!",		0, "x=11 y=20!" },
+		{ "x=12 y=20!",		4, "0",		0, "x=12 y0=20!" },
+		{ "hello",		0, "",		0, "hello" },
+		{ "hi",			0, "!",		0, "hi!" },
+		{ "",			0, "abc",	1, "ab" },
+	};
+	Uint i;
+
+	for (i = 0; i < sizeof(steps)/sizeof(steps[0]); i++) {
+		const char *s;
+
+		if (steps[i].ext != NULL) {
+			/* Modify the binding behind the editable's back. */
+			strcpy(fn(p), steps[i].ext);
+			if (p != NULL) {
+				AGTEXT(p)->ent[AGTEXT(p)->lang].len =
+				    strlen(steps[i].ext);
+			}
+		}
+		Press(ed, AG_KEY_END, 1);
+		Press(ed, AG_KEY_LEFT, steps[i].left);
+		Type(ed, steps[i].keys);
+		Press(ed, AG_KEY_BACKSPACE, steps[i].del);
+
+		if (strcmp((s = fn(p)), steps[i].expect) != 0) {
+			AG_SetError("%s: step %u: \"%s\" != \"%s\"", what,
+			    i, s, steps[i].expect);
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+static char bufferTest[64];
+
+static char *
+GetBufferUTF8(void *p)
+{
+	return (bufferTest);
+}
+
+static char *
+GetBufferText(void *p)
+{
+	AG_Text *txt = p;
+
+	return (txt->ent[txt->lang].buf);
+}
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+	AG_Editable *ed;
+	AG_Text *txt;
+	int rv;
+
+	ed = AG_EditableNew(NULL, 0);
+	AG_EditableBindUTF8(ed, bufferTest, sizeof(bufferTest));
+	rv = TestEditing(ed, GetBufferUTF8, NULL, "UTF-8 buffer");
+	AG_ObjectDestroy(ed);
+	if (rv == -1) {
+		return (-1);
+	}
+	TestMsgS(ti, "Editing a UTF-8 buffer OK");
+
+	txt = AG_TextNew(0);
+	AG_TextSetS(txt, "");
+	AG_TextRealloc(&txt->ent[txt->lang], 64);
+	ed = AG_EditableNew(NULL, 0);
+	AG_EditableBindText(ed, txt);
+	rv = TestEditing(ed, GetBufferText, txt, "AG_Text");
+	AG_ObjectDestroy(ed);
+	AG_TextFree(txt);
+	if (rv == -1) {
+		return (-1);
+	}
+	TestMsgS(ti, "Editing an AG_Text element OK");
+	return (0);
+}
+
 const AG_TestCase textboxTest = {
 	"textbox",
 	N_("Test AG_Textbox(3) / AG_Editable(3) widgets"),
@@ -252,7 +379,7 @@ const AG_TestCase textboxTest = {
 	sizeof(AG_TestInstance),
 	NULL,		/* init */
 	NULL,		/* destroy */
-	NULL,		/* test */
+	Test,
 	TestGUI,
 	NULL		/* bench */
 };
@@ -0,0 +1,169 @@
+/*	Public domain	*/
+
+/*
+ * This program tests the rebuilding of polled AG_Tlist(3) displays: the
+ * reuse of pooled items and the restoring of saved item state.
+ */
+
+#include "agartest.h"
+
+#include <string.h>
+
+#define NITEMS 1000
+
+/* Compare by text, without a hash function (linear lookup). */
+static int
+CompareText(const AG_TlistItem *it1, const AG_TlistItem *it2)
+{
+	return (strcmp(it1->text, it2->text) == 0);
+}
+
+/* Repopulate the list in reverse order, as a polling routine would. */
+static void
+Repopulate(AG_Tlist *tl)
+{
+	char text[32];
+	int i;
+
+	AG_TlistBegin(tl);
+	for (i = NITEMS-1; i >= 0; i--) {
+		Snprintf(text, sizeof(text), "item%d", i);
+		AG_TlistAddPtr(tl, NULL, text, (void *)(size_t)(i+1));
+	}
+	AG_TlistEnd(tl);
+}
+
+/* Check that exactly the items with an index multiple of 7 are selected. */
+static int
+CheckSelection(AG_Tlist *tl)
+{
+	AG_TlistItem *it;
+	int n = 0;
+
+	AG_TLIST_FOREACH(it, tl) {
+		int i = (int)(size_t)it->p1 - 1;
+
+		if (it->selected != ((i % 7) == 0)) {
+			AG_SetError("item%d: selected=%d", i, it->selected);
+			return (-1);
+		}
+		if (it->flags != 0 || it->depth != 0) {
+			AG_SetError("item%d: stale flags 0x%x", i, it->flags);
+			return (-1);
+		}
+		n++;
+	}
+	if (n != NITEMS || tl->nitems != NITEMS) {
+		AG_SetError("%d items (nitems=%d)", n, tl->nitems);
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+TestRestore(AG_TestInstance *ti, AG_Tlist *tl, const char *what)
+{
+	AG_TlistItem *it;
+	Uint nBlocks;
+	int pass;
+
+	AG_TlistBegin(tl);
+	AG_TlistEnd(tl);
+	Repopulate(tl);
+	AG_TLIST_FOREACH(it, tl) {
+		if ((((int)(size_t)it->p1 - 1) % 7) == 0)
+			AG_TlistSelect(tl, it);
+	}
+	nBlocks = 0;
+	for (pass = 0; pass < 3; pass++) {
+		Repopulate(tl);
+		if (CheckSelection(tl) == -1) {
+			return (-1);
+		}
+		/* Saved items coexist with new ones during the first pass. */
+		if (pass == 0) {
+			nBlocks = tl->nPoolBlocks;
+		} else if (tl->nPoolBlocks != nBlocks) {
+			AG_SetError("Pool grew from %u to %u blocks", nBlocks,
+			    tl->nPoolBlocks);
+			return (-1);
+		}
+	}
+	TestMsg(ti, "Selection restored by %s (%u pool blocks)", what,
+	    nBlocks);
+	return (0);
+}
+
+/*
+ * With duplicate keys, AG_TlistVisibleChildren() uses the first saved
+ * item and AG_TlistRestore() behaves as if every match was applied in
+ * turn (so the last one wins).
+ */
+static int
+TestDuplicates(AG_TestInstance *ti, AG_Tlist *tl, const char *what)
+{
+	AG_TlistItem *it;
+
+	AG_TlistBegin(tl);
+	AG_TlistEnd(tl);
+	AG_TlistBegin(tl);
+	it = AG_TlistAddS(tl, NULL, "dup");
+	it->flags |= AG_TLIST_HAS_CHILDREN|AG_TLIST_VISIBLE_CHILDREN;
+	it = AG_TlistAddS(tl, NULL, "dup");
+	it->flags |= AG_TLIST_HAS_CHILDREN;
+	AG_TlistEnd(tl);
+
+	AG_TlistBegin(tl);		/* Saved in reverse order */
+	it = AG_TlistAddS(tl, NULL, "dup");
+	if (AG_TlistVisibleChildren(tl, it)) {
+		AG_SetError("%s: VisibleChildren used the wrong item", what);
+		return (-1);
+	}
+	AG_TlistEnd(tl);
+	if (!(it->flags & AG_TLIST_VISIBLE_CHILDREN)) {
+		AG_SetError("%s: Restore used the wrong item", what);
+		return (-1);
+	}
+	TestMsg(ti, "Duplicate keys resolved by %s", what);
+	return (0);
+}
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+	AG_Tlist *tl;
+	int rv = -1;
+
+	tl = AG_TlistNew(NULL, AG_TLIST_MULTI);
+
+	AG_TlistSetCompareFn(tl, AG_TlistComparePtrs);
+	if (TestRestore(ti, tl, "pointer hash") == -1)
+		goto out;
+	AG_TlistSetCompareFn(tl, AG_TlistCompareStrings);
+	if (TestRestore(ti, tl, "string hash") == -1 ||
+	    TestDuplicates(ti, tl, "string hash") == -1)
+		goto out;
+	AG_TlistSetCompareFn(tl, CompareText);
+	if (TestRestore(ti, tl, "linear search") == -1 ||
+	    TestDuplicates(ti, tl, "linear search") == -1)
+		goto out;
+
+	rv = 0;
+out:
+	AG_ObjectDestroy(tl);
+	return (rv);
+}
+
+const AG_TestCase tlistTest = {
+	"tlist",
+	N_("Test rebuilding polled AG_Tlist(3) displays"),
+	"1.5.0",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
@@ -0,0 +1,170 @@
+/*	Public domain	*/
+
+/*
+ * This program tests the lookup of object variables by name, in particular
+ * the hash index used for objects with many variables (see AG_Variable(3)).
+ */
+
+#include "agartest.h"
+
+#include <string.h>
+
+#define NVARS	100		/* Well above AG_OBJECT_VAR_INDEX_MIN */
+
+/*
+ * Verify that every variable in the list is found under its own name, and
+ * that the list and the variable count agree.
+ */
+static int
+CheckConsistency(AG_Object *obj)
+{
+	AG_Variable *V;
+	Uint n = 0;
+
+	TAILQ_FOREACH(V, &obj->vars, vars) {
+		if (AG_ObjectFindVariable(obj, V->name) != V) {
+			AG_SetError("Variable \"%s\" not found by name", V->name);
+			return (-1);
+		}
+		n++;
+	}
+	if (n != obj->nVars) {
+		AG_SetError("%u variables in list, nVars=%u", n, obj->nVars);
+		return (-1);
+	}
+	return (0);
+}
+
+/* Rename a variable (it must be reinserted under the new name). */
+static void
+RenameVariable(AG_Object *obj, AG_Variable *V, const char *name)
+{
+	AG_ObjectRemoveVariable(obj, V);
+	Strlcpy(V->name, name, sizeof(V->name));
+	AG_ObjectInsertVariable(obj, V);
+}
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+	AG_Object *o;
+	AG_Variable *V;
+	char name[AG_VARIABLE_NAME_MAX];
+	int i;
+
+	if ((o = AG_ObjectNew(NULL, "variables", &agObjectClass)) == NULL) {
+		return (-1);
+	}
+	AG_ObjectLock(o);
+
+	TestMsg(ti, "Adding %d variables", NVARS);
+	for (i = 0; i < NVARS; i++) {
+		Snprintf(name, sizeof(name), "var%d", i);
+		AG_SetInt(o, name, i);
+		if (i == AG_OBJECT_VAR_INDEX_MIN-1 && o->varIndex != NULL) {
+			AG_SetError("Small object has a variable index");
+			goto fail;
+		}
+	}
+	if (o->varIndex == NULL) {
+		AG_SetError("Large object has no variable index");
+		goto fail;
+	}
+	for (i = 0; i < NVARS; i++) {
+		Snprintf(name, sizeof(name), "var%d", i);
+		if (AG_GetInt(o, name) != i) {
+			AG_SetError("%s: got %d", name, AG_GetInt(o, name));
+			goto fail;
+		}
+	}
+	if (AG_Defined(o, "var") || AG_Defined(o, "var100")) {
+		AG_SetError("Undefined variable found");
+		goto fail;
+	}
+	if (CheckConsistency(o) == -1)
+		goto fail;
+
+	TestMsg(ti, "Deleting every third variable");
+	for (i = 0; i < NVARS; i += 3) {
+		Snprintf(name, sizeof(name), "var%d", i);
+		AG_Unset(o, name);
+	}
+	for (i = 0; i < NVARS; i++) {
+		Snprintf(name, sizeof(name), "var%d", i);
+		if ((i % 3) == 0) {
+			if (AG_Defined(o, name)) {
+				AG_SetError("%s: still defined", name);
+				goto fail;
+			}
+		} else if (AG_GetInt(o, name) != i) {
+			AG_SetError("%s: lost after deletion", name);
+			goto fail;
+		}
+	}
+	if (CheckConsistency(o) == -1)
+		goto fail;
+
+	TestMsg(ti, "Renaming variables");
+	for (i = 1; i < NVARS; i += 3) {
+		Snprintf(name, sizeof(name), "var%d", i);
+		if ((V = AG_ObjectFindVariable(o, name)) == NULL) {
+			AG_SetError("%s: not found", name);
+			goto fail;
+		}
+		Snprintf(name, sizeof(name), "renamed%d", i);
+		RenameVariable(o, V, name);
+	}
+	for (i = 1; i < NVARS; i += 3) {
+		Snprintf(name, sizeof(name), "var%d", i);
+		if (AG_Defined(o, name)) {
+			AG_SetError("%s: defined after rename", name);
+			goto fail;
+		}
+		Snprintf(name, sizeof(name), "renamed%d", i);
+		if (AG_GetInt(o, name) != i) {
+			AG_SetError("%s: not found after rename", name);
+			goto fail;
+		}
+	}
+	if (CheckConsistency(o) == -1)
+		goto fail;
+
+	TestMsg(ti, "Deleting all variables");
+	for (i = 0; i < NVARS; i++) {
+		Snprintf(name, sizeof(name), "var%d", i);
+		AG_Unset(o, name);
+		Snprintf(name, sizeof(name), "renamed%d", i);
+		AG_Unset(o, name);
+	}
+	if (o->nVars != 0 || !TAILQ_EMPTY(&o->vars)) {
+		AG_SetError("%u variables left", o->nVars);
+		goto fail;
+	}
+	AG_SetInt(o, "var0", 1234);
+	if (AG_GetInt(o, "var0") != 1234 || CheckConsistency(o) == -1) {
+		AG_SetError("Cannot reuse emptied object");
+		goto fail;
+	}
+
+	AG_ObjectUnlock(o);
+	AG_ObjectDestroy(o);
+	return (0);
+fail:
+	AG_ObjectUnlock(o);
+	AG_ObjectDestroy(o);
+	return (-1);
+}
+
+const AG_TestCase variablesTest = {
+	"variables",
+	N_("Test the AG_Variable(3) lookup by name"),
+	"1.5.0",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
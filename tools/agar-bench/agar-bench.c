@@ -21,6 +21,8 @@ extern struct test_ops surfaceops_test;
 extern struct test_ops memops_test;
 extern struct test_ops misc_test;
 extern struct test_ops events_test;
+extern struct test_ops timers_test;
+extern struct test_ops editable_test;
 
 struct test_ops *tests[] = {
 	&pixelops_test,
@@ -28,7 +30,9 @@ struct test_ops *tests[] = {
 	&surfaceops_test,
 	&memops_test,
 	&misc_test,
-	&events_test
+	&events_test,
+	&timers_test,
+	&editable_test
 };
 int ntests = sizeof(tests) / sizeof(tests[0]);
 
@@ -45,6 +49,7 @@ RunTests(AG_Event *event)
 	AG_Table *t = AG_PTR(2);
 	Uint64 t1, t2;
 	Uint64 tTot, tRun;
+	Uint32 msStart, ms;
 	unsigned i, j, m;
 	
 	if ((test->flags & TEST_GL)  && !agView->opengl) {
@@ -58,7 +63,7 @@ RunTests(AG_Event *event)
 	}
 
 	for (m = 0; m < t->m; m++) {
-		struct testfn_ops *ops = t->cells[m][4].data.p;
+		struct testfn_ops *ops = t->cells[m][5].data.p;
 
 		if (!AG_TableRowSelected(t, m)) {
 			continue;
@@ -67,6 +72,7 @@ RunTests(AG_Event *event)
 		ops->clksMax = 0;
 		fprintf(stderr, "Running test: %s...", ops->name);
 		if (ops->init != NULL) ops->init();
+		msStart = AG_GetTicks();
 		for (i = 0, tTot = 0; i < test->runs; i++) {
 #ifdef USE_RDTSC
 retry:
@@ -99,6 +105,12 @@ retry:
 			tTot += tRun;
 #endif
 		}
+		ms = AG_GetTicks() - msStart;
+		if (ops->pixels > 0) {
+			ops->mpixs = (double)ops->pixels * test->runs *
+			    test->iterations / ((ms > 0 ? ms : 1) * 1e3);
+			fprintf(stderr, " (%.01f Mpix/s)", ops->mpixs);
+		}
 		fprintf(stderr, ".\n");
 		if (ops->destroy != NULL) ops->destroy();
 		ops->clksAvg = (Uint64)(tTot / test->runs);
@@ -110,35 +122,42 @@ poll_test(AG_Event *event)
 {
 	AG_Table *t = AG_SELF();
 	struct test_ops *test = tests[AG_INT(1)];
+	char rate[32];
 	int i;
 
 	AG_TableBegin(t);
 	for (i = 0; i < test->nfuncs; i++) {
 		struct testfn_ops *fn = &test->funcs[i];
+
+		if (fn->pixels > 0 && fn->mpixs > 0.0) {
+			Snprintf(rate, sizeof(rate), "%.01f", fn->mpixs);
+		} else {
+			Strlcpy(rate, "-", sizeof(rate));
+		}
 #ifdef USE_RDTSC
 		if (fn->clksAvg >= 1e6) {
-			AG_TableAddRow(t, "%s:%.06fM:%.06fM:%.06fM:%p",
+			AG_TableAddRow(t, "%s:%.06fM:%.06fM:%.06fM:%s:%p",
 			    fn->name,
 			    (double)(fn->clksMin/1e6),
 			    (double)(fn->clksAvg/1e6),
-			    (double)(fn->clksMax/1e6), fn);
+			    (double)(fn->clksMax/1e6), rate, fn);
 		} else if (fn->clksAvg >= 1e3) {
-			AG_TableAddRow(t, "%s:%.03fk:%.03fk:%.03fk:%p",
+			AG_TableAddRow(t, "%s:%.03fk:%.03fk:%.03fk:%s:%p",
 			    fn->name,
 			    (double)(fn->clksMin/1e3),
 			    (double)(fn->clksAvg/1e3),
-			    (double)(fn->clksMax/1e3), fn);
+			    (double)(fn->clksMax/1e3), rate, fn);
 		} else {
-			AG_TableAddRow(t, "%s:%lu:%lu:%lu:%p", fn->name,
+			AG_TableAddRow(t, "%s:%lu:%lu:%lu:%s:%p", fn->name,
 			    (unsigned long)fn->clksMin,
 			    (unsigned long)fn->clksAvg,
-			    (unsigned long)fn->clksMax, fn);
+			    (unsigned long)fn->clksMax, rate, fn);
 		}
 #else /* !USE_RDTSC */
-		AG_TableAddRow(t, "%s:%luT:%luT:%luT:%p", fn->name,
+		AG_TableAddRow(t, "%s:%luT:%luT:%luT:%s:%p", fn->name,
 		    (unsigned long)fn->clksMin,
 		    (unsigned long)fn->clksAvg,
-		    (unsigned long)fn->clksMax, fn);
+		    (unsigned long)fn->clksMax, rate, fn);
 #endif /* USE_RDTSC */
 	}
 	AG_TableEnd(t);
@@ -221,10 +240,11 @@ MainWindow(void)
 		t = AG_TableNewPolled(ntab, AG_TABLE_MULTI|AG_TABLE_EXPAND,
 		    poll_test, "%i", i);
 
-		AG_TableAddCol(t, "Test", "70%", NULL);
+		AG_TableAddCol(t, "Test", "60%", NULL);
 		AG_TableAddCol(t, "Min", "10%", NULL);
 		AG_TableAddCol(t, "Avg", "10%", NULL);
 		AG_TableAddCol(t, "Max", "10%", NULL);
+		AG_TableAddCol(t, "Mpix/s", "10%", NULL);
 		AG_TableAddCol(t, NULL, NULL, NULL);
 	
 		hbox = AG_HBoxNew(ntab, AG_HBOX_HOMOGENOUS|AG_HBOX_HFILL);
@@ -247,6 +267,7 @@ MainWindow(void)
 			fn->clksMin = 0;
 			fn->clksAvg = 0;
 			fn->clksMax = 0;
+			fn->mpixs = 0.0;
 		}
 	}
 
@@ -262,7 +283,8 @@ main(int argc, char *argv[])
 	int c, i, fps = -1;
 	char *s;
 
-	if (AG_InitCore("agar-bench", 0) == -1) {
+	/* Soft timers, so that the Timers test measures the timing wheel. */
+	if (AG_InitCore("agar-bench", AG_SOFT_TIMERS) == -1) {
 		fprintf(stderr, "%s\n", AG_GetError());
 		return (1);
 	}
@@ -9,7 +9,9 @@ struct testfn_ops {
 	void (*init)(void);
 	void (*destroy)(void);
 	void (*run)(void);
+	Uint pixels;			/* Pixels written per run (or 0) */
 	Uint64 clksMin, clksAvg, clksMax;
+	double mpixs;			/* Measured throughput (Mpix/s) */
 };
 
 struct test_ops {
@@ -0,0 +1,70 @@
+/*	Public domain	*/
+
+#include "agar-bench.h"
+
+static AG_Window *win = NULL;
+static AG_Editable *ed = NULL;
+
+/* Multiline editable holding a document of len characters. */
+static void
+InitEditable(size_t len)
+{
+	char *s;
+	size_t i;
+
+	s = Malloc(len+1);
+	for (i = 0; i < len; i++) {
+		s[i] = (i % 80 == 79) ? '\n' :
+		       (i % 7 == 6) ? ' ' : 'a' + i % 26;
+	}
+	s[len] = '\0';
+
+	win = AG_WindowNew(0);
+	ed = AG_EditableNew(win, AG_EDITABLE_MULTILINE|AG_EDITABLE_EXPAND);
+	AG_EditableSetString(ed, s);
+	ed->pos = (int)len/2;
+	AG_WindowSetGeometry(win, 0, 0, 640, 480);
+	Free(s);
+}
+static void InitEditable64K(void) { InitEditable(65536); }
+static void InitEditable4M(void) { InitEditable(4*1024*1024); }
+static void FreeEditable(void)
+{
+	AG_ObjectDetach(win);
+	win = NULL;
+	ed = NULL;
+}
+
+static void T_InsertChar(void) {
+	AG_PostEvent(NULL, ed, "key-down", "%i,%i,%lu", AG_KEY_A, 0, 'a');
+	AG_PostEvent(NULL, ed, "key-up", "%i,%i,%lu", AG_KEY_A, 0, 'a');
+}
+static void T_DeleteChar(void) {
+	AG_PostEvent(NULL, ed, "key-down", "%i,%i,%lu", AG_KEY_BACKSPACE, 0, 0);
+	AG_PostEvent(NULL, ed, "key-up", "%i,%i,%lu", AG_KEY_BACKSPACE, 0, 0);
+}
+static void T_MapPosition(void) {
+	AG_EditableBuffer *buf;
+	int pos;
+
+	if ((buf = AG_EditableGetBuffer(ed)) != NULL) {
+		AG_EditableMapPosition(ed, buf, 100, 100, &pos);
+		AG_EditableReleaseBuffer(ed, buf);
+	}
+}
+
+static struct testfn_ops testfns[] = {
+ { "Keystroke (insert) - 64K document", InitEditable64K,FreeEditable, T_InsertChar },
+ { "Keystroke (insert) - 4M document", InitEditable4M,FreeEditable, T_InsertChar },
+ { "Keystroke (backspace) - 4M document", InitEditable4M,FreeEditable, T_DeleteChar },
+ { "AG_EditableMapPosition() - 4M document", InitEditable4M,FreeEditable, T_MapPosition },
+};
+
+struct test_ops editable_test = {
+	"Editable",
+	NULL,
+	&testfns[0],
+	sizeof(testfns) / sizeof(testfns[0]),
+	0,
+	4, 1000, 0
+};
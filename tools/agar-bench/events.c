@@ -22,6 +22,28 @@ static void FreeObj(void)
 	AG_ObjectDestroy(&obj);
 }
 
+/* Object with many handlers, as is typical of widgets. */
+static AG_Object objMany;
+static AG_EventAtom atomMotion;
+
+static void InitObjMany(void)
+{
+	char name[AG_EVENT_NAME_MAX];
+	int i;
+
+	AG_ObjectInitStatic(&objMany, &agObjectClass);
+	for (i = 0; i < 64; i++) {
+		snprintf(name, sizeof(name), "object-event-%d", i);
+		AG_SetEvent(&objMany, name, NULL, "%i", i);
+	}
+	AG_SetEvent(&objMany, "mouse-motion", NULL, NULL);
+	atomMotion = AG_InternEventName("mouse-motion");
+}
+static void FreeObjMany(void)
+{
+	AG_ObjectDestroy(&objMany);
+}
+
 static void T_SetEventWithoutArgs(void) {
 	AG_SetEvent(&obj, "foo-event", NULL, NULL);
 }
@@ -37,11 +59,24 @@ static void T_PostEventWithArgs(void) {
 	    1, 1.0, 1.0, "foo bar baz", 1);
 }
 
+static void T_PostEventManyHandlers(void) {
+	AG_PostEvent(NULL, &objMany, "mouse-motion", "%i,%i", 1, 1);
+}
+static void T_PostEventAtomManyHandlers(void) {
+	AG_PostEventAtom(NULL, &objMany, atomMotion, "%i,%i", 1, 1);
+}
+static void T_FindEventHandlerManyHandlers(void) {
+	(void)AG_FindEventHandler(&objMany, "object-event-63");
+}
+
 static struct testfn_ops testfns[] = {
  { "AG_SetEvent() - Without args", InitObj,FreeObj, T_SetEventWithoutArgs },
  { "AG_SetEvent() - With 6 args", InitObj,FreeObj, T_SetEventWithArgs },
  { "AG_PostEvent() - Without args", InitObj,FreeObj, T_PostEventWithoutArgs },
  { "AG_PostEvent() - With 6 args", InitObj,FreeObj, T_PostEventWithArgs },
+ { "AG_PostEvent() - 65 handlers", InitObjMany,FreeObjMany, T_PostEventManyHandlers },
+ { "AG_PostEventAtom() - 65 handlers", InitObjMany,FreeObjMany, T_PostEventAtomManyHandlers },
+ { "AG_FindEventHandler() - 65 handlers", InitObjMany,FreeObjMany, T_FindEventHandlerManyHandlers },
 };
 
 struct test_ops events_test = {
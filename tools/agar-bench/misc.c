@@ -44,6 +44,102 @@ static void T_Snprintf4(void) {
 	snprintf(buf1, sizeof(buf1), "%d,%d,%s,%s", 1, 1, STRING64, STRING64);
 }
 
+/* Objects with few and many variables, as is typical of widgets. */
+static AG_Object objFew, objMany;
+
+static void InitVars(void)
+{
+	char name[AG_VARIABLE_NAME_MAX];
+	int i;
+
+	AG_ObjectInitStatic(&objFew, &agObjectClass);
+	AG_ObjectInitStatic(&objMany, &agObjectClass);
+	for (i = 0; i < 4; i++) {
+		snprintf(name, sizeof(name), "object-var-%d", i);
+		AG_SetInt(&objFew, name, i);
+	}
+	for (i = 0; i < 64; i++) {
+		snprintf(name, sizeof(name), "object-var-%d", i);
+		AG_SetInt(&objMany, name, i);
+	}
+}
+static void FreeVars(void)
+{
+	AG_ObjectDestroy(&objFew);
+	AG_ObjectDestroy(&objMany);
+}
+static void T_GetIntFewVars(void) {
+	(void)AG_GetInt(&objFew, "object-var-3");
+}
+static void T_GetIntManyVars(void) {
+	(void)AG_GetInt(&objMany, "object-var-63");
+}
+static void T_OfClass(void) {
+	(void)AG_OfClass(&objFew, "AG_Object:*");
+}
+static void T_OfSubclass(void) {
+	(void)AG_OfSubclass(&objFew, &agObjectClass);
+}
+
+/* Reading integers from files and growing memory sources. */
+#define DS_PATH "agar-bench.dat"
+#define DS_COUNT 65536
+static AG_DataSource *dsFile, *dsMapped, *dsMappedUnlocked, *dsAuto;
+static Uint dsReads;
+
+static void InitDS(void)
+{
+	AG_DataSource *ds;
+	Uint i;
+
+	if ((ds = AG_OpenFile(DS_PATH, "wb")) == NULL) {
+		AG_FatalError(NULL);
+	}
+	for (i = 0; i < DS_COUNT; i++) {
+		AG_WriteUint32(ds, i);
+	}
+	AG_CloseFile(ds);
+	if ((dsFile = AG_OpenFile(DS_PATH, "rb")) == NULL ||
+	    (dsMapped = AG_OpenFileMapped(DS_PATH)) == NULL ||
+	    (dsMappedUnlocked = AG_OpenFileMapped(DS_PATH)) == NULL ||
+	    (dsAuto = AG_OpenAutoCore()) == NULL) {
+		AG_FatalError(NULL);
+	}
+	AG_DataSourceSetUnlocked(dsMappedUnlocked, 1);
+	dsReads = 0;
+}
+static void FreeDS(void)
+{
+	AG_CloseDataSource(dsFile);
+	AG_CloseDataSource(dsMapped);
+	AG_CloseDataSource(dsMappedUnlocked);
+	AG_CloseDataSource(dsAuto);
+	remove(DS_PATH);
+}
+static void ReadUint32Wrap(AG_DataSource *ds) {
+	(void)AG_ReadUint32(ds);
+	if (++dsReads == DS_COUNT) {
+		AG_Seek(ds, 0, AG_SEEK_SET);
+		dsReads = 0;
+	}
+}
+static void T_ReadUint32File(void) {
+	ReadUint32Wrap(dsFile);
+}
+static void T_ReadUint32Mapped(void) {
+	ReadUint32Wrap(dsMapped);
+}
+static void T_ReadUint32MappedUnlocked(void) {
+	ReadUint32Wrap(dsMappedUnlocked);
+}
+static void T_WriteUint32AutoCore(void) {
+	AG_WriteUint32(dsAuto, 1);
+	if (++dsReads == DS_COUNT) {
+		AG_Seek(dsAuto, 0, AG_SEEK_SET);
+		dsReads = 0;
+	}
+}
+
 static struct testfn_ops testfns[] = {
  { "va_list(int)", NULL, NULL, T_Valist },
  { "strlcpy(1k)", NULL, NULL, T_Strlcpy1k },
@@ -52,6 +148,14 @@ static struct testfn_ops testfns[] = {
  { "strlcat(64B)", NULL, NULL, T_Strlcat64 },
  { "snprintf(64B)", NULL, NULL, T_Snprintf64 },
  { "snprintf(%d,%d,%s,%s)", NULL, NULL, T_Snprintf4 },
+ { "AG_GetInt() - 4 variables", InitVars, FreeVars, T_GetIntFewVars },
+ { "AG_GetInt() - 64 variables", InitVars, FreeVars, T_GetIntManyVars },
+ { "AG_OfClass()", InitVars, FreeVars, T_OfClass },
+ { "AG_OfSubclass()", InitVars, FreeVars, T_OfSubclass },
+ { "AG_ReadUint32() - file", InitDS, FreeDS, T_ReadUint32File },
+ { "AG_ReadUint32() - mapped", InitDS, FreeDS, T_ReadUint32Mapped },
+ { "AG_ReadUint32() - mapped, unlocked", InitDS, FreeDS, T_ReadUint32MappedUnlocked },
+ { "AG_WriteUint32() - auto core", InitDS, FreeDS, T_WriteUint32AutoCore },
 };
 
 struct test_ops misc_test = {
@@ -3,6 +3,8 @@
 
 #include "agar-bench.h"
 
+#include <string.h>
+
 static void
 T_DupSurface(void)
 {
@@ -35,6 +37,93 @@ static void T_Scale32To64Copy(void) {
 	AG_SurfaceFree(s2);
 }
 
+/*
+ * Blit/FillRect/Copy on 256x256 packed 32-bit surfaces; these exercise the
+ * specialized 8888 paths in AG_SurfaceBlit(), AG_FillRect() and
+ * AG_SurfaceCopy() and report throughput in Mpix/s.
+ */
+#define BLIT_W 256
+#define BLIT_H 256
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+# define BGRA_RMASK 0x0000ff00
+# define BGRA_GMASK 0x00ff0000
+# define BGRA_BMASK 0xff000000
+# define BGRA_AMASK 0x000000ff
+#else
+# define BGRA_RMASK 0x00ff0000
+# define BGRA_GMASK 0x0000ff00
+# define BGRA_BMASK 0x000000ff
+# define BGRA_AMASK 0xff000000
+#endif
+
+static AG_Surface *sBlitSrc, *sBlitDst, *sBlitBGRA;
+
+static void
+InitBlitSurfaces(void)
+{
+	Uint8 *p;
+	int i;
+
+	sBlitSrc = AG_SurfaceStdRGBA(BLIT_W, BLIT_H);
+	sBlitDst = AG_SurfaceStdRGBA(BLIT_W, BLIT_H);
+	sBlitBGRA = AG_SurfaceRGBA(BLIT_W, BLIT_H, 32, 0,
+	    BGRA_RMASK, BGRA_GMASK, BGRA_BMASK, BGRA_AMASK);
+	for (i = 0, p = sBlitSrc->pixels; i < BLIT_W*BLIT_H*4; i++) {
+		*p++ = (Uint8)(i*7 + (i>>10));
+	}
+	memcpy(sBlitBGRA->pixels, sBlitSrc->pixels, BLIT_W*BLIT_H*4);
+	AG_FillRect(sBlitDst, NULL, AG_ColorRGB(64,128,192));
+}
+
+static void
+FreeBlitSurfaces(void)
+{
+	AG_SurfaceFree(sBlitSrc);
+	AG_SurfaceFree(sBlitDst);
+	AG_SurfaceFree(sBlitBGRA);
+}
+
+static void T_ScaleNearest(void) {
+	AG_Surface *s = NULL;
+	AG_ScaleSurfaceFiltered(sBlitSrc, 512, 512, AG_SCALE_NEAREST, &s);
+	AG_SurfaceFree(s);
+}
+static void T_ScaleBilinear(void) {
+	AG_Surface *s = NULL;
+	AG_ScaleSurfaceFiltered(sBlitSrc, 512, 512, AG_SCALE_BILINEAR, &s);
+	AG_SurfaceFree(s);
+}
+static void T_ScaleBox(void) {
+	AG_Surface *s = NULL;
+	AG_ScaleSurfaceFiltered(sBlitSrc, 64, 64, AG_SCALE_BOX, &s);
+	AG_SurfaceFree(s);
+}
+
+static void T_FillRect(void) {
+	AG_FillRect(sBlitDst, NULL, AG_ColorRGB(10,20,30));
+}
+static void T_BlitOpaque(void) {
+	sBlitSrc->flags &= ~(AG_SRCALPHA|AG_SRCCOLORKEY);
+	AG_SurfaceBlit(sBlitSrc, NULL, sBlitDst, 0, 0);
+}
+static void T_BlitAlpha(void) {
+	sBlitSrc->flags &= ~(AG_SRCCOLORKEY);
+	sBlitSrc->flags |= AG_SRCALPHA;
+	AG_SurfaceBlit(sBlitSrc, NULL, sBlitDst, 0, 0);
+}
+static void T_BlitColorkey(void) {
+	sBlitSrc->flags &= ~(AG_SRCALPHA);
+	sBlitSrc->flags |= AG_SRCCOLORKEY;
+	AG_SurfaceBlit(sBlitSrc, NULL, sBlitDst, 0, 0);
+}
+static void T_BlitAlphaBGRA(void) {
+	sBlitBGRA->flags |= AG_SRCALPHA;
+	AG_SurfaceBlit(sBlitBGRA, NULL, sBlitDst, 0, 0);
+}
+static void T_CopyBGRA(void) {
+	AG_SurfaceCopy(sBlitDst, sBlitBGRA);
+}
+
 static struct testfn_ops testfns[] = {
  { "DupSurface+Free (32)", InitSurface, FreeSurface, T_DupSurface },
  { "Scale(32->32)", InitSurface, FreeSurface, T_Scale32To32 },
@@ -43,6 +132,24 @@ static struct testfn_ops testfns[] = {
  { "Scale(32->64)+Copy", InitSurface, FreeSurface, T_Scale32To64Copy },
  { "Scale(32->128)", InitSurface, FreeSurface, T_Scale32To128 },
  { "Scale(128->32)", InitSurface, FreeSurface, T_Scale128To32 },
+ { "FillRect(256x256)", InitBlitSurfaces, FreeBlitSurfaces, T_FillRect,
+   BLIT_W*BLIT_H },
+ { "Blit(256x256, opaque)", InitBlitSurfaces, FreeBlitSurfaces, T_BlitOpaque,
+   BLIT_W*BLIT_H },
+ { "Blit(256x256, alpha)", InitBlitSurfaces, FreeBlitSurfaces, T_BlitAlpha,
+   BLIT_W*BLIT_H },
+ { "Blit(256x256, colorkey)", InitBlitSurfaces, FreeBlitSurfaces,
+   T_BlitColorkey, BLIT_W*BLIT_H },
+ { "Blit(256x256, alpha, BGRA->RGBA)", InitBlitSurfaces, FreeBlitSurfaces,
+   T_BlitAlphaBGRA, BLIT_W*BLIT_H },
+ { "Copy(256x256, BGRA->RGBA)", InitBlitSurfaces, FreeBlitSurfaces,
+   T_CopyBGRA, BLIT_W*BLIT_H },
+ { "Scale(256->512, nearest)", InitBlitSurfaces, FreeBlitSurfaces,
+   T_ScaleNearest, 512*512 },
+ { "Scale(256->512, bilinear)", InitBlitSurfaces, FreeBlitSurfaces,
+   T_ScaleBilinear, 512*512 },
+ { "Scale(256->64, box)", InitBlitSurfaces, FreeBlitSurfaces,
+   T_ScaleBox, BLIT_W*BLIT_H },
 };
 
 struct test_ops surfaceops_test = {
@@ -0,0 +1,81 @@
+/*	Public domain	*/
+
+#include "agar-bench.h"
+
+#define NTIMERS 100000
+
+static AG_Object obj;
+static AG_Timer *timers = NULL;
+static int cur = 0;
+
+static Uint32
+TimerFn(AG_Timer *to, AG_Event *event)
+{
+	return (0);
+}
+
+/*
+ * Object with 100000 timers scheduled in the next 1000 seconds. These are
+ * soft timers (see main()), kept in the timing wheel of timeout.c.
+ */
+static void InitTimers(void)
+{
+	int i;
+
+	AG_ObjectInitStatic(&obj, &agObjectClass);
+	timers = Malloc(NTIMERS*sizeof(AG_Timer));
+	for (i = 0; i < NTIMERS; i++) {
+		AG_InitTimer(&timers[i], "bench", 0);
+		AG_AddTimer(&obj, &timers[i], 100000 + (i*7919) % 900000,
+		    TimerFn, NULL);
+	}
+	cur = 0;
+}
+static void FreeTimers(void)
+{
+	int i;
+
+	for (i = 0; i < NTIMERS; i++) {
+		AG_DelTimer(&obj, &timers[i]);
+	}
+	AG_ObjectDestroy(&obj);
+	Free(timers);
+	timers = NULL;
+}
+
+static void T_AddTimer(void) {
+	AG_Timer *to = &timers[cur];
+
+	AG_DelTimer(&obj, to);
+	AG_AddTimer(&obj, to, 100000 + (cur*7919) % 900000, TimerFn, NULL);
+	if (++cur == NTIMERS) { cur = 0; }
+}
+static void T_ResetTimer(void) {
+	AG_ResetTimer(&obj, &timers[cur], 100000 + (cur*104729) % 900000);
+	if (++cur == NTIMERS) { cur = 0; }
+}
+static void T_TimerIsRunning(void) {
+	AG_LockTimers(&obj);
+	(void)AG_TimerIsRunning(&obj, &timers[cur]);
+	AG_UnlockTimers(&obj);
+	if (++cur == NTIMERS) { cur = 0; }
+}
+static void T_ProcessTimeouts(void) {
+	AG_ProcessTimeouts(AG_GetTicks());
+}
+
+static struct testfn_ops testfns[] = {
+ { "AG_DelTimer()+AG_AddTimer() - 100k timers", InitTimers,FreeTimers, T_AddTimer },
+ { "AG_ResetTimer() - 100k timers", InitTimers,FreeTimers, T_ResetTimer },
+ { "AG_TimerIsRunning() - 100k timers", InitTimers,FreeTimers, T_TimerIsRunning },
+ { "AG_ProcessTimeouts() - 100k timers, none expired", InitTimers,FreeTimers, T_ProcessTimeouts },
+};
+
+struct test_ops timers_test = {
+	"Timers",
+	NULL,
+	&testfns[0],
+	sizeof(testfns) / sizeof(testfns[0]),
+	0,
+	4, 10000, 0
+};